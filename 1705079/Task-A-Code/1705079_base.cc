@@ -7,6 +7,11 @@
 //        |   |   |   |   point-to-point  |    |    |    |
 //       ==============                   ================
 //       LAN 10.1.1.0                       LAN 10.2.1.0
+//
+// --traceCompression=gzip or zstd needs zlib or libzstd compiled in:
+//
+//   CXXFLAGS="-DHAVE_ZLIB -DHAVE_ZSTD" LINKFLAGS="-lz -lzstd" ./waf configure
+//   ./waf --run "scratch/1705079_base --traceCompression=zstd"
 
 #include "ns3/core-module.h"
 #include "ns3/network-module.h"
@@ -17,9 +22,20 @@
 #include "ns3/traffic-control-module.h"
 #include "ns3/flow-monitor-module.h"
 
+#include "async-trace-stream.h"
+#include "filtered-trace-helper.h"
+#include "flow-stats-exporter.h"
+#include "endpoint-flow-monitor.h"
+#include "goodput-metrics.h"
+#include "ensemble-runner.h"
+#include "steady-state-monitor.h"
+#include "scalable-dumbbell-helper.h"
+
+#include <chrono>
 #include <iostream>
 #include <iomanip>
 #include <map>
+#include <vector>
 
 using namespace ns3;
 
@@ -41,6 +57,30 @@ int main(int argc, char *argv[])
     uint16_t port = 5001;
     std::string bottleNeckLinkBw = "5Mbps";
     std::string bottleNeckLinkDelay = "100ms";
+    bool asyncTrace = true;
+    std::string traceCompression = "none";
+    uint32_t traceBudgetMb = 64;
+    std::string traceMode = "all";
+    std::string traceNodes = "bottleneck";
+    std::string traceEvents = "all";
+    uint32_t traceSample = 1;
+    bool traceFlowSample = false;
+    bool headDrop = false;
+    std::string flowExport = "csv";
+    double flowExportInterval = 0;
+    std::string flowMonitorMode = "full";
+    double goodputBin = 0.5;
+    uint32_t attackerLeaves = 0;
+    uint32_t ensemble = 0;
+    uint32_t ensembleJobs = 0;
+    double ciPrecision = 0;
+    double ciLevel = 0.95;
+    uint32_t minReplications = 5;
+    std::string steadyState = "none";
+    double steadyInterval = 0.1;
+    double steadyPrecision = 0.05;
+    std::string builder = "dumbbell";
+    uint32_t flowsPerLeaf = 1;
 
     // options for arguments
     CommandLine cmd(__FILE__);
@@ -56,6 +96,42 @@ int main(int argc, char *argv[])
 
     cmd.AddValue("redMinTh", "RED queue minimum threshold (in packets)", minTh);
     cmd.AddValue("redMaxTh", "RED queue maximum threshold (in packets)", maxTh);
+    cmd.AddValue("headDrop", "RED drops the packet at the head of the queue instead of the arriving one", headDrop);
+    cmd.AddValue("asyncTrace", "Write ascii traces from a background thread", asyncTrace);
+    cmd.AddValue("traceCompression", "Compression of async traces (none, gzip with HAVE_ZLIB, zstd with HAVE_ZSTD)",
+                 traceCompression);
+    cmd.AddValue("traceBudgetMb", "Memory budget per async trace stream in MB", traceBudgetMb);
+    cmd.AddValue("traceMode", "Ascii tracing: all (every event), filtered or none", traceMode);
+    cmd.AddValue("traceNodes", "Filtered tracing device set: bottleneck, routers or all", traceNodes);
+    cmd.AddValue("traceEvents", "Filtered tracing events: comma list of enqueue, dequeue, drop, rx, all", traceEvents);
+    cmd.AddValue("traceSample", "Filtered tracing keeps one event in N", traceSample);
+    cmd.AddValue("traceFlowSample", "Filtered tracing samples whole flows by five-tuple hash", traceFlowSample);
+    cmd.AddValue("flowExport", "Flow statistics output: csv, bin or xml", flowExport);
+    cmd.AddValue("flowExportInterval", "Seconds between periodic flow statistics dumps (0 for the final one only)",
+                 flowExportInterval);
+    cmd.AddValue("flowMonitor", "Flow monitoring: full (every node) or endpoint (sources, sinks, bottleneck)",
+                 flowMonitorMode);
+    cmd.AddValue("goodputBin", "Goodput time series bin width in seconds (0 to disable)", goodputBin);
+    cmd.AddValue("attackerLeaves", "Number of right leaves whose flows are reported as attack traffic",
+                 attackerLeaves);
+    cmd.AddValue("ensemble", "Replications forked after the topology is built, from run RngRun (0 for a single run)",
+                 ensemble);
+    cmd.AddValue("ensembleJobs", "Concurrent ensemble workers (0 for the number of cores)", ensembleJobs);
+    cmd.AddValue("ciPrecision", "Stop the ensemble once every confidence interval half-width is below this "
+                                "fraction of its mean (0 to run all replications)",
+                 ciPrecision);
+    cmd.AddValue("ciLevel", "Confidence level of the ensemble statistics", ciLevel);
+    cmd.AddValue("minReplications", "Replications before the ciPrecision rule is checked", minReplications);
+    cmd.AddValue("steadyState", "Steady-state detection on the bottleneck: none, stop (end the run) or trim "
+                                "(keep running, also report the monitored series without warm-up)",
+                 steadyState);
+    cmd.AddValue("steadyInterval", "Steady-state sample interval in seconds", steadyInterval);
+    cmd.AddValue("steadyPrecision", "Steady-state target confidence interval half-width, relative to the mean",
+                 steadyPrecision);
+    cmd.AddValue("builder", "Topology builder: dumbbell (PointToPointDumbbellHelper) or scalable (computed "
+                            "addresses and routes, for large leaf counts)",
+                 builder);
+    cmd.AddValue("flowsPerLeaf", "OnOff flows sent by each right leaf", flowsPerLeaf);
     cmd.Parse(argc, argv);
 
     // default configuration
@@ -85,6 +161,7 @@ int main(int argc, char *argv[])
     Config::SetDefault("ns3::RedQueueDisc::LinkBandwidth", StringValue(bottleNeckLinkBw));
     Config::SetDefault("ns3::RedQueueDisc::LinkDelay", StringValue(bottleNeckLinkDelay));
     Config::SetDefault("ns3::RedQueueDisc::MeanPktSize", UintegerValue(pktSize));
+    Config::SetDefault("ns3::RedQueueDisc::HeadDrop", BooleanValue(headDrop));
 
     //  point-to-point link helpers
     PointToPointHelper bottleNeckLink;
@@ -95,44 +172,92 @@ int main(int argc, char *argv[])
     pointToPointLeaf.SetDeviceAttribute("DataRate", StringValue("5Mbps"));
     pointToPointLeaf.SetChannelAttribute("Delay", StringValue("1ms"));
 
-    PointToPointDumbbellHelper d(nLeftLeafCount, pointToPointLeaf,
-                                 nRightLeafCount, pointToPointLeaf,
-                                 bottleNeckLink);
+    // the rest of the scenario only sees the routers, the leaves and the
+    // leaf addresses, whichever builder made them
+    Ptr<Node> leftRouter;
+    Ptr<Node> rightRouter;
+    NodeContainer leftLeaves;
+    NodeContainer rightLeaves;
+    std::vector<Ipv4Address> leftAddresses;
+    std::vector<Ipv4Address> rightAddresses;
+    auto collect = [&](const auto &d) {
+        leftRouter = d.GetLeft();
+        rightRouter = d.GetRight();
+        for (uint32_t i = 0; i < d.LeftCount(); ++i)
+        {
+            leftLeaves.Add(d.GetLeft(i));
+            leftAddresses.push_back(d.GetLeftIpv4Address(i));
+        }
+        for (uint32_t i = 0; i < d.RightCount(); ++i)
+        {
+            rightLeaves.Add(d.GetRight(i));
+            rightAddresses.push_back(d.GetRightIpv4Address(i));
+        }
+    };
 
-    // protocol stack installation
     InternetStackHelper stack;
-    for (uint32_t i = 0; i < d.LeftCount(); ++i)
+    TrafficControlHelper tchBottleneck;
+    QueueDiscContainer queueDiscs;
+    QueueDiscContainer bottleneckQueueDiscs;
+    tchBottleneck.SetRootQueueDisc("ns3::RedQueueDisc");
+    // device 0 of both routers is the bottleneck link
+    auto installBottleneck = [&](Ptr<Node> left, Ptr<Node> right) {
+        bottleneckQueueDiscs.Add(tchBottleneck.Install(left->GetDevice(0)));
+        queueDiscs = tchBottleneck.Install(right->GetDevice(0));
+        bottleneckQueueDiscs.Add(queueDiscs);
+    };
+
+    std::chrono::steady_clock::time_point setupStart = std::chrono::steady_clock::now();
+    if (builder == "dumbbell")
     {
-        stack.Install(d.GetLeft(i));
+        PointToPointDumbbellHelper d(nLeftLeafCount, pointToPointLeaf,
+                                     nRightLeafCount, pointToPointLeaf,
+                                     bottleNeckLink);
+
+        // protocol stack installation
+        for (uint32_t i = 0; i < d.LeftCount(); ++i)
+        {
+            stack.Install(d.GetLeft(i));
+        }
+        for (uint32_t i = 0; i < d.RightCount(); ++i)
+        {
+            stack.Install(d.GetRight(i));
+        }
+
+        stack.Install(d.GetLeft());
+        stack.Install(d.GetRight());
+
+        // before the addresses, which install a default queue disc
+        installBottleneck(d.GetLeft(), d.GetRight());
+
+        // ip address assignment
+        d.AssignIpv4Addresses(Ipv4AddressHelper("10.1.1.0", "255.255.255.0"),
+                              Ipv4AddressHelper("10.2.1.0", "255.255.255.0"),
+                              Ipv4AddressHelper("10.3.1.0", "255.255.255.0"));
+        Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+        collect(d);
     }
-    for (uint32_t i = 0; i < d.RightCount(); ++i)
+    else if (builder == "scalable")
     {
-        stack.Install(d.GetRight(i));
+        // stacks, addresses and routes are set up by Build ()
+        ScalableDumbbellHelper d;
+        d.SetLeaves(nLeftLeafCount, nRightLeafCount)
+            .SetLeafLink(pointToPointLeaf)
+            .SetBottleneckLink(bottleNeckLink)
+            .Build();
+        installBottleneck(d.GetLeft(), d.GetRight());
+        collect(d);
+    }
+    else
+    {
+        NS_FATAL_ERROR("Unknown builder " << builder << " (use dumbbell or scalable)");
     }
-
-    stack.Install(d.GetLeft());
-    stack.Install(d.GetRight());
-
-    TrafficControlHelper tchBottleneck;
-    QueueDiscContainer queueDiscs;
-    tchBottleneck.SetRootQueueDisc("ns3::RedQueueDisc");
-    tchBottleneck.Install(d.GetLeft()->GetDevice(0));
-    queueDiscs = tchBottleneck.Install(d.GetRight()->GetDevice(0));
-
-    // ip address assignment
-    d.AssignIpv4Addresses(Ipv4AddressHelper("10.1.1.0", "255.255.255.0"),
-                          Ipv4AddressHelper("10.2.1.0", "255.255.255.0"),
-                          Ipv4AddressHelper("10.3.1.0", "255.255.255.0"));
 
     // on|off application installation
 
     Address sinkLocalAddress(InetSocketAddress(Ipv4Address::GetAny(), port));
     PacketSinkHelper packetSinkHelper("ns3::TcpSocketFactory", sinkLocalAddress);
-    ApplicationContainer sinkApps;
-    for (uint32_t i = 0; i < d.LeftCount(); ++i)
-    {
-        sinkApps.Add(packetSinkHelper.Install(d.GetLeft(i)));
-    }
+    ApplicationContainer sinkApps = packetSinkHelper.Install(leftLeaves);
     sinkApps.Start(Seconds(0.0));
     sinkApps.Stop(Seconds(25.0));
 
@@ -140,31 +265,175 @@ int main(int argc, char *argv[])
     clientHelper.SetAttribute("OnTime", StringValue("ns3::UniformRandomVariable[Min=0.|Max=1.]"));
     clientHelper.SetAttribute("OffTime", StringValue("ns3::UniformRandomVariable[Min=0.|Max=1.]"));
     ApplicationContainer clientApps;
-    for (uint32_t i = 0; i < d.RightCount(); ++i)
+    for (uint32_t i = 0; i < rightLeaves.GetN(); ++i)
     {
-        // on|off app installation to send packets
-        AddressValue remoteAddress(InetSocketAddress(d.GetLeftIpv4Address(i), port));
+        // on|off app installation to send packets; the flows of a leaf
+        // share the sink of its left peer
+        AddressValue remoteAddress(InetSocketAddress(leftAddresses[i % leftAddresses.size()], port));
         clientHelper.SetAttribute("Remote", remoteAddress);
-        clientApps.Add(clientHelper.Install(d.GetRight(i)));
+        for (uint32_t k = 0; k < flowsPerLeaf; ++k)
+        {
+            clientApps.Add(clientHelper.Install(rightLeaves.Get(i)));
+        }
     }
     clientApps.Start(Seconds(2.0)); // Start 2 second after sink
     clientApps.Stop(Seconds(10.0)); // Stop before the sink
 
-    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+    std::chrono::duration<double> setupTime = std::chrono::steady_clock::now() - setupStart;
+    std::cout << "Topology with " << clientApps.GetN() << " flows built in " << setupTime.count() << "s" << std::endl;
+
+    // everything above is shared by the ensemble workers; output files are
+    // only opened below, with a per-worker name
+    EnsembleRunner runner;
+    if (ciPrecision > 0)
+    {
+        runner.SetStopRule(ciLevel, ciPrecision, minReplications);
+    }
+    if (!runner.Fork(ensemble, ensembleJobs, "1705079_base"))
+    {
+        return runner.GetNFailed() == 0 ? 0 : 1;
+    }
+
+    // random variables created so far drew their run number before the
+    // fork, so assign every stream again
+    int64_t stream = 1;
+    NodeContainer allNodes = NodeContainer::GetGlobal();
+    stream += stack.AssignStreams(allNodes, stream);
+    for (uint32_t i = 0; i < bottleneckQueueDiscs.GetN(); ++i)
+    {
+        stream += DynamicCast<RedQueueDisc>(bottleneckQueueDiscs.Get(i))->AssignStreams(stream);
+    }
+    for (uint32_t i = 0; i < clientApps.GetN(); ++i)
+    {
+        stream += DynamicCast<OnOffApplication>(clientApps.Get(i))->AssignStreams(stream);
+    }
 
     // performance metrics calculation
 
     AsciiTraceHelper asciiHelper;
-    pointToPointLeaf.EnableAsciiAll(asciiHelper.CreateFileStream("p2p_ascii.tr"));
-    bottleNeckLink.EnableAsciiAll(asciiHelper.CreateFileStream("bottle_neck_ascii.tr"));
+    AsyncTraceHelper asyncHelper(AsyncTraceStreamBuf::ParseCompression(traceCompression),
+                                 4 << 20, static_cast<uint64_t>(traceBudgetMb) << 20);
+    if (traceMode == "all")
+    {
+        if (asyncTrace)
+        {
+            pointToPointLeaf.EnableAsciiAll(asyncHelper.CreateFileStream(runner.GetFileName("p2p_ascii.tr")));
+            bottleNeckLink.EnableAsciiAll(asyncHelper.CreateFileStream(runner.GetFileName("bottle_neck_ascii.tr")));
+        }
+        else
+        {
+            pointToPointLeaf.EnableAsciiAll(asciiHelper.CreateFileStream(runner.GetFileName("p2p_ascii.tr")));
+            bottleNeckLink.EnableAsciiAll(asciiHelper.CreateFileStream(runner.GetFileName("bottle_neck_ascii.tr")));
+        }
+    }
+    else if (traceMode == "filtered")
+    {
+        FilteredTraceHelper filteredHelper;
+        filteredHelper.SetEventMask(FilteredTraceHelper::ParseEventMask(traceEvents));
+        filteredHelper.SetSampling(traceSample, traceFlowSample);
+
+        Ptr<OutputStreamWrapper> bottleNeckStream = asyncTrace
+                                                        ? asyncHelper.CreateFileStream(runner.GetFileName("bottle_neck_ascii.tr"))
+                                                        : asciiHelper.CreateFileStream(runner.GetFileName("bottle_neck_ascii.tr"));
+        filteredHelper.Enable(bottleNeckStream, leftRouter->GetDevice(0));
+        filteredHelper.Enable(bottleNeckStream, rightRouter->GetDevice(0));
+
+        if (traceNodes == "routers" || traceNodes == "all")
+        {
+            Ptr<OutputStreamWrapper> p2pStream = asyncTrace
+                                                     ? asyncHelper.CreateFileStream(runner.GetFileName("p2p_ascii.tr"))
+                                                     : asciiHelper.CreateFileStream(runner.GetFileName("p2p_ascii.tr"));
+            // router device i + 1 connects leaf i
+            for (uint32_t i = 1; i <= leftLeaves.GetN(); ++i)
+            {
+                filteredHelper.Enable(p2pStream, leftRouter->GetDevice(i));
+            }
+            for (uint32_t i = 1; i <= rightLeaves.GetN(); ++i)
+            {
+                filteredHelper.Enable(p2pStream, rightRouter->GetDevice(i));
+            }
+            if (traceNodes == "all")
+            {
+                filteredHelper.Enable(p2pStream, leftLeaves);
+                filteredHelper.Enable(p2pStream, rightLeaves);
+            }
+        }
+        else if (traceNodes != "bottleneck")
+        {
+            NS_FATAL_ERROR("Unknown traceNodes " << traceNodes << " (use bottleneck, routers or all)");
+        }
+    }
+    else if (traceMode != "none")
+    {
+        NS_FATAL_ERROR("Unknown traceMode " << traceMode << " (use all, filtered or none)");
+    }
 
     Ptr<FlowMonitor> flow_monitor;
     FlowMonitorHelper flow_helper;
-    flow_monitor = flow_helper.InstallAll();
+    EndpointFlowMonitor endpointMonitor;
+    if (flowMonitorMode == "full")
+    {
+        flow_monitor = flow_helper.InstallAll();
+    }
+    else if (flowMonitorMode == "endpoint")
+    {
+        NS_ABORT_MSG_IF(flowExport == "xml", "The endpoint flow monitor cannot be serialized to xml");
+        endpointMonitor.InstallSources(rightLeaves);
+        endpointMonitor.InstallSinks(leftLeaves);
+        endpointMonitor.InstallQueueDiscs(bottleneckQueueDiscs);
+    }
+    else
+    {
+        NS_FATAL_ERROR("Unknown flowMonitor " << flowMonitorMode << " (use full or endpoint)");
+    }
+
+    FlowStatsExporter flowExporter(flow_monitor, flow_helper.GetClassifier());
+    if (flowMonitorMode == "endpoint")
+    {
+        flowExporter.SetEndpointFlowMonitor(&endpointMonitor);
+    }
+    if (flowExport != "xml")
+    {
+        FlowStatsExporter::Format format = FlowStatsExporter::ParseFormat(flowExport);
+        flowExporter.Open(runner.GetFileName(format == FlowStatsExporter::CSV ? "flow_monitor_stats.csv" : "flow_monitor_stats.fsx"), format);
+        if (flowExportInterval > 0)
+        {
+            flowExporter.SchedulePeriodic(Seconds(flowExportInterval));
+        }
+    }
+
+    GoodputMetrics goodput(Seconds(goodputBin > 0 ? goodputBin : 1));
+    if (goodputBin > 0)
+    {
+        NS_ABORT_MSG_IF(attackerLeaves > rightLeaves.GetN(), "attackerLeaves exceeds nRightLeafCount");
+        goodput.Install(sinkApps);
+        for (uint32_t i = 0; i < attackerLeaves; ++i)
+        {
+            goodput.AddAttackerSource(rightAddresses[i]);
+        }
+        goodput.OpenStream(runner.GetFileName("goodput_timeseries.csv"));
+        goodput.Start(Seconds(0.0));
+    }
+
+    SteadyStateMonitor steadyMonitor;
+    if (steadyState != "none")
+    {
+        NS_ABORT_MSG_UNLESS(steadyState == "stop" || steadyState == "trim",
+                            "Unknown steadyState " << steadyState << " (use none, stop or trim)");
+        // traffic flows from the right leaves to the left ones, so the
+        // right router queue disc is the bottleneck
+        steadyMonitor.SetQueueDisc(DynamicCast<RedQueueDisc>(queueDiscs.Get(0)));
+        steadyMonitor.SetSinks(sinkApps);
+        steadyMonitor.SetPrecision(steadyPrecision, 0.95, 20);
+        steadyMonitor.Start(Seconds(2.0), Seconds(steadyInterval), 50,
+                            steadyState == "stop" ? SteadyStateMonitor::STOP : SteadyStateMonitor::TRIM);
+    }
 
     std::cout << "Running the simulation" << std::endl;
     Simulator::Stop(Seconds(25.0));
     Simulator::Run();
+    asyncHelper.Close();
+    goodput.Finish();
 
     uint32_t sentPackets = 0;
     uint32_t receivedPackets = 0;
@@ -173,35 +442,45 @@ int main(int argc, char *argv[])
     float avgThroughput = 0.0;
     Time delay;
 
-    flow_monitor->CheckForLostPackets();
-    Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier>(flow_helper.GetClassifier());
-    std::map<FlowId, FlowMonitor::FlowStats> stats = flow_monitor->GetFlowStats();
-    for (std::map<FlowId, FlowMonitor::FlowStats>::const_iterator i = stats.begin(); i != stats.end(); ++i)
-    {
-        Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow(i->first);
-        // std::cout << "id : " << i->first << " src : " << t.sourceAddress << " des : " << t.destinationAddress << " ";
-        // std::cout << "data : " << (i->second.rxBytes) * 8.0 / 1024 / 1024 << "Mbps" << std::endl;
-        NS_LOG_UNCOND("\t\tFlow ID = " << i->first);
-        NS_LOG_UNCOND("sorce address = " << t.sourceAddress << " destination address = " << t.destinationAddress);
-        NS_LOG_UNCOND("sent packects = " << i->second.txPackets);
-        NS_LOG_UNCOND("received packets = " << i->second.rxPackets);
-        NS_LOG_UNCOND("lost packets = " << i->second.txPackets - i->second.rxPackets);
-        NS_LOG_UNCOND("packet delivery ratio = " << i->second.rxPackets * 100 / i->second.txPackets << "%");
-        NS_LOG_UNCOND("packet loss ratio = " << (i->second.txPackets - i->second.rxPackets) * 100 / i->second.txPackets << "%");
-        NS_LOG_UNCOND("delay = " << i->second.delaySum);
-        NS_LOG_UNCOND("throughput = " << i->second.rxBytes * 8.0 / (i->second.timeLastRxPacket.GetSeconds() - i->second.timeFirstTxPacket.GetSeconds()) / 1024 << "Kbps");
-
-        sentPackets = sentPackets + (i->second.txPackets);
-        receivedPackets = receivedPackets + (i->second.rxPackets);
-        lostPackets = lostPackets + (i->second.txPackets - i->second.rxPackets);
-        avgThroughput = avgThroughput + (i->second.rxBytes * 8.0 / (i->second.timeLastRxPacket.GetSeconds() - i->second.timeFirstTxPacket.GetSeconds()) / 1024);
-        delay = delay + (i->second.delaySum);
+    // both monitors are read through the same flow table
+    FlowStatsTable flows;
+    flowExporter.Snapshot(flows);
+    for (std::size_t i = 0; i < flows.GetNRows(); ++i)
+    {
+        if (flows.txPackets[i] == 0)
+        {
+            // only seen at the bottleneck, e.g. ACKs with the endpoint monitor
+            continue;
+        }
+        Ipv4Address sourceAddress = Ipv4Address::Deserialize(flows.srcAddress[i].data());
+        Ipv4Address destinationAddress = Ipv4Address::Deserialize(flows.dstAddress[i].data());
+        double duration = (flows.lastRxNs[i] - flows.firstTxNs[i]) / 1e9;
+        // std::cout << "id : " << flows.flowId[i] << " src : " << sourceAddress << " des : " << destinationAddress << " ";
+        // std::cout << "data : " << (flows.rxBytes[i]) * 8.0 / 1024 / 1024 << "Mbps" << std::endl;
+        NS_LOG_UNCOND("\t\tFlow ID = " << flows.flowId[i]);
+        NS_LOG_UNCOND("sorce address = " << sourceAddress << " destination address = " << destinationAddress);
+        NS_LOG_UNCOND("sent packects = " << flows.txPackets[i]);
+        NS_LOG_UNCOND("received packets = " << flows.rxPackets[i]);
+        NS_LOG_UNCOND("lost packets = " << flows.txPackets[i] - flows.rxPackets[i]);
+        NS_LOG_UNCOND("packet delivery ratio = " << flows.rxPackets[i] * 100 / flows.txPackets[i] << "%");
+        NS_LOG_UNCOND("packet loss ratio = " << (flows.txPackets[i] - flows.rxPackets[i]) * 100 / flows.txPackets[i] << "%");
+        NS_LOG_UNCOND("delay = " << NanoSeconds(flows.delaySumNs[i]));
+        NS_LOG_UNCOND("throughput = " << flows.rxBytes[i] * 8.0 / duration / 1024 << "Kbps");
+
+        sentPackets = sentPackets + (flows.txPackets[i]);
+        receivedPackets = receivedPackets + (flows.rxPackets[i]);
+        lostPackets = lostPackets + (flows.txPackets[i] - flows.rxPackets[i]);
+        avgThroughput = avgThroughput + (flows.rxBytes[i] * 8.0 / duration / 1024);
+        delay = delay + NanoSeconds(flows.delaySumNs[i]);
 
         flow_count++;
     }
 
     avgThroughput = avgThroughput / flow_count;
-    NS_LOG_UNCOND("\t ****Total Results of the simulation****" << std::endl);
+    // flow monitor totals are cumulative, so only the steady-state series
+    // below have the warm-up removed
+    NS_LOG_UNCOND("\t ****Total Results of the simulation****"
+                  << (steadyState == "trim" ? " (whole run, warm-up included)" : "") << std::endl);
     NS_LOG_UNCOND("Total sent packets  =" << sentPackets);
     NS_LOG_UNCOND("Total Received Packets =" << receivedPackets);
     NS_LOG_UNCOND("Total Lost Packets =" << lostPackets);
@@ -211,10 +490,56 @@ int main(int argc, char *argv[])
     NS_LOG_UNCOND("Average End to End Delay =" << delay / flow_count);
     NS_LOG_UNCOND("Total flow count " << flow_count);
 
-    flow_monitor->SerializeToXmlFile("flow_monitor_stats.xml", true, true);
+    if (steadyState != "none")
+    {
+        if (steadyMonitor.IsSteady())
+        {
+            NS_LOG_UNCOND("Steady state reached at " << steadyMonitor.GetSteadyTime().GetSeconds()
+                                                     << "s, warm-up ended at " << steadyMonitor.GetWarmupEnd().GetSeconds() << "s");
+        }
+        else
+        {
+            NS_LOG_UNCOND("Steady state not reached");
+        }
+        for (const SteadyStateMonitor::Estimate &e : steadyMonitor.GetEstimates())
+        {
+            NS_LOG_UNCOND("Steady-state " << e.name << " =" << e.mean << " +/- " << e.halfWidth << " (first "
+                                          << e.warmup << " samples trimmed)");
+        }
+    }
+
+    if (goodputBin > 0)
+    {
+        // binned at the sinks, so attack windows are not averaged away
+        GoodputMetrics::Summary gs = goodput.GetSummary();
+        NS_LOG_UNCOND("Legitimate goodput =" << gs.legitGoodputBps / 1024 << "Kbps over " << gs.nLegitFlows << " flows");
+        NS_LOG_UNCOND("Attack goodput =" << gs.attackGoodputBps / 1024 << "Kbps over " << gs.nAttackFlows << " flows");
+        NS_LOG_UNCOND("Jain fairness index mean =" << gs.meanJain << " min =" << gs.minJain << " over " << gs.nBins
+                                                   << " bins, " << gs.nStarvedBins << " starved (index 0)");
+        goodput.WriteFlowSeries(runner.GetFileName("goodput_flows.csv"));
+    }
+
+    if (flowExport == "xml")
+    {
+        flow_monitor->SerializeToXmlFile(runner.GetFileName("flow_monitor_stats.xml"), true, true);
+    }
+    else
+    {
+        flowExporter.Dump();
+        flowExporter.Close();
+    }
 
     QueueDisc::Stats st = queueDiscs.Get(0)->GetStats();
 
+    // per-replication samples for the ensemble confidence intervals
+    runner.Report("throughput_kbps", avgThroughput);
+    runner.Report("loss_pct", sentPackets > 0 ? lostPackets * 100.0 / sentPackets : 0);
+    runner.Report("delay_ms", flow_count > 0 ? (delay / flow_count).GetSeconds() * 1e3 : 0);
+    runner.Report("unforced_drops", st.GetNDroppedPackets(RedQueueDisc::UNFORCED_DROP));
+    runner.Report("forced_drops", st.GetNDroppedPackets(RedQueueDisc::FORCED_DROP));
+    // head drops leave after dequeue
+    runner.Report("head_drops", st.nTotalDroppedPacketsAfterDequeue);
+
     if (st.GetNDroppedPackets(RedQueueDisc::UNFORCED_DROP) == 0)
     {
         std::cout << "There should be some unforced drops" << std::endl;
@@ -0,0 +1,382 @@
+
+// author :  kazi wasif amin shammo 1705079
+// Distributed version of 1705079_base: the dumbbell is split at the
+// bottleneck link, the left router and leaves run on rank 0 and the right
+// router and leaves on rank 1.
+//
+//                          10.3.1.0
+//        n3  n2  n1  n0   ============   n4   n5   n6   n7
+//        |   |   |   |   point-to-point  |    |    |    |
+//       ==============                   ================
+//       LAN 10.1.1.0                       LAN 10.2.1.0
+//          rank 0                              rank 1
+//
+// The bottleneck becomes a PointToPointRemoteChannel, so the lookahead of
+// the distributed simulator is its 100 ms delay.  Nodes, devices,
+// addresses and random streams are created in the same order as in
+// 1705079_base, so both programs produce the same flows.  The totals count
+// the data flows and their reverse ACK flows, like the FlowMonitor of
+// 1705079_base; the endpoint monitor counts packets still in flight at the
+// end as lost, so they can differ slightly.
+//
+//   ./waf configure --enable-mpi
+//   mpirun -np 2 ./waf --run "scratch/1705079_base_mpi --nLeftLeafCount=2000 --nRightLeafCount=2000"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/traffic-control-module.h"
+#include "ns3/mpi-interface.h"
+
+#include "endpoint-flow-monitor.h"
+#include "flow-stats-reader.h"
+
+#ifdef NS3_MPI
+#include <mpi.h>
+#endif
+
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("1705079BaseMpi");
+
+#ifdef NS3_MPI
+namespace
+{
+    // five-tuple of a flow table row
+    FlowKey RowKey(const FlowStatsTable &t, std::size_t i)
+    {
+        FlowKey key;
+        key.family = t.family[i];
+        std::copy(t.srcAddress[i].begin(), t.srcAddress[i].end(), key.srcAddress);
+        std::copy(t.dstAddress[i].begin(), t.dstAddress[i].end(), key.dstAddress);
+        key.protocol = t.protocol[i];
+        key.srcPort = t.srcPort[i];
+        key.dstPort = t.dstPort[i];
+        return key;
+    }
+} // namespace
+#endif
+
+int main(int argc, char *argv[])
+{
+#ifdef NS3_MPI
+    // default values of the parameters
+    uint32_t nLeftLeafCount = 20;
+    uint32_t nRightLeafCount = 20;
+    uint32_t maxPackets = 500;
+    bool modeBytes = false;
+    uint32_t queueDiscLimitPackets = 100;
+    double minTh = 50;
+    double maxTh = 75;
+    uint32_t pktSize = 256;
+    std::string appDataRate = "10Mbps";
+    uint16_t port = 5001;
+    std::string bottleNeckLinkBw = "5Mbps";
+    std::string bottleNeckLinkDelay = "100ms";
+    bool nullmsg = false;
+
+    // options for arguments
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nLeftLeafCount", "Number of left side leaf nodes", nLeftLeafCount);
+    cmd.AddValue("nRightLeafCount", "Number of right side leaf nodes", nRightLeafCount);
+    cmd.AddValue("maxPackets", "Max Packets allowed in the device queue", maxPackets);
+    cmd.AddValue("queueDiscLimitPackets", "Max Packets allowed in the queue disc",
+                 queueDiscLimitPackets);
+    cmd.AddValue("appPktSize", "Set OnOff App Packet Size", pktSize);
+    cmd.AddValue("appDataRate", "Set OnOff App DataRate", appDataRate);
+    cmd.AddValue("modeBytes", "Set Queue disc mode to Packets (false) or bytes (true)", modeBytes);
+    cmd.AddValue("redMinTh", "RED queue minimum threshold (in packets)", minTh);
+    cmd.AddValue("redMaxTh", "RED queue maximum threshold (in packets)", maxTh);
+    cmd.AddValue("nullmsg", "Use the null message synchronization instead of the granted time window", nullmsg);
+    cmd.Parse(argc, argv);
+
+    if (nullmsg)
+    {
+        GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::NullMessageSimulatorImpl"));
+    }
+    else
+    {
+        GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::DistributedSimulatorImpl"));
+    }
+    MpiInterface::Enable(&argc, &argv);
+    uint32_t systemId = MpiInterface::GetSystemId();
+    NS_ABORT_MSG_UNLESS(MpiInterface::GetSize() == 2, "1705079_base_mpi runs on exactly 2 ranks");
+
+    // default configuration
+    Config::SetDefault("ns3::OnOffApplication::PacketSize", UintegerValue(pktSize));
+    Config::SetDefault("ns3::OnOffApplication::DataRate", StringValue(appDataRate));
+    Config::SetDefault("ns3::DropTailQueue<Packet>::MaxSize",
+                       StringValue(std::to_string(maxPackets) + "p"));
+
+    if (!modeBytes)
+    {
+        Config::SetDefault(
+            "ns3::RedQueueDisc::MaxSize",
+            QueueSizeValue(QueueSize(QueueSizeUnit::PACKETS, queueDiscLimitPackets)));
+    }
+    else
+    {
+        Config::SetDefault(
+            "ns3::RedQueueDisc::MaxSize",
+            QueueSizeValue(QueueSize(QueueSizeUnit::BYTES, queueDiscLimitPackets * pktSize)));
+        minTh *= pktSize;
+        maxTh *= pktSize;
+    }
+
+    // default configuration for queue implementation
+    Config::SetDefault("ns3::RedQueueDisc::MinTh", DoubleValue(minTh));
+    Config::SetDefault("ns3::RedQueueDisc::MaxTh", DoubleValue(maxTh));
+    Config::SetDefault("ns3::RedQueueDisc::LinkBandwidth", StringValue(bottleNeckLinkBw));
+    Config::SetDefault("ns3::RedQueueDisc::LinkDelay", StringValue(bottleNeckLinkDelay));
+    Config::SetDefault("ns3::RedQueueDisc::MeanPktSize", UintegerValue(pktSize));
+
+    //  point-to-point link helpers
+    PointToPointHelper bottleNeckLink;
+    bottleNeckLink.SetDeviceAttribute("DataRate", StringValue(bottleNeckLinkBw));
+    bottleNeckLink.SetChannelAttribute("Delay", StringValue(bottleNeckLinkDelay));
+
+    PointToPointHelper pointToPointLeaf;
+    pointToPointLeaf.SetDeviceAttribute("DataRate", StringValue("5Mbps"));
+    pointToPointLeaf.SetChannelAttribute("Delay", StringValue("1ms"));
+
+    // same construction order as PointToPointDumbbellHelper, with every
+    // node owned by the rank of its side; all ranks build the whole
+    // topology, but only run the events of their own nodes
+    NodeContainer routers;
+    routers.Add(CreateObject<Node>(0));
+    routers.Add(CreateObject<Node>(1));
+    NodeContainer leftLeaves;
+    leftLeaves.Create(nLeftLeafCount, 0);
+    NodeContainer rightLeaves;
+    rightLeaves.Create(nRightLeafCount, 1);
+
+    // the routers are on different ranks: this is a remote channel
+    NetDeviceContainer routerDevices = bottleNeckLink.Install(routers);
+    NetDeviceContainer leftRouterDevices;
+    NetDeviceContainer leftLeafDevices;
+    for (uint32_t i = 0; i < nLeftLeafCount; ++i)
+    {
+        NetDeviceContainer c = pointToPointLeaf.Install(routers.Get(0), leftLeaves.Get(i));
+        leftRouterDevices.Add(c.Get(0));
+        leftLeafDevices.Add(c.Get(1));
+    }
+    NetDeviceContainer rightRouterDevices;
+    NetDeviceContainer rightLeafDevices;
+    for (uint32_t i = 0; i < nRightLeafCount; ++i)
+    {
+        NetDeviceContainer c = pointToPointLeaf.Install(routers.Get(1), rightLeaves.Get(i));
+        rightRouterDevices.Add(c.Get(0));
+        rightLeafDevices.Add(c.Get(1));
+    }
+
+    // protocol stack installation
+    InternetStackHelper stack;
+    stack.Install(leftLeaves);
+    stack.Install(rightLeaves);
+    stack.Install(routers);
+
+    TrafficControlHelper tchBottleneck;
+    QueueDiscContainer bottleneckQueueDiscs;
+    tchBottleneck.SetRootQueueDisc("ns3::RedQueueDisc");
+    bottleneckQueueDiscs.Add(tchBottleneck.Install(routers.Get(0)->GetDevice(0)));
+    bottleneckQueueDiscs.Add(tchBottleneck.Install(routers.Get(1)->GetDevice(0)));
+
+    // ip address assignment, as PointToPointDumbbellHelper::AssignIpv4Addresses
+    Ipv4AddressHelper leftIp("10.1.1.0", "255.255.255.0");
+    Ipv4AddressHelper rightIp("10.2.1.0", "255.255.255.0");
+    Ipv4AddressHelper routerIp("10.3.1.0", "255.255.255.0");
+    routerIp.Assign(routerDevices);
+    Ipv4InterfaceContainer leftLeafInterfaces;
+    for (uint32_t i = 0; i < nLeftLeafCount; ++i)
+    {
+        NetDeviceContainer ndc;
+        ndc.Add(leftLeafDevices.Get(i));
+        ndc.Add(leftRouterDevices.Get(i));
+        leftLeafInterfaces.Add(leftIp.Assign(ndc).Get(0));
+        leftIp.NewNetwork();
+    }
+    for (uint32_t i = 0; i < nRightLeafCount; ++i)
+    {
+        NetDeviceContainer ndc;
+        ndc.Add(rightLeafDevices.Get(i));
+        ndc.Add(rightRouterDevices.Get(i));
+        rightIp.Assign(ndc);
+        rightIp.NewNetwork();
+    }
+
+    // applications only on the nodes of this rank
+    ApplicationContainer sinkApps;
+    if (systemId == 0)
+    {
+        Address sinkLocalAddress(InetSocketAddress(Ipv4Address::GetAny(), port));
+        PacketSinkHelper packetSinkHelper("ns3::TcpSocketFactory", sinkLocalAddress);
+        sinkApps.Add(packetSinkHelper.Install(leftLeaves));
+        sinkApps.Start(Seconds(0.0));
+        sinkApps.Stop(Seconds(25.0));
+    }
+
+    ApplicationContainer clientApps;
+    if (systemId == 1)
+    {
+        OnOffHelper clientHelper("ns3::TcpSocketFactory", Address());
+        clientHelper.SetAttribute("OnTime", StringValue("ns3::UniformRandomVariable[Min=0.|Max=1.]"));
+        clientHelper.SetAttribute("OffTime", StringValue("ns3::UniformRandomVariable[Min=0.|Max=1.]"));
+        for (uint32_t i = 0; i < nRightLeafCount; ++i)
+        {
+            // on|off app installation to send packets
+            // more senders than sinks share the sinks, as in 1705079_base
+            AddressValue remoteAddress(InetSocketAddress(leftLeafInterfaces.GetAddress(i % nLeftLeafCount), port));
+            clientHelper.SetAttribute("Remote", remoteAddress);
+            clientApps.Add(clientHelper.Install(rightLeaves.Get(i)));
+        }
+        clientApps.Start(Seconds(2.0)); // Start 2 second after sink
+        clientApps.Stop(Seconds(10.0)); // Stop before the sink
+    }
+
+    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+
+    // same stream numbers as 1705079_base
+    int64_t stream = 1;
+    stream += stack.AssignStreams(NodeContainer::GetGlobal(), stream);
+    for (uint32_t i = 0; i < bottleneckQueueDiscs.GetN(); ++i)
+    {
+        stream += DynamicCast<RedQueueDisc>(bottleneckQueueDiscs.Get(i))->AssignStreams(stream);
+    }
+    for (uint32_t i = 0; i < clientApps.GetN(); ++i)
+    {
+        stream += DynamicCast<OnOffApplication>(clientApps.Get(i))->AssignStreams(stream);
+    }
+
+    // FlowMonitor needs every hop in one process; the endpoint monitor only
+    // needs the leaves of each rank, which send one direction (data on
+    // rank 1, ACKs on rank 0) and receive the other
+    EndpointFlowMonitor endpointMonitor;
+    NodeContainer &localLeaves = systemId == 0 ? leftLeaves : rightLeaves;
+    endpointMonitor.InstallSources(localLeaves);
+    endpointMonitor.InstallSinks(localLeaves);
+    endpointMonitor.InstallQueueDiscs(QueueDiscContainer(bottleneckQueueDiscs.Get(systemId)));
+
+    if (systemId == 0)
+    {
+        std::cout << "Running the simulation" << std::endl;
+    }
+    Simulator::Stop(Seconds(25.0));
+    Simulator::Run();
+
+    // rank 1 sends its counters to rank 0, which joins both directions by
+    // five-tuple
+    FlowStatsTable local;
+    endpointMonitor.Fill(local, Simulator::Now().GetNanoSeconds());
+    MPI_Comm comm = MpiInterface::GetCommunicator();
+    if (systemId == 1)
+    {
+        std::vector<char> buf;
+        FlowStatsFormat::EncodeHeader(buf);
+        FlowStatsFormat::EncodeBlock(local, 0, local.GetNRows(), buf);
+        uint64_t size = buf.size();
+        MPI_Send(&size, 1, MPI_UINT64_T, 0, 0, comm);
+        MPI_Send(buf.data(), static_cast<int>(size), MPI_CHAR, 0, 1, comm);
+
+        QueueDisc::Stats st = bottleneckQueueDiscs.Get(1)->GetStats();
+        std::cout << std::endl
+                  << "$$$ status showing bottleneck queue disc $$$" << std::endl;
+        std::cout << st << std::endl;
+    }
+    else
+    {
+        uint64_t size;
+        MPI_Recv(&size, 1, MPI_UINT64_T, 1, 0, comm, MPI_STATUS_IGNORE);
+        std::vector<char> buf(size);
+        MPI_Recv(buf.data(), static_cast<int>(size), MPI_CHAR, 1, 1, comm, MPI_STATUS_IGNORE);
+        FlowStatsTable remote;
+        std::string error;
+        NS_ABORT_MSG_UNLESS(FlowStatsReader::LoadBinary(buf.data(), buf.size(), remote, error),
+                            "Bad flow table from rank 1: " << error);
+
+        // each rank holds the sending end of one direction and the
+        // receiving end of the other: the data flows go from rank 1 to
+        // rank 0 and their ACK flows back, as 1705079_base counts both
+        FlatFlowTable<uint32_t> localRows;
+        for (std::size_t i = 0; i < local.GetNRows(); ++i)
+        {
+            localRows.FindOrInsert(RowKey(local, i)) = static_cast<uint32_t>(i) + 1;
+        }
+        FlatFlowTable<uint32_t> remoteRows;
+        for (std::size_t i = 0; i < remote.GetNRows(); ++i)
+        {
+            remoteRows.FindOrInsert(RowKey(remote, i)) = static_cast<uint32_t>(i) + 1;
+        }
+        const FlowStatsTable *txTables[] = {&remote, &local};
+        const FlowStatsTable *rxTables[] = {&local, &remote};
+        FlatFlowTable<uint32_t> *rxRows[] = {&localRows, &remoteRows};
+
+        uint32_t sentPackets = 0;
+        uint32_t receivedPackets = 0;
+        uint32_t lostPackets = 0;
+        uint32_t flow_count = 0;
+        float avgThroughput = 0.0;
+        Time delay;
+        for (int side = 0; side < 2; ++side)
+        {
+            const FlowStatsTable &tx = *txTables[side];
+            const FlowStatsTable &rx = *rxTables[side];
+            for (std::size_t i = 0; i < tx.GetNRows(); ++i)
+            {
+                if (tx.txPackets[i] == 0)
+                {
+                    // receiving end or only seen at the bottleneck, joined
+                    // from the other table
+                    continue;
+                }
+                const uint32_t *row = rxRows[side]->Find(RowKey(tx, i));
+                uint64_t rxPackets = row ? rx.rxPackets[*row - 1] : 0;
+                uint64_t rxBytes = row ? rx.rxBytes[*row - 1] : 0;
+                int64_t delaySumNs = row ? rx.delaySumNs[*row - 1] : 0;
+                int64_t lastRxNs = row ? rx.lastRxNs[*row - 1] : 0;
+                double duration = (lastRxNs - tx.firstTxNs[i]) / 1e9;
+
+                Ipv4Address sourceAddress = Ipv4Address::Deserialize(tx.srcAddress[i].data());
+                Ipv4Address destinationAddress = Ipv4Address::Deserialize(tx.dstAddress[i].data());
+                NS_LOG_UNCOND("\t\tFlow ID = " << tx.flowId[i]);
+                NS_LOG_UNCOND("sorce address = " << sourceAddress << " destination address = " << destinationAddress);
+                NS_LOG_UNCOND("sent packects = " << tx.txPackets[i]);
+                NS_LOG_UNCOND("received packets = " << rxPackets);
+                NS_LOG_UNCOND("lost packets = " << tx.txPackets[i] - rxPackets);
+                NS_LOG_UNCOND("packet delivery ratio = " << rxPackets * 100 / tx.txPackets[i] << "%");
+                NS_LOG_UNCOND("packet loss ratio = " << (tx.txPackets[i] - rxPackets) * 100 / tx.txPackets[i] << "%");
+                NS_LOG_UNCOND("delay = " << NanoSeconds(delaySumNs));
+                NS_LOG_UNCOND("throughput = " << rxBytes * 8.0 / duration / 1024 << "Kbps");
+
+                sentPackets = sentPackets + tx.txPackets[i];
+                receivedPackets = receivedPackets + rxPackets;
+                lostPackets = lostPackets + (tx.txPackets[i] - rxPackets);
+                avgThroughput = avgThroughput + (rxBytes * 8.0 / duration / 1024);
+                delay = delay + NanoSeconds(delaySumNs);
+
+                flow_count++;
+            }
+        }
+
+        avgThroughput = avgThroughput / flow_count;
+        NS_LOG_UNCOND("\t ****Total Results of the simulation****" << std::endl);
+        NS_LOG_UNCOND("Total sent packets  =" << sentPackets);
+        NS_LOG_UNCOND("Total Received Packets =" << receivedPackets);
+        NS_LOG_UNCOND("Total Lost Packets =" << lostPackets);
+        NS_LOG_UNCOND("Packet Loss ratio =" << ((lostPackets * 100) / sentPackets) << "%");
+        NS_LOG_UNCOND("Packet delivery ratio =" << ((receivedPackets * 100) / sentPackets) << "%");
+        NS_LOG_UNCOND("Average Throughput =" << avgThroughput << "Kbps");
+        NS_LOG_UNCOND("Average End to End Delay =" << delay / flow_count);
+        NS_LOG_UNCOND("Total flow count " << flow_count);
+    }
+
+    Simulator::Destroy();
+    MpiInterface::Disable();
+    return 0;
+#else
+    NS_FATAL_ERROR("1705079_base_mpi needs ns-3 configured with --enable-mpi");
+#endif
+}
@@ -0,0 +1,96 @@
+// author :  kazi wasif amin shammo 1705079
+// Checks of the CSV flow statistics reader on hand-written files
+//
+// Each case is a CSV text, the number of rows it must load (or -1 when it
+// must be rejected) and the last_rx_ns of its last row.  Every text is
+// written to a file and loaded with FlowStatsReader::Load; run under
+// AddressSanitizer or valgrind, a write past the end of the columns shows
+// too.  The program prints one line per case and exits with 1 if any
+// failed.
+//
+//   ./waf --run "scratch/1705079_flow_stats_check"
+
+#include "flow-stats-reader.h"
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+using namespace ns3;
+
+namespace
+{
+    struct Case
+    {
+        const char *name;
+        std::string body; // the lines after the header
+        long rows;
+        int64_t lastRxNs;
+    };
+
+    const char *ROW1 = "1000000,1,4,10.1.1.1,10.2.1.1,6,49153,9,10,9,5360,4824,1,0,100,10,0,900,50,950";
+    const char *ROW2 = "2000000,2,4,10.1.2.1,10.2.2.1,17,49154,9,20,20,10720,10720,0,0,200,20,0,1900,60,1960";
+
+    bool
+    Run(const Case &c)
+    {
+        const char *filename = "flow-stats-check.csv";
+        std::string text = std::string(FlowStatsFormat::CSV_HEADER) + "\n" + c.body;
+        std::FILE *f = std::fopen(filename, "wb");
+        if (!f || std::fwrite(text.data(), 1, text.size(), f) != text.size())
+        {
+            std::cout << "FAILED " << c.name << " (cannot write " << filename << ")" << std::endl;
+            return false;
+        }
+        std::fclose(f);
+
+        FlowStatsTable table;
+        std::string error;
+        bool ok = FlowStatsReader::Load(filename, table, error);
+        std::remove(filename);
+        bool pass;
+        if (c.rows < 0)
+        {
+            pass = !ok;
+        }
+        else
+        {
+            pass = ok && table.GetNRows() == static_cast<std::size_t>(c.rows) &&
+                   (c.rows == 0 || table.lastRxNs.back() == c.lastRxNs);
+        }
+        std::cout << (pass ? "ok     " : "FAILED ") << c.name;
+        if (!ok)
+        {
+            std::cout << " (" << error << ")";
+        }
+        else
+        {
+            std::cout << " (" << table.GetNRows() << " rows)";
+        }
+        std::cout << std::endl;
+        return pass;
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string r1 = ROW1;
+    std::string r2 = ROW2;
+    const Case cases[] = {
+        {"trailing newline", r1 + "\n" + r2 + "\n", 2, 1960},
+        {"no trailing newline", r1 + "\n" + r2, 2, 1960},
+        {"single row, no trailing newline", r1, 1, 950},
+        {"CRLF, no trailing newline", r1 + "\r\n" + r2, 2, 1960},
+        {"blank lines", r1 + "\n\n" + r2 + "\n\n", 2, 1960},
+        {"header only", "", 0, 0},
+        {"malformed last row, no trailing newline", r1 + "\n1000,2,4", -1, 0},
+    };
+
+    bool pass = true;
+    for (const Case &c : cases)
+    {
+        pass = Run(c) && pass;
+    }
+    std::cout << (pass ? "All cases passed" : "SOME CASES FAILED") << std::endl;
+    return pass ? 0 : 1;
+}
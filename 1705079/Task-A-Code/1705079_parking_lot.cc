@@ -0,0 +1,401 @@
+
+// author :  kazi wasif amin shammo 1705079
+// Parking-lot topology: a chain of routers, every chain link is a RED
+// (RRED) bottleneck, and each router has one host attached
+//
+//        h0        h1        h2              hN
+//        |         |         |               |
+//        r0 ====== r1 ====== r2 ==  ...  ==  rN
+//          hop 0     hop 1                hop N-1
+//
+// Long flows go from h0 to hN and cross every hop; at each hop h the cross
+// flows go from h to h + 1.  Low-rate DoS sources at the hops listed in
+// attackHops send UDP pulses from their host to hN.  Many flows share one
+// host, so the node count only grows with the number of hops.
+//
+// Addresses and routes are computed: access link i is the /30 10.128.0.0
+// + 4 i (host .1, router .2) and chain link h is the /30 10.0.0.0 + 4 h.
+// Each router has a default route to the right and covers the hosts on
+// its left with at most log2 (N) prefixes, so Ipv4GlobalRoutingHelper is
+// not needed.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/traffic-control-module.h"
+#include "ns3/flow-monitor-module.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+namespace
+{
+    const uint32_t HOST_BLOCK = Ipv4Address("10.128.0.0").Get();
+    const uint32_t CHAIN_BLOCK = Ipv4Address("10.0.0.0").Get();
+
+    Ipv4Address
+    HostAddress(uint32_t i)
+    {
+        return Ipv4Address(HOST_BLOCK + 4 * i + 1);
+    }
+
+    // Route the hosts [first, last) through nextHop with the fewest
+    // aligned prefixes
+    void
+    AddHostRangeRoutes(Ptr<Ipv4StaticRouting> routing, uint32_t first, uint32_t last,
+                       Ipv4Address nextHop, uint32_t interface)
+    {
+        while (first < last)
+        {
+            uint32_t size = 1;
+            while (first % (2 * size) == 0 && first + 2 * size <= last)
+            {
+                size *= 2;
+            }
+            // 4 addresses per host
+            uint32_t prefixMask = ~(4 * size - 1);
+            routing->AddNetworkRouteTo(Ipv4Address(HOST_BLOCK + 4 * first), Ipv4Mask(prefixMask),
+                                       nextHop, interface);
+            first += size;
+        }
+    }
+
+    std::set<uint32_t>
+    ParseHops(const std::string &list, uint32_t nHops)
+    {
+        std::set<uint32_t> hops;
+        std::istringstream is(list);
+        std::string item;
+        while (std::getline(is, item, ','))
+        {
+            if (item.empty())
+            {
+                continue;
+            }
+            uint32_t hop = std::stoul(item);
+            NS_ABORT_MSG_IF(hop >= nHops, "attackHops: hop " << hop << " does not exist");
+            hops.insert(hop);
+        }
+        return hops;
+    }
+
+    // Accumulated statistics of a class of flows
+    struct ClassStats
+    {
+        uint32_t nFlows = 0;
+        uint64_t txPackets = 0;
+        uint64_t rxPackets = 0;
+        uint64_t rxBytes = 0;
+        Time delaySum;
+    };
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // default values of the parameters
+    uint32_t nHops = 8;
+    uint32_t nLongFlows = 10;
+    uint32_t crossFlowsPerHop = 10;
+    std::string attackHops = "";
+    uint32_t attackersPerHop = 1;
+    std::string attackRate = "5Mbps";
+    double attackPeriod = 1.0;
+    double attackBurst = 0.1;
+    uint32_t pktSize = 1000;
+    std::string appDataRate = "1Mbps";
+    std::string hopLinkBw = "10Mbps";
+    std::string hopLinkDelay = "5ms";
+    std::string accessLinkBw = "1Gbps";
+    std::string accessLinkDelay = "1ms";
+    uint32_t queueDiscLimitPackets = 100;
+    double minTh = 20;
+    double maxTh = 60;
+    double stopTime = 30;
+
+    // options for arguments
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nHops", "Number of chain links (routers - 1)", nHops);
+    cmd.AddValue("nLongFlows", "TCP flows crossing every hop", nLongFlows);
+    cmd.AddValue("crossFlowsPerHop", "TCP flows entering at each hop and leaving at the next router",
+                 crossFlowsPerHop);
+    cmd.AddValue("attackHops", "Comma list of hops where low-rate DoS sources enter", attackHops);
+    cmd.AddValue("attackersPerHop", "Low-rate DoS sources at each attack hop", attackersPerHop);
+    cmd.AddValue("attackRate", "Rate of a low-rate DoS pulse", attackRate);
+    cmd.AddValue("attackPeriod", "Low-rate DoS pulse period in seconds", attackPeriod);
+    cmd.AddValue("attackBurst", "Low-rate DoS pulse length in seconds", attackBurst);
+    cmd.AddValue("appPktSize", "Set OnOff App Packet Size", pktSize);
+    cmd.AddValue("appDataRate", "Set OnOff App DataRate", appDataRate);
+    cmd.AddValue("hopLinkBw", "Chain link bandwidth", hopLinkBw);
+    cmd.AddValue("hopLinkDelay", "Chain link delay", hopLinkDelay);
+    cmd.AddValue("accessLinkBw", "Host access link bandwidth", accessLinkBw);
+    cmd.AddValue("accessLinkDelay", "Host access link delay", accessLinkDelay);
+    cmd.AddValue("queueDiscLimitPackets", "Max Packets allowed in each queue disc", queueDiscLimitPackets);
+    cmd.AddValue("redMinTh", "RED queue minimum threshold (in packets)", minTh);
+    cmd.AddValue("redMaxTh", "RED queue maximum threshold (in packets)", maxTh);
+    cmd.AddValue("stopTime", "Simulation time in seconds", stopTime);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_IF(nHops == 0, "nHops must be positive");
+    NS_ABORT_MSG_UNLESS(attackBurst > 0 && attackBurst < attackPeriod, "attackBurst must be in (0, attackPeriod)");
+    std::set<uint32_t> attackAt = ParseHops(attackHops, nHops);
+
+    // default configuration
+    Config::SetDefault("ns3::OnOffApplication::PacketSize", UintegerValue(pktSize));
+    Config::SetDefault("ns3::OnOffApplication::DataRate", StringValue(appDataRate));
+    Config::SetDefault("ns3::RedQueueDisc::MaxSize",
+                       QueueSizeValue(QueueSize(QueueSizeUnit::PACKETS, queueDiscLimitPackets)));
+    Config::SetDefault("ns3::RedQueueDisc::MinTh", DoubleValue(minTh));
+    Config::SetDefault("ns3::RedQueueDisc::MaxTh", DoubleValue(maxTh));
+    Config::SetDefault("ns3::RedQueueDisc::LinkBandwidth", StringValue(hopLinkBw));
+    Config::SetDefault("ns3::RedQueueDisc::LinkDelay", StringValue(hopLinkDelay));
+    Config::SetDefault("ns3::RedQueueDisc::MeanPktSize", UintegerValue(pktSize));
+
+    std::chrono::steady_clock::time_point setupStart = std::chrono::steady_clock::now();
+
+    NodeContainer routers;
+    routers.Create(nHops + 1);
+    NodeContainer hosts;
+    hosts.Create(nHops + 1);
+
+    PointToPointHelper hopLink;
+    hopLink.SetDeviceAttribute("DataRate", StringValue(hopLinkBw));
+    hopLink.SetChannelAttribute("Delay", StringValue(hopLinkDelay));
+    PointToPointHelper accessLink;
+    accessLink.SetDeviceAttribute("DataRate", StringValue(accessLinkBw));
+    accessLink.SetChannelAttribute("Delay", StringValue(accessLinkDelay));
+
+    std::vector<NetDeviceContainer> accessDevices(nHops + 1);
+    for (uint32_t i = 0; i <= nHops; ++i)
+    {
+        // router first
+        accessDevices[i] = accessLink.Install(routers.Get(i), hosts.Get(i));
+    }
+    std::vector<NetDeviceContainer> hopDevices(nHops);
+    for (uint32_t h = 0; h < nHops; ++h)
+    {
+        hopDevices[h] = hopLink.Install(routers.Get(h), routers.Get(h + 1));
+    }
+
+    // protocol stack installation, static routes only
+    InternetStackHelper stack;
+    stack.SetIpv6StackInstall(false);
+    stack.SetRoutingHelper(Ipv4StaticRoutingHelper());
+    stack.Install(routers);
+    stack.Install(hosts);
+
+    // one RED queue disc per hop in the forward direction, before the
+    // addresses, which install a default queue disc
+    TrafficControlHelper tchHop;
+    tchHop.SetRootQueueDisc("ns3::RedQueueDisc");
+    QueueDiscContainer hopQueueDiscs;
+    for (uint32_t h = 0; h < nHops; ++h)
+    {
+        hopQueueDiscs.Add(tchHop.Install(hopDevices[h].Get(0)));
+    }
+
+    // ip address assignment
+    Ipv4AddressHelper address;
+    Ipv4Mask linkMask("255.255.255.252");
+    for (uint32_t i = 0; i <= nHops; ++i)
+    {
+        // the router gets .2, like the hosts' gateway below
+        NetDeviceContainer swapped;
+        swapped.Add(accessDevices[i].Get(1));
+        swapped.Add(accessDevices[i].Get(0));
+        address.SetBase(Ipv4Address(HOST_BLOCK + 4 * i), linkMask);
+        address.Assign(swapped);
+    }
+    for (uint32_t h = 0; h < nHops; ++h)
+    {
+        address.SetBase(Ipv4Address(CHAIN_BLOCK + 4 * h), linkMask);
+        address.Assign(hopDevices[h]);
+    }
+
+    // chain routing
+    Ipv4StaticRoutingHelper staticRouting;
+    for (uint32_t i = 0; i <= nHops; ++i)
+    {
+        Ptr<Ipv4> hostIpv4 = hosts.Get(i)->GetObject<Ipv4>();
+        staticRouting.GetStaticRouting(hostIpv4)->SetDefaultRoute(
+            Ipv4Address(HOST_BLOCK + 4 * i + 2), hostIpv4->GetInterfaceForDevice(accessDevices[i].Get(1)));
+
+        Ptr<Ipv4> ipv4 = routers.Get(i)->GetObject<Ipv4>();
+        Ptr<Ipv4StaticRouting> routing = staticRouting.GetStaticRouting(ipv4);
+        if (i < nHops)
+        {
+            // hosts on the right
+            routing->SetDefaultRoute(Ipv4Address(CHAIN_BLOCK + 4 * i + 2),
+                                     ipv4->GetInterfaceForDevice(hopDevices[i].Get(0)));
+        }
+        if (i > 0)
+        {
+            AddHostRangeRoutes(routing, 0, i, Ipv4Address(CHAIN_BLOCK + 4 * (i - 1) + 1),
+                               ipv4->GetInterfaceForDevice(hopDevices[i - 1].Get(1)));
+        }
+    }
+
+    // applications
+    uint16_t port = 5001;
+    uint16_t attackPort = 5002;
+
+    Address sinkLocalAddress(InetSocketAddress(Ipv4Address::GetAny(), port));
+    PacketSinkHelper packetSinkHelper("ns3::TcpSocketFactory", sinkLocalAddress);
+    ApplicationContainer sinkApps;
+    for (uint32_t i = 1; i <= nHops; ++i)
+    {
+        sinkApps.Add(packetSinkHelper.Install(hosts.Get(i)));
+    }
+    PacketSinkHelper attackSinkHelper("ns3::UdpSocketFactory",
+                                      InetSocketAddress(Ipv4Address::GetAny(), attackPort));
+    sinkApps.Add(attackSinkHelper.Install(hosts.Get(nHops)));
+    sinkApps.Start(Seconds(0.0));
+    sinkApps.Stop(Seconds(stopTime));
+
+    OnOffHelper clientHelper("ns3::TcpSocketFactory", Address());
+    clientHelper.SetAttribute("OnTime", StringValue("ns3::UniformRandomVariable[Min=0.|Max=1.]"));
+    clientHelper.SetAttribute("OffTime", StringValue("ns3::UniformRandomVariable[Min=0.|Max=1.]"));
+    ApplicationContainer clientApps;
+    clientHelper.SetAttribute("Remote", AddressValue(InetSocketAddress(HostAddress(nHops), port)));
+    for (uint32_t k = 0; k < nLongFlows; ++k)
+    {
+        clientApps.Add(clientHelper.Install(hosts.Get(0)));
+    }
+    for (uint32_t h = 0; h < nHops; ++h)
+    {
+        clientHelper.SetAttribute("Remote", AddressValue(InetSocketAddress(HostAddress(h + 1), port)));
+        for (uint32_t k = 0; k < crossFlowsPerHop; ++k)
+        {
+            clientApps.Add(clientHelper.Install(hosts.Get(h)));
+        }
+    }
+    clientApps.Start(Seconds(1.0));
+    clientApps.Stop(Seconds(stopTime - 1));
+
+    // low-rate DoS: square wave pulses of attackBurst every attackPeriod
+    OnOffHelper attackHelper("ns3::UdpSocketFactory", InetSocketAddress(HostAddress(nHops), attackPort));
+    attackHelper.SetConstantRate(DataRate(attackRate), pktSize);
+    attackHelper.SetAttribute("OnTime", StringValue("ns3::ConstantRandomVariable[Constant=" +
+                                                    std::to_string(attackBurst) + "]"));
+    attackHelper.SetAttribute("OffTime", StringValue("ns3::ConstantRandomVariable[Constant=" +
+                                                     std::to_string(attackPeriod - attackBurst) + "]"));
+    ApplicationContainer attackApps;
+    for (uint32_t h : attackAt)
+    {
+        for (uint32_t k = 0; k < attackersPerHop; ++k)
+        {
+            attackApps.Add(attackHelper.Install(hosts.Get(h)));
+        }
+    }
+    attackApps.Start(Seconds(2.0));
+    attackApps.Stop(Seconds(stopTime - 1));
+
+    std::chrono::duration<double> setupTime = std::chrono::steady_clock::now() - setupStart;
+    std::cout << "Parking lot with " << nHops << " hops and " << clientApps.GetN() + attackApps.GetN()
+              << " flows built in " << setupTime.count() << "s" << std::endl;
+
+    // end-to-end statistics: only the hosts are monitored
+    FlowMonitorHelper flow_helper;
+    Ptr<FlowMonitor> flow_monitor = flow_helper.Install(hosts);
+
+    std::cout << "Running the simulation" << std::endl;
+    Simulator::Stop(Seconds(stopTime));
+    Simulator::Run();
+
+    // classify the flows by their end hosts
+    Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier>(flow_helper.GetClassifier());
+    ClassStats longFlows;
+    ClassStats crossFlows;
+    ClassStats attackFlows;
+    for (const std::pair<const FlowId, FlowMonitor::FlowStats> &entry : flow_monitor->GetFlowStats())
+    {
+        Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow(entry.first);
+        uint32_t src = (t.sourceAddress.Get() - HOST_BLOCK) / 4;
+        uint32_t dst = (t.destinationAddress.Get() - HOST_BLOCK) / 4;
+        ClassStats *c;
+        if (t.destinationPort == attackPort)
+        {
+            c = &attackFlows;
+        }
+        else if (t.destinationPort != port)
+        {
+            // ACKs
+            continue;
+        }
+        else if (src == 0 && dst == nHops)
+        {
+            c = &longFlows;
+        }
+        else
+        {
+            c = &crossFlows;
+        }
+        const FlowMonitor::FlowStats &fs = entry.second;
+        c->nFlows++;
+        c->txPackets += fs.txPackets;
+        c->rxPackets += fs.rxPackets;
+        c->rxBytes += fs.rxBytes;
+        c->delaySum += fs.delaySum;
+    }
+
+    double duration = stopTime - 2;
+    const char *names[] = {"Long", "Cross", "Attack"};
+    const ClassStats *classes[] = {&longFlows, &crossFlows, &attackFlows};
+    for (uint32_t k = 0; k < 3; ++k)
+    {
+        const ClassStats &c = *classes[k];
+        if (c.nFlows == 0)
+        {
+            continue;
+        }
+        NS_LOG_UNCOND(names[k] << " flows = " << c.nFlows);
+        NS_LOG_UNCOND(names[k] << " goodput per flow = " << c.rxBytes * 8.0 / duration / 1024 / c.nFlows << "Kbps");
+        NS_LOG_UNCOND(names[k] << " loss ratio = " << (c.txPackets > 0 ? (c.txPackets - c.rxPackets) * 100.0 / c.txPackets : 0)
+                               << "%");
+        NS_LOG_UNCOND(names[k] << " mean delay = " << (c.rxPackets > 0 ? c.delaySum / c.rxPackets : Time()));
+    }
+
+    // per-hop queue disc statistics
+    std::ofstream hopStats("parking_lot_hops.csv");
+    hopStats << "hop,received,unforced_drops,forced_drops,queue_avg" << std::endl;
+    uint64_t unforced = 0;
+    uint64_t forced = 0;
+    uint32_t worstHop = 0;
+    uint64_t worstDrops = 0;
+    for (uint32_t h = 0; h < nHops; ++h)
+    {
+        Ptr<RedQueueDisc> red = DynamicCast<RedQueueDisc>(hopQueueDiscs.Get(h));
+        QueueDisc::Stats st = red->GetStats();
+        uint64_t u = st.GetNDroppedPackets(RedQueueDisc::UNFORCED_DROP);
+        uint64_t f = st.GetNDroppedPackets(RedQueueDisc::FORCED_DROP);
+        hopStats << h << "," << st.nTotalReceivedPackets << "," << u << "," << f << ","
+                 << red->GetQueueAverage() << std::endl;
+        unforced += u;
+        forced += f;
+        if (u + f > worstDrops)
+        {
+            worstDrops = u + f;
+            worstHop = h;
+        }
+    }
+
+    uint64_t legitTx = longFlows.txPackets + crossFlows.txPackets;
+    uint64_t legitRx = longFlows.rxPackets + crossFlows.rxPackets;
+    NS_LOG_UNCOND("\t ****Total Results of the simulation****" << std::endl);
+    NS_LOG_UNCOND("Total legitimate goodput =" << (longFlows.rxBytes + crossFlows.rxBytes) * 8.0 / duration / 1024 << "Kbps");
+    NS_LOG_UNCOND("Total legitimate loss ratio =" << (legitTx > 0 ? (legitTx - legitRx) * 100.0 / legitTx : 0) << "%");
+    NS_LOG_UNCOND("Total unforced drops =" << unforced);
+    NS_LOG_UNCOND("Total forced drops =" << forced);
+    NS_LOG_UNCOND("Most dropping hop " << worstHop << " with " << worstDrops << " drops");
+
+    std::cout << "Destroying the simulation" << std::endl;
+    Simulator::Destroy();
+    return 0;
+}
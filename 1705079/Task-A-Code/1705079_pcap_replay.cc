@@ -0,0 +1,492 @@
+
+// author :  kazi wasif amin shammo 1705079
+// Offline replay of a pcap capture through RedQueueDisc
+//
+// No nodes and no devices: the capture is memory-mapped and every IPv4
+// packet becomes an Ipv4QueueDiscItem, enqueued at its capture time
+// (relative to the first packet).  The queue disc is served at linkBw.
+//
+// Headers are parsed in place in the mapping; the payload is never
+// copied, the item carries a zero-filled payload of the same length
+// (ns-3 stores it as a virtual zero area).  Only one simulator event is
+// pending at a time: each step handles the next arrival or the next end
+// of transmission, whichever comes first, so the virtual clock jumps
+// directly from one capture timestamp to the next.  Packets captured at
+// the same time are handed to RedQueueDisc::EnqueueBatch together.
+//
+// Outputs:
+//   - decisions (optional): one line per packet with the RED decision;
+//   - stats (optional): queue length, average and drops every statsInterval;
+//   - the queue disc statistics and the replay rate on standard output.
+//
+//   ./waf --run "scratch/1705079_pcap_replay --pcap=trace.pcap --linkBw=100Mbps --variant=rred
+//                --redMinTh=50 --redMaxTh=150 --decisions=decisions.csv"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/traffic-control-module.h"
+
+#include "pcap-mmap-reader.h"
+#include "red-variant.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+namespace
+{
+    // Fields of an IPv4 packet read from the capture
+    struct ParsedPacket
+    {
+        uint32_t src;
+        uint32_t dst;
+        uint8_t protocol;
+        uint8_t tos;
+        uint8_t ttl;
+        uint8_t tcpFlags;
+        uint16_t id;
+        uint16_t totalLength;
+        uint16_t headerLength;
+        uint16_t srcPort;
+        uint16_t dstPort;
+    };
+
+    inline uint16_t
+    Read16(const uint8_t *p)
+    {
+        return static_cast<uint16_t>(p[0] << 8 | p[1]);
+    }
+
+    inline uint32_t
+    Read32(const uint8_t *p)
+    {
+        return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 |
+               static_cast<uint32_t>(p[2]) << 8 | p[3];
+    }
+
+    // Offset of the IPv4 header, or -1 if the frame does not carry IPv4
+    int
+    NetworkOffset(const PcapRecord &r, uint32_t linkType)
+    {
+        const uint8_t *d = r.data;
+        uint32_t n = r.capLen;
+        switch (linkType)
+        {
+        case PcapMmapReader::LINKTYPE_ETHERNET:
+        {
+            uint32_t off = 12;
+            while (off + 2 <= n && (Read16(d + off) == 0x8100 || Read16(d + off) == 0x88a8))
+            {
+                off += 4;
+            }
+            return off + 2 <= n && Read16(d + off) == 0x0800 ? static_cast<int>(off + 2) : -1;
+        }
+        case PcapMmapReader::LINKTYPE_PPP:
+        {
+            uint32_t off = n >= 2 && d[0] == 0xff && d[1] == 0x03 ? 2 : 0;
+            return off + 2 <= n && Read16(d + off) == 0x0021 ? static_cast<int>(off + 2) : -1;
+        }
+        case PcapMmapReader::LINKTYPE_LINUX_SLL:
+            return n >= 16 && Read16(d + 14) == 0x0800 ? 16 : -1;
+        case PcapMmapReader::LINKTYPE_RAW:
+        case PcapMmapReader::LINKTYPE_IPV4:
+            return n >= 1 && d[0] >> 4 == 4 ? 0 : -1;
+        default:
+            return -1;
+        }
+    }
+
+    bool
+    Parse(const PcapRecord &r, uint32_t linkType, ParsedPacket &pkt)
+    {
+        int off = NetworkOffset(r, linkType);
+        if (off < 0 || static_cast<uint32_t>(off) + 20 > r.capLen)
+        {
+            return false;
+        }
+        const uint8_t *ip = r.data + off;
+        if (ip[0] >> 4 != 4)
+        {
+            return false;
+        }
+        pkt.headerLength = (ip[0] & 0x0f) * 4;
+        pkt.tos = ip[1];
+        pkt.totalLength = Read16(ip + 2);
+        pkt.id = Read16(ip + 4);
+        pkt.ttl = ip[8];
+        pkt.protocol = ip[9];
+        pkt.src = Read32(ip + 12);
+        pkt.dst = Read32(ip + 16);
+        pkt.srcPort = 0;
+        pkt.dstPort = 0;
+        pkt.tcpFlags = 0;
+        if (pkt.headerLength < 20 || pkt.totalLength < pkt.headerLength)
+        {
+            return false;
+        }
+        // ports only if captured; a truncated capture keeps the IP fields
+        const uint8_t *l4 = ip + pkt.headerLength;
+        uint32_t l4Captured = r.capLen - off > pkt.headerLength ? r.capLen - off - pkt.headerLength : 0;
+        if ((pkt.protocol == 6 || pkt.protocol == 17) && l4Captured >= 4)
+        {
+            pkt.srcPort = Read16(l4);
+            pkt.dstPort = Read16(l4 + 2);
+        }
+        if (pkt.protocol == 6 && l4Captured >= 14)
+        {
+            pkt.tcpFlags = l4[13];
+        }
+        return true;
+    }
+
+    Ptr<QueueDiscItem>
+    MakeItem(const ParsedPacket &pkt)
+    {
+        uint32_t l4Length = pkt.totalLength - pkt.headerLength;
+        Ptr<Packet> p;
+        if (pkt.protocol == 6 && l4Length >= 20)
+        {
+            // options are folded into the zero payload
+            p = Create<Packet>(l4Length - 20);
+            TcpHeader h;
+            h.SetSourcePort(pkt.srcPort);
+            h.SetDestinationPort(pkt.dstPort);
+            h.SetFlags(pkt.tcpFlags);
+            p->AddHeader(h);
+        }
+        else if (pkt.protocol == 17 && l4Length >= 8)
+        {
+            p = Create<Packet>(l4Length - 8);
+            UdpHeader h;
+            h.SetSourcePort(pkt.srcPort);
+            h.SetDestinationPort(pkt.dstPort);
+            p->AddHeader(h);
+        }
+        else
+        {
+            p = Create<Packet>(l4Length);
+        }
+        Ipv4Header ip;
+        ip.SetSource(Ipv4Address(pkt.src));
+        ip.SetDestination(Ipv4Address(pkt.dst));
+        ip.SetProtocol(pkt.protocol);
+        ip.SetTos(pkt.tos);
+        ip.SetTtl(pkt.ttl);
+        ip.SetIdentification(pkt.id);
+        ip.SetPayloadSize(l4Length);
+        return Create<Ipv4QueueDiscItem>(p, Address(), Ipv4L3Protocol::PROT_NUMBER, ip);
+    }
+
+    /**
+     * Replay state; events are bound to a raw pointer, so it must outlive
+     * Simulator::Run ()
+     */
+    class Replay
+    {
+    public:
+        Replay(Ptr<RedQueueDisc> queueDisc, PcapMmapReader &reader, DataRate rate, uint64_t maxPackets)
+            : m_queueDisc(queueDisc),
+              m_reader(reader),
+              m_rate(rate),
+              m_maxPackets(maxPackets),
+              m_firstNs(-1),
+              m_pending(false),
+              m_nRead(0),
+              m_nIpv4(0),
+              m_nReplayed(0),
+              m_nSkipped(0),
+              m_cursor(0),
+              m_decisions(0),
+              m_stats(0)
+        {
+            m_queueDisc->TraceConnectWithoutContext("DropBeforeEnqueue", MakeCallback(&Replay::OnDrop, this));
+            m_queueDisc->TraceConnectWithoutContext("Mark", MakeCallback(&Replay::OnMark, this));
+        }
+
+        void SetDecisionFile(std::FILE *f)
+        {
+            m_decisions = f;
+            std::fprintf(f, "time_ns,src,dst,protocol,src_port,dst_port,size,decision\n");
+        }
+
+        void SetStatsFile(std::FILE *f, Time interval)
+        {
+            m_stats = f;
+            m_statsInterval = interval;
+            std::fprintf(f, "time_ns,packets,bytes,queue_avg,dropped,marked\n");
+        }
+
+        void Start(void)
+        {
+            ReadNext();
+            if (m_pending)
+            {
+                Simulator::Schedule(m_pendingTime, &Replay::Step, this);
+            }
+            if (m_stats)
+            {
+                Simulator::Schedule(Seconds(0), &Replay::Sample, this);
+            }
+        }
+
+        uint64_t GetNRead(void) const
+        {
+            return m_nRead;
+        }
+
+        uint64_t GetNReplayed(void) const
+        {
+            return m_nReplayed;
+        }
+
+        uint64_t GetNSkipped(void) const
+        {
+            return m_nSkipped;
+        }
+
+    private:
+        void ReadNext(void)
+        {
+            m_pending = false;
+            PcapRecord r;
+            while ((m_maxPackets == 0 || m_nIpv4 < m_maxPackets) && m_reader.Next(r))
+            {
+                m_nRead++;
+                if (!Parse(r, m_reader.GetLinkType(), m_next))
+                {
+                    m_nSkipped++;
+                    continue;
+                }
+                m_nIpv4++;
+                if (m_firstNs < 0)
+                {
+                    m_firstNs = r.timeNs;
+                }
+                // captures are not always in time order: never go back
+                m_pendingTime = std::max(NanoSeconds(r.timeNs - m_firstNs), Simulator::Now());
+                m_pending = true;
+                return;
+            }
+        }
+
+        void Step(void)
+        {
+            Time now = Simulator::Now();
+            if (m_pending && m_pendingTime <= now)
+            {
+                Arrive();
+            }
+            if (m_linkFreeAt <= now)
+            {
+                Ptr<QueueDiscItem> item = m_queueDisc->Dequeue();
+                if (item)
+                {
+                    m_linkFreeAt = now + m_rate.CalculateBytesTxTime(item->GetSize());
+                }
+            }
+
+            Time next = Time::Max();
+            if (m_pending)
+            {
+                next = m_pendingTime;
+            }
+            if (m_queueDisc->GetNPackets() > 0)
+            {
+                next = std::min(next, std::max(m_linkFreeAt, now));
+            }
+            if (next != Time::Max())
+            {
+                Simulator::Schedule(next - now, &Replay::Step, this);
+            }
+            else
+            {
+                // the stats sampler and adaptive RED have periodic events
+                Simulator::Stop();
+            }
+        }
+
+        // all the packets captured at the current time form one batch
+        void Arrive(void)
+        {
+            Time now = Simulator::Now();
+            m_batch.clear();
+            m_batchPackets.clear();
+            while (m_pending && m_pendingTime == now)
+            {
+                m_batch.push_back(MakeItem(m_next));
+                m_batchPackets.push_back(m_next);
+                ReadNext();
+            }
+            m_reasons.assign(m_batch.size(), static_cast<const char *>(0));
+            m_cursor = 0;
+            m_queueDisc->EnqueueBatch(m_batch);
+            m_nReplayed += m_batch.size();
+            if (m_decisions)
+            {
+                for (std::size_t i = 0; i < m_batch.size(); ++i)
+                {
+                    const ParsedPacket &pkt = m_batchPackets[i];
+                    std::fprintf(m_decisions, "%lld,%u.%u.%u.%u,%u.%u.%u.%u,%u,%u,%u,%u,%s\n",
+                                 static_cast<long long>(now.GetNanoSeconds()),
+                                 pkt.src >> 24, (pkt.src >> 16) & 0xff, (pkt.src >> 8) & 0xff, pkt.src & 0xff,
+                                 pkt.dst >> 24, (pkt.dst >> 16) & 0xff, (pkt.dst >> 8) & 0xff, pkt.dst & 0xff,
+                                 pkt.protocol, pkt.srcPort, pkt.dstPort, m_batch[i]->GetSize(),
+                                 m_reasons[i] ? m_reasons[i] : "enqueue");
+                }
+            }
+        }
+
+        // traces fire in batch order: find the item from the last one seen
+        void SetReason(Ptr<const QueueDiscItem> item, const char *reason)
+        {
+            while (m_cursor < m_batch.size() && m_batch[m_cursor] != item)
+            {
+                m_cursor++;
+            }
+            if (m_cursor < m_batch.size())
+            {
+                m_reasons[m_cursor] = reason;
+            }
+        }
+
+        void Sample(void)
+        {
+            const QueueDisc::Stats &st = m_queueDisc->GetStats();
+            std::fprintf(m_stats, "%lld,%u,%u,%g,%u,%u\n", static_cast<long long>(Simulator::Now().GetNanoSeconds()),
+                         m_queueDisc->GetNPackets(), m_queueDisc->GetNBytes(), m_queueDisc->GetQueueAverage(),
+                         st.nTotalDroppedPackets, st.nTotalMarkedPackets);
+            Simulator::Schedule(m_statsInterval, &Replay::Sample, this);
+        }
+
+        void OnDrop(Ptr<const QueueDiscItem> item, const char *reason)
+        {
+            SetReason(item, reason);
+        }
+
+        void OnMark(Ptr<const QueueDiscItem> item, const char *reason)
+        {
+            SetReason(item, reason);
+        }
+
+        Ptr<RedQueueDisc> m_queueDisc; //!< Queue disc under test
+        PcapMmapReader &m_reader;      //!< Capture
+        DataRate m_rate;               //!< Service rate
+        uint64_t m_maxPackets;         //!< Packets to replay, 0 for all
+        int64_t m_firstNs;             //!< Time of the first packet
+        bool m_pending;                //!< m_next holds a packet
+        ParsedPacket m_next;           //!< Next packet
+        Time m_pendingTime;            //!< Its arrival time
+        Time m_linkFreeAt;             //!< End of the current transmission
+        uint64_t m_nRead;              //!< Records read
+        uint64_t m_nIpv4;              //!< IPv4 records read
+        uint64_t m_nReplayed;          //!< Packets enqueued or dropped
+        uint64_t m_nSkipped;           //!< Records that are not IPv4
+        std::vector<Ptr<QueueDiscItem>> m_batch; //!< Items arriving now
+        std::vector<ParsedPacket> m_batchPackets; //!< Their fields
+        std::vector<const char *> m_reasons;      //!< Their drop or mark reasons
+        std::size_t m_cursor;                     //!< Last item seen by the traces
+        std::FILE *m_decisions;        //!< Decision output
+        std::FILE *m_stats;            //!< Queue statistics output
+        Time m_statsInterval;          //!< Queue statistics interval
+    };
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // default values of the parameters
+    std::string pcap = "";
+    std::string variant = "rred";
+    std::string linkBw = "10Mbps";
+    uint32_t queueDiscLimitPackets = 100;
+    double minTh = 20;
+    double maxTh = 60;
+    uint32_t meanPktSize = 1000;
+    bool useEcn = false;
+    uint64_t maxPackets = 0;
+    std::string decisions = "";
+    std::string stats = "";
+    double statsInterval = 0.01;
+
+    // options for arguments
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("pcap", "Capture to replay (pcap, not pcapng)", pcap);
+    cmd.AddValue("variant", "RED variant: red, ared, feng, nlred or rred", variant);
+    cmd.AddValue("linkBw", "Bottleneck rate serving the queue disc", linkBw);
+    cmd.AddValue("queueDiscLimitPackets", "Max Packets allowed in the queue disc", queueDiscLimitPackets);
+    cmd.AddValue("redMinTh", "RED queue minimum threshold (in packets)", minTh);
+    cmd.AddValue("redMaxTh", "RED queue maximum threshold (in packets)", maxTh);
+    cmd.AddValue("meanPktSize", "RED mean packet size", meanPktSize);
+    cmd.AddValue("useEcn", "Mark ECN capable packets instead of dropping them", useEcn);
+    cmd.AddValue("maxPackets", "Packets to replay (0 for the whole capture)", maxPackets);
+    cmd.AddValue("decisions", "Per-packet decision output, csv (empty for none)", decisions);
+    cmd.AddValue("stats", "Queue statistics output, csv (empty for none)", stats);
+    cmd.AddValue("statsInterval", "Queue statistics interval in seconds", statsInterval);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_IF(pcap.empty(), "--pcap is required");
+    NS_ABORT_MSG_IF(!stats.empty() && statsInterval <= 0, "statsInterval must be positive");
+
+    PcapMmapReader reader;
+    std::string error;
+    NS_ABORT_MSG_UNLESS(reader.Open(pcap, error), error);
+
+    // default configuration for queue implementation
+    Config::SetDefault("ns3::RedQueueDisc::MaxSize",
+                       QueueSizeValue(QueueSize(QueueSizeUnit::PACKETS, queueDiscLimitPackets)));
+    Config::SetDefault("ns3::RedQueueDisc::MinTh", DoubleValue(minTh));
+    Config::SetDefault("ns3::RedQueueDisc::MaxTh", DoubleValue(maxTh));
+    Config::SetDefault("ns3::RedQueueDisc::LinkBandwidth", StringValue(linkBw));
+    Config::SetDefault("ns3::RedQueueDisc::MeanPktSize", UintegerValue(meanPktSize));
+    Config::SetDefault("ns3::RedQueueDisc::UseEcn", BooleanValue(useEcn));
+
+    ObjectFactory factory;
+    factory.SetTypeId(RedQueueDisc::GetTypeId());
+    RedVariant::Parse(variant).Apply(factory);
+    Ptr<RedQueueDisc> queueDisc = factory.Create<RedQueueDisc>();
+    queueDisc->Initialize();
+
+    Replay replay(queueDisc, reader, DataRate(linkBw), maxPackets);
+    std::FILE *decisionFile = 0;
+    std::FILE *statsFile = 0;
+    if (!decisions.empty())
+    {
+        decisionFile = std::fopen(decisions.c_str(), "w");
+        NS_ABORT_MSG_UNLESS(decisionFile, "Cannot open " << decisions);
+        replay.SetDecisionFile(decisionFile);
+    }
+    if (!stats.empty())
+    {
+        statsFile = std::fopen(stats.c_str(), "w");
+        NS_ABORT_MSG_UNLESS(statsFile, "Cannot open " << stats);
+        replay.SetStatsFile(statsFile, Seconds(statsInterval));
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    replay.Start();
+    Simulator::Run();
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+    Time replayed = Simulator::Now();
+
+    if (decisionFile)
+    {
+        std::fclose(decisionFile);
+    }
+    if (statsFile)
+    {
+        std::fclose(statsFile);
+    }
+
+    std::cout << "Replayed " << replay.GetNReplayed() << " packets of " << replay.GetNRead() << " records ("
+              << replay.GetNSkipped() << " not IPv4), " << replayed.GetSeconds() << "s of traffic in "
+              << wall.count() << "s, " << replay.GetNReplayed() / wall.count() / 1e6 << " Mpps" << std::endl;
+    std::cout << std::endl
+              << "$$$ status showing replayed queue disc $$$" << std::endl;
+    std::cout << queueDisc->GetStats() << std::endl;
+
+    Simulator::Destroy();
+    return 0;
+}
@@ -0,0 +1,226 @@
+
+// author :  kazi wasif amin shammo 1705079
+// RED for thousands of virtual output queues: RedBank against one
+// RedEngine per queue
+//
+// A switch fabric is modelled in time slots.  In every slot each queue
+// receives a packet with probability `arrival` and sends one with
+// probability `service`; the arrivals of a slot are decided together.
+// The same slots (same random draws) are run through:
+//
+//   - engines: one heap-allocated RedEngine per queue, as many separate
+//     RedQueueDisc objects would have;
+//   - bank scalar: a RedBank with the scalar kernel;
+//   - bank simd: a RedBank with the AVX2 kernel (if the processor has it).
+//
+// The program reports the decision rate of each and checks that the three
+// made the same decisions.
+//
+//   ./waf --run "scratch/1705079_red_bank_bench --queues=4096 --slots=20000 --variant=feng"
+
+#include "ns3/core-module.h"
+
+#include "red-bank.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace ns3;
+
+namespace
+{
+    // Arrivals and services of every slot, drawn once for all the runs
+    struct Slots
+    {
+        std::vector<uint8_t> arrived;
+        std::vector<uint8_t> served;
+        std::vector<double> u;
+    };
+
+    // Result of one run
+    struct Result
+    {
+        double seconds;
+        uint64_t arrivals;
+        uint64_t drops;
+        std::vector<uint8_t> decisions;
+    };
+
+    // Queue lengths follow the decisions: admitted packets join, served
+    // packets leave
+    void
+    Advance(std::vector<uint32_t> &lengths, const uint8_t *arrived, const uint8_t *served, const uint8_t *dropType,
+            uint32_t limit)
+    {
+        for (std::size_t q = 0; q < lengths.size(); ++q)
+        {
+            if (arrived[q] && dropType[q] == RedEngine::DTYPE_NONE && lengths[q] < limit)
+            {
+                lengths[q]++;
+            }
+            if (served[q] && lengths[q] > 0)
+            {
+                lengths[q]--;
+            }
+        }
+    }
+
+    Result
+    RunEngines(const RedConfig &config, const Slots &slots, std::size_t nQueues, uint32_t nSlots, uint32_t limit,
+               int64_t slotNs)
+    {
+        std::vector<std::unique_ptr<RedEngine>> engines;
+        for (std::size_t q = 0; q < nQueues; ++q)
+        {
+            engines.push_back(std::unique_ptr<RedEngine>(new RedEngine()));
+            engines.back()->Initialize(config);
+        }
+        std::vector<uint32_t> lengths(nQueues, 0);
+        std::vector<uint8_t> dropType(nQueues);
+        Result r = {0, 0, 0, std::vector<uint8_t>()};
+        r.decisions.reserve(slots.arrived.size());
+
+        for (uint32_t s = 0; s < nSlots; ++s)
+        {
+            std::size_t base = s * nQueues;
+            // adaptation is a timer, not part of the arrivals
+            for (std::size_t q = 0; q < nQueues; ++q)
+            {
+                engines[q]->AdaptUntil(s * slotNs);
+            }
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (std::size_t q = 0; q < nQueues; ++q)
+            {
+                dropType[q] = RedEngine::DTYPE_NONE;
+                if (slots.arrived[base + q])
+                {
+                    // the draw of the slot, as the bank uses it
+                    struct Draw
+                    {
+                        double u;
+                        double operator()(void)
+                        {
+                            return u;
+                        }
+                    } draw = {slots.u[base + q]};
+                    dropType[q] = engines[q]->Decide(s * slotNs, lengths[q], 0, 0, 0, draw).dropType;
+                }
+            }
+            r.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            Advance(lengths, &slots.arrived[base], &slots.served[base], dropType.data(), limit);
+            r.decisions.insert(r.decisions.end(), dropType.begin(), dropType.end());
+        }
+        return r;
+    }
+
+    Result
+    RunBank(const RedConfig &config, bool simd, const Slots &slots, std::size_t nQueues, uint32_t nSlots,
+            uint32_t limit, int64_t slotNs)
+    {
+        RedBank bank(nQueues, config);
+        bank.SetSimd(simd);
+        std::vector<uint32_t> lengths(nQueues, 0);
+        std::vector<uint8_t> dropType(nQueues);
+        Result r = {0, 0, 0, std::vector<uint8_t>()};
+        r.decisions.reserve(slots.arrived.size());
+
+        for (uint32_t s = 0; s < nSlots; ++s)
+        {
+            std::size_t base = s * nQueues;
+            bank.AdaptUntil(s * slotNs);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            bank.Arrive(s * slotNs, 0, nQueues, &slots.arrived[base], lengths.data(), &slots.u[base],
+                        dropType.data());
+            r.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            Advance(lengths, &slots.arrived[base], &slots.served[base], dropType.data(), limit);
+            r.decisions.insert(r.decisions.end(), dropType.begin(), dropType.end());
+        }
+        return r;
+    }
+
+    void
+    Count(Result &r, const Slots &slots)
+    {
+        for (std::size_t i = 0; i < r.decisions.size(); ++i)
+        {
+            r.arrivals += slots.arrived[i];
+            r.drops += r.decisions[i] != RedEngine::DTYPE_NONE;
+        }
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // default values of the parameters
+    uint32_t nQueues = 4096;
+    uint32_t nSlots = 10000;
+    double arrival = 0.6;
+    double service = 0.5;
+    uint32_t limit = 100;
+    double minTh = 20;
+    double maxTh = 60;
+    std::string variant = "red";
+
+    // options for arguments
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("queues", "Number of virtual queues", nQueues);
+    cmd.AddValue("slots", "Number of time slots", nSlots);
+    cmd.AddValue("arrival", "Probability of an arrival per queue and slot", arrival);
+    cmd.AddValue("service", "Probability of a departure per queue and slot", service);
+    cmd.AddValue("limit", "Queue capacity in packets", limit);
+    cmd.AddValue("redMinTh", "RED queue minimum threshold (in packets)", minTh);
+    cmd.AddValue("redMaxTh", "RED queue maximum threshold (in packets)", maxTh);
+    cmd.AddValue("variant", "RED variant: red, ared, feng or nlred", variant);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_IF(nQueues == 0 || nSlots == 0, "queues and slots must be positive");
+    NS_ABORT_MSG_IF(variant == "rred", "RedBank has no RRED filter");
+
+    RedConfig config;
+    config.minTh = minTh;
+    config.maxTh = maxTh;
+    config.isRRED = false;
+    config.isARED = variant == "ared";
+    config.isFengAdaptive = variant == "feng";
+    config.isNonlinear = variant == "nlred";
+    NS_ABORT_MSG_UNLESS(variant == "red" || config.isARED || config.isFengAdaptive || config.isNonlinear,
+                        "Unknown RED variant " << variant);
+    // a slot carries one packet per queue at the link rate
+    int64_t slotNs = static_cast<int64_t>(8e9 * config.meanPktSize / config.linkBitRate);
+
+    Slots slots;
+    std::size_t total = static_cast<std::size_t>(nQueues) * nSlots;
+    slots.arrived.resize(total);
+    slots.served.resize(total);
+    slots.u.resize(total);
+    Ptr<UniformRandomVariable> uv = CreateObject<UniformRandomVariable>();
+    for (std::size_t i = 0; i < total; ++i)
+    {
+        slots.arrived[i] = uv->GetValue() < arrival;
+        slots.served[i] = uv->GetValue() < service;
+        slots.u[i] = uv->GetValue();
+    }
+
+    std::cout << "Deciding " << nSlots << " slots of " << nQueues << " queues (" << variant << ")" << std::endl;
+    Result engines = RunEngines(config, slots, nQueues, nSlots, limit, slotNs);
+    Result scalar = RunBank(config, false, slots, nQueues, nSlots, limit, slotNs);
+    Result simd = RunBank(config, true, slots, nQueues, nSlots, limit, slotNs);
+    Count(engines, slots);
+    Count(scalar, slots);
+    Count(simd, slots);
+
+    bool simdAvailable = RedBank(1, config).IsSimd();
+    const char *names[] = {"engines", "bank scalar", simdAvailable ? "bank simd" : "bank simd (no AVX2, scalar)"};
+    const Result *results[] = {&engines, &scalar, &simd};
+    for (int k = 0; k < 3; ++k)
+    {
+        const Result &r = *results[k];
+        std::cout << names[k] << ": " << r.arrivals / r.seconds / 1e6 << " M decisions/s, "
+                  << r.drops * 100.0 / r.arrivals << "% dropped" << std::endl;
+    }
+    bool same = engines.decisions == scalar.decisions && scalar.decisions == simd.decisions;
+    std::cout << (same ? "Decisions identical" : "DECISIONS DIFFER") << std::endl;
+    return same ? 0 : 1;
+}
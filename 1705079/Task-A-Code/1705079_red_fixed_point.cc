@@ -0,0 +1,286 @@
+
+// author :  kazi wasif amin shammo 1705079
+// Fixed-point RED against the floating-point control law
+//
+// A single queue served at the link rate receives Poisson arrivals.  The
+// floating-point RedEngine decides them and its decisions drive the
+// queue; the arrivals it sees (time, queue length, size, idle periods and
+// the uniform draw) are recorded and replayed through:
+//
+//   - a floating-point engine, to check the replay is exact;
+//   - a fixed-point engine, in shadow: it sees the same inputs and its
+//     decisions are only compared.
+//
+// The program reports the largest differences of the average queue
+// length and of the drop probability, and the share of differing
+// decisions.  Once a decision differs, the drop counts of the two engines
+// and so their later probabilities part; the first differing arrival
+// shows how long the two laws agree.  With exactWeight the floating-point engine uses the queue
+// weight 2^-W of the fixed-point one, so only the arithmetic differs;
+// otherwise the rounding of qW is included.  Each engine then replays the
+// trace alone to measure ns (and, on x86, TSC cycles) per decision.
+//
+//   ./waf --run "scratch/1705079_red_fixed_point --variant=ared --load=1.5 --bytes=true"
+
+#include "ns3/core-module.h"
+
+#include "red-engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+using namespace ns3;
+
+namespace
+{
+    // One arrival as the reference engine saw it
+    struct Arrival
+    {
+        int64_t nowNs;
+        int64_t idleNs; // the queue went idle at this time before the arrival, -1 if not
+        uint32_t nQueued;
+        uint32_t size;
+        double u;
+    };
+
+    // Replays the draw of the trace
+    struct Draw
+    {
+        double u;
+        double operator()(void)
+        {
+            return u;
+        }
+    };
+
+    uint64_t
+    Cycles(void)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    // Runs the queue with the reference engine and records its arrivals
+    std::vector<Arrival>
+    Record(const RedConfig &config, uint32_t nPackets, uint32_t limit, double load, uint32_t pktSize)
+    {
+        RedEngine engine;
+        engine.Initialize(config);
+        Ptr<UniformRandomVariable> uv = CreateObject<UniformRandomVariable>();
+        Ptr<ExponentialRandomVariable> ev = CreateObject<ExponentialRandomVariable>();
+        double nsPerByte = 8e9 / config.linkBitRate;
+        ev->SetAttribute("Mean", DoubleValue(nsPerByte * pktSize / load));
+
+        std::vector<Arrival> trace;
+        trace.reserve(nPackets);
+        std::vector<uint32_t> queue; // sizes of the queued packets, head first
+        std::size_t head = 0;
+        uint32_t nQueued = 0;
+        int64_t now = 0;
+        int64_t departure = 0;
+        while (trace.size() < nPackets)
+        {
+            now += static_cast<int64_t>(ev->GetValue());
+            Arrival a = {now, -1, 0, 0, 0};
+            while (head < queue.size() && departure <= now)
+            {
+                nQueued -= config.isBytes ? queue[head] : 1;
+                ++head;
+                if (head == queue.size())
+                {
+                    a.idleNs = departure;
+                    engine.AdaptUntil(departure);
+                    engine.SetIdle(departure);
+                }
+                else
+                {
+                    departure += static_cast<int64_t>(nsPerByte * queue[head]);
+                }
+            }
+            a.nQueued = nQueued;
+            a.size = static_cast<uint32_t>(pktSize * (0.5 + uv->GetValue()));
+            a.u = uv->GetValue();
+            trace.push_back(a);
+
+            Draw draw = {a.u};
+            engine.AdaptUntil(now);
+            if (engine.Admit(now, nQueued, a.size, 0, 0, draw) && head + limit > queue.size())
+            {
+                if (head == queue.size())
+                {
+                    departure = now + static_cast<int64_t>(nsPerByte * a.size);
+                }
+                queue.push_back(a.size);
+                nQueued += config.isBytes ? a.size : 1;
+            }
+        }
+        return trace;
+    }
+
+    // Feeds one arrival to an engine
+    inline bool
+    Replay(RedEngine &engine, const Arrival &a)
+    {
+        // the adaptation events due, in time order with the idle report
+        if (a.idleNs >= 0)
+        {
+            engine.AdaptUntil(a.idleNs);
+            engine.SetIdle(a.idleNs);
+        }
+        engine.AdaptUntil(a.nowNs);
+        Draw draw = {a.u};
+        return engine.Admit(a.nowNs, a.nQueued, a.size, 0, 0, draw);
+    }
+
+    // Time and cycles per decision of one engine over the trace
+    void
+    Measure(const RedConfig &config, const std::vector<Arrival> &trace, uint32_t repeat, double &ns,
+            double &cycles)
+    {
+        RedEngine engine;
+        uint64_t drops = 0;
+        ns = cycles = 1e300;
+        for (uint32_t r = 0; r < repeat; ++r)
+        {
+            engine.Initialize(config);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            uint64_t c0 = Cycles();
+            for (const Arrival &a : trace)
+            {
+                drops += !Replay(engine, a);
+            }
+            uint64_t c1 = Cycles();
+            double t = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            ns = std::min(ns, t / trace.size());
+            cycles = std::min(cycles, static_cast<double>(c1 - c0) / trace.size());
+        }
+        // keeps the loop from being optimised away
+        if (drops == 0xffffffffffffffffull)
+        {
+            std::cout << std::endl;
+        }
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // default values of the parameters
+    std::string variant = "red";
+    uint32_t nPackets = 1000000;
+    uint32_t repeat = 5;
+    double load = 1.2;
+    uint32_t pktSize = 100;
+    uint32_t limit = 100;
+    double minTh = 20;
+    double maxTh = 60;
+    double qW = 0.002;
+    std::string linkBw = "250kbps";
+    bool bytes = false;
+    bool exactWeight = true;
+
+    // options for arguments
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("variant", "RED variant: red, ared, feng or nlred", variant);
+    cmd.AddValue("packets", "Arrivals in the trace", nPackets);
+    cmd.AddValue("repeat", "Timed replays per engine", repeat);
+    cmd.AddValue("load", "Mean arrival rate over the link rate", load);
+    cmd.AddValue("pktSize", "Mean packet size in bytes", pktSize);
+    cmd.AddValue("limit", "Queue capacity in packets", limit);
+    cmd.AddValue("redMinTh", "RED queue minimum threshold (in packets)", minTh);
+    cmd.AddValue("redMaxTh", "RED queue maximum threshold (in packets)", maxTh);
+    cmd.AddValue("qW", "Queue weight", qW);
+    cmd.AddValue("linkBw", "Service rate of the queue", linkBw);
+    cmd.AddValue("bytes", "Queue length and thresholds in bytes", bytes);
+    cmd.AddValue("exactWeight", "Floating-point engine uses the fixed-point weight 2^-W", exactWeight);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_IF(nPackets == 0 || repeat == 0, "packets and repeat must be positive");
+    NS_ABORT_MSG_UNLESS(load > 0, "load must be positive");
+
+    RedConfig config;
+    config.isRRED = false;
+    config.isARED = variant == "ared";
+    config.isFengAdaptive = variant == "feng";
+    config.isNonlinear = variant == "nlred";
+    NS_ABORT_MSG_UNLESS(variant == "red" || config.isARED || config.isFengAdaptive || config.isNonlinear,
+                        "Unknown RED variant " << variant);
+    config.isBytes = bytes;
+    config.meanPktSize = pktSize;
+    config.minTh = bytes ? minTh * pktSize : minTh;
+    config.maxTh = bytes ? maxTh * pktSize : maxTh;
+    config.qW = qW;
+    config.linkBitRate = DataRate(linkBw).GetBitRate();
+
+    RedConfig fixedConfig = config;
+    fixedConfig.isFixedPoint = true;
+    RedEngine fixedEngine;
+    fixedEngine.Initialize(fixedConfig);
+    uint32_t wlog = fixedEngine.GetWeightShift();
+    if (exactWeight)
+    {
+        // apply the automatic settings first, or ARED would pick qW again
+        RedEngine::Resolve(config);
+        config.isARED = false;
+        config.qW = std::ldexp(1.0, -static_cast<int>(wlog));
+    }
+    RedEngine floatEngine;
+    floatEngine.Initialize(config);
+
+    std::vector<Arrival> trace = Record(config, nPackets, limit, load, pktSize);
+
+    // shadow replay
+    RedEngine check;
+    check.Initialize(config);
+    uint64_t drops = 0;
+    uint64_t fixedDrops = 0;
+    uint64_t differ = 0;
+    uint64_t firstDiffer = nPackets;
+    uint64_t replayDiffer = 0;
+    double maxAvgDiff = 0;
+    double maxProbDiff = 0;
+    double maxAvg = 0;
+    for (const Arrival &a : trace)
+    {
+        bool admitted = Replay(floatEngine, a);
+        bool fixedAdmitted = Replay(fixedEngine, a);
+        // a second floating-point engine, to see the trace replays exactly
+        replayDiffer += Replay(check, a) != admitted;
+        drops += !admitted;
+        fixedDrops += !fixedAdmitted;
+        if (admitted != fixedAdmitted && differ++ == 0)
+        {
+            firstDiffer = &a - &trace[0];
+        }
+        maxAvg = std::max(maxAvg, floatEngine.GetQueueAverage());
+        maxAvgDiff = std::max(maxAvgDiff, std::fabs(fixedEngine.GetQueueAverage() - floatEngine.GetQueueAverage()));
+        maxProbDiff = std::max(maxProbDiff, std::fabs(fixedEngine.GetVProb() - floatEngine.GetVProb()));
+    }
+    NS_ABORT_MSG_IF(replayDiffer, "The trace does not replay exactly");
+
+    std::cout << variant << (bytes ? " (bytes)" : " (packets)") << ", qW " << floatEngine.GetConfig().qW
+              << ", fixed-point W " << wlog
+              << " (qW' " << std::ldexp(1.0, -static_cast<int>(wlog)) << ")" << std::endl;
+    std::cout << "max average " << maxAvg << ", max |average difference| " << maxAvgDiff
+              << ", max |probability difference| " << maxProbDiff << std::endl;
+    std::cout << "drops: floating " << drops * 100.0 / nPackets << "%, fixed " << fixedDrops * 100.0 / nPackets
+              << "%, differing decisions " << differ * 100.0 / nPackets << "% (first at arrival " << firstDiffer
+              << ")" << std::endl;
+
+    double ns;
+    double cycles;
+    Measure(config, trace, repeat, ns, cycles);
+    std::cout << "floating-point: " << ns << " ns, " << cycles << " cycles per decision" << std::endl;
+    Measure(fixedConfig, trace, repeat, ns, cycles);
+    std::cout << "fixed-point: " << ns << " ns, " << cycles << " cycles per decision" << std::endl;
+    return 0;
+}
@@ -0,0 +1,506 @@
+
+// author :  kazi wasif amin shammo 1705079
+// Microbenchmark of RedQueueDisc enqueue and dequeue
+//
+// A standalone queue disc (no node, no device) is fed a synthetic stream
+// of Ipv4QueueDiscItems and served at the link rate.  Arrivals and
+// services are simulator events, so Simulator::Now () follows the
+// synthetic arrival process exactly and the time-dependent parts of RED
+// (idle time, ARED / Feng intervals, RRED timers) behave as in a real
+// run.  Only the Enqueue and Dequeue calls are timed: packet and header
+// construction happen outside the measured region.  With batch > 1 each
+// arrival event brings that many items, enqueued with EnqueueBatch, and
+// the enqueue cost is reported per item.
+//
+// Every variant runs the same stream (same seeds).  For each one the
+// program reports the median and minimum over the repetitions of:
+//   - ns per Enqueue / Dequeue call, minus the timer overhead;
+//   - heap allocations per Enqueue / Dequeue call (global operator new);
+//   - the drop ratio, to check that the variants worked at similar loads.
+//
+//   ./waf --run "scratch/1705079_red_microbench --variants=red,rred --flows=10000
+//                --arrival=bursty:50:50 --format=json --output=before.json --label=before"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/traffic-control-module.h"
+
+#include "red-variant.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+// Heap allocations of the whole process; the benchmark is single threaded
+static uint64_t g_allocations = 0;
+
+void *
+operator new(std::size_t size)
+{
+    ++g_allocations;
+    void *p = std::malloc(size ? size : 1);
+    if (p == 0)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void
+operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    // Packet size distribution
+    struct SizeModel
+    {
+        std::string kind; // fixed, uniform or bimodal
+        uint32_t a;
+        uint32_t b;
+        double p;
+
+        static SizeModel Parse(const std::string &spec)
+        {
+            std::vector<std::string> f;
+            std::istringstream is(spec);
+            std::string item;
+            while (std::getline(is, item, ':'))
+            {
+                f.push_back(item);
+            }
+            SizeModel m = {f.empty() ? "" : f[0], 0, 0, 0.5};
+            if (m.kind == "fixed" && f.size() == 2)
+            {
+                m.a = m.b = std::stoul(f[1]);
+            }
+            else if (m.kind == "uniform" && f.size() == 3)
+            {
+                m.a = std::stoul(f[1]);
+                m.b = std::stoul(f[2]);
+            }
+            else if (m.kind == "bimodal" && (f.size() == 3 || f.size() == 4))
+            {
+                m.a = std::stoul(f[1]);
+                m.b = std::stoul(f[2]);
+                m.p = f.size() == 4 ? std::stod(f[3]) : 0.5;
+            }
+            else
+            {
+                NS_FATAL_ERROR("Bad pktSize " << spec << " (use fixed:S, uniform:MIN:MAX or bimodal:S1:S2[:P1])");
+            }
+            NS_ABORT_MSG_IF(std::min(m.a, m.b) < 40 || (m.kind == "uniform" && m.a > m.b),
+                            "Bad pktSize " << spec << ": sizes include 40 bytes of headers");
+            return m;
+        }
+
+        double Mean(void) const
+        {
+            return kind == "bimodal" ? p * a + (1 - p) * b : (a + b) / 2.0;
+        }
+    };
+
+    // Arrival process
+    struct ArrivalModel
+    {
+        std::string kind; // paced, poisson or bursty
+        Time on;
+        Time off;
+
+        static ArrivalModel Parse(const std::string &spec)
+        {
+            ArrivalModel m;
+            std::string::size_type c = spec.find(':');
+            m.kind = spec.substr(0, c);
+            if (m.kind == "bursty")
+            {
+                std::string::size_type c2 = spec.find(':', c + 1);
+                NS_ABORT_MSG_IF(c == std::string::npos || c2 == std::string::npos,
+                                "Bad arrival " << spec << " (use bursty:ON_MS:OFF_MS)");
+                m.on = MilliSeconds(std::stoul(spec.substr(c + 1, c2 - c - 1)));
+                m.off = MilliSeconds(std::stoul(spec.substr(c2 + 1)));
+            }
+            else
+            {
+                NS_ABORT_MSG_UNLESS(m.kind == "paced" || m.kind == "poisson",
+                                    "Bad arrival " << spec << " (use paced, poisson or bursty:ON_MS:OFF_MS)");
+            }
+            return m;
+        }
+    };
+
+    // State of one measured run
+    struct Run
+    {
+        Ptr<QueueDisc> queueDisc;
+        SizeModel sizes;
+        ArrivalModel arrivals;
+        uint32_t nFlows;
+        double udpFraction;
+        uint32_t remaining;
+        uint32_t sent;
+        uint32_t batch;        // items per arrival event
+        std::vector<Ptr<QueueDiscItem>> items;
+        Time meanGap;          // mean time between arrival events
+        DataRate linkRate;
+        Ptr<UniformRandomVariable> uv;
+        Ptr<ExponentialRandomVariable> ev;
+        Time burstEnd;
+        std::chrono::steady_clock::duration enqueueTime;
+        std::chrono::steady_clock::duration dequeueTime;
+        uint64_t enqueueAllocations;
+        uint64_t dequeueAllocations;
+        uint64_t nDequeueCalls;
+    };
+
+    uint32_t
+    DrawSize(Run *r)
+    {
+        const SizeModel &m = r->sizes;
+        if (m.kind == "uniform")
+        {
+            return r->uv->GetInteger(m.a, m.b);
+        }
+        if (m.kind == "bimodal")
+        {
+            return r->uv->GetValue() < m.p ? m.a : m.b;
+        }
+        return m.a;
+    }
+
+    Time
+    NextGap(Run *r)
+    {
+        const ArrivalModel &m = r->arrivals;
+        if (m.kind == "poisson")
+        {
+            return Seconds(r->ev->GetValue(r->meanGap.GetSeconds(), 0));
+        }
+        if (m.kind == "bursty")
+        {
+            // the on period sends at a rate that keeps the mean load
+            Time gap = r->meanGap * (m.on.GetSeconds() / (m.on + m.off).GetSeconds());
+            if (Simulator::Now() + gap >= r->burstEnd)
+            {
+                r->burstEnd += m.on + m.off;
+                return r->burstEnd - m.on - Simulator::Now();
+            }
+            return gap;
+        }
+        return r->meanGap;
+    }
+
+    Ptr<QueueDiscItem>
+    MakeItem(Run *r)
+    {
+        uint32_t flow = r->uv->GetInteger(0, r->nFlows - 1);
+        bool udp = r->uv->GetValue() < r->udpFraction;
+        Ptr<Packet> p = Create<Packet>(DrawSize(r) - 40);
+        if (udp)
+        {
+            UdpHeader h;
+            h.SetSourcePort(1024 + flow % 60000);
+            h.SetDestinationPort(5002);
+            p->AddHeader(h);
+        }
+        else
+        {
+            TcpHeader h;
+            h.SetSourcePort(1024 + flow % 60000);
+            h.SetDestinationPort(5001);
+            p->AddHeader(h);
+        }
+        Ipv4Header ip;
+        ip.SetSource(Ipv4Address(Ipv4Address("10.128.0.0").Get() + flow));
+        ip.SetDestination(Ipv4Address("10.1.0.1"));
+        ip.SetProtocol(udp ? UdpL4Protocol::PROT_NUMBER : TcpL4Protocol::PROT_NUMBER);
+        ip.SetPayloadSize(p->GetSize());
+        return Create<Ipv4QueueDiscItem>(p, Address(), Ipv4L3Protocol::PROT_NUMBER, ip);
+    }
+
+    void
+    Arrival(Run *r)
+    {
+        uint32_t n = std::min(r->batch, r->remaining);
+        r->items.clear();
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            r->items.push_back(MakeItem(r));
+        }
+
+        uint64_t allocations = g_allocations;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (r->batch == 1)
+        {
+            r->queueDisc->Enqueue(r->items[0]);
+        }
+        else
+        {
+            DynamicCast<RedQueueDisc>(r->queueDisc)->EnqueueBatch(r->items);
+        }
+        r->enqueueTime += std::chrono::steady_clock::now() - start;
+        r->enqueueAllocations += g_allocations - allocations;
+
+        r->sent += n;
+        r->remaining -= n;
+        if (r->remaining > 0)
+        {
+            Simulator::Schedule(NextGap(r), &Arrival, r);
+        }
+    }
+
+    void
+    Service(Run *r)
+    {
+        uint64_t allocations = g_allocations;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        Ptr<QueueDiscItem> item = r->queueDisc->Dequeue();
+        r->dequeueTime += std::chrono::steady_clock::now() - start;
+        r->dequeueAllocations += g_allocations - allocations;
+        r->nDequeueCalls++;
+
+        // the link is busy for the packet's transmission time; an idle link
+        // polls at the mean packet time
+        uint32_t size = item ? item->GetSize() : static_cast<uint32_t>(r->sizes.Mean());
+        if (r->remaining > 0 || r->queueDisc->GetNPackets() > 0)
+        {
+            Simulator::Schedule(r->linkRate.CalculateBytesTxTime(size), &Service, r);
+        }
+        else
+        {
+            // the adaptive variants keep a periodic event of their own
+            Simulator::Stop();
+        }
+    }
+
+    // steady_clock::now () pair cost, subtracted from every timed call
+    double
+    TimerOverhead(void)
+    {
+        const uint32_t n = 1000000;
+        std::chrono::steady_clock::duration total = std::chrono::steady_clock::duration::zero();
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            total += std::chrono::steady_clock::now() - start;
+        }
+        return std::chrono::duration<double, std::nano>(total).count() / n;
+    }
+
+    // Result of one repetition
+    struct Sample
+    {
+        double enqueueNs;
+        double dequeueNs;
+        double enqueueAllocs;
+        double dequeueAllocs;
+        double dropPct;
+    };
+
+    Sample
+    RunOnce(const RedVariant &variant, const SizeModel &sizes, const ArrivalModel &arrivals, uint32_t nFlows,
+            double udpFraction, uint32_t nPackets, uint32_t batch, double load, DataRate linkRate, double timerNs)
+    {
+        ObjectFactory factory;
+        factory.SetTypeId(RedQueueDisc::GetTypeId());
+        variant.Apply(factory);
+        Ptr<RedQueueDisc> qd = factory.Create<RedQueueDisc>();
+        qd->Initialize();
+
+        Run r;
+        r.queueDisc = qd;
+        r.sizes = sizes;
+        r.arrivals = arrivals;
+        r.nFlows = nFlows;
+        r.udpFraction = udpFraction;
+        r.remaining = nPackets;
+        r.sent = 0;
+        r.batch = batch;
+        r.linkRate = linkRate;
+        // one arrival event per batch keeps the mean load
+        r.meanGap = linkRate.CalculateBytesTxTime(static_cast<uint32_t>(sizes.Mean())) * static_cast<int64_t>(batch) /
+                    load;
+        r.uv = CreateObject<UniformRandomVariable>();
+        r.ev = CreateObject<ExponentialRandomVariable>();
+        // fixed streams: every variant and repetition sees the same packets
+        r.uv->SetStream(1);
+        r.ev->SetStream(2);
+        qd->AssignStreams(3);
+        r.burstEnd = arrivals.on;
+        r.enqueueTime = r.dequeueTime = std::chrono::steady_clock::duration::zero();
+        r.enqueueAllocations = r.dequeueAllocations = r.nDequeueCalls = 0;
+
+        Simulator::Schedule(Seconds(0), &Arrival, &r);
+        Simulator::Schedule(linkRate.CalculateBytesTxTime(static_cast<uint32_t>(sizes.Mean())), &Service, &r);
+        Simulator::Run();
+
+        QueueDisc::Stats st = qd->GetStats();
+        Sample s;
+        s.enqueueNs = std::chrono::duration<double, std::nano>(r.enqueueTime).count() / r.sent - timerNs;
+        s.dequeueNs = std::chrono::duration<double, std::nano>(r.dequeueTime).count() / r.nDequeueCalls - timerNs;
+        s.enqueueAllocs = static_cast<double>(r.enqueueAllocations) / r.sent;
+        s.dequeueAllocs = static_cast<double>(r.dequeueAllocations) / r.nDequeueCalls;
+        s.dropPct = st.nTotalDroppedPackets * 100.0 / st.nTotalReceivedPackets;
+
+        r.queueDisc = 0;
+        qd->Dispose();
+        Simulator::Destroy();
+        return s;
+    }
+
+    double
+    Median(std::vector<double> x)
+    {
+        std::sort(x.begin(), x.end());
+        std::size_t n = x.size();
+        return n % 2 ? x[n / 2] : (x[n / 2 - 1] + x[n / 2]) / 2;
+    }
+
+    double
+    Min(const std::vector<double> &x)
+    {
+        return *std::min_element(x.begin(), x.end());
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // default values of the parameters
+    std::string variants = "red,ared,feng,nlred,rred";
+    uint32_t nFlows = 1000;
+    std::string pktSize = "fixed:1000";
+    std::string arrival = "poisson";
+    double load = 1.1;
+    double udpFraction = 0;
+    uint32_t nPackets = 1000000;
+    uint32_t repeat = 5;
+    uint32_t batch = 1;
+    std::string linkBw = "10Mbps";
+    uint32_t queueDiscLimitPackets = 100;
+    double minTh = 20;
+    double maxTh = 60;
+    std::string format = "csv";
+    std::string output = "";
+    std::string label = "";
+
+    // options for arguments
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("variants", "Comma list of RED variants: red, ared, feng, nlred, rred", variants);
+    cmd.AddValue("flows", "Number of flows of the synthetic stream", nFlows);
+    cmd.AddValue("pktSize", "Packet sizes: fixed:S, uniform:MIN:MAX or bimodal:S1:S2[:P1]", pktSize);
+    cmd.AddValue("arrival", "Arrival process: paced, poisson or bursty:ON_MS:OFF_MS", arrival);
+    cmd.AddValue("load", "Mean arrival rate over the link rate", load);
+    cmd.AddValue("udpFraction", "Fraction of UDP packets, the rest is TCP", udpFraction);
+    cmd.AddValue("packets", "Enqueues per repetition", nPackets);
+    cmd.AddValue("repeat", "Repetitions per variant", repeat);
+    cmd.AddValue("batch", "Items per arrival, enqueued with EnqueueBatch when above 1", batch);
+    cmd.AddValue("linkBw", "Service rate of the queue disc", linkBw);
+    cmd.AddValue("queueDiscLimitPackets", "Max Packets allowed in the queue disc", queueDiscLimitPackets);
+    cmd.AddValue("redMinTh", "RED queue minimum threshold (in packets)", minTh);
+    cmd.AddValue("redMaxTh", "RED queue maximum threshold (in packets)", maxTh);
+    cmd.AddValue("format", "Output format: csv or json", format);
+    cmd.AddValue("output", "Output file (default: standard output)", output);
+    cmd.AddValue("label", "Free text stored with every result, e.g. a build or commit name", label);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_IF(nFlows == 0 || nPackets == 0 || repeat == 0 || batch == 0,
+                    "flows, packets, repeat and batch must be positive");
+    NS_ABORT_MSG_UNLESS(load > 0, "load must be positive");
+    NS_ABORT_MSG_UNLESS(format == "csv" || format == "json", "Unknown format " << format << " (use csv or json)");
+    SizeModel sizes = SizeModel::Parse(pktSize);
+    ArrivalModel arrivals = ArrivalModel::Parse(arrival);
+
+    // default configuration for queue implementation
+    Config::SetDefault("ns3::RedQueueDisc::MaxSize",
+                       QueueSizeValue(QueueSize(QueueSizeUnit::PACKETS, queueDiscLimitPackets)));
+    Config::SetDefault("ns3::RedQueueDisc::MinTh", DoubleValue(minTh));
+    Config::SetDefault("ns3::RedQueueDisc::MaxTh", DoubleValue(maxTh));
+    Config::SetDefault("ns3::RedQueueDisc::LinkBandwidth", StringValue(linkBw));
+    Config::SetDefault("ns3::RedQueueDisc::MeanPktSize", UintegerValue(static_cast<uint32_t>(sizes.Mean())));
+
+    double timerNs = TimerOverhead();
+
+    std::ofstream file;
+    if (!output.empty())
+    {
+        file.open(output.c_str());
+        NS_ABORT_MSG_UNLESS(file.is_open(), "Cannot open " << output);
+    }
+    std::ostream &os = output.empty() ? std::cout : file;
+
+    const char *fields[] = {"enqueue_ns", "dequeue_ns", "enqueue_allocs", "dequeue_allocs", "drop_pct"};
+    if (format == "csv")
+    {
+        os << "label,variant,flows,pkt_size,arrival,load,packets,repeat,batch";
+        for (const char *f : fields)
+        {
+            os << "," << f << "_median," << f << "_min";
+        }
+        os << std::endl;
+    }
+    else
+    {
+        os << "{\"label\":\"" << label << "\",\"timer_ns\":" << timerNs << ",\"results\":[";
+    }
+
+    bool first = true;
+    for (const RedVariant &variant : RedVariant::ParseList(variants))
+    {
+        std::vector<std::vector<double>> values(5);
+        for (uint32_t i = 0; i < repeat; ++i)
+        {
+            Sample s = RunOnce(variant, sizes, arrivals, nFlows, udpFraction, nPackets, batch, load,
+                               DataRate(linkBw), timerNs);
+            values[0].push_back(s.enqueueNs);
+            values[1].push_back(s.dequeueNs);
+            values[2].push_back(s.enqueueAllocs);
+            values[3].push_back(s.dequeueAllocs);
+            values[4].push_back(s.dropPct);
+        }
+
+        if (format == "csv")
+        {
+            os << label << "," << variant.name << "," << nFlows << "," << pktSize << "," << arrival << "," << load
+               << "," << nPackets << "," << repeat << "," << batch;
+            for (const std::vector<double> &v : values)
+            {
+                os << "," << Median(v) << "," << Min(v);
+            }
+            os << std::endl;
+        }
+        else
+        {
+            os << (first ? "" : ",") << "{\"variant\":\"" << variant.name << "\",\"flows\":" << nFlows
+               << ",\"pkt_size\":\"" << pktSize << "\",\"arrival\":\"" << arrival << "\",\"load\":" << load
+               << ",\"packets\":" << nPackets << ",\"repeat\":" << repeat << ",\"batch\":" << batch;
+            for (std::size_t k = 0; k < values.size(); ++k)
+            {
+                os << ",\"" << fields[k] << "\":{\"median\":" << Median(values[k]) << ",\"min\":" << Min(values[k])
+                   << "}";
+            }
+            os << "}";
+        }
+        first = false;
+    }
+    if (format == "json")
+    {
+        os << "]}" << std::endl;
+    }
+    return 0;
+}
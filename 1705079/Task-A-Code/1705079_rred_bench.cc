@@ -0,0 +1,387 @@
+
+// author :  kazi wasif amin shammo 1705079
+// Benchmark of the RedQueueDisc modes against a low-rate DoS attack
+//
+//   legit sources ----\                        /---- legit sinks
+//                      r0 ==== bottleneck ==== r1
+//   attackers --------/                        \---- attack sink
+//
+// Every mode (red, ared, feng, nlred, rred) is simulated twice on the same
+// dumbbell, without and with the attack, and reports:
+//
+//   - goodput retention: legitimate goodput under attack over the
+//     legitimate goodput of the same mode without attack;
+//   - detection latency: time from the first attack pulse to the first
+//     attack packet dropped by an early decision (RED probability or RRED
+//     filter), and the share of attack packets dropped at the bottleneck;
+//   - enqueue cost: wall-clock time of RedQueueDisc::Enqueue in a separate
+//     run that feeds one queue disc with a fixed mix of flows.
+//
+// Results are printed and written to rred_bench.csv.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/point-to-point-layout-module.h"
+#include "ns3/traffic-control-module.h"
+
+#include "low-rate-dos-application.h"
+#include "red-variant.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+namespace
+{
+    // Scenario parameters shared by every run
+    struct Params
+    {
+        uint32_t nLegit;
+        uint32_t nAttackers;
+        std::string bottleneckBw;
+        std::string bottleneckDelay;
+        uint32_t pktSize;
+        double attackPeriod;
+        double attackBurst;
+        std::string attackRate;
+        std::string spoofing;
+        double attackStart;
+        double stopTime;
+        uint32_t costPackets;
+        uint32_t costFlows;
+    };
+
+    // Results of one simulation
+    struct RunResult
+    {
+        double legitGoodputBps = 0;
+        uint64_t attackArrivals = 0;
+        uint64_t attackDrops = 0;
+        Time firstDetection = Time::Max();
+    };
+
+    bool
+    IsAttack(Ptr<const QueueDiscItem> item)
+    {
+        Ptr<const Ipv4QueueDiscItem> ipItem = DynamicCast<const Ipv4QueueDiscItem>(item);
+        return ipItem && ipItem->GetHeader().GetProtocol() == UdpL4Protocol::PROT_NUMBER;
+    }
+
+    void
+    OnEnqueue(RunResult *r, Ptr<const QueueDiscItem> item)
+    {
+        if (IsAttack(item))
+        {
+            r->attackArrivals++;
+        }
+    }
+
+    void
+    OnDrop(RunResult *r, Ptr<const QueueDiscItem> item, const char *reason)
+    {
+        if (!IsAttack(item))
+        {
+            return;
+        }
+        r->attackArrivals++;
+        r->attackDrops++;
+        std::string why(reason);
+        if (r->firstDetection == Time::Max() &&
+            (why == RedQueueDisc::UNFORCED_DROP || why == RedQueueDisc::RRED_DROP))
+        {
+            r->firstDetection = Simulator::Now();
+        }
+    }
+
+    RunResult
+    RunScenario(const RedVariant &mode, bool attack, const Params &prm)
+    {
+        PointToPointHelper bottleNeckLink;
+        bottleNeckLink.SetDeviceAttribute("DataRate", StringValue(prm.bottleneckBw));
+        bottleNeckLink.SetChannelAttribute("Delay", StringValue(prm.bottleneckDelay));
+        PointToPointHelper pointToPointLeaf;
+        pointToPointLeaf.SetDeviceAttribute("DataRate", StringValue("100Mbps"));
+        pointToPointLeaf.SetChannelAttribute("Delay", StringValue("1ms"));
+
+        // left leaf nLegit is the attack sink, right leaves from nLegit on
+        // are the attackers
+        PointToPointDumbbellHelper d(prm.nLegit + 1, pointToPointLeaf,
+                                     prm.nLegit + prm.nAttackers, pointToPointLeaf,
+                                     bottleNeckLink);
+        InternetStackHelper stack;
+        d.InstallStack(stack);
+
+        TrafficControlHelper tchBottleneck;
+        tchBottleneck.SetRootQueueDisc("ns3::RedQueueDisc",
+                                       "ARED", BooleanValue(mode.ared),
+                                       "FengAdaptive", BooleanValue(mode.feng),
+                                       "NLRED", BooleanValue(mode.nlred),
+                                       "RRED", BooleanValue(mode.rred));
+        tchBottleneck.Install(d.GetLeft()->GetDevice(0));
+        QueueDiscContainer queueDiscs = tchBottleneck.Install(d.GetRight()->GetDevice(0));
+
+        d.AssignIpv4Addresses(Ipv4AddressHelper("10.1.1.0", "255.255.255.0"),
+                              Ipv4AddressHelper("10.2.1.0", "255.255.255.0"),
+                              Ipv4AddressHelper("10.3.1.0", "255.255.255.0"));
+        Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+
+        uint16_t port = 5001;
+        uint16_t attackPort = 5002;
+        PacketSinkHelper packetSinkHelper("ns3::TcpSocketFactory", InetSocketAddress(Ipv4Address::GetAny(), port));
+        ApplicationContainer sinkApps;
+        for (uint32_t i = 0; i < prm.nLegit; ++i)
+        {
+            sinkApps.Add(packetSinkHelper.Install(d.GetLeft(i)));
+        }
+        PacketSinkHelper attackSinkHelper("ns3::UdpSocketFactory", InetSocketAddress(Ipv4Address::GetAny(), attackPort));
+        attackSinkHelper.Install(d.GetLeft(prm.nLegit));
+
+        // greedy legitimate TCP flows
+        OnOffHelper clientHelper("ns3::TcpSocketFactory", Address());
+        clientHelper.SetAttribute("OnTime", StringValue("ns3::ConstantRandomVariable[Constant=1]"));
+        clientHelper.SetAttribute("OffTime", StringValue("ns3::ConstantRandomVariable[Constant=0]"));
+        clientHelper.SetAttribute("DataRate", StringValue(prm.bottleneckBw));
+        clientHelper.SetAttribute("PacketSize", UintegerValue(prm.pktSize));
+        ApplicationContainer clientApps;
+        for (uint32_t i = 0; i < prm.nLegit; ++i)
+        {
+            clientHelper.SetAttribute("Remote", AddressValue(InetSocketAddress(d.GetLeftIpv4Address(i), port)));
+            clientApps.Add(clientHelper.Install(d.GetRight(i)));
+        }
+        clientApps.Start(Seconds(1.0));
+        clientApps.Stop(Seconds(prm.stopTime));
+
+        ApplicationContainer attackApps;
+        if (attack)
+        {
+            LowRateDosHelper attackHelper(InetSocketAddress(d.GetLeftIpv4Address(prm.nLegit), attackPort));
+            attackHelper.SetAttribute("Period", TimeValue(Seconds(prm.attackPeriod)));
+            attackHelper.SetAttribute("BurstLength", TimeValue(Seconds(prm.attackBurst)));
+            attackHelper.SetAttribute("PeakRate", DataRateValue(DataRate(prm.attackRate)));
+            attackHelper.SetAttribute("PacketSize", UintegerValue(prm.pktSize));
+            attackHelper.SetAttribute("Spoofing", StringValue(prm.spoofing));
+            for (uint32_t i = 0; i < prm.nAttackers; ++i)
+            {
+                attackApps.Add(attackHelper.Install(d.GetRight(prm.nLegit + i)));
+            }
+            attackApps.Start(Seconds(prm.attackStart));
+            attackApps.Stop(Seconds(prm.stopTime));
+        }
+
+        // same streams in every run, so the runs only differ by the mode
+        // and the attack
+        int64_t stream = 1;
+        stream += stack.AssignStreams(NodeContainer::GetGlobal(), stream);
+        stream += DynamicCast<RedQueueDisc>(queueDiscs.Get(0))->AssignStreams(stream);
+        for (uint32_t i = 0; i < attackApps.GetN(); ++i)
+        {
+            stream += DynamicCast<LowRateDosApplication>(attackApps.Get(i))->AssignStreams(stream);
+        }
+
+        RunResult r;
+        Ptr<QueueDisc> bottleneck = queueDiscs.Get(0);
+        bottleneck->TraceConnectWithoutContext("Enqueue", MakeBoundCallback(&OnEnqueue, &r));
+        bottleneck->TraceConnectWithoutContext("DropBeforeEnqueue", MakeBoundCallback(&OnDrop, &r));
+
+        Simulator::Stop(Seconds(prm.stopTime));
+        Simulator::Run();
+
+        // goodput over the attack window, measured the same way without
+        // attack
+        uint64_t rx = 0;
+        for (uint32_t i = 0; i < sinkApps.GetN(); ++i)
+        {
+            rx += DynamicCast<PacketSink>(sinkApps.Get(i))->GetTotalRx();
+        }
+        r.legitGoodputBps = rx * 8.0 / (prm.stopTime - 1.0);
+
+        Simulator::Destroy();
+        Ipv4AddressGenerator::Reset();
+        return r;
+    }
+
+    // Wall-clock cost of the enqueues of a standalone queue disc
+    struct CostRun
+    {
+        Ptr<QueueDisc> queueDisc;
+        uint32_t remaining;
+        uint32_t next;
+        uint32_t nFlows;
+        uint32_t pktSize;
+        Time arrivalInterval;
+        Time serviceInterval;
+        std::chrono::steady_clock::duration elapsed;
+    };
+
+    void
+    CostArrival(CostRun *c)
+    {
+        // legitimate TCP flows round robin, one packet in eight is UDP
+        uint32_t flow = c->next++ % c->nFlows;
+        bool udp = c->next % 8 == 0;
+        Ptr<Packet> p = Create<Packet>(c->pktSize - 40);
+        if (udp)
+        {
+            UdpHeader h;
+            h.SetSourcePort(10000 + flow);
+            h.SetDestinationPort(5002);
+            p->AddHeader(h);
+        }
+        else
+        {
+            TcpHeader h;
+            h.SetSourcePort(10000 + flow);
+            h.SetDestinationPort(5001);
+            p->AddHeader(h);
+        }
+        Ipv4Header ip;
+        ip.SetSource(Ipv4Address(Ipv4Address("10.2.0.0").Get() + flow));
+        ip.SetDestination(Ipv4Address("10.1.0.1"));
+        ip.SetProtocol(udp ? UdpL4Protocol::PROT_NUMBER : TcpL4Protocol::PROT_NUMBER);
+        ip.SetPayloadSize(p->GetSize());
+        Ptr<QueueDiscItem> item = Create<Ipv4QueueDiscItem>(p, Address(), Ipv4L3Protocol::PROT_NUMBER, ip);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        c->queueDisc->Enqueue(item);
+        c->elapsed += std::chrono::steady_clock::now() - start;
+
+        if (--c->remaining > 0)
+        {
+            Simulator::Schedule(c->arrivalInterval, &CostArrival, c);
+        }
+    }
+
+    void
+    CostService(CostRun *c)
+    {
+        c->queueDisc->Dequeue();
+        if (c->remaining > 0)
+        {
+            Simulator::Schedule(c->serviceInterval, &CostService, c);
+        }
+        else
+        {
+            // adaptive variants keep a periodic event while packets are queued
+            Simulator::Stop();
+        }
+    }
+
+    double
+    MeasureEnqueueCost(const RedVariant &mode, const Params &prm)
+    {
+        ObjectFactory factory;
+        factory.SetTypeId(RedQueueDisc::GetTypeId());
+        mode.Apply(factory);
+        Ptr<QueueDisc> qd = factory.Create<QueueDisc>();
+        qd->Initialize();
+
+        // arrivals 10% above the link rate, so that RED has to drop
+        DataRate rate(prm.bottleneckBw);
+        CostRun c;
+        c.queueDisc = qd;
+        c.remaining = prm.costPackets;
+        c.next = 0;
+        c.nFlows = prm.costFlows;
+        c.pktSize = prm.pktSize;
+        c.serviceInterval = rate.CalculateBytesTxTime(prm.pktSize);
+        c.arrivalInterval = c.serviceInterval * 10 / 11;
+        c.elapsed = std::chrono::steady_clock::duration::zero();
+        Simulator::Schedule(Seconds(0), &CostArrival, &c);
+        Simulator::Schedule(c.serviceInterval, &CostService, &c);
+        Simulator::Run();
+        Simulator::Destroy();
+        qd->Dispose();
+
+        return std::chrono::duration<double, std::nano>(c.elapsed).count() / prm.costPackets;
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // default values of the parameters
+    std::string modes = "red,ared,feng,nlred,rred";
+    Params prm;
+    prm.nLegit = 10;
+    prm.nAttackers = 1;
+    prm.bottleneckBw = "10Mbps";
+    prm.bottleneckDelay = "20ms";
+    prm.pktSize = 1000;
+    prm.attackPeriod = 1.0;
+    prm.attackBurst = 0.1;
+    prm.attackRate = "10Mbps";
+    prm.spoofing = "None";
+    prm.attackStart = 5.0;
+    prm.stopTime = 30.0;
+    prm.costPackets = 200000;
+    prm.costFlows = 1000;
+    uint32_t queueDiscLimitPackets = 100;
+    double minTh = 20;
+    double maxTh = 60;
+
+    // options for arguments
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("modes", "Comma list of modes: red, ared, feng, nlred, rred", modes);
+    cmd.AddValue("nLegit", "Legitimate TCP flows", prm.nLegit);
+    cmd.AddValue("nAttackers", "Low-rate DoS sources", prm.nAttackers);
+    cmd.AddValue("bottleNeckLinkBw", "Bottleneck bandwidth", prm.bottleneckBw);
+    cmd.AddValue("bottleNeckLinkDelay", "Bottleneck delay", prm.bottleneckDelay);
+    cmd.AddValue("appPktSize", "Packet size of every source", prm.pktSize);
+    cmd.AddValue("attackPeriod", "Pulse period in seconds", prm.attackPeriod);
+    cmd.AddValue("attackBurst", "Pulse length in seconds", prm.attackBurst);
+    cmd.AddValue("attackRate", "Pulse peak rate of each attacker", prm.attackRate);
+    cmd.AddValue("spoofing", "Attacker source spoofing: None, Fixed or Random", prm.spoofing);
+    cmd.AddValue("attackStart", "First pulse time in seconds", prm.attackStart);
+    cmd.AddValue("stopTime", "Simulation time in seconds", prm.stopTime);
+    cmd.AddValue("costPackets", "Enqueues of the enqueue cost measurement", prm.costPackets);
+    cmd.AddValue("costFlows", "Flows of the enqueue cost measurement", prm.costFlows);
+    cmd.AddValue("queueDiscLimitPackets", "Max Packets allowed in the queue disc", queueDiscLimitPackets);
+    cmd.AddValue("redMinTh", "RED queue minimum threshold (in packets)", minTh);
+    cmd.AddValue("redMaxTh", "RED queue maximum threshold (in packets)", maxTh);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_IF(prm.nLegit == 0 || prm.costPackets == 0 || prm.costFlows == 0,
+                    "nLegit, costPackets and costFlows must be positive");
+
+    // default configuration for queue implementation
+    Config::SetDefault("ns3::RedQueueDisc::MaxSize",
+                       QueueSizeValue(QueueSize(QueueSizeUnit::PACKETS, queueDiscLimitPackets)));
+    Config::SetDefault("ns3::RedQueueDisc::MinTh", DoubleValue(minTh));
+    Config::SetDefault("ns3::RedQueueDisc::MaxTh", DoubleValue(maxTh));
+    Config::SetDefault("ns3::RedQueueDisc::LinkBandwidth", StringValue(prm.bottleneckBw));
+    Config::SetDefault("ns3::RedQueueDisc::LinkDelay", StringValue(prm.bottleneckDelay));
+    Config::SetDefault("ns3::RedQueueDisc::MeanPktSize", UintegerValue(prm.pktSize));
+
+    std::ofstream csv("rred_bench.csv");
+    csv << "mode,goodput_kbps,legit_goodput_attacked_kbps,retention_pct,detection_ms,attack_drop_pct,enqueue_ns" << std::endl;
+    std::cout << std::left << std::setw(8) << "mode" << std::setw(14) << "goodput_kbps" << std::setw(14)
+              << "attacked_kbps" << std::setw(14) << "retention_%" << std::setw(14) << "detection_ms"
+              << std::setw(14) << "attack_drop_%" << "enqueue_ns" << std::endl;
+
+    for (const RedVariant &mode : RedVariant::ParseList(modes))
+    {
+        RunResult base = RunScenario(mode, false, prm);
+        RunResult attacked = RunScenario(mode, true, prm);
+        double cost = MeasureEnqueueCost(mode, prm);
+
+        double retention = base.legitGoodputBps > 0 ? attacked.legitGoodputBps * 100 / base.legitGoodputBps : 0;
+        // -1 when no attack packet was ever dropped early
+        double detection = attacked.firstDetection == Time::Max()
+                               ? -1
+                               : (attacked.firstDetection - Seconds(prm.attackStart)).GetMilliSeconds();
+        double attackDrop = attacked.attackArrivals > 0 ? attacked.attackDrops * 100.0 / attacked.attackArrivals : 0;
+
+        csv << mode.name << "," << base.legitGoodputBps / 1024 << "," << attacked.legitGoodputBps / 1024 << ","
+            << retention << "," << detection << "," << attackDrop << "," << cost << std::endl;
+        std::cout << std::left << std::setw(8) << mode.name << std::setw(14) << base.legitGoodputBps / 1024
+                  << std::setw(14) << attacked.legitGoodputBps / 1024 << std::setw(14) << retention
+                  << std::setw(14) << detection << std::setw(14) << attackDrop << cost << std::endl;
+    }
+    return 0;
+}
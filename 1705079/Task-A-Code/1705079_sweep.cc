@@ -0,0 +1,432 @@
+
+// author :  kazi wasif amin shammo 1705079
+// Parameter sweep driver for 1705079_base
+//
+// Runs every configuration of a grid (or of a list file) through the
+// already built 1705079_base binary, several processes at a time, and
+// appends the totals printed by each run to one CSV results table.
+//
+//   ./waf shell
+//   ./build/scratch/ns3.35-1705079_sweep-optimized
+//       --binary=build/scratch/ns3.35-1705079_base-optimized
+//       --grid="nLeftLeafCount=10,20;redMinTh=5,15;redMaxTh=30,45;appDataRate=1Mbps,10Mbps;modeBytes=0,1"
+//
+// A list file has one configuration per line, e.g.
+//   nLeftLeafCount=10 redMinTh=5 redMaxTh=30
+//
+// Every run gets its own directory under outDir, so trace and flow files
+// of concurrent runs do not collide; it is named after the configuration,
+// with characters unsafe in a file name replaced and a hash appended.
+// exit_status is the exit code of the run, or minus the signal that
+// killed it.  Results are appended as runs finish;
+// restarting with the same outDir skips configurations already in the
+// table.  With --retryFailed the rows of failed configurations are removed
+// and replaced by the rows of their new runs.
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+namespace
+{
+    // one configuration: ordered (parameter, value) pairs
+    typedef std::vector<std::pair<std::string, std::string>> Config;
+
+    // metrics read from the "Total Results" block of 1705079_base, in
+    // column order: (column name, prefix of the output line)
+    const char *const METRICS[][2] = {
+        {"sent_packets", "Total sent packets"},
+        {"received_packets", "Total Received Packets"},
+        {"lost_packets", "Total Lost Packets"},
+        {"loss_ratio_pct", "Packet Loss ratio"},
+        {"delivery_ratio_pct", "Packet delivery ratio"},
+        {"avg_throughput_kbps", "Average Throughput"},
+        {"avg_delay_s", "Average End to End Delay"},
+        {"flow_count", "Total flow count"},
+        {"legit_goodput_kbps", "Legitimate goodput"},
+        {"attack_goodput_kbps", "Attack goodput"},
+        {"jain_mean", "Jain fairness index mean"},
+    };
+    const std::size_t N_METRICS = sizeof(METRICS) / sizeof(METRICS[0]);
+
+    std::vector<std::string>
+    Split(const std::string &s, char sep)
+    {
+        std::vector<std::string> out;
+        std::string item;
+        std::istringstream is(s);
+        while (std::getline(is, item, sep))
+        {
+            if (!item.empty())
+            {
+                out.push_back(item);
+            }
+        }
+        return out;
+    }
+
+    // "a=1,2;b=x,y" -> cartesian product, first parameter varying slowest
+    std::vector<Config>
+    ParseGrid(const std::string &spec)
+    {
+        std::vector<Config> configs(1);
+        for (const std::string &axis : Split(spec, ';'))
+        {
+            std::size_t eq = axis.find('=');
+            NS_ABORT_MSG_IF(eq == std::string::npos, "Malformed grid axis " << axis);
+            std::string name = axis.substr(0, eq);
+            std::vector<std::string> values = Split(axis.substr(eq + 1), ',');
+            NS_ABORT_MSG_IF(values.empty(), "Grid axis " << name << " has no values");
+
+            std::vector<Config> next;
+            for (const Config &c : configs)
+            {
+                for (const std::string &v : values)
+                {
+                    next.push_back(c);
+                    next.back().push_back(std::make_pair(name, v));
+                }
+            }
+            configs.swap(next);
+        }
+        return configs;
+    }
+
+    // one "a=1 b=x" configuration per line, '#' starts a comment
+    std::vector<Config>
+    ParseList(const std::string &filename)
+    {
+        std::ifstream in(filename);
+        NS_ABORT_MSG_UNLESS(in, "Cannot open list " << filename);
+        std::vector<Config> configs;
+        std::string line;
+        while (std::getline(in, line))
+        {
+            line = line.substr(0, line.find('#'));
+            Config c;
+            std::istringstream is(line);
+            std::string item;
+            while (is >> item)
+            {
+                std::size_t eq = item.find('=');
+                NS_ABORT_MSG_IF(eq == std::string::npos, "Malformed list entry " << item);
+                c.push_back(std::make_pair(item.substr(0, eq), item.substr(eq + 1)));
+            }
+            if (!c.empty())
+            {
+                configs.push_back(c);
+            }
+        }
+        return configs;
+    }
+
+    // canonical text of a configuration, used as the resume key
+    std::string
+    Key(const Config &c)
+    {
+        std::string key;
+        for (const auto &p : c)
+        {
+            key += (key.empty() ? "" : "_") + p.first + "=" + p.second;
+        }
+        return key;
+    }
+
+    // run directory name of a key: characters that are not safe in a file
+    // name become '_', and a hash of the key keeps such names (and
+    // shortened long ones) apart
+    std::string
+    DirName(const std::string &key)
+    {
+        std::string name;
+        for (char ch : key)
+        {
+            bool safe = std::isalnum(static_cast<unsigned char>(ch)) || std::strchr("._=,+-", ch);
+            name += safe ? ch : '_';
+        }
+        if (name == key && name.size() <= 200 && name != "." && name != "..")
+        {
+            return name;
+        }
+        uint64_t hash = 14695981039346656037ull; // FNV-1a
+        for (char ch : key)
+        {
+            hash = (hash ^ static_cast<unsigned char>(ch)) * 1099511628211ull;
+        }
+        char suffix[24];
+        std::snprintf(suffix, sizeof(suffix), "_%016llx", static_cast<unsigned long long>(hash));
+        return name.substr(0, 200) + suffix;
+    }
+
+    // value after the first '=' of a line, converted to a plain number;
+    // times are printed by ns-3 with a unit suffix and reported in seconds
+    std::string
+    ParseValue(const std::string &line)
+    {
+        std::size_t eq = line.find('=');
+        std::string text = eq == std::string::npos ? line : line.substr(eq + 1);
+        const char *begin = text.c_str();
+        char *end;
+        double v = std::strtod(begin, &end);
+        if (end == begin)
+        {
+            return "";
+        }
+        std::string unit(end);
+        unit = unit.substr(0, unit.find_first_of(" \t%K"));
+        if (unit == "ns")
+        {
+            v *= 1e-9;
+        }
+        else if (unit == "us")
+        {
+            v *= 1e-6;
+        }
+        else if (unit == "ms")
+        {
+            v *= 1e-3;
+        }
+        std::ostringstream os;
+        os.precision(10);
+        os << v;
+        return os.str();
+    }
+
+    // runs one configuration and fills the metric columns; returns the
+    // exit code of the run, minus the signal number if a signal killed it
+    // and INT_MIN if it could not be started
+    int
+    Run(const std::string &binary, const std::string &dir, const Config &c, std::vector<std::string> &metrics)
+    {
+        // no shell: the values reach the program as they are, and a
+        // signal death is seen as such
+        std::vector<std::string> args(1, binary);
+        for (const auto &p : c)
+        {
+            args.push_back("--" + p.first + "=" + p.second);
+        }
+        std::vector<char *> argv;
+        for (std::string &a : args)
+        {
+            argv.push_back(&a[0]);
+        }
+        argv.push_back(0);
+        std::string logName = dir + "/run.log";
+
+        // only async-signal-safe calls between fork and exec, the sweep
+        // has other threads
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            int fd = open(logName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0 || chdir(dir.c_str()) != 0 || dup2(fd, 1) < 0 || dup2(fd, 2) < 0)
+            {
+                _exit(127);
+            }
+            close(fd);
+            execv(argv[0], argv.data());
+            _exit(127);
+        }
+        int status = 0;
+        if (pid < 0 || waitpid(pid, &status, 0) != pid)
+        {
+            metrics.assign(N_METRICS, "");
+            return INT_MIN;
+        }
+
+        metrics.assign(N_METRICS, "");
+        std::ifstream log(logName);
+        std::string line;
+        while (std::getline(log, line))
+        {
+            for (std::size_t m = 0; m < N_METRICS; ++m)
+            {
+                if (line.compare(0, std::strlen(METRICS[m][1]), METRICS[m][1]) == 0)
+                {
+                    // "Total flow count N" has no '='
+                    metrics[m] = ParseValue(line.find('=') == std::string::npos
+                                                ? line.substr(std::strlen(METRICS[m][1]))
+                                                : line);
+                }
+            }
+        }
+        if (WIFSIGNALED(status))
+        {
+            return -WTERMSIG(status);
+        }
+        return WIFEXITED(status) ? WEXITSTATUS(status) : INT_MIN;
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string binary = "build/scratch/ns3.35-1705079_base-optimized";
+    std::string grid;
+    std::string list;
+    std::string outDir = "sweep";
+    uint32_t jobs = std::thread::hardware_concurrency();
+    bool retryFailed = false;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("binary", "Path of the built 1705079_base program", binary);
+    cmd.AddValue("grid", "Grid spec: name=v1,v2;name=v1,v2;...", grid);
+    cmd.AddValue("list", "File with one configuration (name=value ...) per line", list);
+    cmd.AddValue("outDir", "Directory of the run directories and of results.csv", outDir);
+    cmd.AddValue("jobs", "Concurrent runs (default: number of cores)", jobs);
+    cmd.AddValue("retryFailed", "Run again configurations that exited with an error", retryFailed);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_IF(grid.empty() == list.empty(), "Give exactly one of --grid and --list");
+    std::vector<Config> configs = grid.empty() ? ParseList(list) : ParseGrid(grid);
+    jobs = std::max<uint32_t>(jobs, 1);
+
+    // the runs change directory, so the binary path must not be relative
+    char resolved[PATH_MAX];
+    NS_ABORT_MSG_UNLESS(realpath(binary.c_str(), resolved), "Cannot find " << binary);
+    binary = resolved;
+    NS_ABORT_MSG_IF(mkdir(outDir.c_str(), 0755) != 0 && errno != EEXIST, "Cannot create " << outDir);
+
+    // resume: configurations with a row in the table are done, unless they
+    // failed and retryFailed is set.  The rows of the configurations run
+    // again are removed from the table first, and of several rows of one
+    // configuration only the last is kept, so that every configuration has
+    // at most one row.
+    std::string results = outDir + "/results.csv";
+    std::set<std::string> done;
+    {
+        std::vector<std::string> lines;
+        std::map<std::string, std::size_t> lastRow;
+        std::ifstream in(results);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::vector<std::string> fields = Split(line, ',');
+            if (fields.size() >= 2 && fields[0] != "config")
+            {
+                lastRow[fields[0]] = lines.size();
+            }
+            lines.push_back(line);
+        }
+        in.close();
+
+        std::vector<std::string> kept;
+        for (std::size_t i = 0; i < lines.size(); ++i)
+        {
+            std::vector<std::string> fields = Split(lines[i], ',');
+            if (fields.size() >= 2 && fields[0] != "config")
+            {
+                if (lastRow[fields[0]] != i || (retryFailed && fields[1] != "0"))
+                {
+                    continue;
+                }
+                done.insert(fields[0]);
+            }
+            kept.push_back(lines[i]);
+        }
+        if (kept.size() != lines.size())
+        {
+            // replace the table in one step, a crash leaves either version
+            std::string tmp = results + ".tmp";
+            std::ofstream rewritten(tmp);
+            for (const std::string &l : kept)
+            {
+                rewritten << l << "\n";
+            }
+            rewritten.close();
+            NS_ABORT_MSG_UNLESS(rewritten && std::rename(tmp.c_str(), results.c_str()) == 0,
+                                "Cannot rewrite " << results);
+        }
+    }
+
+    std::vector<std::size_t> pending;
+    for (std::size_t i = 0; i < configs.size(); ++i)
+    {
+        if (done.count(Key(configs[i])) == 0)
+        {
+            pending.push_back(i);
+        }
+    }
+    NS_LOG_UNCOND(configs.size() << " configurations, " << configs.size() - pending.size()
+                                 << " already done, " << pending.size() << " to run on " << jobs << " workers");
+
+    std::FILE *out = std::fopen(results.c_str(), "a");
+    NS_ABORT_MSG_UNLESS(out, "Cannot open " << results);
+    if (std::ftell(out) == 0)
+    {
+        std::fprintf(out, "config,exit_status");
+        for (std::size_t m = 0; m < N_METRICS; ++m)
+        {
+            std::fprintf(out, ",%s", METRICS[m][0]);
+        }
+        std::fprintf(out, "\n");
+        std::fflush(out);
+    }
+
+    // work queue: workers take the next pending configuration until none
+    // is left; rows are appended and flushed as soon as a run completes
+    std::atomic<std::size_t> next(0);
+    std::mutex outMutex;
+    std::size_t finished = 0;
+    auto worker = [&]()
+    {
+        std::vector<std::string> metrics;
+        for (std::size_t i = next++; i < pending.size(); i = next++)
+        {
+            const Config &c = configs[pending[i]];
+            std::string key = Key(c);
+            std::string dir = outDir + "/" + DirName(key);
+            if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)
+            {
+                std::cerr << "Cannot create " << dir << std::endl;
+                continue;
+            }
+            int status = Run(binary, dir, c, metrics);
+
+            std::lock_guard<std::mutex> lock(outMutex);
+            std::fprintf(out, "%s,%d", key.c_str(), status);
+            for (const std::string &m : metrics)
+            {
+                std::fprintf(out, ",%s", m.c_str());
+            }
+            std::fprintf(out, "\n");
+            std::fflush(out);
+            ++finished;
+            NS_LOG_UNCOND("[" << finished << "/" << pending.size() << "] " << key << " exit " << status);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t j = 0; j < jobs; ++j)
+    {
+        threads.push_back(std::thread(worker));
+    }
+    for (std::thread &t : threads)
+    {
+        t.join();
+    }
+    std::fclose(out);
+    return 0;
+}
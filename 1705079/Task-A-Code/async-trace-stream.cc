@@ -0,0 +1,506 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "async-trace-stream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace ns3
+{
+
+  NS_LOG_COMPONENT_DEFINE("AsyncTraceStream");
+
+  AsyncTraceStreamBuf::AsyncTraceStreamBuf(const std::string &filename, Compression compression,
+                                           std::size_t bufferSize, std::size_t memoryBudget)
+      : m_file(0),
+        m_compression(compression),
+        m_bufferSize(std::max<std::size_t>(bufferSize, 4096)),
+        m_current(0),
+        m_closing(false),
+        m_closed(false),
+        m_droppedBytes(0),
+        m_writtenBytes(0),
+        m_gapBytes(0),
+        m_gapStart(0),
+        m_gapMarkerSize(0),
+        m_codec(0)
+  {
+    NS_LOG_FUNCTION(this << filename << compression << bufferSize << memoryBudget);
+
+    m_file = std::fopen(filename.c_str(), "wb");
+    NS_ABORT_MSG_UNLESS(m_file, "AsyncTraceStreamBuf: cannot open " << filename);
+
+    switch (m_compression)
+    {
+    case NONE:
+      break;
+    case GZIP:
+    {
+#ifdef HAVE_ZLIB
+      z_stream *zs = new z_stream();
+      // windowBits 15 + 16 selects the gzip container; level 1 keeps the
+      // writer thread ahead of the simulator on trace-heavy runs
+      int ret = deflateInit2(zs, 1, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+      NS_ABORT_MSG_UNLESS(ret == Z_OK, "AsyncTraceStreamBuf: deflateInit2 failed");
+      m_codec = zs;
+#else
+      NS_FATAL_ERROR("AsyncTraceStreamBuf: gzip requested but built without HAVE_ZLIB");
+#endif
+      break;
+    }
+    case ZSTD:
+    {
+#ifdef HAVE_ZSTD
+      ZSTD_CCtx *cctx = ZSTD_createCCtx();
+      NS_ABORT_MSG_UNLESS(cctx, "AsyncTraceStreamBuf: ZSTD_createCCtx failed");
+      ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, 1);
+      m_codec = cctx;
+#else
+      NS_FATAL_ERROR("AsyncTraceStreamBuf: zstd requested but built without HAVE_ZSTD");
+#endif
+      break;
+    }
+    }
+    m_codecOut.resize(m_compression == NONE ? 0 : m_bufferSize / 2 + 1024);
+
+    // Double buffering is the minimum; anything above that is bounded by the budget
+    std::size_t nBuffers = std::max<std::size_t>(2, memoryBudget / m_bufferSize);
+    for (std::size_t i = 0; i < nBuffers; ++i)
+    {
+      m_pool.emplace_back(new Buffer(m_bufferSize));
+      m_free.push_back(m_pool.back().get());
+    }
+    m_current = m_free.back();
+    m_free.pop_back();
+    ResetPutArea();
+
+    m_writer = std::thread(&AsyncTraceStreamBuf::WriterLoop, this);
+  }
+
+  AsyncTraceStreamBuf::~AsyncTraceStreamBuf()
+  {
+    NS_LOG_FUNCTION(this);
+    Close();
+  }
+
+  AsyncTraceStreamBuf::Compression
+  AsyncTraceStreamBuf::ParseCompression(const std::string &name)
+  {
+    if (name == "none")
+    {
+      return NONE;
+    }
+    if (name == "gzip")
+    {
+      NS_ABORT_MSG_UNLESS(IsAvailable(GZIP), "gzip trace compression needs a build with "
+                                             "CXXFLAGS=-DHAVE_ZLIB LINKFLAGS=-lz");
+      return GZIP;
+    }
+    if (name == "zstd")
+    {
+      NS_ABORT_MSG_UNLESS(IsAvailable(ZSTD), "zstd trace compression needs a build with "
+                                             "CXXFLAGS=-DHAVE_ZSTD LINKFLAGS=-lzstd");
+      return ZSTD;
+    }
+    NS_FATAL_ERROR("Unknown trace compression " << name << " (use none, gzip or zstd)");
+    return NONE;
+  }
+
+  bool
+  AsyncTraceStreamBuf::IsAvailable(Compression compression)
+  {
+    switch (compression)
+    {
+    case NONE:
+      return true;
+    case GZIP:
+#ifdef HAVE_ZLIB
+      return true;
+#else
+      return false;
+#endif
+    case ZSTD:
+#ifdef HAVE_ZSTD
+      return true;
+#else
+      return false;
+#endif
+    }
+    return false;
+  }
+
+  void
+  AsyncTraceStreamBuf::ResetPutArea(void)
+  {
+    char *begin = m_current->data();
+    setp(begin, begin + m_bufferSize);
+  }
+
+  void
+  AsyncTraceStreamBuf::Handoff(void)
+  {
+    std::size_t used = pptr() - pbase();
+    if (used == 0)
+    {
+      return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_free.empty())
+    {
+      // The writer is behind and the budget is exhausted: never block the
+      // simulator, drop lines of this buffer instead
+      lock.unlock();
+      DropLines();
+      return;
+    }
+    m_current->resize(used);
+    m_full.push_back(m_current);
+    m_current = m_free.back();
+    m_free.pop_back();
+    lock.unlock();
+    m_cv.notify_one();
+    ResetPutArea();
+    m_gapBytes = 0;
+    m_gapMarkerSize = 0;
+  }
+
+  void
+  AsyncTraceStreamBuf::DropLines(void)
+  {
+    char *begin = pbase();
+    std::size_t used = pptr() - begin;
+
+    // Keep the end of the line the previous buffer stopped in (or what
+    // precedes the marker of an earlier drop into this buffer)...
+    std::size_t lead;
+    std::size_t start;
+    if (m_gapMarkerSize > 0)
+    {
+      lead = m_gapStart;
+      start = m_gapStart + m_gapMarkerSize;
+    }
+    else
+    {
+      const char *eol = static_cast<const char *>(std::memchr(begin, '\n', used));
+      lead = eol ? eol + 1 - begin : 0;
+      start = lead;
+    }
+    // ...and the start of the line being written
+    std::size_t tail = start;
+    for (std::size_t i = used; i > start; --i)
+    {
+      if (begin[i - 1] == '\n')
+      {
+        tail = i;
+        break;
+      }
+    }
+    std::size_t partial = used - tail;
+    std::size_t dropped = tail - start;
+
+    // Keeping them must free at least half of the buffer; lines longer
+    // than that are cut
+    const std::size_t maxMarker = 64;
+    if (lead + maxMarker + partial > m_bufferSize / 2)
+    {
+      dropped += partial;
+      partial = 0;
+    }
+    if (lead + maxMarker > m_bufferSize / 2)
+    {
+      dropped += lead;
+      lead = 0;
+    }
+    m_droppedBytes += dropped;
+    m_gapBytes += dropped;
+
+    char marker[maxMarker];
+    int n = std::snprintf(marker, sizeof(marker), "# trace gap: %llu bytes dropped\n",
+                          static_cast<unsigned long long>(m_gapBytes));
+    std::memmove(begin + lead + n, begin + tail, partial);
+    std::memcpy(begin + lead, marker, n);
+    m_gapStart = lead;
+    m_gapMarkerSize = n;
+
+    ResetPutArea();
+    // pbump takes an int, the kept bytes are bounded by the buffer size
+    pbump(static_cast<int>(lead + n + partial));
+  }
+
+  AsyncTraceStreamBuf::int_type
+  AsyncTraceStreamBuf::overflow(int_type ch)
+  {
+    if (m_closed)
+    {
+      return traits_type::eof();
+    }
+    Handoff();
+    if (!traits_type::eq_int_type(ch, traits_type::eof()))
+    {
+      *pptr() = traits_type::to_char_type(ch);
+      pbump(1);
+      m_writtenBytes++;
+    }
+    return traits_type::not_eof(ch);
+  }
+
+  std::streamsize
+  AsyncTraceStreamBuf::xsputn(const char *s, std::streamsize n)
+  {
+    if (m_closed)
+    {
+      return 0;
+    }
+    std::streamsize left = n;
+    while (left > 0)
+    {
+      std::streamsize room = epptr() - pptr();
+      if (room == 0)
+      {
+        Handoff();
+        continue;
+      }
+      std::streamsize chunk = std::min(room, left);
+      std::memcpy(pptr(), s, chunk);
+      // pbump takes an int, chunk is bounded by the buffer size
+      pbump(static_cast<int>(chunk));
+      s += chunk;
+      left -= chunk;
+    }
+    m_writtenBytes += n;
+    return n;
+  }
+
+  int
+  AsyncTraceStreamBuf::sync(void)
+  {
+    // See the class documentation: flushes are deferred to buffer handoff
+    return 0;
+  }
+
+  void
+  AsyncTraceStreamBuf::WriterLoop(void)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+      m_cv.wait(lock, [this]
+                { return !m_full.empty() || m_closing; });
+      if (m_full.empty())
+      {
+        // closing and drained
+        break;
+      }
+      Buffer *buf = m_full.front();
+      m_full.pop_front();
+      lock.unlock();
+
+      WriteChunk(buf->data(), buf->size(), false);
+      buf->resize(m_bufferSize);
+
+      lock.lock();
+      m_free.push_back(buf);
+    }
+    lock.unlock();
+    WriteChunk(0, 0, true);
+  }
+
+  void
+  AsyncTraceStreamBuf::WriteChunk(const char *data, std::size_t size, bool finish)
+  {
+    (void)finish; // only the compressors need to terminate their stream
+    switch (m_compression)
+    {
+    case NONE:
+      if (size > 0)
+      {
+        std::fwrite(data, 1, size, m_file);
+      }
+      break;
+    case GZIP:
+    {
+#ifdef HAVE_ZLIB
+      z_stream *zs = static_cast<z_stream *>(m_codec);
+      zs->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+      zs->avail_in = static_cast<uInt>(size);
+      int ret;
+      do
+      {
+        zs->next_out = reinterpret_cast<Bytef *>(m_codecOut.data());
+        zs->avail_out = static_cast<uInt>(m_codecOut.size());
+        ret = deflate(zs, finish ? Z_FINISH : Z_NO_FLUSH);
+        std::fwrite(m_codecOut.data(), 1, m_codecOut.size() - zs->avail_out, m_file);
+      } while (zs->avail_out == 0 || (finish && ret != Z_STREAM_END));
+#endif
+      break;
+    }
+    case ZSTD:
+    {
+#ifdef HAVE_ZSTD
+      ZSTD_CCtx *cctx = static_cast<ZSTD_CCtx *>(m_codec);
+      ZSTD_inBuffer in = {data, size, 0};
+      std::size_t remaining;
+      do
+      {
+        ZSTD_outBuffer out = {m_codecOut.data(), m_codecOut.size(), 0};
+        remaining = ZSTD_compressStream2(cctx, &out, &in, finish ? ZSTD_e_end : ZSTD_e_continue);
+        std::fwrite(m_codecOut.data(), 1, out.pos, m_file);
+      } while (in.pos < in.size || (finish && remaining != 0));
+#endif
+      break;
+    }
+    }
+  }
+
+  void
+  AsyncTraceStreamBuf::Close(void)
+  {
+    NS_LOG_FUNCTION(this);
+    if (m_closed)
+    {
+      return;
+    }
+
+    std::size_t used = pptr() - pbase();
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      // The last buffer does not need a replacement, so it is never dropped
+      if (used > 0)
+      {
+        m_current->resize(used);
+        m_full.push_back(m_current);
+      }
+      m_current = 0;
+      m_closing = true;
+    }
+    m_cv.notify_one();
+    m_writer.join();
+    m_closed = true;
+    setp(0, 0);
+
+#ifdef HAVE_ZLIB
+    if (m_compression == GZIP)
+    {
+      z_stream *zs = static_cast<z_stream *>(m_codec);
+      deflateEnd(zs);
+      delete zs;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if (m_compression == ZSTD)
+    {
+      ZSTD_freeCCtx(static_cast<ZSTD_CCtx *>(m_codec));
+    }
+#endif
+    m_codec = 0;
+
+    std::fclose(m_file);
+    m_file = 0;
+
+    if (m_droppedBytes > 0)
+    {
+      NS_LOG_WARN("Trace writer fell behind, " << m_droppedBytes << " of " << m_writtenBytes
+                                               << " bytes were discarded");
+    }
+  }
+
+  uint64_t
+  AsyncTraceStreamBuf::GetDroppedBytes(void) const
+  {
+    return m_droppedBytes;
+  }
+
+  uint64_t
+  AsyncTraceStreamBuf::GetWrittenBytes(void) const
+  {
+    return m_writtenBytes;
+  }
+
+  AsyncTraceStream::AsyncTraceStream(const std::string &filename,
+                                     AsyncTraceStreamBuf::Compression compression,
+                                     std::size_t bufferSize, std::size_t memoryBudget)
+      : std::ostream(0),
+        m_buf(filename, compression, bufferSize, memoryBudget)
+  {
+    rdbuf(&m_buf);
+  }
+
+  AsyncTraceStreamBuf *
+  AsyncTraceStream::GetBuf(void)
+  {
+    return &m_buf;
+  }
+
+  AsyncTraceHelper::AsyncTraceHelper(AsyncTraceStreamBuf::Compression compression,
+                                     std::size_t bufferSize, std::size_t memoryBudget)
+      : m_compression(compression),
+        m_bufferSize(bufferSize),
+        m_memoryBudget(memoryBudget),
+        m_nClosed(0)
+  {
+    NS_LOG_FUNCTION(this << compression << bufferSize << memoryBudget);
+  }
+
+  AsyncTraceHelper::~AsyncTraceHelper()
+  {
+    NS_LOG_FUNCTION(this);
+    Close();
+  }
+
+  Ptr<OutputStreamWrapper>
+  AsyncTraceHelper::CreateFileStream(std::string filename)
+  {
+    NS_LOG_FUNCTION(this << filename);
+    if (m_compression == AsyncTraceStreamBuf::GZIP)
+    {
+      filename += ".gz";
+    }
+    else if (m_compression == AsyncTraceStreamBuf::ZSTD)
+    {
+      filename += ".zst";
+    }
+    m_streams.emplace_back(new AsyncTraceStream(filename, m_compression, m_bufferSize, m_memoryBudget));
+    return Create<OutputStreamWrapper>(m_streams.back().get());
+  }
+
+  void
+  AsyncTraceHelper::Close(void)
+  {
+    NS_LOG_FUNCTION(this);
+    for (; m_nClosed < m_streams.size(); ++m_nClosed)
+    {
+      AsyncTraceStreamBuf *buf = m_streams[m_nClosed]->GetBuf();
+      buf->Close();
+      if (buf->GetDroppedBytes() > 0)
+      {
+        std::cout << "Trace writer discarded " << buf->GetDroppedBytes() << " bytes, raise the trace memory budget" << std::endl;
+      }
+    }
+  }
+
+} // namespace ns3
@@ -0,0 +1,265 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ASYNC_TRACE_STREAM_H
+#define ASYNC_TRACE_STREAM_H
+
+#include "ns3/output-stream-wrapper.h"
+#include "ns3/ptr.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ns3
+{
+
+  /**
+   * \ingroup traffic-control
+   *
+   * \brief A streambuf that formats into large buffers and hands full
+   * buffers to a background writer thread.
+   *
+   * The simulator thread only ever copies bytes into the current buffer.
+   * When it is full, the buffer is queued for the writer thread and a free
+   * one is taken from the pool.  The pool size is bounded by the memory
+   * budget; if the writer falls behind and no free buffer is left, the
+   * complete lines of the full buffer are discarded (and accounted for)
+   * instead of blocking the simulation.  The line the previous buffer
+   * ended in and the line this one ends in are kept, and a
+   * "# trace gap: N bytes dropped" line takes the place of the discarded
+   * ones, so that the file never splices two partial lines.  Only a line
+   * longer than half a buffer can still be cut.
+   *
+   * sync () is deliberately a no-op: the ns-3 ascii trace sinks terminate
+   * every line with std::endl, and flushing on each of them would defeat
+   * the buffering.  Data reaches the file when a buffer fills up and on
+   * Close ().
+   */
+  class AsyncTraceStreamBuf : public std::streambuf
+  {
+  public:
+    /**
+     * \brief Compression applied by the writer thread
+     *
+     * GZIP and ZSTD are compiled in only when HAVE_ZLIB or HAVE_ZSTD is
+     * defined and the program is linked with -lz or -lzstd, e.g.
+     *
+     *   CXXFLAGS="-DHAVE_ZLIB -DHAVE_ZSTD" LINKFLAGS="-lz -lzstd" ./waf configure
+     */
+    enum Compression
+    {
+      NONE, //!< Plain text
+      GZIP, //!< gzip container (requires HAVE_ZLIB)
+      ZSTD, //!< zstd frame (requires HAVE_ZSTD)
+    };
+
+    /**
+     * \brief Constructor
+     *
+     * \param filename output file name
+     * \param compression compression applied by the writer thread
+     * \param bufferSize size in bytes of each formatting buffer
+     * \param memoryBudget upper bound in bytes for all buffers (at least two
+     *        buffers are always allocated)
+     */
+    AsyncTraceStreamBuf(const std::string &filename, Compression compression,
+                        std::size_t bufferSize, std::size_t memoryBudget);
+
+    /**
+     * \brief Destructor, closes the stream if still open
+     */
+    virtual ~AsyncTraceStreamBuf();
+
+    /**
+     * \brief Hand the pending buffer to the writer, wait for it to drain
+     * and close the file.
+     */
+    void Close(void);
+
+    /**
+     * \returns the number of bytes discarded because the memory budget
+     * was exhausted
+     */
+    uint64_t GetDroppedBytes(void) const;
+
+    /**
+     * \returns the number of bytes accepted from the simulator thread
+     */
+    uint64_t GetWrittenBytes(void) const;
+
+    /**
+     * \brief Parse a compression name ("none", "gzip" or "zstd")
+     *
+     * A compression that was not compiled in is a fatal error here, before
+     * the simulation is set up.
+     *
+     * \param name the compression name
+     * \returns the compression
+     */
+    static Compression ParseCompression(const std::string &name);
+
+    /**
+     * \param compression a compression
+     * \returns true if the compression was compiled in
+     */
+    static bool IsAvailable(Compression compression);
+
+  protected:
+    virtual int_type overflow(int_type ch);
+    virtual std::streamsize xsputn(const char *s, std::streamsize n);
+    virtual int sync(void);
+
+  private:
+    typedef std::vector<char> Buffer; //!< A formatting buffer
+
+    /**
+     * \brief Queue the current buffer for the writer and take a free one
+     */
+    void Handoff(void);
+    /**
+     * \brief Discard the complete lines of the current buffer and write a
+     * gap marker in their place
+     */
+    void DropLines(void);
+    /**
+     * \brief Set the put area to the current buffer
+     */
+    void ResetPutArea(void);
+    /**
+     * \brief Body of the writer thread
+     */
+    void WriterLoop(void);
+    /**
+     * \brief Compress (if needed) and write a chunk of data to the file
+     * \param data the data
+     * \param size the data size
+     * \param finish true on the last call, to terminate the compressed stream
+     */
+    void WriteChunk(const char *data, std::size_t size, bool finish);
+
+    std::FILE *m_file;          //!< Output file, only used by the writer thread
+    Compression m_compression;  //!< Compression in use
+    std::size_t m_bufferSize;   //!< Size of each buffer
+    Buffer *m_current;          //!< Buffer being filled by the simulator thread
+    std::vector<std::unique_ptr<Buffer>> m_pool; //!< Owner of all buffers
+    std::vector<Buffer *> m_free;  //!< Buffers available to the simulator thread
+    std::deque<Buffer *> m_full;   //!< Buffers waiting for the writer thread
+    std::mutex m_mutex;            //!< Protects m_free, m_full and m_closing
+    std::condition_variable m_cv;  //!< Signals the writer thread
+    bool m_closing;                //!< True once Close () has been called
+    bool m_closed;                 //!< True once the writer thread has been joined
+    uint64_t m_droppedBytes;       //!< Bytes discarded for lack of buffers
+    uint64_t m_writtenBytes;       //!< Bytes accepted from the simulator thread
+    uint64_t m_gapBytes;           //!< Bytes dropped since the current buffer was taken
+    std::size_t m_gapStart;        //!< Offset of the gap marker in the current buffer
+    std::size_t m_gapMarkerSize;   //!< Size of the gap marker, 0 if there is none
+    void *m_codec;                 //!< Compression context (z_stream or ZSTD_CStream)
+    std::vector<char> m_codecOut;  //!< Compression output scratch buffer
+    std::thread m_writer;          //!< Background writer thread
+  };
+
+  /**
+   * \ingroup traffic-control
+   *
+   * \brief An std::ostream that owns an AsyncTraceStreamBuf
+   */
+  class AsyncTraceStream : public std::ostream
+  {
+  public:
+    /**
+     * \brief Constructor, see AsyncTraceStreamBuf
+     * \param filename output file name
+     * \param compression compression applied by the writer thread
+     * \param bufferSize size in bytes of each formatting buffer
+     * \param memoryBudget upper bound in bytes for all buffers
+     */
+    AsyncTraceStream(const std::string &filename, AsyncTraceStreamBuf::Compression compression,
+                     std::size_t bufferSize, std::size_t memoryBudget);
+
+    /**
+     * \returns the underlying buffer
+     */
+    AsyncTraceStreamBuf *GetBuf(void);
+
+  private:
+    AsyncTraceStreamBuf m_buf; //!< The asynchronous buffer
+  };
+
+  /**
+   * \ingroup traffic-control
+   *
+   * \brief Drop-in replacement for AsciiTraceHelper::CreateFileStream that
+   * returns streams written by a background thread.
+   *
+   * OutputStreamWrapper does not own streams passed by pointer, so the
+   * helper keeps them and must outlive the simulation.  Call Close () once
+   * Simulator::Run () has returned; the destructor does it otherwise.
+   */
+  class AsyncTraceHelper
+  {
+  public:
+    /**
+     * \brief Constructor
+     * \param compression compression applied to every stream created
+     * \param bufferSize size in bytes of each formatting buffer
+     * \param memoryBudget upper bound in bytes for the buffers of one stream
+     */
+    AsyncTraceHelper(AsyncTraceStreamBuf::Compression compression = AsyncTraceStreamBuf::NONE,
+                     std::size_t bufferSize = 4 << 20, std::size_t memoryBudget = 64 << 20);
+
+    /**
+     * \brief Destructor, closes all streams
+     */
+    ~AsyncTraceHelper();
+
+    /**
+     * \brief Create an asynchronous file stream
+     *
+     * A ".gz" or ".zst" suffix is appended to the file name when compression
+     * is enabled.
+     *
+     * \param filename output file name
+     * \returns a wrapper usable with the Enable*Ascii* helper methods
+     */
+    Ptr<OutputStreamWrapper> CreateFileStream(std::string filename);
+
+    /**
+     * \brief Drain and close all streams, reporting discarded bytes
+     *
+     * Streams already closed by an earlier call are neither closed nor
+     * reported again.
+     */
+    void Close(void);
+
+  private:
+    AsyncTraceStreamBuf::Compression m_compression; //!< Compression for new streams
+    std::size_t m_bufferSize;                        //!< Buffer size for new streams
+    std::size_t m_memoryBudget;                      //!< Memory budget for new streams
+    std::vector<std::unique_ptr<AsyncTraceStream>> m_streams; //!< Streams created so far
+    std::size_t m_nClosed;                           //!< Streams already closed and reported
+  };
+
+} // namespace ns3
+
+#endif // ASYNC_TRACE_STREAM_H
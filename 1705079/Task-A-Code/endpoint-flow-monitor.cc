@@ -0,0 +1,327 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/callback.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv6-l3-protocol.h"
+#include "ns3/ipv4-queue-disc-item.h"
+#include "ns3/ipv6-queue-disc-item.h"
+#include "endpoint-flow-monitor.h"
+
+namespace ns3
+{
+
+  NS_LOG_COMPONENT_DEFINE("EndpointFlowMonitor");
+
+  NS_OBJECT_ENSURE_REGISTERED(EndpointTimestampTag);
+
+  TypeId
+  EndpointTimestampTag::GetTypeId(void)
+  {
+    static TypeId tid = TypeId("ns3::EndpointTimestampTag")
+                            .SetParent<Tag>()
+                            .SetGroupName("FlowMonitor")
+                            .AddConstructor<EndpointTimestampTag>();
+    return tid;
+  }
+
+  EndpointTimestampTag::EndpointTimestampTag()
+      : txTimeNs(0)
+  {
+  }
+
+  TypeId
+  EndpointTimestampTag::GetInstanceTypeId(void) const
+  {
+    return GetTypeId();
+  }
+
+  uint32_t
+  EndpointTimestampTag::GetSerializedSize(void) const
+  {
+    return 8;
+  }
+
+  void
+  EndpointTimestampTag::Serialize(TagBuffer buf) const
+  {
+    buf.WriteU64(static_cast<uint64_t>(txTimeNs));
+  }
+
+  void
+  EndpointTimestampTag::Deserialize(TagBuffer buf)
+  {
+    txTimeNs = static_cast<int64_t>(buf.ReadU64());
+  }
+
+  void
+  EndpointTimestampTag::Print(std::ostream &os) const
+  {
+    os << "txTimeNs=" << txTimeNs;
+  }
+
+  EndpointFlowMonitor::EndpointFlowMonitor()
+      : m_nextFlowId(1)
+  {
+    NS_LOG_FUNCTION(this);
+  }
+
+  void
+  EndpointFlowMonitor::InstallSources(NodeContainer nodes)
+  {
+    NS_LOG_FUNCTION(this);
+    for (NodeContainer::Iterator i = nodes.Begin(); i != nodes.End(); ++i)
+    {
+      Ptr<Ipv4L3Protocol> ipv4 = (*i)->GetObject<Ipv4L3Protocol>();
+      if (ipv4)
+      {
+        ipv4->TraceConnectWithoutContext("SendOutgoing", MakeCallback(&EndpointFlowMonitor::SendOutgoing4, this));
+      }
+      Ptr<Ipv6L3Protocol> ipv6 = (*i)->GetObject<Ipv6L3Protocol>();
+      if (ipv6)
+      {
+        ipv6->TraceConnectWithoutContext("SendOutgoing", MakeCallback(&EndpointFlowMonitor::SendOutgoing6, this));
+      }
+    }
+  }
+
+  void
+  EndpointFlowMonitor::InstallSinks(NodeContainer nodes)
+  {
+    NS_LOG_FUNCTION(this);
+    for (NodeContainer::Iterator i = nodes.Begin(); i != nodes.End(); ++i)
+    {
+      Ptr<Ipv4L3Protocol> ipv4 = (*i)->GetObject<Ipv4L3Protocol>();
+      if (ipv4)
+      {
+        ipv4->TraceConnectWithoutContext("LocalDeliver", MakeCallback(&EndpointFlowMonitor::LocalDeliver4, this));
+      }
+      Ptr<Ipv6L3Protocol> ipv6 = (*i)->GetObject<Ipv6L3Protocol>();
+      if (ipv6)
+      {
+        ipv6->TraceConnectWithoutContext("LocalDeliver", MakeCallback(&EndpointFlowMonitor::LocalDeliver6, this));
+      }
+    }
+  }
+
+  void
+  EndpointFlowMonitor::InstallQueueDiscs(QueueDiscContainer queueDiscs)
+  {
+    NS_LOG_FUNCTION(this);
+    for (QueueDiscContainer::ConstIterator i = queueDiscs.Begin(); i != queueDiscs.End(); ++i)
+    {
+      (*i)->TraceConnectWithoutContext("Drop", MakeCallback(&EndpointFlowMonitor::QueueDrop, this));
+      (*i)->TraceConnectWithoutContext("Mark", MakeCallback(&EndpointFlowMonitor::QueueMark, this));
+    }
+  }
+
+  const FlatFlowTable<EndpointFlowMonitor::FlowCounters> &
+  EndpointFlowMonitor::GetFlows(void) const
+  {
+    return m_flows;
+  }
+
+  void
+  EndpointFlowMonitor::ReadPorts(Ptr<const Packet> payload, FlowKey &key)
+  {
+    // TCP and UDP both start with the source and destination ports
+    if (key.protocol == 6 || key.protocol == 17)
+    {
+      uint8_t ports[4];
+      if (payload->CopyData(ports, 4) == 4)
+      {
+        key.srcPort = static_cast<uint16_t>((ports[0] << 8) | ports[1]);
+        key.dstPort = static_cast<uint16_t>((ports[2] << 8) | ports[3]);
+      }
+    }
+  }
+
+  void
+  EndpointFlowMonitor::MakeKey(const Ipv4Header &header, Ptr<const Packet> payload, FlowKey &key)
+  {
+    key.family = 4;
+    key.protocol = header.GetProtocol();
+    header.GetSource().Serialize(key.srcAddress);
+    header.GetDestination().Serialize(key.dstAddress);
+    ReadPorts(payload, key);
+  }
+
+  void
+  EndpointFlowMonitor::MakeKey(const Ipv6Header &header, Ptr<const Packet> payload, FlowKey &key)
+  {
+    key.family = 6;
+    key.protocol = header.GetNextHeader();
+    header.GetSourceAddress().Serialize(key.srcAddress);
+    header.GetDestinationAddress().Serialize(key.dstAddress);
+    ReadPorts(payload, key);
+  }
+
+  bool
+  EndpointFlowMonitor::MakeKey(Ptr<const QueueDiscItem> item, FlowKey &key)
+  {
+    Ptr<const Ipv4QueueDiscItem> item4 = DynamicCast<const Ipv4QueueDiscItem>(item);
+    if (item4)
+    {
+      MakeKey(item4->GetHeader(), item4->GetPacket(), key);
+      return true;
+    }
+    Ptr<const Ipv6QueueDiscItem> item6 = DynamicCast<const Ipv6QueueDiscItem>(item);
+    if (item6)
+    {
+      MakeKey(item6->GetHeader(), item6->GetPacket(), key);
+      return true;
+    }
+    return false;
+  }
+
+  EndpointFlowMonitor::FlowCounters &
+  EndpointFlowMonitor::Lookup(const FlowKey &key)
+  {
+    FlowCounters &counters = m_flows.FindOrInsert(key);
+    if (counters.flowId == 0)
+    {
+      counters.flowId = m_nextFlowId++;
+      counters.firstTxNs = -1;
+      counters.firstRxNs = -1;
+    }
+    return counters;
+  }
+
+  void
+  EndpointFlowMonitor::Sent(const FlowKey &key, Ptr<const Packet> payload, uint32_t headerSize)
+  {
+    int64_t now = Simulator::Now().GetNanoSeconds();
+    FlowCounters &counters = Lookup(key);
+    counters.txPackets++;
+    counters.txBytes += payload->GetSize() + headerSize;
+    if (counters.firstTxNs < 0)
+    {
+      counters.firstTxNs = now;
+    }
+    counters.lastTxNs = now;
+
+    EndpointTimestampTag tag;
+    tag.txTimeNs = now;
+    // same technique as the FlowMonitor probes: the trace hands out a const
+    // packet, but byte tags do not change the packet contents
+    const_cast<Packet *>(PeekPointer(payload))->AddByteTag(tag);
+  }
+
+  void
+  EndpointFlowMonitor::Delivered(const FlowKey &key, Ptr<const Packet> payload, uint32_t headerSize)
+  {
+    int64_t now = Simulator::Now().GetNanoSeconds();
+    FlowCounters &counters = Lookup(key);
+    counters.rxPackets++;
+    counters.rxBytes += payload->GetSize() + headerSize;
+    if (counters.firstRxNs < 0)
+    {
+      counters.firstRxNs = now;
+    }
+    counters.lastRxNs = now;
+
+    EndpointTimestampTag tag;
+    if (payload->FindFirstMatchingByteTag(tag))
+    {
+      counters.delaySumNs += now - tag.txTimeNs;
+    }
+  }
+
+  void
+  EndpointFlowMonitor::SendOutgoing4(const Ipv4Header &header, Ptr<const Packet> payload, uint32_t interface)
+  {
+    FlowKey key;
+    MakeKey(header, payload, key);
+    Sent(key, payload, header.GetSerializedSize());
+  }
+
+  void
+  EndpointFlowMonitor::LocalDeliver4(const Ipv4Header &header, Ptr<const Packet> payload, uint32_t interface)
+  {
+    FlowKey key;
+    MakeKey(header, payload, key);
+    Delivered(key, payload, header.GetSerializedSize());
+  }
+
+  void
+  EndpointFlowMonitor::SendOutgoing6(const Ipv6Header &header, Ptr<const Packet> payload, uint32_t interface)
+  {
+    FlowKey key;
+    MakeKey(header, payload, key);
+    Sent(key, payload, header.GetSerializedSize());
+  }
+
+  void
+  EndpointFlowMonitor::LocalDeliver6(const Ipv6Header &header, Ptr<const Packet> payload, uint32_t interface)
+  {
+    FlowKey key;
+    MakeKey(header, payload, key);
+    Delivered(key, payload, header.GetSerializedSize());
+  }
+
+  void
+  EndpointFlowMonitor::QueueDrop(Ptr<const QueueDiscItem> item)
+  {
+    FlowKey key;
+    if (MakeKey(item, key))
+    {
+      Lookup(key).queueDrops++;
+    }
+  }
+
+  void
+  EndpointFlowMonitor::QueueMark(Ptr<const QueueDiscItem> item, const char *reason)
+  {
+    FlowKey key;
+    if (MakeKey(item, key))
+    {
+      Lookup(key).queueMarks++;
+    }
+  }
+
+  void
+  EndpointFlowMonitor::Fill(FlowStatsTable &rows, int64_t nowNs) const
+  {
+    rows.Resize(m_flows.GetSize());
+    std::size_t row = 0;
+    m_flows.ForEach([&rows, &row, nowNs](const FlowKey &key, const FlowCounters &c)
+                    {
+                      rows.timeNs[row] = nowNs;
+                      rows.flowId[row] = c.flowId;
+                      rows.family[row] = key.family;
+                      std::copy(key.srcAddress, key.srcAddress + 16, rows.srcAddress[row].begin());
+                      std::copy(key.dstAddress, key.dstAddress + 16, rows.dstAddress[row].begin());
+                      rows.protocol[row] = key.protocol;
+                      rows.srcPort[row] = key.srcPort;
+                      rows.dstPort[row] = key.dstPort;
+                      rows.txPackets[row] = c.txPackets;
+                      rows.rxPackets[row] = c.rxPackets;
+                      rows.txBytes[row] = c.txBytes;
+                      rows.rxBytes[row] = c.rxBytes;
+                      rows.lostPackets[row] = c.queueDrops;
+                      rows.timesForwarded[row] = 0;
+                      rows.delaySumNs[row] = c.delaySumNs;
+                      rows.jitterSumNs[row] = 0;
+                      rows.firstTxNs[row] = c.firstTxNs;
+                      rows.lastTxNs[row] = c.lastTxNs;
+                      rows.firstRxNs[row] = c.firstRxNs;
+                      rows.lastRxNs[row] = c.lastRxNs;
+                      ++row; });
+  }
+
+} // namespace ns3
@@ -0,0 +1,198 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ENDPOINT_FLOW_MONITOR_H
+#define ENDPOINT_FLOW_MONITOR_H
+
+#include "ns3/node-container.h"
+#include "ns3/queue-disc-container.h"
+#include "ns3/queue-item.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv6-header.h"
+#include "ns3/nstime.h"
+#include "ns3/tag.h"
+#include "flow-key.h"
+#include "flow-stats-reader.h"
+
+namespace ns3
+{
+
+  /**
+   * \ingroup flow-monitor
+   *
+   * \brief Byte tag carrying the time a packet left its source
+   */
+  class EndpointTimestampTag : public Tag
+  {
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId(void);
+    virtual TypeId GetInstanceTypeId(void) const;
+    virtual uint32_t GetSerializedSize(void) const;
+    virtual void Serialize(TagBuffer buf) const;
+    virtual void Deserialize(TagBuffer buf);
+    virtual void Print(std::ostream &os) const;
+
+    EndpointTimestampTag();
+
+    int64_t txTimeNs; //!< Transmission time at the source
+  };
+
+  /**
+   * \ingroup flow-monitor
+   *
+   * \brief Lightweight flow monitor that only instruments flow endpoints
+   * and selected queue discs
+   *
+   * Sources are instrumented on the Ipv4L3Protocol / Ipv6L3Protocol
+   * SendOutgoing trace, which only fires for locally originated packets,
+   * and stamp each packet with an EndpointTimestampTag.  Sinks use the
+   * LocalDeliver trace.  Queue discs report drops and marks per flow.
+   * Intermediate hops are not touched, so the cost per packet does not
+   * depend on the path length.
+   *
+   * Counters are kept in a FlatFlowTable keyed by the RRED five-tuple
+   * (FlowKey).  Unlike FlowMonitor there is no per-packet state: packets
+   * still in flight at the end of the run are counted as lost.
+   *
+   * Trace sinks are bound to a raw pointer, so the monitor must outlive
+   * Simulator::Run ().
+   */
+  class EndpointFlowMonitor
+  {
+  public:
+    /**
+     * \brief Per-flow counters
+     */
+    struct FlowCounters
+    {
+      uint32_t flowId;     //!< Sequential id, in order of first appearance
+      uint64_t txPackets;  //!< Packets sent by the source
+      uint64_t txBytes;    //!< Bytes sent by the source, IP header included
+      uint64_t rxPackets;  //!< Packets delivered to the sink
+      uint64_t rxBytes;    //!< Bytes delivered to the sink, IP header included
+      uint64_t queueDrops; //!< Packets dropped by the instrumented queue discs
+      uint64_t queueMarks; //!< Packets marked by the instrumented queue discs
+      int64_t delaySumNs;  //!< Sum of the end-to-end delays
+      int64_t firstTxNs;   //!< First transmission
+      int64_t lastTxNs;    //!< Last transmission
+      int64_t firstRxNs;   //!< First reception
+      int64_t lastRxNs;    //!< Last reception
+    };
+
+    EndpointFlowMonitor();
+
+    /**
+     * \brief Instrument the nodes where flows start
+     * \param nodes the source nodes
+     */
+    void InstallSources(NodeContainer nodes);
+
+    /**
+     * \brief Instrument the nodes where flows end
+     * \param nodes the sink nodes
+     */
+    void InstallSinks(NodeContainer nodes);
+
+    /**
+     * \brief Count drops and marks of some queue discs
+     * \param queueDiscs the queue discs
+     */
+    void InstallQueueDiscs(QueueDiscContainer queueDiscs);
+
+    /**
+     * \returns the per-flow counters
+     */
+    const FlatFlowTable<FlowCounters> &GetFlows(void) const;
+
+    /**
+     * \brief Snapshot the counters in the FlowStatsExporter columns
+     *
+     * Queue drops are reported as lost packets and times forwarded is zero.
+     *
+     * \param rows the table, resized to the number of flows
+     * \param nowNs dump time
+     */
+    void Fill(FlowStatsTable &rows, int64_t nowNs) const;
+
+  private:
+    /**
+     * \brief Build the key of an IPv4 packet
+     * \param header the IP header
+     * \param payload the IP payload
+     * \param key the key
+     */
+    static void MakeKey(const Ipv4Header &header, Ptr<const Packet> payload, FlowKey &key);
+    /**
+     * \brief Build the key of an IPv6 packet
+     * \param header the IP header
+     * \param payload the IP payload
+     * \param key the key
+     */
+    static void MakeKey(const Ipv6Header &header, Ptr<const Packet> payload, FlowKey &key);
+    /**
+     * \brief Read the ports at the start of a TCP or UDP payload
+     * \param payload the IP payload
+     * \param key the key, with protocol already set
+     */
+    static void ReadPorts(Ptr<const Packet> payload, FlowKey &key);
+
+    /**
+     * \brief Find the counters of a flow, creating them if needed
+     * \param key the key
+     * \returns the counters
+     */
+    FlowCounters &Lookup(const FlowKey &key);
+
+    /**
+     * \brief Record a packet leaving a source
+     * \param key the flow key
+     * \param payload the IP payload
+     * \param headerSize size of the IP header
+     */
+    void Sent(const FlowKey &key, Ptr<const Packet> payload, uint32_t headerSize);
+    /**
+     * \brief Record a packet reaching a sink
+     * \param key the flow key
+     * \param payload the IP payload
+     * \param headerSize size of the IP header
+     */
+    void Delivered(const FlowKey &key, Ptr<const Packet> payload, uint32_t headerSize);
+
+    void SendOutgoing4(const Ipv4Header &header, Ptr<const Packet> payload, uint32_t interface); //!< Ipv4 source trace
+    void LocalDeliver4(const Ipv4Header &header, Ptr<const Packet> payload, uint32_t interface); //!< Ipv4 sink trace
+    void SendOutgoing6(const Ipv6Header &header, Ptr<const Packet> payload, uint32_t interface); //!< Ipv6 source trace
+    void LocalDeliver6(const Ipv6Header &header, Ptr<const Packet> payload, uint32_t interface); //!< Ipv6 sink trace
+    void QueueDrop(Ptr<const QueueDiscItem> item);                     //!< Queue disc drop trace
+    void QueueMark(Ptr<const QueueDiscItem> item, const char *reason); //!< Queue disc mark trace
+    /**
+     * \brief Build the key of a queue disc item
+     * \param item the item
+     * \param key the key
+     * \returns false if the item is neither IPv4 nor IPv6
+     */
+    static bool MakeKey(Ptr<const QueueDiscItem> item, FlowKey &key);
+
+    FlatFlowTable<FlowCounters> m_flows; //!< Per-flow counters
+    uint32_t m_nextFlowId;               //!< Next flow id
+  };
+
+} // namespace ns3
+
+#endif // ENDPOINT_FLOW_MONITOR_H
@@ -0,0 +1,229 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/rng-seed-manager.h"
+#include "ensemble-runner.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace ns3
+{
+
+  NS_LOG_COMPONENT_DEFINE("EnsembleRunner");
+
+  EnsembleRunner::EnsembleRunner()
+      : m_worker(false),
+        m_run(RngSeedManager::GetRun()),
+        m_nFailed(0),
+        m_stopRule(false),
+        m_reportFd(-1)
+  {
+  }
+
+  void
+  EnsembleRunner::SetStopRule(double level, double relativePrecision, uint32_t minReplications)
+  {
+    NS_LOG_FUNCTION(this << level << relativePrecision << minReplications);
+    NS_ABORT_MSG_UNLESS(level > 0 && level < 1, "EnsembleRunner: confidence level must be in (0, 1)");
+    m_stopRule = true;
+    m_statistics = ReplicationStatistics(level, relativePrecision, minReplications);
+  }
+
+  bool
+  EnsembleRunner::Fork(uint32_t replications, uint32_t jobs, const std::string &logPrefix)
+  {
+    NS_LOG_FUNCTION(this << replications << jobs << logPrefix);
+    if (replications == 0)
+    {
+      return true;
+    }
+    if (jobs == 0)
+    {
+      jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // buffered output would otherwise be written once per worker
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(0);
+
+    uint32_t firstRun = m_run;
+    // worker pid -> (run, read end of its report pipe)
+    std::map<pid_t, std::pair<uint32_t, int>> running;
+    uint32_t next = 0;
+    bool stopped = false;
+    while ((next < replications && !stopped) || !running.empty())
+    {
+      while (next < replications && !stopped && running.size() < jobs)
+      {
+        int fds[2];
+        NS_ABORT_MSG_IF(pipe(fds) != 0, "EnsembleRunner: pipe failed");
+        pid_t pid = fork();
+        NS_ABORT_MSG_IF(pid < 0, "EnsembleRunner: fork failed");
+        if (pid == 0)
+        {
+          // report pipes of the other workers belong to the parent
+          for (std::map<pid_t, std::pair<uint32_t, int>>::iterator i = running.begin(); i != running.end(); ++i)
+          {
+            close(i->second.second);
+          }
+          close(fds[0]);
+          m_reportFd = fds[1];
+          m_run = firstRun + next;
+          BecomeWorker(logPrefix);
+          return true;
+        }
+        close(fds[1]);
+        running[pid] = std::make_pair(firstRun + next, fds[0]);
+        ++next;
+      }
+
+      int status;
+      pid_t pid = waitpid(-1, &status, 0);
+      if (pid < 0)
+      {
+        NS_ABORT_MSG("EnsembleRunner: waitpid failed");
+      }
+      std::map<pid_t, std::pair<uint32_t, int>>::iterator it = running.find(pid);
+      if (it == running.end())
+      {
+        continue;
+      }
+      bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+      m_nFailed += !ok;
+      Collect(it->second.second);
+      std::cout << "run " << it->second.first << (ok ? " done" : " FAILED") << " (" << logPrefix << "-run"
+                << it->second.first << ".log)" << std::endl;
+      running.erase(it);
+      if (m_stopRule && !stopped && m_statistics.IsPreciseEnough())
+      {
+        std::cout << "confidence intervals reached the target, not starting new runs" << std::endl;
+        stopped = true;
+      }
+    }
+    std::cout << next << " runs, " << m_nFailed << " failed" << std::endl;
+    m_statistics.Print(std::cout);
+    return false;
+  }
+
+  void
+  EnsembleRunner::Collect(int fd)
+  {
+    // reports are a few lines of "name value", read once the worker exited
+    std::string text;
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0)
+    {
+      text.append(buf, n);
+    }
+    close(fd);
+
+    std::istringstream is(text);
+    std::string name;
+    double value;
+    while (is >> name >> value)
+    {
+      m_statistics.Add(name, value);
+    }
+  }
+
+  void
+  EnsembleRunner::Report(const std::string &name, double value)
+  {
+    NS_LOG_FUNCTION(this << name << value);
+    NS_ABORT_MSG_IF(name.find_first_of(" \t\n") != std::string::npos, "EnsembleRunner: metric names cannot contain spaces");
+    if (!m_worker)
+    {
+      m_statistics.Add(name, value);
+      return;
+    }
+    std::ostringstream os;
+    os.precision(17);
+    os << name << " " << value << "\n";
+    std::string line = os.str();
+    // lines are shorter than PIPE_BUF, so each write is atomic
+    NS_ABORT_MSG_IF(write(m_reportFd, line.data(), line.size()) != static_cast<ssize_t>(line.size()),
+                    "EnsembleRunner: cannot report to the parent");
+  }
+
+  const ReplicationStatistics &
+  EnsembleRunner::GetStatistics(void) const
+  {
+    return m_statistics;
+  }
+
+  void
+  EnsembleRunner::BecomeWorker(const std::string &logPrefix)
+  {
+    m_worker = true;
+    RngSeedManager::SetRun(m_run);
+
+    std::string log = logPrefix + "-run" + std::to_string(m_run) + ".log";
+    int fd = open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    NS_ABORT_MSG_IF(fd < 0, "EnsembleRunner: cannot open " << log);
+    dup2(fd, STDOUT_FILENO);
+    dup2(fd, STDERR_FILENO);
+    close(fd);
+  }
+
+  bool
+  EnsembleRunner::IsWorker(void) const
+  {
+    return m_worker;
+  }
+
+  uint32_t
+  EnsembleRunner::GetRun(void) const
+  {
+    return m_run;
+  }
+
+  std::string
+  EnsembleRunner::GetFileName(const std::string &name) const
+  {
+    if (!m_worker)
+    {
+      return name;
+    }
+    std::string suffix = "-run" + std::to_string(m_run);
+    std::size_t dot = name.rfind('.');
+    std::size_t slash = name.rfind('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    {
+      return name + suffix;
+    }
+    return name.substr(0, dot) + suffix + name.substr(dot);
+  }
+
+  uint32_t
+  EnsembleRunner::GetNFailed(void) const
+  {
+    return m_nFailed;
+  }
+
+} // namespace ns3
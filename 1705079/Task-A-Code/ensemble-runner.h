@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ENSEMBLE_RUNNER_H
+#define ENSEMBLE_RUNNER_H
+
+#include "replication-statistics.h"
+
+#include <stdint.h>
+#include <string>
+
+namespace ns3
+{
+
+  /**
+   * \ingroup core
+   *
+   * \brief Runs replications of a scenario in processes forked after the
+   * topology has been built
+   *
+   * Fork () is called once the nodes, stacks, applications and routes are
+   * in place, and before any output file is opened.  Every worker is a
+   * copy-on-write image of the fully built scenario; it only sets its own
+   * RNG run number (RngSeedManager::SetRun, starting from the current
+   * --RngRun) and redirects stdout / stderr to its own log file.
+   *
+   * Random variables created before the fork keep the run number of the
+   * parent until their stream is assigned again, so the scenario must call
+   * AssignStreams on its random sources (stacks, queue discs,
+   * applications, devices) after Fork () returns.  Doing so in every mode
+   * keeps worker N identical to a plain run with --RngRun=N.
+   *
+   * Workers can Report () metrics back to the parent through a pipe.  The
+   * parent aggregates them in a ReplicationStatistics; with a stop rule,
+   * the replication count is a maximum and no new worker is started once
+   * every metric's confidence interval is tight enough.  Workers already
+   * running when the rule is met are waited for and counted, so that the
+   * result does not depend on which replications finish first.
+   *
+   * No thread may be running when Fork () is called.
+   */
+  class EnsembleRunner
+  {
+  public:
+    EnsembleRunner();
+
+    /**
+     * \brief Stop early once the metrics are precise enough
+     * \param level confidence level, e.g. 0.95
+     * \param relativePrecision target half-width relative to the mean
+     * \param minReplications replications before the rule is checked
+     */
+    void SetStopRule(double level, double relativePrecision, uint32_t minReplications);
+
+    /**
+     * \brief Fork the workers
+     *
+     * With zero replications nothing is forked and the caller continues
+     * as a plain run.  Otherwise the parent runs at most jobs workers at a
+     * time, waits for all of them and returns false; every worker returns
+     * true.
+     *
+     * \param replications number of workers (0 to disable)
+     * \param jobs maximum number of concurrent workers (0 for the number
+     * of cores)
+     * \param logPrefix worker N writes its output to logPrefix-runN.log
+     * \returns true if the caller should run the simulation
+     */
+    bool Fork(uint32_t replications, uint32_t jobs, const std::string &logPrefix);
+
+    /**
+     * \returns true in a forked worker
+     */
+    bool IsWorker(void) const;
+
+    /**
+     * \returns the RNG run number of this process
+     */
+    uint32_t GetRun(void) const;
+
+    /**
+     * \brief Make an output file name unique to the worker
+     *
+     * Inserts "-runN" before the extension in a worker, e.g.
+     * flow_monitor_stats-run3.csv; returns the name unchanged otherwise.
+     *
+     * \param name the file name
+     * \returns the worker file name
+     */
+    std::string GetFileName(const std::string &name) const;
+
+    /**
+     * \returns in the parent, the number of workers that did not exit
+     * with status 0
+     */
+    uint32_t GetNFailed(void) const;
+
+    /**
+     * \brief Report a metric of this replication
+     *
+     * In a worker the value is sent to the parent; in a plain run it is
+     * added to the local statistics.
+     *
+     * \param name the metric name
+     * \param value the value
+     */
+    void Report(const std::string &name, double value);
+
+    /**
+     * \returns in the parent, the statistics of the reported metrics
+     */
+    const ReplicationStatistics &GetStatistics(void) const;
+
+  private:
+    /**
+     * \brief Set up the current process as a worker
+     * \param logPrefix the log file prefix
+     */
+    void BecomeWorker(const std::string &logPrefix);
+
+    /**
+     * \brief Read the metrics reported by a finished worker
+     * \param fd the read end of its pipe, closed on return
+     */
+    void Collect(int fd);
+
+    bool m_worker;                       //!< True in a forked worker
+    uint32_t m_run;                      //!< RNG run number
+    uint32_t m_nFailed;                  //!< Failed workers, in the parent
+    bool m_stopRule;                     //!< Stop once m_statistics is precise enough
+    ReplicationStatistics m_statistics;  //!< Reported metrics
+    int m_reportFd;                      //!< Write end of the pipe, in a worker
+  };
+
+} // namespace ns3
+
+#endif // ENSEMBLE_RUNNER_H
@@ -0,0 +1,292 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/queue.h"
+#include "ns3/point-to-point-net-device.h"
+#include "ns3/lr-wpan-net-device.h"
+#include "ns3/lr-wpan-mac.h"
+#include "filtered-trace-helper.h"
+
+#include <sstream>
+
+namespace ns3
+{
+
+  NS_LOG_COMPONENT_DEFINE("FilteredTraceHelper");
+
+  FilteredTraceHelper::FilteredTraceHelper()
+      : m_eventMask(ALL_EVENTS),
+        m_oneInN(1),
+        m_perFlow(false)
+  {
+  }
+
+  uint32_t
+  FilteredTraceHelper::ParseEventMask(const std::string &list)
+  {
+    uint32_t mask = 0;
+    std::istringstream iss(list);
+    std::string name;
+    while (std::getline(iss, name, ','))
+    {
+      if (name == "enqueue")
+      {
+        mask |= ENQUEUE;
+      }
+      else if (name == "dequeue")
+      {
+        mask |= DEQUEUE;
+      }
+      else if (name == "drop")
+      {
+        mask |= DROP;
+      }
+      else if (name == "rx")
+      {
+        mask |= RX;
+      }
+      else if (name == "all")
+      {
+        mask |= ALL_EVENTS;
+      }
+      else
+      {
+        NS_FATAL_ERROR("Unknown trace event " << name << " (use enqueue, dequeue, drop, rx or all)");
+      }
+    }
+    return mask;
+  }
+
+  void
+  FilteredTraceHelper::SetEventMask(uint32_t mask)
+  {
+    m_eventMask = mask;
+  }
+
+  void
+  FilteredTraceHelper::SetSampling(uint32_t oneInN, bool perFlow)
+  {
+    NS_ABORT_MSG_IF(oneInN == 0, "FilteredTraceHelper: sampling ratio must be at least 1");
+    m_oneInN = oneInN;
+    m_perFlow = perFlow;
+  }
+
+  void
+  FilteredTraceHelper::Enable(Ptr<OutputStreamWrapper> stream, Ptr<NetDevice> device)
+  {
+    NS_LOG_FUNCTION(this << stream << device);
+
+    std::ostringstream oss;
+    oss << "/NodeList/" << device->GetNode()->GetId() << "/DeviceList/" << device->GetIfIndex();
+
+    Ptr<Sink> sink = Create<Sink>();
+    sink->stream = stream;
+    sink->oneInN = m_oneInN;
+    sink->perFlow = m_perFlow;
+    sink->counter = 0;
+
+    Ptr<PointToPointNetDevice> p2p = DynamicCast<PointToPointNetDevice>(device);
+    if (p2p)
+    {
+      oss << "/$ns3::PointToPointNetDevice";
+      sink->context = oss.str();
+      sink->hasPpp = true;
+
+      Ptr<Queue<Packet>> queue = p2p->GetQueue();
+      if (m_eventMask & ENQUEUE)
+      {
+        queue->TraceConnectWithoutContext("Enqueue", MakeBoundCallback(&FilteredTraceHelper::TraceEnqueue, sink));
+      }
+      if (m_eventMask & DEQUEUE)
+      {
+        queue->TraceConnectWithoutContext("Dequeue", MakeBoundCallback(&FilteredTraceHelper::TraceDequeue, sink));
+      }
+      if (m_eventMask & DROP)
+      {
+        queue->TraceConnectWithoutContext("Drop", MakeBoundCallback(&FilteredTraceHelper::TraceDrop, sink));
+        p2p->TraceConnectWithoutContext("PhyRxDrop", MakeBoundCallback(&FilteredTraceHelper::TraceDrop, sink));
+      }
+      if (m_eventMask & RX)
+      {
+        p2p->TraceConnectWithoutContext("MacRx", MakeBoundCallback(&FilteredTraceHelper::TraceRx, sink));
+      }
+      return;
+    }
+
+    Ptr<LrWpanNetDevice> lrwpan = DynamicCast<LrWpanNetDevice>(device);
+    if (lrwpan)
+    {
+      oss << "/$ns3::LrWpanNetDevice";
+      sink->context = oss.str();
+      sink->hasPpp = false;
+
+      Ptr<LrWpanMac> mac = lrwpan->GetMac();
+      if (m_eventMask & ENQUEUE)
+      {
+        mac->TraceConnectWithoutContext("MacTxEnqueue", MakeBoundCallback(&FilteredTraceHelper::TraceEnqueue, sink));
+      }
+      if (m_eventMask & DEQUEUE)
+      {
+        mac->TraceConnectWithoutContext("MacTxDequeue", MakeBoundCallback(&FilteredTraceHelper::TraceDequeue, sink));
+      }
+      if (m_eventMask & DROP)
+      {
+        mac->TraceConnectWithoutContext("MacTxDrop", MakeBoundCallback(&FilteredTraceHelper::TraceDrop, sink));
+      }
+      if (m_eventMask & RX)
+      {
+        mac->TraceConnectWithoutContext("MacRx", MakeBoundCallback(&FilteredTraceHelper::TraceRx, sink));
+      }
+      return;
+    }
+
+    NS_LOG_WARN("FilteredTraceHelper: unsupported device type on " << oss.str() << ", not traced");
+  }
+
+  void
+  FilteredTraceHelper::Enable(Ptr<OutputStreamWrapper> stream, NetDeviceContainer devices)
+  {
+    for (NetDeviceContainer::Iterator i = devices.Begin(); i != devices.End(); ++i)
+    {
+      Enable(stream, *i);
+    }
+  }
+
+  void
+  FilteredTraceHelper::Enable(Ptr<OutputStreamWrapper> stream, NodeContainer nodes)
+  {
+    for (NodeContainer::Iterator i = nodes.Begin(); i != nodes.End(); ++i)
+    {
+      for (uint32_t j = 0; j < (*i)->GetNDevices(); ++j)
+      {
+        Ptr<NetDevice> device = (*i)->GetDevice(j);
+        // Skip the loopback device silently
+        if (DynamicCast<PointToPointNetDevice>(device) || DynamicCast<LrWpanNetDevice>(device))
+        {
+          Enable(stream, device);
+        }
+      }
+    }
+  }
+
+  bool
+  FilteredTraceHelper::FlowHash(Ptr<const Packet> p, uint32_t &hash)
+  {
+    // PPP header (2 bytes) + IPv4 header without options (20 bytes) + ports (4 bytes)
+    uint8_t buf[2 + 60 + 4];
+    uint32_t n = p->CopyData(buf, sizeof(buf));
+    if (n < 2 + 20 || buf[0] != 0x00 || buf[1] != 0x21)
+    {
+      return false;
+    }
+    const uint8_t *ip = buf + 2;
+    if ((ip[0] >> 4) != 4)
+    {
+      return false;
+    }
+    uint32_t ihl = (ip[0] & 0x0f) * 4;
+    uint8_t protocol = ip[9];
+
+    // FNV-1a over addresses, protocol and, for TCP/UDP, the ports
+    uint32_t h = 2166136261u;
+    for (uint32_t k = 12; k < 20; ++k)
+    {
+      h = (h ^ ip[k]) * 16777619u;
+    }
+    h = (h ^ protocol) * 16777619u;
+    if ((protocol == 6 || protocol == 17) && n >= 2 + ihl + 4)
+    {
+      for (uint32_t k = ihl; k < ihl + 4; ++k)
+      {
+        h = (h ^ ip[k]) * 16777619u;
+      }
+    }
+    // final avalanche so that "h % N" is well spread for any N
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    hash = h;
+    return true;
+  }
+
+  bool
+  FilteredTraceHelper::Keep(Ptr<Sink> sink, Ptr<const Packet> p)
+  {
+    if (sink->oneInN <= 1)
+    {
+      return true;
+    }
+    if (!sink->perFlow)
+    {
+      return (sink->counter++ % sink->oneInN) == 0;
+    }
+    uint32_t hash;
+    if (!sink->hasPpp || !FlowHash(p, hash))
+    {
+      uint64_t uid = p->GetUid();
+      hash = static_cast<uint32_t>((uid * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+    return (hash % sink->oneInN) == 0;
+  }
+
+  void
+  FilteredTraceHelper::Write(Ptr<Sink> sink, char event, Ptr<const Packet> p)
+  {
+    *sink->stream->GetStream() << event << " " << Simulator::Now().GetSeconds() << " "
+                               << sink->context << " " << *p << std::endl;
+  }
+
+  void
+  FilteredTraceHelper::TraceEnqueue(Ptr<Sink> sink, Ptr<const Packet> p)
+  {
+    if (Keep(sink, p))
+    {
+      Write(sink, '+', p);
+    }
+  }
+
+  void
+  FilteredTraceHelper::TraceDequeue(Ptr<Sink> sink, Ptr<const Packet> p)
+  {
+    if (Keep(sink, p))
+    {
+      Write(sink, '-', p);
+    }
+  }
+
+  void
+  FilteredTraceHelper::TraceDrop(Ptr<Sink> sink, Ptr<const Packet> p)
+  {
+    if (Keep(sink, p))
+    {
+      Write(sink, 'd', p);
+    }
+  }
+
+  void
+  FilteredTraceHelper::TraceRx(Ptr<Sink> sink, Ptr<const Packet> p)
+  {
+    if (Keep(sink, p))
+    {
+      Write(sink, 'r', p);
+    }
+  }
+
+} // namespace ns3
@@ -0,0 +1,162 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FILTERED_TRACE_HELPER_H
+#define FILTERED_TRACE_HELPER_H
+
+#include "ns3/net-device-container.h"
+#include "ns3/node-container.h"
+#include "ns3/output-stream-wrapper.h"
+#include "ns3/packet.h"
+#include "ns3/simple-ref-count.h"
+
+#include <string>
+
+namespace ns3
+{
+
+  /**
+   * \ingroup traffic-control
+   *
+   * \brief Ascii tracing restricted to a device set, an event set and a
+   * deterministic sample of the events.
+   *
+   * Unlike the Enable*AsciiAll helpers, only the trace sources of the
+   * selected event types are connected, and the sampling decision is taken
+   * in the trace sink before the packet is printed.  Supported devices are
+   * PointToPointNetDevice (queue Enqueue/Dequeue/Drop, MacRx, PhyRxDrop) and
+   * LrWpanNetDevice (MacTxEnqueue/MacTxDequeue/MacTxDrop/MacRx).  The line
+   * format matches the one of the ns-3 ascii trace helpers.
+   *
+   * Sampling keeps 1 event in N.  In per-event mode a per-device counter is
+   * used; in per-flow mode the decision is taken on a hash of the IPv4
+   * five-tuple read directly from the packet bytes, so that all events of a
+   * sampled flow are kept.  Packets whose five-tuple cannot be read cheaply
+   * (e.g. 6LoWPAN compressed frames) are sampled on their packet uid.
+   */
+  class FilteredTraceHelper
+  {
+  public:
+    /**
+     * \brief Event types, usable as a bit mask
+     */
+    enum EventType
+    {
+      ENQUEUE = 1 << 0, //!< Packet enqueued in the device queue ("+")
+      DEQUEUE = 1 << 1, //!< Packet dequeued from the device queue ("-")
+      DROP = 1 << 2,    //!< Packet dropped by the device ("d")
+      RX = 1 << 3,      //!< Packet received by the device ("r")
+      ALL_EVENTS = ENQUEUE | DEQUEUE | DROP | RX,
+    };
+
+    FilteredTraceHelper();
+
+    /**
+     * \brief Parse a comma separated list of event names
+     *
+     * Accepted names are enqueue, dequeue, drop, rx and all.
+     *
+     * \param list the list
+     * \returns the corresponding event mask
+     */
+    static uint32_t ParseEventMask(const std::string &list);
+
+    /**
+     * \brief Select the event types to trace
+     * \param mask a combination of EventType values
+     */
+    void SetEventMask(uint32_t mask);
+
+    /**
+     * \brief Configure the sampling
+     * \param oneInN keep one event in oneInN (1 keeps everything)
+     * \param perFlow true to sample on the flow hash instead of per event
+     */
+    void SetSampling(uint32_t oneInN, bool perFlow);
+
+    /**
+     * \brief Trace a device
+     * \param stream output stream
+     * \param device the device
+     */
+    void Enable(Ptr<OutputStreamWrapper> stream, Ptr<NetDevice> device);
+
+    /**
+     * \brief Trace a set of devices
+     * \param stream output stream
+     * \param devices the devices
+     */
+    void Enable(Ptr<OutputStreamWrapper> stream, NetDeviceContainer devices);
+
+    /**
+     * \brief Trace all the devices of a set of nodes
+     * \param stream output stream
+     * \param nodes the nodes
+     */
+    void Enable(Ptr<OutputStreamWrapper> stream, NodeContainer nodes);
+
+  private:
+    /**
+     * \brief Per-device state bound to the trace sinks
+     */
+    class Sink : public SimpleRefCount<Sink>
+    {
+    public:
+      Ptr<OutputStreamWrapper> stream; //!< Output stream
+      std::string context;             //!< Config path printed on each line
+      uint32_t oneInN;                 //!< Sampling ratio
+      bool perFlow;                    //!< Per-flow sampling
+      bool hasPpp;                     //!< True if frames start with a PPP header
+      uint64_t counter;                //!< Events seen, for per-event sampling
+    };
+
+    /**
+     * \brief Sampling decision, taken before any formatting
+     * \param sink the sink
+     * \param p the packet
+     * \returns true if the event has to be written
+     */
+    static bool Keep(Ptr<Sink> sink, Ptr<const Packet> p);
+
+    /**
+     * \brief Hash of the IPv4 five-tuple of a PPP frame
+     * \param p the packet
+     * \param hash the hash, set on success
+     * \returns true if the packet carries IPv4
+     */
+    static bool FlowHash(Ptr<const Packet> p, uint32_t &hash);
+
+    /**
+     * \brief Write one trace line
+     * \param sink the sink
+     * \param event the event character
+     * \param p the packet
+     */
+    static void Write(Ptr<Sink> sink, char event, Ptr<const Packet> p);
+
+    static void TraceEnqueue(Ptr<Sink> sink, Ptr<const Packet> p); //!< "+" sink
+    static void TraceDequeue(Ptr<Sink> sink, Ptr<const Packet> p); //!< "-" sink
+    static void TraceDrop(Ptr<Sink> sink, Ptr<const Packet> p);    //!< "d" sink
+    static void TraceRx(Ptr<Sink> sink, Ptr<const Packet> p);      //!< "r" sink
+
+    uint32_t m_eventMask; //!< Event types to trace
+    uint32_t m_oneInN;    //!< Sampling ratio
+    bool m_perFlow;       //!< Per-flow sampling
+  };
+
+} // namespace ns3
+
+#endif // FILTERED_TRACE_HELPER_H
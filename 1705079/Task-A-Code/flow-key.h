@@ -0,0 +1,277 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLOW_KEY_H
+#define FLOW_KEY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/*
+ * Header-only and independent of ns-3: the same key and hash are used by
+ * the simulator models and by standalone tools.
+ */
+
+namespace ns3
+{
+
+  /**
+   * \ingroup traffic-control
+   *
+   * \brief Five-tuple identifying a flow, as used by RRED
+   *
+   * Addresses are stored on 16 bytes; IPv4 addresses use the first 4 and
+   * leave the rest zeroed, so that keys can be compared with memcmp.
+   */
+  struct FlowKey
+  {
+    uint8_t srcAddress[16]; //!< Source address
+    uint8_t dstAddress[16]; //!< Destination address
+    uint16_t srcPort;       //!< Source port (0 if not TCP/UDP)
+    uint16_t dstPort;       //!< Destination port (0 if not TCP/UDP)
+    uint8_t protocol;       //!< IP protocol number
+    uint8_t family;         //!< 4 or 6
+    uint8_t pad[2];         //!< Always zero, keeps memcmp well defined
+
+    FlowKey()
+    {
+      std::memset(this, 0, sizeof(FlowKey));
+    }
+
+    /**
+     * \returns the 32 bit flow hash
+     */
+    uint32_t Hash(void) const
+    {
+      // FNV-1a over the whole key followed by a murmur3 finalizer, so that
+      // the low bits can be used directly as a table index
+      const uint8_t *p = reinterpret_cast<const uint8_t *>(this);
+      uint32_t h = 2166136261u;
+      for (std::size_t i = 0; i < sizeof(FlowKey); ++i)
+      {
+        h = (h ^ p[i]) * 16777619u;
+      }
+      h ^= h >> 16;
+      h *= 0x85ebca6bu;
+      h ^= h >> 13;
+      h *= 0xc2b2ae35u;
+      h ^= h >> 16;
+      return h;
+    }
+
+    bool operator==(const FlowKey &o) const
+    {
+      return std::memcmp(this, &o, sizeof(FlowKey)) == 0;
+    }
+  };
+
+  /**
+   * \ingroup traffic-control
+   *
+   * \brief Open-addressing hash table from FlowKey to a value
+   *
+   * Keys, hashes and values live in flat arrays indexed by a slot number
+   * that stays valid until the table grows, so that hot paths do a single
+   * probe sequence and no allocation per lookup.
+   */
+  template <typename Value>
+  class FlatFlowTable
+  {
+  public:
+    /**
+     * \brief Constructor
+     * \param capacity initial number of slots, rounded up to a power of two
+     */
+    explicit FlatFlowTable(std::size_t capacity = 1024)
+        : m_size(0)
+    {
+      std::size_t n = 16;
+      while (n < capacity)
+      {
+        n <<= 1;
+      }
+      Allocate(n);
+    }
+
+    /**
+     * \brief Find a flow, inserting a value-initialized entry if absent
+     * \param key the flow key
+     * \param hash key.Hash (), when already known
+     * \returns a reference to the value
+     */
+    Value &FindOrInsert(const FlowKey &key, uint32_t hash)
+    {
+      if ((m_size + 1) * 2 > m_keys.size())
+      {
+        Grow();
+      }
+      std::size_t mask = m_keys.size() - 1;
+      std::size_t slot = hash & mask;
+      while (m_used[slot])
+      {
+        if (m_hashes[slot] == hash && m_keys[slot] == key)
+        {
+          return m_values[slot];
+        }
+        slot = (slot + 1) & mask;
+      }
+      m_used[slot] = 1;
+      m_hashes[slot] = hash;
+      m_keys[slot] = key;
+      m_values[slot] = Value();
+      ++m_size;
+      return m_values[slot];
+    }
+
+    /**
+     * \brief Find a flow, inserting it if absent
+     * \param key the flow key
+     * \returns a reference to the value
+     */
+    Value &FindOrInsert(const FlowKey &key)
+    {
+      return FindOrInsert(key, key.Hash());
+    }
+
+    /**
+     * \brief Find a flow
+     * \param key the flow key
+     * \returns a pointer to the value, or 0 if absent
+     */
+    const Value *Find(const FlowKey &key) const
+    {
+      uint32_t hash = key.Hash();
+      std::size_t mask = m_keys.size() - 1;
+      for (std::size_t slot = hash & mask; m_used[slot]; slot = (slot + 1) & mask)
+      {
+        if (m_hashes[slot] == hash && m_keys[slot] == key)
+        {
+          return &m_values[slot];
+        }
+      }
+      return 0;
+    }
+
+    /**
+     * \brief Hint that the slot of a hash will be probed soon
+     *
+     * Batched callers hash a group of keys first and prefetch their
+     * slots, so that the lookups of the group overlap their cache misses.
+     *
+     * \param hash the key hash
+     */
+    void Prefetch(uint32_t hash) const
+    {
+      std::size_t slot = hash & (m_keys.size() - 1);
+#if defined(__GNUC__)
+      __builtin_prefetch(&m_hashes[slot]);
+      __builtin_prefetch(&m_keys[slot]);
+      __builtin_prefetch(&m_values[slot]);
+#else
+      (void)slot;
+#endif
+    }
+
+    /**
+     * \returns the number of flows
+     */
+    std::size_t GetSize(void) const
+    {
+      return m_size;
+    }
+
+    /**
+     * \brief Call f (key, value) for every flow, in slot order
+     * \param f the function
+     */
+    template <typename F>
+    void ForEach(F f) const
+    {
+      for (std::size_t slot = 0; slot < m_keys.size(); ++slot)
+      {
+        if (m_used[slot])
+        {
+          f(m_keys[slot], m_values[slot]);
+        }
+      }
+    }
+
+    /**
+     * \brief Remove all flows
+     */
+    void Clear(void)
+    {
+      std::fill(m_used.begin(), m_used.end(), 0);
+      m_size = 0;
+    }
+
+  private:
+    /**
+     * \brief Allocate empty slots
+     * \param n number of slots
+     */
+    void Allocate(std::size_t n)
+    {
+      m_keys.assign(n, FlowKey());
+      m_hashes.assign(n, 0);
+      m_used.assign(n, 0);
+      m_values.assign(n, Value());
+    }
+
+    /**
+     * \brief Double the number of slots and rehash
+     */
+    void Grow(void)
+    {
+      std::vector<FlowKey> keys;
+      std::vector<uint32_t> hashes;
+      std::vector<uint8_t> used;
+      std::vector<Value> values;
+      keys.swap(m_keys);
+      hashes.swap(m_hashes);
+      used.swap(m_used);
+      values.swap(m_values);
+      Allocate(keys.size() * 2);
+      std::size_t mask = m_keys.size() - 1;
+      for (std::size_t i = 0; i < keys.size(); ++i)
+      {
+        if (used[i])
+        {
+          std::size_t slot = hashes[i] & mask;
+          while (m_used[slot])
+          {
+            slot = (slot + 1) & mask;
+          }
+          m_used[slot] = 1;
+          m_hashes[slot] = hashes[i];
+          m_keys[slot] = keys[i];
+          m_values[slot] = values[i];
+        }
+      }
+    }
+
+    std::vector<FlowKey> m_keys;    //!< Keys
+    std::vector<uint32_t> m_hashes; //!< Cached hashes
+    std::vector<uint8_t> m_used;    //!< Slot occupancy
+    std::vector<Value> m_values;    //!< Values
+    std::size_t m_size;             //!< Number of flows
+  };
+
+} // namespace ns3
+
+#endif // FLOW_KEY_H
@@ -0,0 +1,228 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/ipv4-flow-classifier.h"
+#include "ns3/ipv6-flow-classifier.h"
+#include "flow-stats-exporter.h"
+
+#include <arpa/inet.h>
+#include <cinttypes>
+
+namespace ns3
+{
+
+  NS_LOG_COMPONENT_DEFINE("FlowStatsExporter");
+
+  FlowStatsExporter::FlowStatsExporter(Ptr<FlowMonitor> monitor, Ptr<FlowClassifier> classifier)
+      : m_monitor(monitor),
+        m_classifier(classifier),
+        m_endpointMonitor(0),
+        m_format(CSV),
+        m_file(0)
+  {
+    NS_LOG_FUNCTION(this << monitor << classifier);
+  }
+
+  FlowStatsExporter::~FlowStatsExporter()
+  {
+    NS_LOG_FUNCTION(this);
+    Close();
+  }
+
+  void
+  FlowStatsExporter::SetEndpointFlowMonitor(const EndpointFlowMonitor *monitor)
+  {
+    NS_LOG_FUNCTION(this << monitor);
+    m_endpointMonitor = monitor;
+  }
+
+  FlowStatsExporter::Format
+  FlowStatsExporter::ParseFormat(const std::string &name)
+  {
+    if (name == "csv")
+    {
+      return CSV;
+    }
+    if (name == "bin")
+    {
+      return BINARY;
+    }
+    NS_FATAL_ERROR("Unknown flow statistics format " << name << " (use csv or bin)");
+    return CSV;
+  }
+
+  void
+  FlowStatsExporter::Open(const std::string &filename, Format format)
+  {
+    NS_LOG_FUNCTION(this << filename << format);
+    NS_ABORT_MSG_IF(m_file, "FlowStatsExporter: already open");
+
+    m_format = format;
+    m_file = std::fopen(filename.c_str(), "wb");
+    NS_ABORT_MSG_UNLESS(m_file, "FlowStatsExporter: cannot open " << filename);
+
+    if (m_format == CSV)
+    {
+      std::fprintf(m_file, "%s\n", FlowStatsFormat::CSV_HEADER);
+    }
+    else
+    {
+      m_out.clear();
+      FlowStatsFormat::EncodeHeader(m_out);
+      std::fwrite(m_out.data(), 1, m_out.size(), m_file);
+    }
+  }
+
+  void
+  FlowStatsExporter::SchedulePeriodic(Time interval)
+  {
+    NS_LOG_FUNCTION(this << interval);
+    NS_ABORT_MSG_UNLESS(interval.IsStrictlyPositive(), "FlowStatsExporter: interval must be positive");
+    m_interval = interval;
+    m_event.Cancel();
+    m_event = Simulator::Schedule(m_interval, &FlowStatsExporter::PeriodicDump, this);
+  }
+
+  void
+  FlowStatsExporter::PeriodicDump(void)
+  {
+    Dump();
+    m_event = Simulator::Schedule(m_interval, &FlowStatsExporter::PeriodicDump, this);
+  }
+
+  void
+  FlowStatsExporter::Snapshot(FlowStatsTable &rows)
+  {
+    if (m_endpointMonitor)
+    {
+      m_endpointMonitor->Fill(rows, Simulator::Now().GetNanoSeconds());
+      return;
+    }
+
+    m_monitor->CheckForLostPackets();
+    const FlowMonitor::FlowStatsContainer &stats = m_monitor->GetFlowStats();
+    Ptr<Ipv4FlowClassifier> v4 = DynamicCast<Ipv4FlowClassifier>(m_classifier);
+    Ptr<Ipv6FlowClassifier> v6 = DynamicCast<Ipv6FlowClassifier>(m_classifier);
+    int64_t now = Simulator::Now().GetNanoSeconds();
+
+    rows.Resize(stats.size());
+    std::size_t row = 0;
+    for (FlowMonitor::FlowStatsContainerCI i = stats.begin(); i != stats.end(); ++i, ++row)
+    {
+      const FlowMonitor::FlowStats &fs = i->second;
+      rows.timeNs[row] = now;
+      rows.flowId[row] = i->first;
+      rows.srcAddress[row].fill(0);
+      rows.dstAddress[row].fill(0);
+      if (v4)
+      {
+        Ipv4FlowClassifier::FiveTuple t = v4->FindFlow(i->first);
+        rows.family[row] = 4;
+        t.sourceAddress.Serialize(rows.srcAddress[row].data());
+        t.destinationAddress.Serialize(rows.dstAddress[row].data());
+        rows.protocol[row] = t.protocol;
+        rows.srcPort[row] = t.sourcePort;
+        rows.dstPort[row] = t.destinationPort;
+      }
+      else if (v6)
+      {
+        Ipv6FlowClassifier::FiveTuple t = v6->FindFlow(i->first);
+        rows.family[row] = 6;
+        t.sourceAddress.Serialize(rows.srcAddress[row].data());
+        t.destinationAddress.Serialize(rows.dstAddress[row].data());
+        rows.protocol[row] = t.protocol;
+        rows.srcPort[row] = t.sourcePort;
+        rows.dstPort[row] = t.destinationPort;
+      }
+      else
+      {
+        rows.family[row] = 0;
+        rows.protocol[row] = 0;
+        rows.srcPort[row] = 0;
+        rows.dstPort[row] = 0;
+      }
+      rows.txPackets[row] = fs.txPackets;
+      rows.rxPackets[row] = fs.rxPackets;
+      rows.txBytes[row] = fs.txBytes;
+      rows.rxBytes[row] = fs.rxBytes;
+      rows.lostPackets[row] = fs.lostPackets;
+      rows.timesForwarded[row] = fs.timesForwarded;
+      rows.delaySumNs[row] = fs.delaySum.GetNanoSeconds();
+      rows.jitterSumNs[row] = fs.jitterSum.GetNanoSeconds();
+      rows.firstTxNs[row] = fs.timeFirstTxPacket.GetNanoSeconds();
+      rows.lastTxNs[row] = fs.timeLastTxPacket.GetNanoSeconds();
+      rows.firstRxNs[row] = fs.timeFirstRxPacket.GetNanoSeconds();
+      rows.lastRxNs[row] = fs.timeLastRxPacket.GetNanoSeconds();
+    }
+  }
+
+  void
+  FlowStatsExporter::Dump(void)
+  {
+    NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_UNLESS(m_file, "FlowStatsExporter: Open () has not been called");
+
+    Snapshot(m_rows);
+    std::size_t n = m_rows.GetNRows();
+    if (n == 0)
+    {
+      return;
+    }
+
+    if (m_format == BINARY)
+    {
+      m_out.clear();
+      FlowStatsFormat::EncodeBlock(m_rows, 0, n, m_out);
+      std::fwrite(m_out.data(), 1, m_out.size(), m_file);
+      return;
+    }
+
+    char src[INET6_ADDRSTRLEN];
+    char dst[INET6_ADDRSTRLEN];
+    for (std::size_t row = 0; row < n; ++row)
+    {
+      int af = m_rows.family[row] == 6 ? AF_INET6 : AF_INET;
+      inet_ntop(af, m_rows.srcAddress[row].data(), src, sizeof(src));
+      inet_ntop(af, m_rows.dstAddress[row].data(), dst, sizeof(dst));
+      std::fprintf(m_file,
+                   "%" PRId64 ",%" PRIu32 ",%u,%s,%s,%u,%u,%u,"
+                   "%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu32 ","
+                   "%" PRId64 ",%" PRId64 ",%" PRId64 ",%" PRId64 ",%" PRId64 ",%" PRId64 "\n",
+                   m_rows.timeNs[row], m_rows.flowId[row], unsigned(m_rows.family[row]), src, dst,
+                   unsigned(m_rows.protocol[row]), unsigned(m_rows.srcPort[row]), unsigned(m_rows.dstPort[row]),
+                   m_rows.txPackets[row], m_rows.rxPackets[row], m_rows.txBytes[row], m_rows.rxBytes[row],
+                   m_rows.lostPackets[row], m_rows.timesForwarded[row],
+                   m_rows.delaySumNs[row], m_rows.jitterSumNs[row], m_rows.firstTxNs[row],
+                   m_rows.lastTxNs[row], m_rows.firstRxNs[row], m_rows.lastRxNs[row]);
+    }
+  }
+
+  void
+  FlowStatsExporter::Close(void)
+  {
+    NS_LOG_FUNCTION(this);
+    m_event.Cancel();
+    if (m_file)
+    {
+      std::fclose(m_file);
+      m_file = 0;
+    }
+  }
+
+} // namespace ns3
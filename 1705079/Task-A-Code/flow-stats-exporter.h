@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLOW_STATS_EXPORTER_H
+#define FLOW_STATS_EXPORTER_H
+
+#include "ns3/flow-monitor.h"
+#include "ns3/flow-classifier.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "flow-stats-reader.h"
+#include "endpoint-flow-monitor.h"
+
+#include <cstdio>
+#include <string>
+
+namespace ns3
+{
+
+  /**
+   * \ingroup flow-monitor
+   *
+   * \brief Compact replacement for FlowMonitor::SerializeToXmlFile
+   *
+   * Every dump appends one row per flow (FlowMonitor::FlowStats plus the
+   * five-tuple of the Ipv4FlowClassifier or Ipv6FlowClassifier), or the
+   * counters of an EndpointFlowMonitor, to a CSV or binary columnar file,
+   * see FlowStatsFormat.  Histograms and probe statistics are not exported.  Dumps can be scheduled periodically to
+   * follow the run; counters in each dump are cumulative.
+   *
+   * The exporter schedules events with a raw pointer to itself, so it must
+   * outlive Simulator::Run ().
+   */
+  class FlowStatsExporter
+  {
+  public:
+    /**
+     * \brief Output formats
+     */
+    enum Format
+    {
+      CSV,    //!< One text line per row
+      BINARY, //!< Column blocks, see FlowStatsFormat
+    };
+
+    /**
+     * \brief Constructor
+     * \param monitor the flow monitor
+     * \param classifier the classifier installed with the monitor
+     */
+    FlowStatsExporter(Ptr<FlowMonitor> monitor, Ptr<FlowClassifier> classifier);
+
+    /**
+     * \brief Export the counters of an EndpointFlowMonitor instead of a
+     * FlowMonitor
+     * \param monitor the endpoint monitor, which must outlive the exporter
+     */
+    void SetEndpointFlowMonitor(const EndpointFlowMonitor *monitor);
+
+    /**
+     * \brief Destructor, closes the file
+     */
+    ~FlowStatsExporter();
+
+    /**
+     * \brief Parse a format name ("csv" or "bin")
+     * \param name the format name
+     * \returns the format
+     */
+    static Format ParseFormat(const std::string &name);
+
+    /**
+     * \brief Open the output file
+     * \param filename the file name
+     * \param format the output format
+     */
+    void Open(const std::string &filename, Format format);
+
+    /**
+     * \brief Dump the current statistics every interval, starting one
+     * interval from now
+     * \param interval the dump period
+     */
+    void SchedulePeriodic(Time interval);
+
+    /**
+     * \brief Append a snapshot of all flows at the current time
+     */
+    void Dump(void);
+
+    /**
+     * \brief Take a snapshot of all flows at the current time, without
+     * writing it
+     * \param rows the table, resized to the number of flows
+     */
+    void Snapshot(FlowStatsTable &rows);
+
+    /**
+     * \brief Cancel periodic dumps and close the file
+     */
+    void Close(void);
+
+  private:
+    /**
+     * \brief Periodic dump event
+     */
+    void PeriodicDump(void);
+
+
+    Ptr<FlowMonitor> m_monitor;       //!< Monitored statistics
+    Ptr<FlowClassifier> m_classifier; //!< Five-tuple source
+    const EndpointFlowMonitor *m_endpointMonitor; //!< Used instead of m_monitor if set
+    Format m_format;                  //!< Output format
+    std::FILE *m_file;                //!< Output file
+    Time m_interval;                  //!< Periodic dump interval
+    EventId m_event;                  //!< Next periodic dump
+    FlowStatsTable m_rows;            //!< Staging rows, reused across dumps
+    std::vector<char> m_out;          //!< Staging output buffer
+  };
+
+} // namespace ns3
+
+#endif // FLOW_STATS_EXPORTER_H
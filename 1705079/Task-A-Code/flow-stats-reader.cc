@@ -0,0 +1,342 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "flow-stats-reader.h"
+
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace ns3
+{
+
+  const char FlowStatsFormat::FILE_MAGIC[4] = {'F', 'S', 'X', '1'};
+  const char *FlowStatsFormat::CSV_HEADER =
+      "time_ns,flow_id,family,src_address,dst_address,protocol,src_port,dst_port,"
+      "tx_packets,rx_packets,tx_bytes,rx_bytes,lost_packets,times_forwarded,"
+      "delay_sum_ns,jitter_sum_ns,first_tx_ns,last_tx_ns,first_rx_ns,last_rx_ns";
+
+  namespace
+  {
+    /**
+     * Apply a function to every column, in on-disk order
+     */
+    template <typename Table, typename F>
+    void
+    ForEachColumn(Table &t, F f)
+    {
+      f(t.timeNs);
+      f(t.flowId);
+      f(t.family);
+      f(t.srcAddress);
+      f(t.dstAddress);
+      f(t.protocol);
+      f(t.srcPort);
+      f(t.dstPort);
+      f(t.txPackets);
+      f(t.rxPackets);
+      f(t.txBytes);
+      f(t.rxBytes);
+      f(t.lostPackets);
+      f(t.timesForwarded);
+      f(t.delaySumNs);
+      f(t.jitterSumNs);
+      f(t.firstTxNs);
+      f(t.lastTxNs);
+      f(t.firstRxNs);
+      f(t.lastRxNs);
+    }
+
+    /**
+     * Parse an unsigned field and move past the following separator
+     */
+    bool
+    ParseUnsigned(const char *&p, const char *end, uint64_t &value)
+    {
+      uint64_t v = 0;
+      const char *start = p;
+      while (p < end && *p >= '0' && *p <= '9')
+      {
+        v = v * 10 + (*p - '0');
+        ++p;
+      }
+      if (p == start)
+      {
+        return false;
+      }
+      if (p < end && *p == ',')
+      {
+        ++p;
+      }
+      value = v;
+      return true;
+    }
+
+    /**
+     * Parse a signed field and move past the following separator
+     */
+    bool
+    ParseSigned(const char *&p, const char *end, int64_t &value)
+    {
+      bool negative = false;
+      if (p < end && *p == '-')
+      {
+        negative = true;
+        ++p;
+      }
+      uint64_t v;
+      if (!ParseUnsigned(p, end, v))
+      {
+        return false;
+      }
+      value = negative ? -static_cast<int64_t>(v) : static_cast<int64_t>(v);
+      return true;
+    }
+
+    /**
+     * Parse an address field and move past the following separator
+     */
+    bool
+    ParseAddress(const char *&p, const char *end, uint8_t family, FlowStatsTable::Address &addr)
+    {
+      char buf[64];
+      std::size_t len = 0;
+      while (p < end && *p != ',' && len < sizeof(buf) - 1)
+      {
+        buf[len++] = *p++;
+      }
+      buf[len] = '\0';
+      if (p < end && *p == ',')
+      {
+        ++p;
+      }
+      addr.fill(0);
+      return inet_pton(family == 6 ? AF_INET6 : AF_INET, buf, addr.data()) == 1;
+    }
+  } // namespace
+
+  void
+  FlowStatsTable::Clear(void)
+  {
+    Resize(0);
+  }
+
+  void
+  FlowStatsTable::Resize(std::size_t n)
+  {
+    ForEachColumn(*this, [n](auto &column)
+                  { column.resize(n); });
+  }
+
+  void
+  FlowStatsFormat::EncodeHeader(std::vector<char> &out)
+  {
+    uint32_t header[2] = {BYTE_ORDER_MARK, N_COLUMNS};
+    out.insert(out.end(), FILE_MAGIC, FILE_MAGIC + 4);
+    out.insert(out.end(), reinterpret_cast<const char *>(header),
+               reinterpret_cast<const char *>(header) + sizeof(header));
+  }
+
+  void
+  FlowStatsFormat::EncodeBlock(const FlowStatsTable &table, std::size_t first, std::size_t n,
+                               std::vector<char> &out)
+  {
+    uint32_t header[2] = {BLOCK_MAGIC, static_cast<uint32_t>(n)};
+    out.insert(out.end(), reinterpret_cast<const char *>(header),
+               reinterpret_cast<const char *>(header) + sizeof(header));
+    ForEachColumn(table, [&out, first, n](const auto &column)
+                  {
+                    const char *begin = reinterpret_cast<const char *>(column.data() + first);
+                    out.insert(out.end(), begin, begin + n * sizeof(column[0])); });
+  }
+
+  bool
+  FlowStatsReader::Load(const std::string &filename, FlowStatsTable &table, std::string &error)
+  {
+    std::FILE *f = std::fopen(filename.c_str(), "rb");
+    if (!f)
+    {
+      error = "cannot open " + filename;
+      return false;
+    }
+    std::fseek(f, 0, SEEK_END);
+    long size = std::ftell(f);
+    std::fseek(f, 0, SEEK_SET);
+    std::vector<char> data(size > 0 ? size : 0);
+    std::size_t got = data.empty() ? 0 : std::fread(data.data(), 1, data.size(), f);
+    std::fclose(f);
+    if (got != data.size())
+    {
+      error = "short read on " + filename;
+      return false;
+    }
+
+    if (data.size() >= 4 && std::memcmp(data.data(), FlowStatsFormat::FILE_MAGIC, 4) == 0)
+    {
+      return LoadBinary(data.data(), data.size(), table, error);
+    }
+    return LoadCsv(data.data(), data.size(), table, error);
+  }
+
+  bool
+  FlowStatsReader::LoadBinary(const char *data, std::size_t size, FlowStatsTable &table, std::string &error)
+  {
+    const std::size_t fileHeader = 4 + 2 * sizeof(uint32_t);
+    if (size < fileHeader)
+    {
+      error = "truncated file header";
+      return false;
+    }
+    uint32_t bom;
+    uint32_t nColumns;
+    std::memcpy(&bom, data + 4, sizeof(bom));
+    std::memcpy(&nColumns, data + 8, sizeof(nColumns));
+    if (bom != FlowStatsFormat::BYTE_ORDER_MARK)
+    {
+      error = "file was written with a different byte order";
+      return false;
+    }
+    if (nColumns != FlowStatsFormat::N_COLUMNS)
+    {
+      error = "unexpected number of columns";
+      return false;
+    }
+
+    // Size all columns once, so that the copy loop never reallocates
+    std::size_t rowSize = 0;
+    ForEachColumn(table, [&rowSize](const auto &column)
+                  { rowSize += sizeof(column[0]); });
+    std::size_t total = table.GetNRows();
+    std::size_t pos = fileHeader;
+    while (pos + 2 * sizeof(uint32_t) <= size)
+    {
+      uint32_t header[2];
+      std::memcpy(header, data + pos, sizeof(header));
+      if (header[0] != FlowStatsFormat::BLOCK_MAGIC)
+      {
+        error = "corrupted block header";
+        return false;
+      }
+      pos += sizeof(header) + header[1] * rowSize;
+      total += header[1];
+    }
+    if (pos != size)
+    {
+      error = "truncated block";
+      return false;
+    }
+
+    std::size_t row = table.GetNRows();
+    table.Resize(total);
+    pos = fileHeader;
+    while (pos < size)
+    {
+      uint32_t header[2];
+      std::memcpy(header, data + pos, sizeof(header));
+      pos += sizeof(header);
+      std::size_t n = header[1];
+      ForEachColumn(table, [data, &pos, row, n](auto &column)
+                    {
+                      std::memcpy(column.data() + row, data + pos, n * sizeof(column[0]));
+                      pos += n * sizeof(column[0]); });
+      row += n;
+    }
+    return true;
+  }
+
+  bool
+  FlowStatsReader::LoadCsv(const char *data, std::size_t size, FlowStatsTable &table, std::string &error)
+  {
+    const char *p = data;
+    const char *end = data + size;
+
+    // skip the header line
+    const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+    if (!eol || std::strncmp(p, FlowStatsFormat::CSV_HEADER, std::strlen(FlowStatsFormat::CSV_HEADER)) != 0)
+    {
+      error = "not a flow statistics file";
+      return false;
+    }
+    p = eol + 1;
+
+    // one pass to count lines, so that columns are allocated once
+    std::size_t lines = 0;
+    for (const char *q = p; q < end; ++q)
+    {
+      lines += (*q == '\n');
+    }
+    // the last row may have no newline
+    if (p < end && end[-1] != '\n')
+    {
+      ++lines;
+    }
+    std::size_t row = table.GetNRows();
+    table.Resize(row + lines);
+
+    uint64_t u;
+    int64_t s;
+    while (p < end)
+    {
+      if (*p == '\n')
+      {
+        ++p;
+        continue;
+      }
+      bool ok = ParseSigned(p, end, s);
+      table.timeNs[row] = s;
+      ok = ok && ParseUnsigned(p, end, u);
+      table.flowId[row] = static_cast<uint32_t>(u);
+      ok = ok && ParseUnsigned(p, end, u);
+      table.family[row] = static_cast<uint8_t>(u);
+      ok = ok && ParseAddress(p, end, table.family[row], table.srcAddress[row]);
+      ok = ok && ParseAddress(p, end, table.family[row], table.dstAddress[row]);
+      ok = ok && ParseUnsigned(p, end, u);
+      table.protocol[row] = static_cast<uint8_t>(u);
+      ok = ok && ParseUnsigned(p, end, u);
+      table.srcPort[row] = static_cast<uint16_t>(u);
+      ok = ok && ParseUnsigned(p, end, u);
+      table.dstPort[row] = static_cast<uint16_t>(u);
+      ok = ok && ParseUnsigned(p, end, table.txPackets[row]);
+      ok = ok && ParseUnsigned(p, end, table.rxPackets[row]);
+      ok = ok && ParseUnsigned(p, end, table.txBytes[row]);
+      ok = ok && ParseUnsigned(p, end, table.rxBytes[row]);
+      ok = ok && ParseUnsigned(p, end, table.lostPackets[row]);
+      ok = ok && ParseUnsigned(p, end, u);
+      table.timesForwarded[row] = static_cast<uint32_t>(u);
+      ok = ok && ParseSigned(p, end, table.delaySumNs[row]);
+      ok = ok && ParseSigned(p, end, table.jitterSumNs[row]);
+      ok = ok && ParseSigned(p, end, table.firstTxNs[row]);
+      ok = ok && ParseSigned(p, end, table.lastTxNs[row]);
+      ok = ok && ParseSigned(p, end, table.firstRxNs[row]);
+      ok = ok && ParseSigned(p, end, table.lastRxNs[row]);
+      if (!ok || (p < end && *p != '\n' && *p != '\r'))
+      {
+        error = "malformed line " + std::to_string(row + 2);
+        table.Resize(row);
+        return false;
+      }
+      while (p < end && *p != '\n')
+      {
+        ++p;
+      }
+      ++row;
+    }
+    table.Resize(row);
+    return true;
+  }
+
+} // namespace ns3
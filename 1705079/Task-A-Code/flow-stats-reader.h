@@ -0,0 +1,172 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLOW_STATS_READER_H
+#define FLOW_STATS_READER_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * This header does not depend on ns-3, so that post-processing tools can
+ * load exported flow statistics without linking the simulator.
+ */
+
+namespace ns3
+{
+
+  /**
+   * \ingroup flow-monitor
+   *
+   * \brief Column-oriented table of flow statistics rows
+   *
+   * One row is one flow at one dump time.  Times are in nanoseconds,
+   * addresses are stored on 16 bytes (IPv4 addresses use the first 4).
+   */
+  struct FlowStatsTable
+  {
+    typedef std::array<uint8_t, 16> Address; //!< Raw address bytes
+
+    std::vector<int64_t> timeNs;          //!< Dump time
+    std::vector<uint32_t> flowId;         //!< FlowMonitor flow id
+    std::vector<uint8_t> family;          //!< 4 or 6
+    std::vector<Address> srcAddress;      //!< Source address
+    std::vector<Address> dstAddress;      //!< Destination address
+    std::vector<uint8_t> protocol;        //!< IP protocol number
+    std::vector<uint16_t> srcPort;        //!< Source port
+    std::vector<uint16_t> dstPort;        //!< Destination port
+    std::vector<uint64_t> txPackets;      //!< FlowStats::txPackets
+    std::vector<uint64_t> rxPackets;      //!< FlowStats::rxPackets
+    std::vector<uint64_t> txBytes;        //!< FlowStats::txBytes
+    std::vector<uint64_t> rxBytes;        //!< FlowStats::rxBytes
+    std::vector<uint64_t> lostPackets;    //!< FlowStats::lostPackets
+    std::vector<uint32_t> timesForwarded; //!< FlowStats::timesForwarded
+    std::vector<int64_t> delaySumNs;      //!< FlowStats::delaySum
+    std::vector<int64_t> jitterSumNs;     //!< FlowStats::jitterSum
+    std::vector<int64_t> firstTxNs;       //!< FlowStats::timeFirstTxPacket
+    std::vector<int64_t> lastTxNs;        //!< FlowStats::timeLastTxPacket
+    std::vector<int64_t> firstRxNs;       //!< FlowStats::timeFirstRxPacket
+    std::vector<int64_t> lastRxNs;        //!< FlowStats::timeLastRxPacket
+
+    /**
+     * \returns the number of rows
+     */
+    std::size_t GetNRows(void) const
+    {
+      return flowId.size();
+    }
+
+    /**
+     * \brief Remove all rows
+     */
+    void Clear(void);
+
+    /**
+     * \brief Resize every column
+     * \param n the new number of rows
+     */
+    void Resize(std::size_t n);
+  };
+
+  /**
+   * \ingroup flow-monitor
+   *
+   * \brief On-disk layout shared by FlowStatsExporter and FlowStatsReader
+   *
+   * The binary format is a file header followed by blocks, one per dump.
+   *
+   *   file header  : magic "FSX1", uint32 byte-order mark 0x01020304,
+   *                  uint32 number of columns
+   *   block header : uint32 block magic "BLK1", uint32 number of rows n
+   *   block body   : each column in the order of the FlowStatsTable members,
+   *                  as n contiguous values of the column type
+   *
+   * The CSV format has one header line followed by one line per row, with
+   * the same columns in the same order and addresses in text form.
+   */
+  struct FlowStatsFormat
+  {
+    static const char FILE_MAGIC[4];            //!< "FSX1"
+    static const uint32_t BYTE_ORDER_MARK = 0x01020304; //!< Written in host byte order
+    static const uint32_t BLOCK_MAGIC = 0x314b4c42;     //!< "BLK1" read as little endian
+    static const uint32_t N_COLUMNS = 20;               //!< Columns per row
+    static const char *CSV_HEADER;                      //!< CSV header line
+
+    /**
+     * \brief Append the file header to a buffer
+     * \param out the output buffer
+     */
+    static void EncodeHeader(std::vector<char> &out);
+
+    /**
+     * \brief Append the binary encoding of some rows to a buffer
+     * \param table the table
+     * \param first first row to encode
+     * \param n number of rows
+     * \param out the output buffer
+     */
+    static void EncodeBlock(const FlowStatsTable &table, std::size_t first, std::size_t n,
+                            std::vector<char> &out);
+  };
+
+  /**
+   * \ingroup flow-monitor
+   *
+   * \brief Loads CSV or binary flow statistics files into a FlowStatsTable
+   *
+   * The binary loader reads the whole file with a single read and copies
+   * every column block with memcpy; the CSV loader parses the buffer in
+   * place without per-field allocations.
+   */
+  class FlowStatsReader
+  {
+  public:
+    /**
+     * \brief Load a file, the format is detected from its first bytes
+     * \param filename the file name
+     * \param table the table rows are appended to
+     * \param error set to a description of the failure, if any
+     * \returns true on success
+     */
+    static bool Load(const std::string &filename, FlowStatsTable &table, std::string &error);
+
+    /**
+     * \brief Decode a binary file image, e.g. received from another process
+     * \param data file contents (header and blocks)
+     * \param size file size
+     * \param table the table rows are appended to
+     * \param error error description
+     * \returns true on success
+     */
+    static bool LoadBinary(const char *data, std::size_t size, FlowStatsTable &table, std::string &error);
+
+  private:
+    /**
+     * \brief Parse a CSV file image
+     * \param data file contents
+     * \param size file size
+     * \param table output table
+     * \param error error description
+     * \returns true on success
+     */
+    static bool LoadCsv(const char *data, std::size_t size, FlowStatsTable &table, std::string &error);
+  };
+
+} // namespace ns3
+
+#endif // FLOW_STATS_READER_H
@@ -0,0 +1,322 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/callback.h"
+#include "ns3/packet-sink.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/inet6-socket-address.h"
+#include "goodput-metrics.h"
+
+#include <arpa/inet.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace ns3
+{
+
+  NS_LOG_COMPONENT_DEFINE("GoodputMetrics");
+
+  GoodputMetrics::GoodputMetrics(Time binWidth)
+      : m_binWidth(binWidth),
+        m_running(false),
+        m_bin(0),
+        m_attackers(16),
+        m_measured(Seconds(0)),
+        m_jainSum(0),
+        m_nJainBins(0),
+        m_nStarvedBins(0),
+        m_jainMin(1),
+        m_stream(0)
+  {
+    NS_LOG_FUNCTION(this << binWidth);
+    NS_ABORT_MSG_UNLESS(binWidth.IsStrictlyPositive(), "GoodputMetrics: bin width must be positive");
+    for (int c = 0; c < 2; ++c)
+    {
+      m_nFlows[c] = 0;
+      m_current[c].bytes = 0;
+      m_current[c].sumSq = 0;
+      m_totalBytes[c] = 0;
+    }
+  }
+
+  GoodputMetrics::~GoodputMetrics()
+  {
+    NS_LOG_FUNCTION(this);
+    m_event.Cancel();
+    if (m_stream)
+    {
+      std::fclose(m_stream);
+      m_stream = 0;
+    }
+  }
+
+  void
+  GoodputMetrics::Install(ApplicationContainer sinks)
+  {
+    NS_LOG_FUNCTION(this);
+    for (ApplicationContainer::Iterator i = sinks.Begin(); i != sinks.End(); ++i)
+    {
+      Ptr<PacketSink> sink = DynamicCast<PacketSink>(*i);
+      NS_ABORT_MSG_UNLESS(sink, "GoodputMetrics: application is not a PacketSink");
+      sink->TraceConnectWithoutContext("RxWithAddresses", MakeCallback(&GoodputMetrics::Rx, this));
+    }
+  }
+
+  void
+  GoodputMetrics::AddAttackerSource(Ipv4Address address)
+  {
+    NS_LOG_FUNCTION(this << address);
+    FlowKey key;
+    key.family = 4;
+    address.Serialize(key.srcAddress);
+    m_attackers.FindOrInsert(key) = 1;
+  }
+
+  void
+  GoodputMetrics::AddAttackerSource(Ipv6Address address)
+  {
+    NS_LOG_FUNCTION(this << address);
+    FlowKey key;
+    key.family = 6;
+    address.Serialize(key.srcAddress);
+    m_attackers.FindOrInsert(key) = 1;
+  }
+
+  void
+  GoodputMetrics::OpenStream(const std::string &filename)
+  {
+    NS_LOG_FUNCTION(this << filename);
+    NS_ABORT_MSG_IF(m_stream, "GoodputMetrics: stream already open");
+    m_stream = std::fopen(filename.c_str(), "w");
+    NS_ABORT_MSG_UNLESS(m_stream, "GoodputMetrics: cannot open " << filename);
+    std::fprintf(m_stream, "bin_start_s,bin_width_s,legit_goodput_bps,attack_goodput_bps,jain_index,"
+                           "legit_flows,attack_flows\n");
+  }
+
+  void
+  GoodputMetrics::Start(Time start)
+  {
+    NS_LOG_FUNCTION(this << start);
+    m_event.Cancel();
+    m_binStart = start;
+    m_event = Simulator::Schedule(start + m_binWidth - Simulator::Now(), &GoodputMetrics::CloseBin, this);
+    m_running = false;
+    Simulator::Schedule(start - Simulator::Now(), &GoodputMetrics::Begin, this);
+  }
+
+  void
+  GoodputMetrics::Begin(void)
+  {
+    m_running = true;
+  }
+
+  void
+  GoodputMetrics::FillKey(const Address &address, bool src, FlowKey &key)
+  {
+    uint8_t *addr = src ? key.srcAddress : key.dstAddress;
+    uint16_t port = 0;
+    if (InetSocketAddress::IsMatchingType(address))
+    {
+      InetSocketAddress a = InetSocketAddress::ConvertFrom(address);
+      key.family = 4;
+      a.GetIpv4().Serialize(addr);
+      port = a.GetPort();
+    }
+    else if (Inet6SocketAddress::IsMatchingType(address))
+    {
+      Inet6SocketAddress a = Inet6SocketAddress::ConvertFrom(address);
+      key.family = 6;
+      a.GetIpv6().Serialize(addr);
+      port = a.GetPort();
+    }
+    if (src)
+    {
+      key.srcPort = port;
+    }
+    else
+    {
+      key.dstPort = port;
+    }
+  }
+
+  void
+  GoodputMetrics::Rx(Ptr<const Packet> packet, const Address &from, const Address &to)
+  {
+    if (!m_running)
+    {
+      return;
+    }
+
+    FlowKey key;
+    FillKey(from, true, key);
+    FillKey(to, false, key);
+    FlowState &flow = m_flows.FindOrInsert(key);
+    if (flow.index == 0)
+    {
+      FlowKey source;
+      source.family = key.family;
+      std::memcpy(source.srcAddress, key.srcAddress, sizeof(source.srcAddress));
+      flow.attacker = m_attackers.Find(source) != 0;
+      flow.index = static_cast<uint32_t>(m_keys.size()) + 1;
+      m_keys.push_back(key);
+      m_isAttacker.push_back(flow.attacker);
+      m_series.push_back(std::vector<uint32_t>());
+      ++m_nFlows[flow.attacker];
+    }
+    if (flow.bin != m_bin)
+    {
+      // first packet of the flow in this bin: its previous bin was closed
+      flow.bin = m_bin;
+      flow.binBytes = 0;
+    }
+
+    uint32_t size = packet->GetSize();
+    ClassBin &c = m_current[flow.attacker];
+    double before = static_cast<double>(flow.binBytes);
+    flow.binBytes += size;
+    double after = static_cast<double>(flow.binBytes);
+    c.bytes += size;
+    c.sumSq += after * after - before * before;
+
+    std::vector<uint32_t> &series = m_series[flow.index - 1];
+    if (series.size() <= m_bin)
+    {
+      series.resize(m_bin + 1, 0);
+    }
+    series[m_bin] += size;
+  }
+
+  void
+  GoodputMetrics::CloseBin(void)
+  {
+    EndBin(m_binWidth);
+    m_event = Simulator::Schedule(m_binWidth, &GoodputMetrics::CloseBin, this);
+  }
+
+  void
+  GoodputMetrics::EndBin(Time width)
+  {
+    NS_LOG_FUNCTION(this << width);
+    double seconds = width.GetSeconds();
+    const ClassBin &legit = m_current[0];
+    const ClassBin &attack = m_current[1];
+
+    // Jain's index (sum x)^2 / (n sum x^2) over the legitimate flows seen
+    // so far; a bin where none of them received anything is starved (0)
+    double jain = std::numeric_limits<double>::quiet_NaN();
+    if (m_nFlows[0] > 0)
+    {
+      double sum = static_cast<double>(legit.bytes);
+      jain = legit.sumSq > 0 ? sum * sum / (m_nFlows[0] * legit.sumSq) : 0;
+      m_nStarvedBins += legit.sumSq == 0;
+      m_jainSum += jain;
+      m_jainMin = std::min(m_jainMin, jain);
+      ++m_nJainBins;
+    }
+
+    if (m_stream && seconds > 0)
+    {
+      std::fprintf(m_stream, "%.9g,%.9g,%.9g,%.9g,%.6f,%u,%u\n",
+                   m_binStart.GetSeconds(), seconds,
+                   legit.bytes * 8.0 / seconds, attack.bytes * 8.0 / seconds,
+                   jain, m_nFlows[0], m_nFlows[1]);
+    }
+
+    for (int c = 0; c < 2; ++c)
+    {
+      m_totalBytes[c] += m_current[c].bytes;
+      m_current[c].bytes = 0;
+      m_current[c].sumSq = 0;
+    }
+    m_widths.push_back(width.GetSeconds());
+    m_measured += width;
+    m_binStart += width;
+    ++m_bin;
+  }
+
+  void
+  GoodputMetrics::Finish(void)
+  {
+    NS_LOG_FUNCTION(this);
+    if (!m_running)
+    {
+      return;
+    }
+    m_event.Cancel();
+    Time width = Simulator::Now() - m_binStart;
+    if (width.IsStrictlyPositive())
+    {
+      EndBin(width);
+    }
+    m_running = false;
+    if (m_stream)
+    {
+      std::fflush(m_stream);
+    }
+  }
+
+  GoodputMetrics::Summary
+  GoodputMetrics::GetSummary(void) const
+  {
+    Summary s;
+    s.nBins = static_cast<uint32_t>(m_bin);
+    s.nLegitFlows = m_nFlows[0];
+    s.nAttackFlows = m_nFlows[1];
+    double seconds = m_measured.GetSeconds();
+    s.legitGoodputBps = seconds > 0 ? m_totalBytes[0] * 8.0 / seconds : 0;
+    s.attackGoodputBps = seconds > 0 ? m_totalBytes[1] * 8.0 / seconds : 0;
+    s.nStarvedBins = m_nStarvedBins;
+    s.meanJain = m_nJainBins > 0 ? m_jainSum / m_nJainBins : std::numeric_limits<double>::quiet_NaN();
+    s.minJain = m_nJainBins > 0 ? m_jainMin : std::numeric_limits<double>::quiet_NaN();
+    return s;
+  }
+
+  void
+  GoodputMetrics::WriteFlowSeries(const std::string &filename) const
+  {
+    NS_LOG_FUNCTION(this << filename);
+    std::FILE *f = std::fopen(filename.c_str(), "w");
+    NS_ABORT_MSG_UNLESS(f, "GoodputMetrics: cannot open " << filename);
+    std::fprintf(f, "flow,src_address,src_port,dst_address,dst_port,attacker,bin_start_s,goodput_bps\n");
+
+    char src[INET6_ADDRSTRLEN];
+    char dst[INET6_ADDRSTRLEN];
+    double start = (m_binStart - m_measured).GetSeconds();
+    for (std::size_t i = 0; i < m_keys.size(); ++i)
+    {
+      const FlowKey &key = m_keys[i];
+      int af = key.family == 6 ? AF_INET6 : AF_INET;
+      inet_ntop(af, key.srcAddress, src, sizeof(src));
+      inet_ntop(af, key.dstAddress, dst, sizeof(dst));
+      // silent bins are written as zero, up to the last closed bin
+      double binStart = start;
+      for (uint64_t bin = 0; bin < m_bin; ++bin)
+      {
+        uint32_t bytes = bin < m_series[i].size() ? m_series[i][bin] : 0;
+        std::fprintf(f, "%zu,%s,%u,%s,%u,%u,%.9g,%.9g\n", i + 1, src, unsigned(key.srcPort), dst,
+                     unsigned(key.dstPort), unsigned(m_isAttacker[i]),
+                     binStart, bytes * 8.0 / m_widths[bin]);
+        binStart += m_widths[bin];
+      }
+    }
+    std::fclose(f);
+  }
+
+} // namespace ns3
@@ -0,0 +1,215 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef GOODPUT_METRICS_H
+#define GOODPUT_METRICS_H
+
+#include "ns3/application-container.h"
+#include "ns3/address.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv6-address.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "flow-key.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+  /**
+   * \ingroup applications
+   *
+   * \brief Per-flow goodput in fixed time bins, with Jain's fairness index
+   * and the attack / legitimate split computed as packets arrive
+   *
+   * Goodput is counted at the PacketSink applications (RxWithAddresses
+   * trace), so only payload delivered to the application is included.
+   * A flow is the (sender, receiver) socket address pair; flows whose
+   * sender address was registered with AddAttackerSource are counted as
+   * attack traffic.
+   *
+   * Each received packet updates the per-class sum and sum of squares of
+   * the current bin in O(1), so closing a bin does not iterate over the
+   * flows.  The fairness index of a bin is computed over every
+   * legitimate flow seen so far: a flow that stops receiving during an
+   * attack counts as zero instead of disappearing from the index.  A bin
+   * where none of them received anything is starved and gets index 0,
+   * not the 1 of the formula's limit, so a total collapse pulls the mean
+   * and minimum down; bins before the first legitimate packet have no
+   * index (NaN in the CSV) and are left out of both.
+   *
+   * Closed bins can be streamed to a CSV file (one line per bin); the
+   * per-flow series is kept in memory and can be written at the end.
+   *
+   * Events and trace sinks are bound to a raw pointer, so the collector
+   * must outlive Simulator::Run ().
+   */
+  class GoodputMetrics
+  {
+  public:
+    /**
+     * \brief Whole-run results
+     */
+    struct Summary
+    {
+      uint32_t nBins;          //!< Number of closed bins
+      uint32_t nLegitFlows;    //!< Legitimate flows seen
+      uint32_t nAttackFlows;   //!< Attack flows seen
+      double legitGoodputBps;  //!< Mean legitimate goodput over the measured time
+      double attackGoodputBps; //!< Mean attack goodput over the measured time
+      uint32_t nStarvedBins;   //!< Bins where no legitimate flow received anything
+      double meanJain;         //!< Mean fairness index over the bins with an index, NaN if none
+      double minJain;          //!< Lowest fairness index of a bin, NaN if none
+    };
+
+    /**
+     * \brief Constructor
+     * \param binWidth the bin width
+     */
+    GoodputMetrics(Time binWidth);
+
+    /**
+     * \brief Destructor, closes the stream file
+     */
+    ~GoodputMetrics();
+
+    /**
+     * \brief Count the traffic received by some PacketSink applications
+     * \param sinks the applications
+     */
+    void Install(ApplicationContainer sinks);
+
+    /**
+     * \brief Count flows sent from an address as attack traffic
+     * \param address the sender address
+     */
+    void AddAttackerSource(Ipv4Address address);
+    /**
+     * \brief Count flows sent from an address as attack traffic
+     * \param address the sender address
+     */
+    void AddAttackerSource(Ipv6Address address);
+
+    /**
+     * \brief Write every closed bin to a CSV file
+     * \param filename the file name
+     */
+    void OpenStream(const std::string &filename);
+
+    /**
+     * \brief Start the first bin; packets received earlier are ignored
+     * \param start the start time
+     */
+    void Start(Time start);
+
+    /**
+     * \brief Close the current, possibly partial, bin and stop binning
+     */
+    void Finish(void);
+
+    /**
+     * \returns the whole-run results
+     */
+    Summary GetSummary(void) const;
+
+    /**
+     * \brief Write the goodput of every flow in every bin (long format)
+     * \param filename the file name
+     */
+    void WriteFlowSeries(const std::string &filename) const;
+
+  private:
+    /**
+     * \brief Per-flow state
+     */
+    struct FlowState
+    {
+      uint32_t index;    //!< Index in m_series, plus one (0 for new entries)
+      bool attacker;     //!< Counted as attack traffic
+      uint64_t bin;      //!< Bin of binBytes
+      uint64_t binBytes; //!< Bytes received in bin
+    };
+
+    /**
+     * \brief Per-class accumulators of the current bin
+     */
+    struct ClassBin
+    {
+      uint64_t bytes; //!< Sum of the flow bytes
+      double sumSq;   //!< Sum of the squared flow bytes
+    };
+
+    /**
+     * \brief PacketSink receive trace
+     * \param packet the packet
+     * \param from the sender socket address
+     * \param to the receiver socket address
+     */
+    void Rx(Ptr<const Packet> packet, const Address &from, const Address &to);
+
+    /**
+     * \brief Fill the address and port of a key from a socket address
+     * \param address the socket address
+     * \param src true for the sender side
+     * \param key the key
+     */
+    static void FillKey(const Address &address, bool src, FlowKey &key);
+
+    /**
+     * \brief Start counting received packets
+     */
+    void Begin(void);
+
+    /**
+     * \brief Bin close event
+     */
+    void CloseBin(void);
+
+    /**
+     * \brief Close the current bin
+     * \param width actual width of the bin
+     */
+    void EndBin(Time width);
+
+    Time m_binWidth;                       //!< Bin width
+    Time m_binStart;                       //!< Start of the current bin
+    bool m_running;                        //!< Between Start and Finish
+    uint64_t m_bin;                        //!< Index of the current bin
+    EventId m_event;                       //!< Next bin close
+    FlatFlowTable<FlowState> m_flows;      //!< Flow states
+    FlatFlowTable<uint8_t> m_attackers;    //!< Attacker sources (address part of the key only)
+    std::vector<FlowKey> m_keys;           //!< Flow keys, by index
+    std::vector<uint8_t> m_isAttacker;     //!< Flow classes, by index
+    std::vector<std::vector<uint32_t>> m_series; //!< Bytes per bin, by flow index
+    uint32_t m_nFlows[2];                  //!< Flows seen, legitimate and attack
+    ClassBin m_current[2];                 //!< Current bin, legitimate and attack
+    uint64_t m_totalBytes[2];              //!< Bytes of closed bins, legitimate and attack
+    std::vector<double> m_widths;          //!< Width of every closed bin in seconds
+    Time m_measured;                       //!< Total width of closed bins
+    double m_jainSum;                      //!< Sum of the per-bin fairness indexes
+    uint32_t m_nJainBins;                  //!< Bins with a fairness index
+    uint32_t m_nStarvedBins;               //!< Bins with legitimate flows but no legitimate bytes
+    double m_jainMin;                      //!< Lowest per-bin fairness index
+    std::FILE *m_stream;                   //!< Streamed bins, or 0
+  };
+
+} // namespace ns3
+
+#endif // GOODPUT_METRICS_H
@@ -0,0 +1,276 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/socket.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-raw-socket-factory.h"
+#include "ns3/udp-header.h"
+#include "ns3/udp-l4-protocol.h"
+#include "ns3/udp-socket-factory.h"
+#include "low-rate-dos-application.h"
+
+namespace ns3
+{
+
+  NS_LOG_COMPONENT_DEFINE("LowRateDosApplication");
+
+  NS_OBJECT_ENSURE_REGISTERED(LowRateDosApplication);
+
+  namespace
+  {
+    // IPv4 and UDP headers, without options
+    const uint32_t HEADER_SIZE = 28;
+  } // namespace
+
+  TypeId
+  LowRateDosApplication::GetTypeId(void)
+  {
+    static TypeId tid = TypeId("ns3::LowRateDosApplication")
+                            .SetParent<Application>()
+                            .SetGroupName("Applications")
+                            .AddConstructor<LowRateDosApplication>()
+                            .AddAttribute("Remote",
+                                          "The address of the destination",
+                                          AddressValue(),
+                                          MakeAddressAccessor(&LowRateDosApplication::m_remote),
+                                          MakeAddressChecker())
+                            .AddAttribute("Period",
+                                          "Time between the starts of two pulses",
+                                          TimeValue(Seconds(1.0)),
+                                          MakeTimeAccessor(&LowRateDosApplication::m_period),
+                                          MakeTimeChecker())
+                            .AddAttribute("BurstLength",
+                                          "Length of a pulse",
+                                          TimeValue(MilliSeconds(100)),
+                                          MakeTimeAccessor(&LowRateDosApplication::m_burstLength),
+                                          MakeTimeChecker())
+                            .AddAttribute("Phase",
+                                          "Offset of the first pulse from the application start",
+                                          TimeValue(Seconds(0.0)),
+                                          MakeTimeAccessor(&LowRateDosApplication::m_phase),
+                                          MakeTimeChecker())
+                            .AddAttribute("PeakRate",
+                                          "Sending rate during a pulse",
+                                          DataRateValue(DataRate("10Mbps")),
+                                          MakeDataRateAccessor(&LowRateDosApplication::m_peakRate),
+                                          MakeDataRateChecker())
+                            .AddAttribute("PacketSize",
+                                          "Size of the packets, IP and UDP headers included",
+                                          UintegerValue(1000),
+                                          MakeUintegerAccessor(&LowRateDosApplication::m_pktSize),
+                                          MakeUintegerChecker<uint32_t>(HEADER_SIZE))
+                            .AddAttribute("Spoofing",
+                                          "Source address spoofing",
+                                          EnumValue(NONE),
+                                          MakeEnumAccessor(&LowRateDosApplication::m_spoofing),
+                                          MakeEnumChecker(NONE, "None",
+                                                          FIXED, "Fixed",
+                                                          RANDOM, "Random"))
+                            .AddAttribute("SpoofAddress",
+                                          "Spoofed source address (Fixed) or network (Random)",
+                                          Ipv4AddressValue(Ipv4Address("192.168.0.0")),
+                                          MakeIpv4AddressAccessor(&LowRateDosApplication::m_spoofAddress),
+                                          MakeIpv4AddressChecker())
+                            .AddAttribute("SpoofMask",
+                                          "Mask of the spoofed network (Random)",
+                                          Ipv4MaskValue(Ipv4Mask("255.255.0.0")),
+                                          MakeIpv4MaskAccessor(&LowRateDosApplication::m_spoofMask),
+                                          MakeIpv4MaskChecker())
+                            .AddAttribute("SourcePort",
+                                          "Spoofed source port (Fixed)",
+                                          UintegerValue(9),
+                                          MakeUintegerAccessor(&LowRateDosApplication::m_sourcePort),
+                                          MakeUintegerChecker<uint16_t>())
+                            .AddTraceSource("Tx",
+                                            "A packet is sent",
+                                            MakeTraceSourceAccessor(&LowRateDosApplication::m_txTrace),
+                                            "ns3::Packet::TracedCallback");
+    return tid;
+  }
+
+  LowRateDosApplication::LowRateDosApplication()
+      : m_burstSent(0),
+        m_totalTx(0)
+  {
+    NS_LOG_FUNCTION(this);
+    m_uv = CreateObject<UniformRandomVariable>();
+  }
+
+  LowRateDosApplication::~LowRateDosApplication()
+  {
+    NS_LOG_FUNCTION(this);
+  }
+
+  void
+  LowRateDosApplication::DoDispose(void)
+  {
+    NS_LOG_FUNCTION(this);
+    m_socket = 0;
+    m_uv = 0;
+    Application::DoDispose();
+  }
+
+  uint64_t
+  LowRateDosApplication::GetTotalTx(void) const
+  {
+    return m_totalTx;
+  }
+
+  int64_t
+  LowRateDosApplication::AssignStreams(int64_t stream)
+  {
+    NS_LOG_FUNCTION(this << stream);
+    m_uv->SetStream(stream);
+    return 1;
+  }
+
+  void
+  LowRateDosApplication::StartApplication(void)
+  {
+    NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_UNLESS(m_burstLength.IsStrictlyPositive() && m_burstLength <= m_period,
+                        "LowRateDosApplication: BurstLength must be in (0, Period]");
+    if (!m_socket)
+    {
+      if (m_spoofing == NONE)
+      {
+        m_socket = Socket::CreateSocket(GetNode(), UdpSocketFactory::GetTypeId());
+        if (InetSocketAddress::IsMatchingType(m_remote))
+        {
+          m_socket->Bind();
+        }
+        else
+        {
+          m_socket->Bind6();
+        }
+        m_socket->Connect(m_remote);
+      }
+      else
+      {
+        NS_ABORT_MSG_UNLESS(InetSocketAddress::IsMatchingType(m_remote),
+                            "LowRateDosApplication: spoofing needs an IPv4 Remote");
+        m_socket = Socket::CreateSocket(GetNode(), Ipv4RawSocketFactory::GetTypeId());
+        m_socket->SetAttribute("Protocol", UintegerValue(UdpL4Protocol::PROT_NUMBER));
+        m_socket->SetAttribute("IpHeaderInclude", BooleanValue(true));
+      }
+      m_socket->ShutdownRecv();
+    }
+    m_interval = m_peakRate.CalculateBytesTxTime(m_pktSize);
+    m_burstStart = Simulator::Now() + m_phase;
+    m_event = Simulator::Schedule(m_phase, &LowRateDosApplication::StartBurst, this);
+  }
+
+  void
+  LowRateDosApplication::StopApplication(void)
+  {
+    NS_LOG_FUNCTION(this);
+    m_event.Cancel();
+  }
+
+  void
+  LowRateDosApplication::StartBurst(void)
+  {
+    NS_LOG_FUNCTION(this);
+    m_burstSent = 0;
+    SendPacket();
+  }
+
+  void
+  LowRateDosApplication::SendPacket(void)
+  {
+    Ptr<Packet> p = Create<Packet>(m_pktSize - HEADER_SIZE);
+    if (m_spoofing == NONE)
+    {
+      m_socket->Send(p);
+    }
+    else
+    {
+      InetSocketAddress remote = InetSocketAddress::ConvertFrom(m_remote);
+      Ipv4Address source = m_spoofAddress;
+      uint16_t sourcePort = m_sourcePort;
+      if (m_spoofing == RANDOM)
+      {
+        // a host of the network, never its network or broadcast address
+        uint32_t hosts = ~m_spoofMask.Get();
+        uint32_t host = hosts > 1 ? m_uv->GetInteger(1, hosts - 1) : 0;
+        source = Ipv4Address((m_spoofAddress.Get() & m_spoofMask.Get()) | host);
+        sourcePort = static_cast<uint16_t>(m_uv->GetInteger(1024, 65535));
+      }
+      UdpHeader udp;
+      udp.SetSourcePort(sourcePort);
+      udp.SetDestinationPort(remote.GetPort());
+      p->AddHeader(udp);
+      Ipv4Header ip;
+      ip.SetSource(source);
+      ip.SetDestination(remote.GetIpv4());
+      ip.SetProtocol(UdpL4Protocol::PROT_NUMBER);
+      ip.SetPayloadSize(p->GetSize());
+      ip.SetTtl(64);
+      p->AddHeader(ip);
+      m_socket->SendTo(p, 0, remote);
+    }
+    m_txTrace(p);
+    m_totalTx++;
+    m_burstSent++;
+
+    // times are derived from the burst start, not from the last event
+    Time next = m_burstStart + m_interval * static_cast<int64_t>(m_burstSent);
+    if (next < m_burstStart + m_burstLength)
+    {
+      m_event = Simulator::Schedule(next - Simulator::Now(), &LowRateDosApplication::SendPacket, this);
+    }
+    else
+    {
+      m_burstStart += m_period;
+      m_event = Simulator::Schedule(m_burstStart - Simulator::Now(), &LowRateDosApplication::StartBurst, this);
+    }
+  }
+
+  LowRateDosHelper::LowRateDosHelper(Address remote)
+  {
+    m_factory.SetTypeId(LowRateDosApplication::GetTypeId());
+    m_factory.Set("Remote", AddressValue(remote));
+  }
+
+  void
+  LowRateDosHelper::SetAttribute(std::string name, const AttributeValue &value)
+  {
+    m_factory.Set(name, value);
+  }
+
+  ApplicationContainer
+  LowRateDosHelper::Install(NodeContainer nodes) const
+  {
+    ApplicationContainer apps;
+    for (NodeContainer::Iterator i = nodes.Begin(); i != nodes.End(); ++i)
+    {
+      Ptr<Application> app = m_factory.Create<Application>();
+      (*i)->AddApplication(app);
+      apps.Add(app);
+    }
+    return apps;
+  }
+
+} // namespace ns3
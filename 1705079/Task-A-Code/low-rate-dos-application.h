@@ -0,0 +1,161 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LOW_RATE_DOS_APPLICATION_H
+#define LOW_RATE_DOS_APPLICATION_H
+
+#include "ns3/application.h"
+#include "ns3/application-container.h"
+#include "ns3/address.h"
+#include "ns3/data-rate.h"
+#include "ns3/event-id.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/object-factory.h"
+#include "ns3/ptr.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3
+{
+
+  class Socket;
+  class Packet;
+
+  /**
+   * \ingroup applications
+   *
+   * \brief Low-rate DoS (shrew) attack source
+   *
+   * Sends UDP pulses in a square wave: every Period, a burst of
+   * BurstLength at PeakRate.  Packet times are computed from the start of
+   * the burst, and burst starts from the start of the first burst, so
+   * the pattern does not drift with the event scheduling.
+   *
+   * With spoofing, packets are sent through an Ipv4 raw socket with the
+   * IP header included, so that the source address and port seen by the
+   * network are the spoofed ones: FIXED uses SpoofAddress and SourcePort,
+   * RANDOM draws a host of SpoofAddress / SpoofMask and a source port for
+   * every packet (every packet is then a new five-tuple).  Spoofing
+   * requires an IPv4 Remote.
+   */
+  class LowRateDosApplication : public Application
+  {
+  public:
+    /**
+     * \brief Source address spoofing
+     */
+    enum Spoofing
+    {
+      NONE,   //!< Real source address, UDP socket
+      FIXED,  //!< SpoofAddress and SourcePort
+      RANDOM, //!< Random host of SpoofAddress / SpoofMask, random port
+    };
+
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId(void);
+
+    LowRateDosApplication();
+    virtual ~LowRateDosApplication();
+
+    /**
+     * \returns the number of packets sent
+     */
+    uint64_t GetTotalTx(void) const;
+
+    /**
+     * \brief Assign a fixed random variable stream number to the random
+     * variables used by this model
+     * \param stream first stream index to use
+     * \return the number of stream indices assigned by this model
+     */
+    int64_t AssignStreams(int64_t stream);
+
+  protected:
+    virtual void DoDispose(void);
+
+  private:
+    virtual void StartApplication(void);
+    virtual void StopApplication(void);
+
+    /**
+     * \brief Start a burst
+     */
+    void StartBurst(void);
+
+    /**
+     * \brief Send one packet and schedule the next one
+     */
+    void SendPacket(void);
+
+    Address m_remote;            //!< Destination
+    Time m_period;               //!< Pulse period
+    Time m_burstLength;          //!< Pulse length
+    Time m_phase;                //!< First burst offset from the start time
+    DataRate m_peakRate;         //!< Rate during a pulse
+    uint32_t m_pktSize;          //!< Packet size, IP and UDP headers included
+    Spoofing m_spoofing;         //!< Spoofing mode
+    Ipv4Address m_spoofAddress;  //!< Spoofed address or network
+    Ipv4Mask m_spoofMask;        //!< Spoofed network mask in RANDOM mode
+    uint16_t m_sourcePort;       //!< Source port in FIXED mode
+
+    Ptr<Socket> m_socket;        //!< Sending socket
+    Ptr<UniformRandomVariable> m_uv; //!< Spoofed addresses and ports
+    EventId m_event;             //!< Next packet or burst
+    Time m_burstStart;           //!< Start of the current burst
+    Time m_interval;             //!< Packet spacing at the peak rate
+    uint32_t m_burstSent;        //!< Packets sent in the current burst
+    uint64_t m_totalTx;          //!< Packets sent
+
+    TracedCallback<Ptr<const Packet>> m_txTrace; //!< Packet sent
+  };
+
+  /**
+   * \ingroup applications
+   *
+   * \brief Installs LowRateDosApplication, in the style of OnOffHelper
+   */
+  class LowRateDosHelper
+  {
+  public:
+    /**
+     * \param remote the destination of the pulses
+     */
+    LowRateDosHelper(Address remote);
+
+    /**
+     * \param name attribute name
+     * \param value attribute value
+     */
+    void SetAttribute(std::string name, const AttributeValue &value);
+
+    /**
+     * \param nodes the attacking nodes
+     * \returns the applications
+     */
+    ApplicationContainer Install(NodeContainer nodes) const;
+
+  private:
+    ObjectFactory m_factory; //!< Application factory
+  };
+
+} // namespace ns3
+
+#endif // LOW_RATE_DOS_APPLICATION_H
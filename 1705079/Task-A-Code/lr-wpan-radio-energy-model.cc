@@ -0,0 +1,242 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/double.h"
+#include "ns3/lr-wpan-net-device.h"
+#include "lr-wpan-radio-energy-model.h"
+
+namespace ns3
+{
+
+  NS_LOG_COMPONENT_DEFINE("LrWpanRadioEnergyModel");
+
+  NS_OBJECT_ENSURE_REGISTERED(LrWpanRadioEnergyModel);
+
+  TypeId
+  LrWpanRadioEnergyModel::GetTypeId(void)
+  {
+    static TypeId tid = TypeId("ns3::LrWpanRadioEnergyModel")
+                            .SetParent<DeviceEnergyModel>()
+                            .SetGroupName("Energy")
+                            .AddConstructor<LrWpanRadioEnergyModel>()
+                            .AddAttribute("TxCurrentA",
+                                          "Current while transmitting (A)",
+                                          DoubleValue(0.0174),
+                                          MakeDoubleAccessor(&LrWpanRadioEnergyModel::m_txCurrentA),
+                                          MakeDoubleChecker<double>(0.0))
+                            .AddAttribute("RxCurrentA",
+                                          "Current while receiving or listening (A)",
+                                          DoubleValue(0.0188),
+                                          MakeDoubleAccessor(&LrWpanRadioEnergyModel::m_rxCurrentA),
+                                          MakeDoubleChecker<double>(0.0))
+                            .AddAttribute("IdleCurrentA",
+                                          "Current with the transceiver on and idle (TX_ON) (A)",
+                                          DoubleValue(0.000426),
+                                          MakeDoubleAccessor(&LrWpanRadioEnergyModel::m_idleCurrentA),
+                                          MakeDoubleChecker<double>(0.0))
+                            .AddAttribute("SleepCurrentA",
+                                          "Current with the transceiver off (A)",
+                                          DoubleValue(0.00002),
+                                          MakeDoubleAccessor(&LrWpanRadioEnergyModel::m_sleepCurrentA),
+                                          MakeDoubleChecker<double>(0.0))
+                            .AddTraceSource("TotalEnergyConsumption",
+                                            "Energy of the states left so far (J)",
+                                            MakeTraceSourceAccessor(&LrWpanRadioEnergyModel::m_totalEnergyConsumption),
+                                            "ns3::TracedValueCallback::Double")
+                            .AddTraceSource("TxEnergy",
+                                            "A frame and the energy of its transmission (J)",
+                                            MakeTraceSourceAccessor(&LrWpanRadioEnergyModel::m_txEnergyTrace),
+                                            "ns3::LrWpanRadioEnergyModel::TxEnergyTracedCallback");
+    return tid;
+  }
+
+  LrWpanRadioEnergyModel::LrWpanRadioEnergyModel()
+      : m_source(0),
+        m_phy(0),
+        m_txCurrentA(0),
+        m_rxCurrentA(0),
+        m_idleCurrentA(0),
+        m_sleepCurrentA(0),
+        m_state(IEEE_802_15_4_PHY_TRX_OFF),
+        m_lastUpdateTime(Seconds(0)),
+        m_totalEnergyConsumption(0),
+        m_txEnergy(0)
+  {
+    NS_LOG_FUNCTION(this);
+  }
+
+  LrWpanRadioEnergyModel::~LrWpanRadioEnergyModel()
+  {
+    NS_LOG_FUNCTION(this);
+  }
+
+  void
+  LrWpanRadioEnergyModel::DoDispose(void)
+  {
+    NS_LOG_FUNCTION(this);
+    m_source = 0;
+    m_phy = 0;
+    m_txFrame = 0;
+    DeviceEnergyModel::DoDispose();
+  }
+
+  void
+  LrWpanRadioEnergyModel::AttachPhy(Ptr<LrWpanPhy> phy)
+  {
+    NS_LOG_FUNCTION(this << phy);
+    NS_ASSERT(phy);
+    m_phy = phy;
+    phy->TraceConnectWithoutContext("TrxState", MakeCallback(&LrWpanRadioEnergyModel::TrxStateChanged, this));
+    phy->TraceConnectWithoutContext("PhyTxBegin", MakeCallback(&LrWpanRadioEnergyModel::TxBegin, this));
+  }
+
+  void
+  LrWpanRadioEnergyModel::SetEnergySource(Ptr<EnergySource> source)
+  {
+    NS_LOG_FUNCTION(this << source);
+    NS_ASSERT(source);
+    m_source = source;
+  }
+
+  double
+  LrWpanRadioEnergyModel::GetSupplyVoltage(void) const
+  {
+    return m_source ? m_source->GetSupplyVoltage() : 0;
+  }
+
+  double
+  LrWpanRadioEnergyModel::GetStateA(LrWpanPhyEnumeration state) const
+  {
+    switch (state)
+    {
+    case IEEE_802_15_4_PHY_BUSY_TX:
+      return m_txCurrentA;
+    case IEEE_802_15_4_PHY_BUSY_RX:
+    case IEEE_802_15_4_PHY_RX_ON:
+      return m_rxCurrentA;
+    case IEEE_802_15_4_PHY_TX_ON:
+      return m_idleCurrentA;
+    default:
+      return m_sleepCurrentA;
+    }
+  }
+
+  double
+  LrWpanRadioEnergyModel::DoGetCurrentA(void) const
+  {
+    return GetStateA(m_state);
+  }
+
+  double
+  LrWpanRadioEnergyModel::GetTotalEnergyConsumption(void) const
+  {
+    // the state in progress is only added when it is left
+    double elapsed = (Simulator::Now() - m_lastUpdateTime).GetSeconds();
+    return m_totalEnergyConsumption + elapsed * GetStateA(m_state) * GetSupplyVoltage();
+  }
+
+  double
+  LrWpanRadioEnergyModel::GetTxEnergy(void) const
+  {
+    return m_txEnergy;
+  }
+
+  void
+  LrWpanRadioEnergyModel::ChangeState(int newState)
+  {
+    NS_LOG_FUNCTION(this << newState);
+    double energy = (Simulator::Now() - m_lastUpdateTime).GetSeconds() * GetStateA(m_state) * GetSupplyVoltage();
+    m_totalEnergyConsumption += energy;
+    m_lastUpdateTime = Simulator::Now();
+    if (m_state == IEEE_802_15_4_PHY_BUSY_TX)
+    {
+      m_txEnergy += energy;
+      if (m_txFrame)
+      {
+        m_txEnergyTrace(m_txFrame, energy);
+        m_txFrame = 0;
+      }
+    }
+    // the source integrates its current up to now, still in the old state
+    if (m_source)
+    {
+      m_source->UpdateEnergySource();
+    }
+    m_state = static_cast<LrWpanPhyEnumeration>(newState);
+    NS_LOG_DEBUG("State " << m_state << ", total energy " << m_totalEnergyConsumption << " J");
+  }
+
+  void
+  LrWpanRadioEnergyModel::TrxStateChanged(Time time, LrWpanPhyEnumeration oldState, LrWpanPhyEnumeration newState)
+  {
+    if (oldState != newState)
+    {
+      ChangeState(newState);
+    }
+  }
+
+  void
+  LrWpanRadioEnergyModel::TxBegin(Ptr<const Packet> frame)
+  {
+    m_txFrame = frame;
+  }
+
+  void
+  LrWpanRadioEnergyModel::HandleEnergyDepletion(void)
+  {
+    NS_LOG_FUNCTION(this);
+    NS_LOG_INFO("Energy source depleted at " << Simulator::Now().GetSeconds() << "s");
+  }
+
+  void
+  LrWpanRadioEnergyModel::HandleEnergyRecharged(void)
+  {
+    NS_LOG_FUNCTION(this);
+  }
+
+  void
+  LrWpanRadioEnergyModel::HandleEnergyChanged(void)
+  {
+    NS_LOG_FUNCTION(this);
+  }
+
+  LrWpanRadioEnergyModelHelper::LrWpanRadioEnergyModelHelper()
+  {
+    m_radioEnergy.SetTypeId("ns3::LrWpanRadioEnergyModel");
+  }
+
+  void
+  LrWpanRadioEnergyModelHelper::Set(std::string name, const AttributeValue &v)
+  {
+    m_radioEnergy.Set(name, v);
+  }
+
+  Ptr<DeviceEnergyModel>
+  LrWpanRadioEnergyModelHelper::DoInstall(Ptr<NetDevice> device, Ptr<EnergySource> source) const
+  {
+    NS_ASSERT(device && source);
+    Ptr<LrWpanNetDevice> lrWpan = DynamicCast<LrWpanNetDevice>(device);
+    NS_ABORT_MSG_UNLESS(lrWpan, "LrWpanRadioEnergyModel needs an LrWpanNetDevice");
+    Ptr<LrWpanRadioEnergyModel> model = m_radioEnergy.Create<LrWpanRadioEnergyModel>();
+    model->SetEnergySource(source);
+    source->AppendDeviceEnergyModel(model);
+    model->AttachPhy(lrWpan->GetPhy());
+    return model;
+  }
+
+} // namespace ns3
@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LR_WPAN_RADIO_ENERGY_MODEL_H
+#define LR_WPAN_RADIO_ENERGY_MODEL_H
+
+#include "ns3/device-energy-model.h"
+#include "ns3/device-energy-model-helper.h"
+#include "ns3/energy-source.h"
+#include "ns3/lr-wpan-phy.h"
+#include "ns3/nstime.h"
+#include "ns3/object-factory.h"
+#include "ns3/packet.h"
+#include "ns3/traced-value.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3
+{
+
+  /**
+   * \ingroup energy
+   *
+   * \brief Energy model of an IEEE 802.15.4 transceiver
+   *
+   * The model follows the TrxState trace of an LrWpanPhy and draws a
+   * constant current in each state:
+   *
+   *  - BUSY_TX: TxCurrentA;
+   *  - BUSY_RX and RX_ON (listening): RxCurrentA;
+   *  - TX_ON: IdleCurrentA;
+   *  - TRX_OFF and FORCE_TRX_OFF: SleepCurrentA.
+   *
+   * The defaults are the CC2420 figures at 0 dBm.  Energy is the current
+   * times the supply voltage of the source times the time in the state.
+   *
+   * At the end of every transmission the TxEnergy trace reports the frame
+   * (MAC header included, as seen by PhyTxBegin) and the energy of its
+   * BUSY_TX period, so that the cost of a frame, retries included, can be
+   * charged to the packet it carries.
+   *
+   * The radio is not switched off when the source is depleted: the
+   * source stays at zero and the model keeps counting.
+   */
+  class LrWpanRadioEnergyModel : public DeviceEnergyModel
+  {
+  public:
+    /**
+     * \brief Callback of the TxEnergy trace
+     * \param frame the transmitted frame
+     * \param energyJ energy of its transmission, J
+     */
+    typedef void (*TxEnergyTracedCallback)(Ptr<const Packet> frame, double energyJ);
+
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId(void);
+
+    LrWpanRadioEnergyModel();
+    virtual ~LrWpanRadioEnergyModel();
+
+    /**
+     * \brief Follow the states of a PHY
+     * \param phy the PHY
+     */
+    void AttachPhy(Ptr<LrWpanPhy> phy);
+
+    // inherited from DeviceEnergyModel
+    virtual void SetEnergySource(Ptr<EnergySource> source);
+    virtual double GetTotalEnergyConsumption(void) const;
+    virtual void ChangeState(int newState);
+    virtual void HandleEnergyDepletion(void);
+    virtual void HandleEnergyRecharged(void);
+    virtual void HandleEnergyChanged(void);
+
+    /**
+     * \returns the energy spent in BUSY_TX so far, J
+     */
+    double GetTxEnergy(void) const;
+
+    /**
+     * \param state a transceiver state
+     * \returns the current drawn in it, A
+     */
+    double GetStateA(LrWpanPhyEnumeration state) const;
+
+  private:
+    virtual void DoDispose(void);
+    virtual double DoGetCurrentA(void) const;
+
+    /**
+     * \brief TrxState trace sink
+     * \param time time of the change
+     * \param oldState the previous state
+     * \param newState the new state
+     */
+    void TrxStateChanged(Time time, LrWpanPhyEnumeration oldState, LrWpanPhyEnumeration newState);
+
+    /**
+     * \brief PhyTxBegin trace sink, keeps the frame for TxEnergy
+     * \param frame the frame
+     */
+    void TxBegin(Ptr<const Packet> frame);
+
+    /**
+     * \returns the voltage of the source, 0 without one
+     */
+    double GetSupplyVoltage(void) const;
+
+    Ptr<EnergySource> m_source;                 //!< Energy source
+    Ptr<LrWpanPhy> m_phy;                       //!< Followed PHY
+    double m_txCurrentA;                        //!< Current while transmitting
+    double m_rxCurrentA;                        //!< Current while receiving or listening
+    double m_idleCurrentA;                      //!< Current in TX_ON
+    double m_sleepCurrentA;                     //!< Current with the transceiver off
+    LrWpanPhyEnumeration m_state;               //!< Current state
+    Time m_lastUpdateTime;                      //!< Entry in m_state
+    TracedValue<double> m_totalEnergyConsumption; //!< Energy of the states left so far, J
+    double m_txEnergy;                          //!< Energy spent in BUSY_TX, J
+    Ptr<const Packet> m_txFrame;                //!< Frame being transmitted
+    TracedCallback<Ptr<const Packet>, double> m_txEnergyTrace; //!< TxEnergy trace
+  };
+
+  /**
+   * \ingroup energy
+   *
+   * \brief Installs an LrWpanRadioEnergyModel on LrWpanNetDevices
+   */
+  class LrWpanRadioEnergyModelHelper : public DeviceEnergyModelHelper
+  {
+  public:
+    LrWpanRadioEnergyModelHelper();
+
+    /**
+     * \brief Set an attribute of the models
+     * \param name attribute name
+     * \param v attribute value
+     */
+    virtual void Set(std::string name, const AttributeValue &v);
+
+  private:
+    /**
+     * \brief Create a model, attach it to the source and to the PHY
+     * \param device an LrWpanNetDevice
+     * \param source the energy source of its node
+     * \returns the model
+     */
+    virtual Ptr<DeviceEnergyModel> DoInstall(Ptr<NetDevice> device, Ptr<EnergySource> source) const;
+
+    ObjectFactory m_radioEnergy; //!< Model factory
+  };
+
+} // namespace ns3
+
+#endif // LR_WPAN_RADIO_ENERGY_MODEL_H
@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "pcap-mmap-reader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3
+{
+
+  namespace
+  {
+    const uint32_t MAGIC_US = 0xa1b2c3d4;
+    const uint32_t MAGIC_NS = 0xa1b23c4d;
+  } // namespace
+
+  PcapMmapReader::PcapMmapReader()
+      : m_data(0),
+        m_size(0),
+        m_offset(0),
+        m_swap(false),
+        m_fracNs(1000),
+        m_linkType(0)
+  {
+  }
+
+  PcapMmapReader::~PcapMmapReader()
+  {
+    Close();
+  }
+
+  bool
+  PcapMmapReader::Open(const std::string &filename, std::string &error)
+  {
+    Close();
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+      error = "cannot open " + filename;
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 24)
+    {
+      close(fd);
+      error = filename + " is not a pcap file";
+      return false;
+    }
+    void *map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps the file referenced
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+      error = "cannot map " + filename;
+      return false;
+    }
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+    m_data = static_cast<const uint8_t *>(map);
+    m_size = st.st_size;
+
+    m_swap = false;
+    uint32_t magic = Read32(m_data);
+    if (magic != MAGIC_US && magic != MAGIC_NS)
+    {
+      m_swap = true;
+      magic = Read32(m_data);
+    }
+    if (magic != MAGIC_US && magic != MAGIC_NS)
+    {
+      Close();
+      error = filename + " is not a pcap file (pcapng is not supported)";
+      return false;
+    }
+    m_fracNs = magic == MAGIC_NS ? 1 : 1000;
+    m_linkType = Read32(m_data + 20) & 0xffff;
+    m_offset = 24;
+    return true;
+  }
+
+  void
+  PcapMmapReader::Close(void)
+  {
+    if (m_data)
+    {
+      munmap(const_cast<uint8_t *>(m_data), m_size);
+    }
+    m_data = 0;
+    m_size = 0;
+    m_offset = 0;
+  }
+
+} // namespace ns3
@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PCAP_MMAP_READER_H
+#define PCAP_MMAP_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * Like flow-stats-reader.h, this header does not depend on ns-3.
+ */
+
+namespace ns3
+{
+
+  /**
+   * \ingroup network
+   *
+   * \brief One record of a pcap file, pointing into the mapping
+   */
+  struct PcapRecord
+  {
+    int64_t timeNs;      //!< Capture time
+    uint32_t capLen;     //!< Captured bytes at data
+    uint32_t origLen;    //!< Length on the wire
+    const uint8_t *data; //!< Captured bytes, valid while the file is open
+  };
+
+  /**
+   * \ingroup network
+   *
+   * \brief Sequential reader of a memory-mapped pcap file
+   *
+   * Reads classic pcap files (not pcapng) in either byte order, with
+   * microsecond or nanosecond timestamps.  Records are returned as
+   * pointers into the mapping, nothing is copied; the kernel is told the
+   * access is sequential.
+   */
+  class PcapMmapReader
+  {
+  public:
+    /**
+     * \brief Link types handled by the replay
+     */
+    enum LinkType
+    {
+      LINKTYPE_ETHERNET = 1,    //!< Ethernet II, optional 802.1Q tags
+      LINKTYPE_PPP = 9,         //!< PPP, as written by PointToPointNetDevice
+      LINKTYPE_RAW = 101,       //!< Raw IP
+      LINKTYPE_LINUX_SLL = 113, //!< Linux cooked capture
+      LINKTYPE_IPV4 = 228,      //!< Raw IPv4
+    };
+
+    PcapMmapReader();
+    ~PcapMmapReader();
+
+    /**
+     * \brief Map a file and check its global header
+     * \param filename the pcap file
+     * \param error set on failure
+     * \returns true on success
+     */
+    bool Open(const std::string &filename, std::string &error);
+
+    /**
+     * \brief Unmap the file
+     */
+    void Close(void);
+
+    /**
+     * \returns the link type of the file
+     */
+    uint32_t GetLinkType(void) const
+    {
+      return m_linkType;
+    }
+
+    /**
+     * \returns the file size in bytes
+     */
+    std::size_t GetSize(void) const
+    {
+      return m_size;
+    }
+
+    /**
+     * \brief Read the next record
+     * \param record the record
+     * \returns false at the end of the file or on a truncated record
+     */
+    bool Next(PcapRecord &record)
+    {
+      if (m_offset + 16 > m_size)
+      {
+        return false;
+      }
+      const uint8_t *h = m_data + m_offset;
+      uint32_t sec = Read32(h);
+      uint32_t frac = Read32(h + 4);
+      record.capLen = Read32(h + 8);
+      record.origLen = Read32(h + 12);
+      if (m_offset + 16 + record.capLen > m_size)
+      {
+        return false;
+      }
+      record.timeNs = static_cast<int64_t>(sec) * 1000000000 + static_cast<int64_t>(frac) * m_fracNs;
+      record.data = h + 16;
+      m_offset += 16 + record.capLen;
+      return true;
+    }
+
+  private:
+    /**
+     * \param p 4 bytes in the file byte order
+     * \returns the value
+     */
+    uint32_t Read32(const uint8_t *p) const
+    {
+      uint32_t v = static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+                   static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+      return m_swap ? __builtin_bswap32(v) : v;
+    }
+
+    const uint8_t *m_data; //!< Mapping
+    std::size_t m_size;    //!< Mapping size
+    std::size_t m_offset;  //!< Next record
+    bool m_swap;           //!< File is big endian
+    int64_t m_fracNs;      //!< Nanoseconds per timestamp fraction unit
+    uint32_t m_linkType;   //!< Link type
+  };
+
+} // namespace ns3
+
+#endif // PCAP_MMAP_READER_H
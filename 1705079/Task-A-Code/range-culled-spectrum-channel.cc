@@ -0,0 +1,358 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/double.h"
+#include "ns3/node.h"
+#include "ns3/net-device.h"
+#include "ns3/angles.h"
+#include "ns3/antenna-model.h"
+#include "ns3/spectrum-phy.h"
+#include "ns3/spectrum-signal-parameters.h"
+#include "ns3/spectrum-propagation-loss-model.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/propagation-delay-model.h"
+#include "range-culled-spectrum-channel.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+
+  NS_LOG_COMPONENT_DEFINE("RangeCulledSpectrumChannel");
+
+  NS_OBJECT_ENSURE_REGISTERED(RangeCulledSpectrumChannel);
+
+  TypeId
+  RangeCulledSpectrumChannel::GetTypeId(void)
+  {
+    static TypeId tid = TypeId("ns3::RangeCulledSpectrumChannel")
+                            .SetParent<SpectrumChannel>()
+                            .SetGroupName("Spectrum")
+                            .AddConstructor<RangeCulledSpectrumChannel>()
+                            .AddAttribute("MaxRange",
+                                          "Receivers farther than this (m) are skipped; 0 to take the MaxRange "
+                                          "of the RangePropagationLossModel of the channel",
+                                          DoubleValue(0.0),
+                                          MakeDoubleAccessor(&RangeCulledSpectrumChannel::m_maxRange),
+                                          MakeDoubleChecker<double>(0.0));
+    return tid;
+  }
+
+  RangeCulledSpectrumChannel::RangeCulledSpectrumChannel()
+      : m_maxRange(0),
+        m_range(0),
+        m_rangeResolved(false),
+        m_gridValid(false),
+        m_maxSpeed(0),
+        m_nEvaluated(0)
+  {
+    NS_LOG_FUNCTION(this);
+  }
+
+  void
+  RangeCulledSpectrumChannel::DoDispose(void)
+  {
+    NS_LOG_FUNCTION(this);
+    m_phyList.clear();
+    m_spectrumModel = 0;
+    m_grid.clear();
+    m_unplaced.clear();
+    m_watched.clear();
+    SpectrumChannel::DoDispose();
+  }
+
+  void
+  RangeCulledSpectrumChannel::AddRx(Ptr<SpectrumPhy> phy)
+  {
+    NS_LOG_FUNCTION(this << phy);
+    m_phyList.push_back(phy);
+    m_gridValid = false;
+  }
+
+  void
+  RangeCulledSpectrumChannel::RemoveRx(Ptr<SpectrumPhy> phy)
+  {
+    NS_LOG_FUNCTION(this << phy);
+    PhyList::iterator it = std::find(m_phyList.begin(), m_phyList.end(), phy);
+    if (it != m_phyList.end())
+    {
+      m_phyList.erase(it);
+      m_gridValid = false;
+    }
+  }
+
+  std::size_t
+  RangeCulledSpectrumChannel::GetNDevices(void) const
+  {
+    NS_LOG_FUNCTION(this);
+    return m_phyList.size();
+  }
+
+  Ptr<NetDevice>
+  RangeCulledSpectrumChannel::GetDevice(std::size_t i) const
+  {
+    NS_LOG_FUNCTION(this << i);
+    return m_phyList.at(i)->GetDevice();
+  }
+
+  double
+  RangeCulledSpectrumChannel::GetRange(void)
+  {
+    if (!m_rangeResolved)
+    {
+      m_range = m_maxRange;
+      // the loss models are only known once the channel is configured
+      for (Ptr<PropagationLossModel> model = m_propagationLoss; m_range == 0 && model; model = model->GetNext())
+      {
+        if (DynamicCast<RangePropagationLossModel>(model))
+        {
+          DoubleValue range;
+          model->GetAttribute("MaxRange", range);
+          m_range = range.Get();
+        }
+      }
+      m_rangeResolved = true;
+      NS_LOG_INFO("Receivers beyond " << m_range << " m are skipped");
+    }
+    return m_range;
+  }
+
+  uint64_t
+  RangeCulledSpectrumChannel::GetNEvaluated(void) const
+  {
+    return m_nEvaluated;
+  }
+
+  int64_t
+  RangeCulledSpectrumChannel::Cell(double x) const
+  {
+    return static_cast<int64_t>(std::floor(x / m_range));
+  }
+
+  uint64_t
+  RangeCulledSpectrumChannel::CellKey(int64_t cx, int64_t cy)
+  {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+  }
+
+  void
+  RangeCulledSpectrumChannel::CourseChanged(Ptr<const MobilityModel> mobility)
+  {
+    NS_LOG_FUNCTION(this << mobility);
+    m_gridValid = false;
+  }
+
+  void
+  RangeCulledSpectrumChannel::BuildGrid(void)
+  {
+    NS_LOG_FUNCTION(this);
+    m_grid.clear();
+    m_unplaced.clear();
+    m_maxSpeed = 0;
+    for (uint32_t i = 0; i < m_phyList.size(); ++i)
+    {
+      Ptr<MobilityModel> mobility = m_phyList[i]->GetMobility();
+      if (!mobility)
+      {
+        m_unplaced.push_back(i);
+        continue;
+      }
+      if (std::find(m_watched.begin(), m_watched.end(), mobility) == m_watched.end())
+      {
+        mobility->TraceConnectWithoutContext("CourseChange",
+                                             MakeCallback(&RangeCulledSpectrumChannel::CourseChanged, this));
+        m_watched.push_back(mobility);
+      }
+      Vector p = mobility->GetPosition();
+      Placed placed = {i, p, mobility};
+      m_grid[CellKey(Cell(p.x), Cell(p.y))].push_back(placed);
+      m_maxSpeed = std::max(m_maxSpeed, CalculateDistance(mobility->GetVelocity(), Vector()));
+    }
+    m_gridValid = true;
+    m_gridTime = Simulator::Now();
+    NS_LOG_INFO(m_phyList.size() << " receivers in " << m_grid.size() << " cells, " << m_unplaced.size()
+                                 << " without position, top speed " << m_maxSpeed << " m/s");
+  }
+
+  void
+  RangeCulledSpectrumChannel::StartTx(Ptr<SpectrumSignalParameters> txParams)
+  {
+    NS_LOG_FUNCTION(this << txParams->psd << txParams->duration << txParams->txPhy);
+    NS_ASSERT_MSG(txParams->psd, "NULL txPsd");
+    NS_ASSERT_MSG(txParams->txPhy, "NULL txPhy");
+
+    m_txSigParamsTrace(txParams);
+
+    if (m_spectrumModel == 0)
+    {
+      m_spectrumModel = txParams->psd->GetSpectrumModel();
+    }
+    else
+    {
+      // all attached SpectrumPhy instances must use the same SpectrumModel
+      NS_ASSERT(*(txParams->psd->GetSpectrumModel()) == *m_spectrumModel);
+    }
+
+    Ptr<MobilityModel> senderMobility = txParams->txPhy->GetMobility();
+    double range = GetRange();
+    if (range <= 0 || !senderMobility)
+    {
+      for (PhyList::const_iterator it = m_phyList.begin(); it != m_phyList.end(); ++it)
+      {
+        if (*it != txParams->txPhy)
+        {
+          Deliver(txParams, senderMobility, *it);
+        }
+      }
+      return;
+    }
+
+    // receivers moved by at most pad since the grid was built
+    double pad = 0;
+    if (m_gridValid && m_maxSpeed > 0)
+    {
+      pad = m_maxSpeed * (Simulator::Now() - m_gridTime).GetSeconds();
+      m_gridValid = pad <= range;
+    }
+    if (!m_gridValid)
+    {
+      BuildGrid();
+      pad = 0;
+    }
+
+    // the receivers within range, in the order they were added; with a
+    // padding up to the range, they are at most two cells away
+    Vector s = senderMobility->GetPosition();
+    int64_t cx = Cell(s.x);
+    int64_t cy = Cell(s.y);
+    int64_t ring = pad > 0 ? 2 : 1;
+    m_candidates.assign(m_unplaced.begin(), m_unplaced.end());
+    for (int64_t dx = -ring; dx <= ring; ++dx)
+    {
+      for (int64_t dy = -ring; dy <= ring; ++dy)
+      {
+        Grid::const_iterator cell = m_grid.find(CellKey(cx + dx, cy + dy));
+        if (cell == m_grid.end())
+        {
+          continue;
+        }
+        for (const Placed &placed : cell->second)
+        {
+          // RangePropagationLossModel keeps receivers at exactly the range
+          if (CalculateDistance(s, placed.position) > range + pad)
+          {
+            continue;
+          }
+          if (pad == 0 || CalculateDistance(s, placed.mobility->GetPosition()) <= range)
+          {
+            m_candidates.push_back(placed.index);
+          }
+        }
+      }
+    }
+    std::sort(m_candidates.begin(), m_candidates.end());
+
+    // Deliver may schedule events only; m_candidates stays valid
+    for (uint32_t i : m_candidates)
+    {
+      if (m_phyList[i] != txParams->txPhy)
+      {
+        Deliver(txParams, senderMobility, m_phyList[i]);
+      }
+    }
+  }
+
+  void
+  RangeCulledSpectrumChannel::Deliver(Ptr<SpectrumSignalParameters> txParams, Ptr<MobilityModel> senderMobility,
+                                      Ptr<SpectrumPhy> receiver)
+  {
+    Time delay = MicroSeconds(0);
+    Ptr<MobilityModel> receiverMobility = receiver->GetMobility();
+    Ptr<SpectrumSignalParameters> rxParams = txParams->Copy();
+    ++m_nEvaluated;
+
+    if (senderMobility && receiverMobility)
+    {
+      double txAntennaGain = 0;
+      double rxAntennaGain = 0;
+      double propagationGainDb = 0;
+      double pathLossDb = 0;
+      if (rxParams->txAntenna != 0)
+      {
+        Angles txAngles(receiverMobility->GetPosition(), senderMobility->GetPosition());
+        txAntennaGain = rxParams->txAntenna->GetGainDb(txAngles);
+        pathLossDb -= txAntennaGain;
+      }
+      Ptr<AntennaModel> rxAntenna = DynamicCast<AntennaModel>(receiver->GetRxAntenna());
+      if (rxAntenna != 0)
+      {
+        Angles rxAngles(senderMobility->GetPosition(), receiverMobility->GetPosition());
+        rxAntennaGain = rxAntenna->GetGainDb(rxAngles);
+        pathLossDb -= rxAntennaGain;
+      }
+      if (m_propagationLoss)
+      {
+        propagationGainDb = m_propagationLoss->CalcRxPower(0, senderMobility, receiverMobility);
+        pathLossDb -= propagationGainDb;
+      }
+      NS_LOG_LOGIC("total pathLoss = " << pathLossDb << " dB");
+      m_gainTrace(senderMobility, receiverMobility, txAntennaGain, rxAntennaGain, propagationGainDb, pathLossDb);
+      m_pathLossTrace(txParams->txPhy, receiver, pathLossDb);
+      if (pathLossDb > m_maxLossDb)
+      {
+        // beyond range
+        return;
+      }
+      double pathGainLinear = std::pow(10.0, (-pathLossDb) / 10.0);
+      *(rxParams->psd) *= pathGainLinear;
+
+      if (m_spectrumPropagationLoss)
+      {
+        rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity(rxParams->psd, senderMobility,
+                                                                              receiverMobility);
+      }
+
+      if (m_propagationDelay)
+      {
+        delay = m_propagationDelay->GetDelay(senderMobility, receiverMobility);
+      }
+    }
+
+    Ptr<NetDevice> netDev = receiver->GetDevice();
+    if (netDev)
+    {
+      // the receiver has a NetDevice, so we expect that it is attached to a Node
+      uint32_t dstNode = netDev->GetNode()->GetId();
+      Simulator::ScheduleWithContext(dstNode, delay, &RangeCulledSpectrumChannel::StartRx, this, rxParams, receiver);
+    }
+    else
+    {
+      // the receiver is not attached to a NetDevice, so we cannot assume that it is attached to a node
+      Simulator::Schedule(delay, &RangeCulledSpectrumChannel::StartRx, this, rxParams, receiver);
+    }
+  }
+
+  void
+  RangeCulledSpectrumChannel::StartRx(Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> receiver)
+  {
+    NS_LOG_FUNCTION(this << params);
+    receiver->StartRx(params);
+  }
+
+} // namespace ns3
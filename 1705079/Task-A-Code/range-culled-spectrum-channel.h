@@ -0,0 +1,170 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RANGE_CULLED_SPECTRUM_CHANNEL_H
+#define RANGE_CULLED_SPECTRUM_CHANNEL_H
+
+#include "ns3/spectrum-channel.h"
+#include "ns3/spectrum-model.h"
+#include "ns3/mobility-model.h"
+#include "ns3/nstime.h"
+#include "ns3/vector.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+  /**
+   * \ingroup spectrum
+   *
+   * \brief SingleModelSpectrumChannel that only delivers signals to the
+   * receivers within range of the transmitter
+   *
+   * SingleModelSpectrumChannel copies every signal to every PHY of the
+   * channel and leaves the loss model to push the far ones below any
+   * sensitivity (RangePropagationLossModel returns -1000 dBm), so a
+   * transmission costs events in all N PHYs.  This channel keeps the PHYs
+   * in a grid of square cells of the range's size and only looks at the
+   * 3 x 3 cells around the transmitter; receivers farther than the range
+   * are skipped before any event is scheduled.  The cost of a
+   * transmission then follows the number of neighbours.
+   *
+   * The range is the MaxRange attribute or, when that is zero, the
+   * MaxRange of a RangePropagationLossModel in the propagation loss
+   * chain, read at the first transmission.  Without a range the channel
+   * behaves as SingleModelSpectrumChannel.  Receivers are served in the
+   * order they were added, as in SingleModelSpectrumChannel; the path
+   * loss and gain traces do not fire for skipped receivers.
+   *
+   * Positions and speeds are read from the mobility models when the grid
+   * is built.  The grid is rebuilt after PHYs are added or removed and
+   * after a CourseChange of any of them; PHYs without a mobility model
+   * receive every signal.  Models that move continuously (constant
+   * velocity, random walk between course changes) change position
+   * without a CourseChange, so while any PHY moves the lookup is padded
+   * by the highest speed times the age of the grid, and the receivers
+   * found are checked at their current position; the grid is rebuilt
+   * once the padding reaches the range.  A change of speed must fire
+   * CourseChange, as it does in the ns-3 mobility models.
+   */
+  class RangeCulledSpectrumChannel : public SpectrumChannel
+  {
+  public:
+    RangeCulledSpectrumChannel();
+
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId(void);
+
+    // inherited from SpectrumChannel
+    virtual void RemoveRx(Ptr<SpectrumPhy> phy);
+    virtual void AddRx(Ptr<SpectrumPhy> phy);
+    virtual void StartTx(Ptr<SpectrumSignalParameters> params);
+
+    // inherited from Channel
+    virtual std::size_t GetNDevices(void) const;
+    virtual Ptr<NetDevice> GetDevice(std::size_t i) const;
+
+    /**
+     * \returns the range used to skip receivers, 0 if none
+     */
+    double GetRange(void);
+
+    /**
+     * \returns the number of receivers passed to the loss model so far
+     */
+    uint64_t GetNEvaluated(void) const;
+
+  private:
+    virtual void DoDispose(void);
+
+    /**
+     * \brief Deliver a signal to a receiver
+     * \param params the signal, already attenuated
+     * \param receiver the receiver
+     */
+    void StartRx(Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> receiver);
+
+    /**
+     * \brief Attenuate and schedule a signal for one receiver, as
+     * SingleModelSpectrumChannel does
+     * \param txParams the transmitted signal
+     * \param senderMobility the mobility of the transmitter, may be 0
+     * \param receiver the receiver
+     */
+    void Deliver(Ptr<SpectrumSignalParameters> txParams, Ptr<MobilityModel> senderMobility,
+                 Ptr<SpectrumPhy> receiver);
+
+    /**
+     * \brief Put every PHY with a mobility model in its cell
+     */
+    void BuildGrid(void);
+
+    /**
+     * \brief CourseChange sink, invalidates the grid
+     * \param mobility the model that moved
+     */
+    void CourseChanged(Ptr<const MobilityModel> mobility);
+
+    /**
+     * \param x coordinate
+     * \returns the cell index along that axis
+     */
+    int64_t Cell(double x) const;
+
+    /**
+     * \param cx cell index along x
+     * \param cy cell index along y
+     * \returns the key of the cell in m_grid
+     */
+    static uint64_t CellKey(int64_t cx, int64_t cy);
+
+    typedef std::vector<Ptr<SpectrumPhy>> PhyList; //!< Container of receivers
+
+    /**
+     * \brief A receiver in the grid
+     */
+    struct Placed
+    {
+      uint32_t index;               //!< Index in m_phyList
+      Vector position;              //!< Position when the grid was built
+      Ptr<MobilityModel> mobility;  //!< Its mobility model
+    };
+
+    typedef std::unordered_map<uint64_t, std::vector<Placed>> Grid; //!< Cell key to receivers
+
+    PhyList m_phyList;                     //!< Receivers, in the order they were added
+    Ptr<const SpectrumModel> m_spectrumModel; //!< The model all PHYs share
+    double m_maxRange;                     //!< MaxRange attribute
+    double m_range;                        //!< Range in use, 0 if none
+    bool m_rangeResolved;                  //!< True once m_range is set
+    bool m_gridValid;                      //!< False when the grid must be rebuilt
+    Time m_gridTime;                       //!< When the grid was built
+    double m_maxSpeed;                     //!< Highest receiver speed when the grid was built (m/s)
+    Grid m_grid;                           //!< Receivers with a position, by cell
+    std::vector<uint32_t> m_unplaced;      //!< Indexes of PHYs without a mobility model
+    std::vector<Ptr<MobilityModel>> m_watched; //!< Mobility models whose CourseChange is connected
+    std::vector<uint32_t> m_candidates;    //!< Receivers of the current transmission
+    uint64_t m_nEvaluated;                 //!< Receivers passed to the loss model
+  };
+
+} // namespace ns3
+
+#endif // RANGE_CULLED_SPECTRUM_CHANNEL_H
@@ -0,0 +1,670 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RED_BANK_H
+#define RED_BANK_H
+
+#include "red-engine.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RED_BANK_AVX2 1
+#include <immintrin.h>
+#endif
+
+/*
+ * Header-only and independent of ns-3, like RedEngine.  The AVX2 kernel
+ * is compiled for the avx2 target whatever the build flags and chosen at
+ * run time, so the same binary runs on machines without AVX2.
+ */
+
+namespace ns3
+{
+
+  /**
+   * \ingroup traffic-control
+   *
+   * \brief The RED state of many queues in structure-of-arrays form
+   *
+   * Each queue has the RED state of a RedEngine (average, count,
+   * current max_p, threshold coefficients) stored in one array per
+   * field, so that arrivals at a range of queues are decided by a
+   * vector kernel: AVX2 when the processor has it, scalar otherwise,
+   * with bit-identical results.
+   *
+   * The options that change the control flow (gentle, wait, nonlinear,
+   * adaptation) and the queue weight are shared by the bank; thresholds
+   * are per queue.  Queue lengths are in packets; isBytes, isFixedPoint
+   * and the RRED filter of RedConfig are ignored.  The caller draws the random
+   * numbers, one per arrival, so that any generator can be used.
+   *
+   * As in RedEngine, ARED and Feng's adaptive RED adapt max_p in Adapt,
+   * which the caller runs every intervalNs for all queues at once;
+   * arrivals only read it.
+   */
+  class RedBank
+  {
+  public:
+    /**
+     * \brief A RedQueueDisc-like handle on one queue of a bank
+     *
+     * Views are plain values and stay valid as long as the bank is not
+     * resized.
+     */
+    class View
+    {
+    public:
+      /**
+       * \param bank the bank
+       * \param queue the queue index
+       */
+      View(RedBank *bank, std::size_t queue)
+          : m_bank(bank),
+            m_queue(queue)
+      {
+      }
+
+      /**
+       * \brief Set the thresh limits of RED.
+       *
+       * \param minTh Minimum thresh in packets.
+       * \param maxTh Maximum thresh in packets.
+       */
+      void SetTh(double minTh, double maxTh)
+      {
+        m_bank->SetTh(m_queue, minTh, maxTh);
+      }
+
+      /**
+       * \returns the average queue size, as updated by the last arrival
+       */
+      double GetQueueAverage(void) const
+      {
+        return m_bank->m_qAvg[m_queue];
+      }
+
+      /**
+       * \returns the current max_p
+       */
+      double GetCurMaxP(void) const
+      {
+        return m_bank->m_curMaxP[m_queue];
+      }
+
+      /**
+       * \returns the drop probability computed by the last early drop test
+       */
+      double GetVProb(void) const
+      {
+        return m_bank->m_vProb[m_queue];
+      }
+
+      /**
+       * \brief Decide on one arrival
+       * \param nowNs arrival time
+       * \param nQueued current queue length in packets
+       * \param u uniform [0, 1) draw
+       * \returns RedEngine::DTYPE_NONE, DTYPE_FORCED or DTYPE_UNFORCED
+       */
+      uint8_t Arrive(int64_t nowNs, uint32_t nQueued, double u)
+      {
+        uint8_t arrived = 1;
+        uint8_t dropType;
+        m_bank->Arrive(nowNs, m_queue, 1, &arrived, &nQueued, &u, &dropType);
+        return dropType;
+      }
+
+      /**
+       * \brief Report that a dequeue found the queue empty
+       * \param nowNs the time
+       */
+      void SetIdle(int64_t nowNs)
+      {
+        m_bank->SetIdle(m_queue, nowNs);
+      }
+
+      /**
+       * \brief Report that a packet was dequeued
+       */
+      void SetBusy(void)
+      {
+        m_bank->SetBusy(m_queue);
+      }
+
+    private:
+      RedBank *m_bank;     //!< The bank
+      std::size_t m_queue; //!< Queue index
+    };
+
+    /**
+     * \brief Constructor
+     * \param nQueues number of queues
+     * \param config shared configuration; its thresholds are the initial
+     * thresholds of every queue
+     */
+    RedBank(std::size_t nQueues, const RedConfig &config)
+        : m_useAvx2(HasAvx2())
+    {
+      m_config = config;
+      m_ptc = RedEngine::Resolve(m_config);
+      Resize(nQueues);
+    }
+
+    /**
+     * \brief Set the number of queues and reset all of them
+     * \param nQueues number of queues
+     */
+    void Resize(std::size_t nQueues)
+    {
+      m_qAvg.assign(nQueues, 0.0);
+      m_count.assign(nQueues, 0.0);
+      m_old.assign(nQueues, 0.0);
+      m_vProb.assign(nQueues, 0.0);
+      m_curMaxP.assign(nQueues, 1.0 / m_config.lInterm);
+      m_minTh.assign(nQueues, 0.0);
+      m_maxTh.assign(nQueues, 0.0);
+      m_forcedTh.assign(nQueues, 0.0);
+      m_vA.assign(nQueues, 0.0);
+      m_vB.assign(nQueues, 0.0);
+      m_vC.assign(nQueues, 0.0);
+      m_vD.assign(nQueues, 0.0);
+      m_idle.assign(nQueues, 1);
+      m_idleTimeNs.assign(nQueues, 0);
+      m_lastSetNs.assign(nQueues, m_config.lastSetNs);
+      m_nextAdaptNs = m_config.intervalNs;
+      m_fengStatus.assign(nQueues, RedEngine::Above);
+      for (std::size_t q = 0; q < nQueues; ++q)
+      {
+        SetTh(q, m_config.minTh, m_config.maxTh);
+      }
+    }
+
+    /**
+     * \returns the number of queues
+     */
+    std::size_t GetSize(void) const
+    {
+      return m_qAvg.size();
+    }
+
+    /**
+     * \param queue the queue index
+     * \returns a view on the queue
+     */
+    View GetView(std::size_t queue)
+    {
+      return View(this, queue);
+    }
+
+    /**
+     * \brief Set the thresholds of a queue
+     * \param queue the queue index
+     * \param minTh minimum threshold in packets
+     * \param maxTh maximum threshold in packets
+     */
+    void SetTh(std::size_t queue, double minTh, double maxTh)
+    {
+      m_minTh[queue] = minTh;
+      m_maxTh[queue] = maxTh;
+      m_forcedTh[queue] = m_config.isGentle ? 2 * maxTh : maxTh;
+      double th_diff = maxTh - minTh;
+      if (th_diff == 0)
+      {
+        th_diff = 1.0;
+      }
+      m_vA[queue] = 1.0 / th_diff;
+      m_vB[queue] = -minTh / th_diff;
+      UpdateGentle(queue);
+    }
+
+    /**
+     * \brief Select the kernel
+     * \param useAvx2 true for AVX2, ignored if the processor lacks it
+     */
+    void SetSimd(bool useAvx2)
+    {
+      m_useAvx2 = useAvx2 && HasAvx2();
+    }
+
+    /**
+     * \returns true if arrivals use the AVX2 kernel
+     */
+    bool IsSimd(void) const
+    {
+      return m_useAvx2;
+    }
+
+    /**
+     * \brief Decide on arrivals at queues first .. first + n - 1
+     *
+     * At most one arrival per queue: queue first + i receives a packet if
+     * arrived[i] is not zero.  Each arrival follows the law of
+     * RedEngine::Decide, without the RRED filter.
+     *
+     * \param nowNs arrival time
+     * \param first first queue
+     * \param n number of queues
+     * \param arrived arrival flags
+     * \param nQueued queue lengths in packets, before the arrivals
+     * \param u uniform [0, 1) draws, read for arrivals only
+     * \param dropType RedEngine::DTYPE_NONE, DTYPE_FORCED or DTYPE_UNFORCED
+     * per queue, DTYPE_NONE where nothing arrived
+     */
+    void Arrive(int64_t nowNs, std::size_t first, std::size_t n, const uint8_t *arrived, const uint32_t *nQueued,
+                const double *u, uint8_t *dropType)
+    {
+      // idle periods are rare: age their averages before the kernel
+      for (std::size_t i = 0; i < n; ++i)
+      {
+        std::size_t q = first + i;
+        if (arrived[i] && m_idle[q])
+        {
+          m_qAvg[q] = IdleAverage(q, nowNs);
+          m_idle[q] = 0;
+        }
+      }
+
+      std::size_t i = 0;
+#ifdef RED_BANK_AVX2
+      if (m_useAvx2)
+      {
+        i = ArriveAvx2(first, n, arrived, nQueued, u, dropType);
+      }
+#endif
+      for (; i < n; ++i)
+      {
+        dropType[i] = arrived[i] ? ArriveScalar(first + i, nQueued[i], u[i]) : uint8_t(RedEngine::DTYPE_NONE);
+      }
+    }
+
+    /**
+     * \brief Report that a dequeue found a queue empty
+     * \param queue the queue index
+     * \param nowNs the time
+     */
+    void SetIdle(std::size_t queue, int64_t nowNs)
+    {
+      m_idle[queue] = 1;
+      m_idleTimeNs[queue] = nowNs;
+    }
+
+    /**
+     * \brief Report that a packet was dequeued from a queue
+     * \param queue the queue index
+     */
+    void SetBusy(std::size_t queue)
+    {
+      m_idle[queue] = 0;
+    }
+
+    /**
+     * \returns true if max_p adapts (ARED or Feng's adaptive RED), and
+     * Adapt must then run every intervalNs
+     */
+    bool IsAdaptive(void) const
+    {
+      return m_config.isAdaptMaxP || m_config.isFengAdaptive;
+    }
+
+    /**
+     * \brief ARED and Feng's adaptation of max_p for every queue, a
+     * periodic event
+     *
+     * Same rules as RedEngine::Adapt, on the average of each queue aged
+     * over its idle period; the gentle coefficients follow max_p.
+     *
+     * \param nowNs the time
+     */
+    void Adapt(int64_t nowNs)
+    {
+      const RedConfig &c = m_config;
+      for (std::size_t q = 0; q < m_qAvg.size(); ++q)
+      {
+        double avg = m_idle[q] ? IdleAverage(q, nowNs) : m_qAvg[q];
+        double maxP = m_curMaxP[q];
+        if (c.isAdaptMaxP)
+        {
+          if (nowNs < m_lastSetNs[q] + c.intervalNs)
+          {
+            continue;
+          }
+          double part = 0.4 * (m_maxTh[q] - m_minTh[q]);
+          if (avg < m_minTh[q] + part && maxP > c.bottom)
+          {
+            maxP = maxP * c.beta;
+            m_lastSetNs[q] = nowNs;
+          }
+          else if (avg > m_maxTh[q] - part && c.top > maxP)
+          {
+            double alpha = c.alpha > 0.25 * maxP ? 0.25 * maxP : c.alpha;
+            maxP = maxP + alpha;
+            m_lastSetNs[q] = nowNs;
+          }
+        }
+        else if (c.isFengAdaptive)
+        {
+          if (m_minTh[q] < avg && avg < m_maxTh[q])
+          {
+            m_fengStatus[q] = RedEngine::Between;
+          }
+          else if (avg < m_minTh[q] && m_fengStatus[q] != RedEngine::Below)
+          {
+            m_fengStatus[q] = RedEngine::Below;
+            maxP = maxP / c.fengA;
+          }
+          else if (avg > m_maxTh[q] && m_fengStatus[q] != RedEngine::Above)
+          {
+            m_fengStatus[q] = RedEngine::Above;
+            maxP = maxP * c.fengB;
+          }
+        }
+        m_curMaxP[q] = maxP;
+        UpdateGentle(q);
+      }
+    }
+
+    /**
+     * \brief Run the Adapt events due up to a time, for callers without
+     * a scheduler, see RedEngine::AdaptUntil
+     * \param nowNs the time
+     */
+    void AdaptUntil(int64_t nowNs)
+    {
+      if (!IsAdaptive() || m_config.intervalNs <= 0)
+      {
+        return;
+      }
+      while (m_nextAdaptNs <= nowNs)
+      {
+        Adapt(m_nextAdaptNs);
+        m_nextAdaptNs += m_config.intervalNs;
+      }
+    }
+
+    /**
+     * \returns the configuration, with the automatic settings applied
+     */
+    const RedConfig &GetConfig(void) const
+    {
+      return m_config;
+    }
+
+  private:
+    /**
+     * \returns true if the processor supports AVX2
+     */
+    static bool HasAvx2(void)
+    {
+#ifdef RED_BANK_AVX2
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+#else
+      return false;
+#endif
+    }
+
+    /**
+     * \param q the queue index
+     * \param nowNs the time
+     * \returns the average of an idle queue, aged over the packets that
+     * could have arrived since it went idle
+     */
+    double IdleAverage(std::size_t q, int64_t nowNs) const
+    {
+      if (nowNs <= m_idleTimeNs[q])
+      {
+        return m_qAvg[q];
+      }
+      double ptc = m_ptc;
+      if (m_config.cautious == 3)
+      {
+        ptc = m_ptc * m_config.meanPktSize / m_config.idlePktSize;
+      }
+      uint32_t m = uint32_t(ptc * (nowNs - m_idleTimeNs[q]) * 1e-9);
+      return m_qAvg[q] * std::pow(1.0 - m_config.qW, m);
+    }
+
+    /**
+     * \brief Recompute the gentle coefficients from the current max_p
+     * \param queue the queue index
+     */
+    void UpdateGentle(std::size_t queue)
+    {
+      m_vC[queue] = (1.0 - m_curMaxP[queue]) / m_maxTh[queue];
+      m_vD[queue] = 2.0 * m_curMaxP[queue] - 1.0;
+    }
+
+    /**
+     * \brief Decide on one arrival
+     * \param q the queue index
+     * \param nQueued queue length in packets
+     * \param u uniform [0, 1) draw
+     * \returns the drop type
+     */
+    uint8_t ArriveScalar(std::size_t q, uint32_t nQueued, double u)
+    {
+      const RedConfig &c = m_config;
+      double n = nQueued;
+      double avg = m_qAvg[q] * (1.0 - c.qW) + c.qW * n;
+      m_qAvg[q] = avg;
+      m_count[q] += 1;
+
+      if (!(avg >= m_minTh[q] && n > 1))
+      {
+        // No packets are being dropped
+        m_vProb[q] = 0.0;
+        m_old[q] = 0;
+        return RedEngine::DTYPE_NONE;
+      }
+      if (avg >= m_forcedTh[q])
+      {
+        return RedEngine::DTYPE_FORCED;
+      }
+      if (m_old[q] == 0)
+      {
+        m_count[q] = 1;
+        m_old[q] = 1;
+        return RedEngine::DTYPE_NONE;
+      }
+
+      // CalculatePNew, then ModifyP in packet mode
+      double p;
+      if (c.isGentle && avg >= m_maxTh[q])
+      {
+        p = m_vC[q] * avg + m_vD[q];
+      }
+      else
+      {
+        p = m_vA[q] * avg + m_vB[q];
+        if (c.isNonlinear)
+        {
+          p *= p * 1.5;
+        }
+        p *= m_curMaxP[q];
+      }
+      p = p > 1.0 ? 1.0 : p;
+
+      double cp = m_count[q] * p;
+      if (c.isWait)
+      {
+        p = cp < 1.0 ? 0.0 : (cp < 2.0 ? p / (2.0 - cp) : 1.0);
+      }
+      else
+      {
+        p = cp < 1.0 ? p / (1.0 - cp) : 1.0;
+      }
+      p = p > 1.0 ? 1.0 : p;
+      m_vProb[q] = p;
+
+      if (u <= p)
+      {
+        m_count[q] = 0;
+        return RedEngine::DTYPE_UNFORCED;
+      }
+      return RedEngine::DTYPE_NONE;
+    }
+
+#ifdef RED_BANK_AVX2
+    /**
+     * \brief ArriveScalar over four queues at a time
+     *
+     * Every branch of ArriveScalar is computed on all lanes and the
+     * results are blended, in the same operation order, so that the
+     * results are identical.
+     *
+     * \param first first queue
+     * \param n number of queues
+     * \param arrived arrival flags
+     * \param nQueued queue lengths in packets
+     * \param u uniform [0, 1) draws
+     * \param dropType drop types
+     * \returns the number of queues processed, a multiple of 4
+     */
+    __attribute__((target("avx2"))) std::size_t
+    ArriveAvx2(std::size_t first, std::size_t n, const uint8_t *arrived, const uint32_t *nQueued, const double *u,
+               uint8_t *dropType)
+    {
+      const RedConfig &c = m_config;
+      const __m256d zero = _mm256_setzero_pd();
+      const __m256d one = _mm256_set1_pd(1.0);
+      const __m256d two = _mm256_set1_pd(2.0);
+      const __m256d oneHalf = _mm256_set1_pd(1.5);
+      const __m256d oneMinusQW = _mm256_set1_pd(1.0 - c.qW);
+      const __m256d qW = _mm256_set1_pd(c.qW);
+      const __m256d forcedType = _mm256_set1_pd(RedEngine::DTYPE_FORCED);
+      const __m256d unforcedType = _mm256_set1_pd(RedEngine::DTYPE_UNFORCED);
+
+      std::size_t i = 0;
+      for (; i + 4 <= n; i += 4)
+      {
+        std::size_t q = first + i;
+        int32_t flags;
+        __builtin_memcpy(&flags, arrived + i, 4);
+        __m256i flags64 = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(flags));
+        __m256d arrive = _mm256_castsi256_pd(_mm256_cmpgt_epi64(flags64, _mm256_setzero_si256()));
+        if (_mm256_movemask_pd(arrive) == 0)
+        {
+          __builtin_memset(dropType + i, 0, 4);
+          continue;
+        }
+
+        __m256d nq = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i *>(nQueued + i)));
+        __m256d qAvg = _mm256_loadu_pd(&m_qAvg[q]);
+        __m256d count = _mm256_loadu_pd(&m_count[q]);
+        __m256d old = _mm256_loadu_pd(&m_old[q]);
+        __m256d vProb = _mm256_loadu_pd(&m_vProb[q]);
+        __m256d minTh = _mm256_loadu_pd(&m_minTh[q]);
+        __m256d maxTh = _mm256_loadu_pd(&m_maxTh[q]);
+
+        __m256d avg = _mm256_add_pd(_mm256_mul_pd(qAvg, oneMinusQW), _mm256_mul_pd(qW, nq));
+        __m256d cnt = _mm256_add_pd(count, one);
+
+        __m256d active = _mm256_and_pd(_mm256_cmp_pd(avg, minTh, _CMP_GE_OQ), _mm256_cmp_pd(nq, one, _CMP_GT_OQ));
+        active = _mm256_and_pd(active, arrive);
+        __m256d forced = _mm256_and_pd(active, _mm256_cmp_pd(avg, _mm256_loadu_pd(&m_forcedTh[q]), _CMP_GE_OQ));
+        __m256d notForced = _mm256_andnot_pd(forced, active);
+        __m256d oldZero = _mm256_cmp_pd(old, zero, _CMP_EQ_OQ);
+        __m256d crossing = _mm256_and_pd(notForced, oldZero);
+        __m256d early = _mm256_andnot_pd(oldZero, notForced);
+
+        // CalculatePNew
+        __m256d p = _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(&m_vA[q]), avg), _mm256_loadu_pd(&m_vB[q]));
+        if (c.isNonlinear)
+        {
+          p = _mm256_mul_pd(p, _mm256_mul_pd(p, oneHalf));
+        }
+        p = _mm256_mul_pd(p, _mm256_loadu_pd(&m_curMaxP[q]));
+        if (c.isGentle)
+        {
+          __m256d pGentle = _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(&m_vC[q]), avg), _mm256_loadu_pd(&m_vD[q]));
+          p = _mm256_blendv_pd(p, pGentle, _mm256_cmp_pd(avg, maxTh, _CMP_GE_OQ));
+        }
+        p = _mm256_blendv_pd(p, one, _mm256_cmp_pd(p, one, _CMP_GT_OQ));
+
+        // ModifyP
+        __m256d cp = _mm256_mul_pd(cnt, p);
+        __m256d below1 = _mm256_cmp_pd(cp, one, _CMP_LT_OQ);
+        __m256d pm;
+        if (c.isWait)
+        {
+          __m256d below2 = _mm256_cmp_pd(cp, two, _CMP_LT_OQ);
+          pm = _mm256_blendv_pd(one, _mm256_div_pd(p, _mm256_sub_pd(two, cp)), below2);
+          pm = _mm256_blendv_pd(pm, zero, below1);
+        }
+        else
+        {
+          pm = _mm256_blendv_pd(one, _mm256_div_pd(p, _mm256_sub_pd(one, cp)), below1);
+        }
+        pm = _mm256_blendv_pd(pm, one, _mm256_cmp_pd(pm, one, _CMP_GT_OQ));
+
+        __m256d drop = _mm256_and_pd(early, _mm256_cmp_pd(_mm256_loadu_pd(u + i), pm, _CMP_LE_OQ));
+
+        // new state, for the lanes with an arrival only
+        __m256d inactive = _mm256_andnot_pd(active, arrive);
+        __m256d newCount = _mm256_blendv_pd(cnt, one, crossing);
+        newCount = _mm256_blendv_pd(newCount, zero, drop);
+        __m256d newOld = _mm256_blendv_pd(old, one, crossing);
+        newOld = _mm256_blendv_pd(newOld, zero, inactive);
+        __m256d newVProb = _mm256_blendv_pd(vProb, pm, early);
+        newVProb = _mm256_blendv_pd(newVProb, zero, inactive);
+
+        _mm256_storeu_pd(&m_qAvg[q], _mm256_blendv_pd(qAvg, avg, arrive));
+        _mm256_storeu_pd(&m_count[q], _mm256_blendv_pd(count, newCount, arrive));
+        _mm256_storeu_pd(&m_old[q], newOld);
+        _mm256_storeu_pd(&m_vProb[q], newVProb);
+
+        __m256d type = _mm256_and_pd(forced, forcedType);
+        type = _mm256_blendv_pd(type, unforcedType, drop);
+        __m128i type32 = _mm256_cvtpd_epi32(type);
+        __m128i type8 = _mm_packus_epi16(_mm_packus_epi32(type32, type32), _mm_setzero_si128());
+        int32_t types = _mm_cvtsi128_si32(type8);
+        __builtin_memcpy(dropType + i, &types, 4);
+      }
+      return i;
+    }
+#endif
+
+    RedConfig m_config;    //!< Shared configuration, automatic settings applied
+    double m_ptc;          //!< packet time constant in packets/second
+    bool m_useAvx2;        //!< True to use the AVX2 kernel
+    int64_t m_nextAdaptNs; //!< Next Adapt event of AdaptUntil
+
+    // ** Per-queue state, one array per field
+    std::vector<double> m_qAvg;         //!< Average queue length
+    std::vector<double> m_count;        //!< Packets since last drop, as a double for the kernel
+    std::vector<double> m_old;          //!< 0 when average queue first exceeds threshold
+    std::vector<double> m_vProb;        //!< Prob. of packet drop
+    std::vector<double> m_curMaxP;      //!< Current max_p
+    std::vector<double> m_minTh;        //!< Minimum threshold
+    std::vector<double> m_maxTh;        //!< Maximum threshold
+    std::vector<double> m_forcedTh;     //!< Forced drops from here: maxTh, 2 * maxTh if gentle
+    std::vector<double> m_vA;           //!< 1.0 / (maxTh - minTh)
+    std::vector<double> m_vB;           //!< -minTh / (maxTh - minTh)
+    std::vector<double> m_vC;           //!< (1.0 - curMaxP) / maxTh - used in "gentle" mode
+    std::vector<double> m_vD;           //!< 2.0 * curMaxP - 1.0 - used in "gentle" mode
+    std::vector<uint8_t> m_idle;        //!< 0/1 idle status
+    std::vector<int64_t> m_idleTimeNs;  //!< Start of current idle period
+    std::vector<int64_t> m_lastSetNs;   //!< Last time curMaxP was updated
+    std::vector<int> m_fengStatus;      //!< For use in Feng's Adaptive RED
+  };
+
+} // namespace ns3
+
+#endif // RED_BANK_H
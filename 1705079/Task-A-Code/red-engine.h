@@ -0,0 +1,1358 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RED_ENGINE_H
+#define RED_ENGINE_H
+
+#include "flow-key.h"
+
+#include <cmath>
+#include <cstdint>
+
+/*
+ * Header-only and independent of ns-3: the RED control law and the RRED
+ * filter of RedQueueDisc, driven by plain packet descriptors.  Time is
+ * passed in by the caller (nanoseconds) and the random number generator
+ * is a template argument of Decide, so the same code runs inside the
+ * simulator and in standalone packet-processing tools.
+ */
+
+namespace ns3
+{
+
+  /**
+   * \ingroup traffic-control
+   *
+   * \brief Configuration of a RedEngine
+   *
+   * The fields mirror the RedQueueDisc attributes; times are in
+   * nanoseconds and the link rate in bit/s.  Zero thresholds (or ARED)
+   * select the automatic setting, as in RedQueueDisc.
+   */
+  struct RedConfig
+  {
+    uint32_t meanPktSize;  //!< Avg pkt size
+    uint32_t idlePktSize;  //!< Avg pkt size used during idle times
+    bool isWait;           //!< True for waiting between dropped packets
+    bool isGentle;         //!< True to increase dropping prob. slowly when qAvg exceeds maxTh
+    bool isARED;           //!< True to enable Adaptive RED
+    bool isAdaptMaxP;      //!< True to adapt curMaxP
+    bool isFengAdaptive;   //!< True to enable Feng's Adaptive RED
+    bool isNonlinear;      //!< True to enable Nonlinear RED
+    bool isRRED;           //!< True to enable the RRED filter
+    bool isNs1Compat;      //!< Ns-1 compatibility
+    bool isBytes;          //!< True if the queue length is in bytes
+    bool isFixedPoint;     //!< True for the integer control law, see RedEngine
+    double minTh;          //!< Minimum threshold for qAvg
+    double maxTh;          //!< Maximum threshold for qAvg
+    double qW;             //!< Queue weight given to cur queue size sample
+    double lInterm;        //!< The max probability of dropping a packet
+    double top;            //!< Upper bound for curMaxP in ARED
+    double bottom;         //!< Lower bound for curMaxP in ARED
+    double alpha;          //!< Increment parameter for curMaxP in ARED
+    double beta;           //!< Decrement parameter for curMaxP in ARED
+    double fengA;          //!< Decrement parameter for curMaxP in Feng's Adaptive RED
+    double fengB;          //!< Increment parameter for curMaxP in Feng's Adaptive RED
+    double linkBitRate;    //!< Link bandwidth in bit/s
+    int64_t linkDelayNs;   //!< Link delay
+    int64_t targetDelayNs; //!< Target average queuing delay in ARED
+    int64_t intervalNs;    //!< Time interval to update curMaxP
+    int64_t rttNs;         //!< Rtt used to set bottom in ARED
+    int64_t lastSetNs;     //!< Initial time of the last curMaxP update
+    int64_t rredWindowNs;  //!< RRED T*: packets within T* of a drop are suspicious
+    uint32_t cautious;     //!< 0 for default RED, 1 and 2 experimental, 3 idle packet size in the ptc
+
+    /**
+     * \brief The defaults of the RedQueueDisc attributes
+     */
+    RedConfig()
+        : meanPktSize(500),
+          idlePktSize(0),
+          isWait(true),
+          isGentle(true),
+          isARED(false),
+          isAdaptMaxP(false),
+          isFengAdaptive(false),
+          isNonlinear(false),
+          isRRED(true),
+          isNs1Compat(false),
+          isBytes(false),
+          isFixedPoint(false),
+          minTh(5),
+          maxTh(15),
+          qW(0.002),
+          lInterm(50),
+          top(0.5),
+          bottom(0.0),
+          alpha(0.01),
+          beta(0.9),
+          fengA(3.0),
+          fengB(2.0),
+          linkBitRate(1.5e6),
+          linkDelayNs(20000000),
+          targetDelayNs(5000000),
+          intervalNs(500000000),
+          rttNs(100000000),
+          lastSetNs(0),
+          rredWindowNs(10000000),
+          cautious(0)
+    {
+    }
+  };
+
+  /**
+   * \ingroup traffic-control
+   *
+   * \brief Outcome of RedEngine::Decide
+   *
+   * dropType is what RED asks for; the caller either drops the packet
+   * (and reports it with RedEngine::Dropped) or marks it.  rredDrop is set
+   * when the RRED filter rejects the packet; it applies to packets RED
+   * lets through or marks.
+   */
+  struct RedDecision
+  {
+    uint8_t dropType; //!< RedEngine::DTYPE_NONE, DTYPE_FORCED or DTYPE_UNFORCED
+    bool rredDrop;    //!< True if the RRED filter rejects the packet
+  };
+
+  /**
+   * \ingroup traffic-control
+   *
+   * \brief Small xorshift64* generator of uniform doubles in [0, 1)
+   *
+   * For standalone use of RedEngine; the simulator passes its own
+   * random variable stream instead.
+   */
+  struct RedXorShiftRng
+  {
+    uint64_t state; //!< Never zero
+
+    /**
+     * \param seed the seed, any value
+     */
+    explicit RedXorShiftRng(uint64_t seed = 1)
+        : state(seed ? seed : 0x9e3779b97f4a7c15ull)
+    {
+    }
+
+    /**
+     * \returns the next value
+     */
+    double operator()(void)
+    {
+      state ^= state >> 12;
+      state ^= state << 25;
+      state ^= state >> 27;
+      return ((state * 0x2545f4914f6cdd1dull) >> 11) * (1.0 / 9007199254740992.0);
+    }
+  };
+
+  /**
+   * \ingroup traffic-control
+   *
+   * \brief RED, ARED, Feng's adaptive RED, NLRED and RRED decisions
+   *
+   * Ported from RedQueueDisc, which is now an adapter over this class.
+   * The engine does not hold packets: the caller passes the current
+   * queue length with every arrival and reports when the queue goes
+   * idle.
+   *
+   * With RedConfig::isFixedPoint the per-packet path of RED, ARED and
+   * Feng's adaptive RED uses integer additions, shifts and 64-bit
+   * multiplications only (plus one 32-bit division per early drop test
+   * in byte mode), as on a router without an FPU; the constants are
+   * derived once in Initialize.  RRED is integer in both modes.
+   *
+   *  - The queue weight is rounded to qW' = 2^-W, W = round (-log2 qW)
+   *    in [1, 16].  The average is kept as A = qAvg * 2^(W + 16) and
+   *    updated as A += (n << 16) - (A >> W); an idle period of m packets
+   *    ages it by (1 - 2^-W)^m, computed by repeated squaring.
+   *  - Probabilities and max_p are Q0.32; the average enters the drop
+   *    probability as Q.16.
+   *  - ModifyP does not divide: u <= p / (2 - count * p) is tested as
+   *    u * (2 - count * p) <= p.
+   *
+   * Error bounds against the floating-point path run with qW' (a power
+   * of two qW makes the two laws the same):
+   *
+   *  - the average exceeds the exact one by less than 2^-16 packet
+   *    (byte): each update truncates A >> W by less than one unit of A,
+   *    and these errors decay with (1 - 2^-W); ageing over an idle period
+   *    rounds it down by a relative 2^-30 at most;
+   *  - the thresholds are rounded to multiples of 2^-16;
+   *  - for the same average and thresholds the drop probability is
+   *    within 2^-28, and every ARED / Feng update of max_p within 2^-31;
+   *  - max_p saturates at 1, where Feng's rule may push the
+   *    floating-point max_p above 1;
+   *  - the packets simulated for an idle period may be one fewer.
+   *
+   * For the same uniform draw the two paths decide differently only
+   * when the draw lies within these bounds of the drop probability or
+   * the averages straddle a threshold.  When qW is not a power of two,
+   * qW' is within a factor of sqrt (2) of it and the time constant of
+   * the average changes accordingly.  cautious modes 1 and 2 are
+   * floating-point only and are ignored in fixed-point mode.
+   *
+   * ARED and Feng's adaptive RED do not touch max_p on arrivals: the
+   * caller runs Adapt every intervalNs (RedQueueDisc schedules it, tools
+   * without a scheduler call AdaptUntil), and Decide only reads max_p and
+   * the gentle coefficients.  Adapt samples the average itself, aged over
+   * the idle time, so max_p keeps moving while no packet arrives.
+   */
+  class RedEngine
+  {
+  public:
+    /**
+     * \brief Used in Feng's Adaptive RED
+     */
+    enum FengStatus
+    {
+      Above,   //!< When qAvg > maxTh
+      Between, //!< When maxTh < qAvg < minTh
+      Below,   //!< When qAvg < minTh
+    };
+
+    /**
+     * \brief Drop types
+     */
+    enum
+    {
+      DTYPE_NONE,     //!< Ok, no drop
+      DTYPE_FORCED,   //!< A "forced" drop
+      DTYPE_UNFORCED, //!< An "unforced" (random) drop
+    };
+
+    /**
+     * \brief Per-flow RRED state
+     */
+    struct RredFlow
+    {
+      int64_t t1Ns;      //!< Arrival of the last packet dropped by the filter
+      int32_t indicator; //!< Below zero, the flow is flagged
+
+      RredFlow()
+          : t1Ns(NEVER),
+            indicator(0)
+      {
+      }
+    };
+
+    /**
+     * \brief Drop time before any drop; far enough in the past that
+     * adding T* cannot overflow
+     */
+    static const int64_t NEVER = INT64_MIN / 2;
+
+    /**
+     * \brief 1.0 in Q0.32
+     */
+    static const uint64_t FX_ONE = 1ull << 32;
+
+    RedEngine()
+        : m_rredFlows(1024)
+    {
+      Initialize(RedConfig());
+    }
+
+    /**
+     * \brief Apply the automatic settings of a configuration
+     *
+     * ARED and zero thresholds set the thresholds from the target delay,
+     * a zero or negative qW selects one of the automatic queue weights,
+     * and a zero bottom is set from the link rate and rtt.
+     *
+     * \param c the configuration, modified in place
+     * \returns the packet time constant, in packets per second
+     */
+    static double Resolve(RedConfig &c)
+    {
+      double ptc = c.linkBitRate / (8.0 * c.meanPktSize);
+
+      if (c.isARED)
+      {
+        // Set minTh, maxTh and qW to zero for automatic setting
+        c.minTh = 0;
+        c.maxTh = 0;
+        c.qW = 0;
+
+        // Turn on isAdaptMaxP to adapt curMaxP
+        c.isAdaptMaxP = true;
+      }
+
+      if (c.minTh == 0 && c.maxTh == 0)
+      {
+        c.minTh = 5.0;
+
+        // set minTh to max(minTh, targetqueue/2.0) [Ref: http://www.icir.org/floyd/papers/adaptiveRed.pdf]
+        double targetqueue = c.targetDelayNs * 1e-9 * ptc;
+
+        if (c.minTh < targetqueue / 2.0)
+        {
+          c.minTh = targetqueue / 2.0;
+        }
+        if (c.isBytes)
+        {
+          c.minTh = c.minTh * c.meanPktSize;
+        }
+
+        // set maxTh to three times minTh [Ref: http://www.icir.org/floyd/papers/adaptiveRed.pdf]
+        c.maxTh = 3 * c.minTh;
+      }
+
+      /*
+       * If qW=0, set it to a reasonable value of 1-exp(-1/C)
+       * This corresponds to choosing qW to be of that value for
+       * which the packet time constant -1/ln(1-m)qW) per default RTT
+       * of 100ms is an order of magnitude more than the link capacity, C.
+       *
+       * If qW=-1, then the queue weight is set to be a function of
+       * the bandwidth and the link propagation delay.  In particular,
+       * the default RTT is assumed to be three times the link delay and
+       * transmission delay, if this gives a default RTT greater than 100 ms.
+       *
+       * If qW=-2, set it to a reasonable value of 1-exp(-10/C).
+       */
+      if (c.qW == 0.0)
+      {
+        c.qW = 1.0 - std::exp(-1.0 / ptc);
+      }
+      else if (c.qW == -1.0)
+      {
+        double rtt = 3.0 * (c.linkDelayNs * 1e-9 + 1.0 / ptc);
+
+        if (rtt < 0.1)
+        {
+          rtt = 0.1;
+        }
+        c.qW = 1.0 - std::exp(-1.0 / (10 * rtt * ptc));
+      }
+      else if (c.qW == -2.0)
+      {
+        c.qW = 1.0 - std::exp(-10.0 / ptc);
+      }
+
+      if (c.bottom == 0)
+      {
+        c.bottom = 0.01;
+        // Set bottom to at most 1/W, where W is the delay-bandwidth
+        // product in packets for a connection.
+        double bottom1 = (8.0 * c.meanPktSize * c.rttNs * 1e-9) / c.linkBitRate;
+        if (bottom1 < c.bottom)
+        {
+          c.bottom = bottom1;
+        }
+      }
+      return ptc;
+    }
+
+    /**
+     * \brief Reset the state and compute the derived parameters
+     *
+     * Automatic thresholds, queue weight and ARED bottom are written back
+     * into the configuration, see GetConfig.
+     *
+     * \param config the configuration
+     */
+    void Initialize(const RedConfig &config)
+    {
+      m_config = config;
+      RedConfig &c = m_config;
+      m_ptc = Resolve(c);
+      m_oneMinusQW = 1.0 - c.qW;
+
+      m_fengStatus = Above;
+      m_qAvg = 0.0;
+      m_count = 0;
+      m_countBytes = 0;
+      m_old = 0;
+      m_idle = 1;
+      m_vProb = 0.0;
+
+      double th_diff = (c.maxTh - c.minTh);
+      if (th_diff == 0)
+      {
+        th_diff = 1.0;
+      }
+      m_vA = 1.0 / th_diff;
+      m_curMaxP = 1.0 / c.lInterm;
+      m_vB = -c.minTh / th_diff;
+      m_vC = (1.0 - m_curMaxP) / c.maxTh;
+      m_vD = 2.0 * m_curMaxP - 1.0;
+      m_idleTimeNs = 0;
+      m_lastSetNs = c.lastSetNs;
+      m_nextAdaptNs = c.intervalNs;
+
+      m_t2Ns = NEVER;
+      m_rredFlows.Clear();
+
+      InitializeFixed();
+    }
+
+    /**
+     * \brief Decide the fate of an arriving packet
+     *
+     * \param nowNs arrival time
+     * \param nQueued current queue length, in packets or bytes
+     * \param size packet size in bytes
+     * \param key flow of the packet, or 0 to bypass the RRED filter
+     * \param hash key->Hash (), ignored without a key
+     * \param rng uniform [0, 1) generator, called as rng ()
+     * \returns the decision
+     */
+    template <typename Rng>
+    RedDecision Decide(int64_t nowNs, uint32_t nQueued, uint32_t size, const FlowKey *key, uint32_t hash, Rng &rng)
+    {
+      RedDecision d;
+      d.dropType = DTYPE_NONE;
+      d.rredDrop = m_config.isRRED && key && !RredPass(nowNs, *key, hash);
+
+      // simulate number of packets arrival during idle period
+      uint32_t m = 0;
+
+      if (m_idle == 1)
+      {
+        m = IdleArrivals(nowNs);
+        m_idle = 0;
+      }
+
+      const RedConfig &c = m_config;
+      bool above;
+      bool forced;
+      if (c.isFixedPoint)
+      {
+        EstimatorFixed(nQueued, m);
+        above = m_avgFx >= m_minThFx;
+        forced = m_avgFx >= m_forcedThFx;
+      }
+      else
+      {
+        m_qAvg = Estimator(nQueued, m + 1, m_qAvg);
+        above = m_qAvg >= c.minTh;
+        forced = (!c.isGentle && m_qAvg >= c.maxTh) ||
+                 (c.isGentle && m_qAvg >= 2 * c.maxTh);
+      }
+
+      m_count++;
+      m_countBytes += size;
+
+      if (above && nQueued > 1)
+      {
+        if (forced)
+        {
+          d.dropType = DTYPE_FORCED;
+        }
+        else if (m_old == 0)
+        {
+          /*
+           * The average queue size has just crossed the
+           * threshold from below to above minTh, or
+           * from above minTh with an empty queue to
+           * above minTh with a nonempty queue.
+           */
+          m_count = 1;
+          m_countBytes = size;
+          m_old = 1;
+        }
+        else if (c.isFixedPoint ? DropEarlyFixed(size, rng) : DropEarly(size, nQueued, rng))
+        {
+          d.dropType = DTYPE_UNFORCED;
+        }
+      }
+      else
+      {
+        // No packets are being dropped
+        m_vProb = 0.0;
+        m_vProbNumFx = 0;
+        m_vProbDenFx = FX_ONE;
+        m_old = 0;
+      }
+      return d;
+    }
+
+    /**
+     * \brief Decide the fate of an arriving packet, hashing its key
+     *
+     * \param nowNs arrival time
+     * \param nQueued current queue length, in packets or bytes
+     * \param size packet size in bytes
+     * \param key flow of the packet, or 0 to bypass the RRED filter
+     * \param rng uniform [0, 1) generator, called as rng ()
+     * \returns the decision
+     */
+    template <typename Rng>
+    RedDecision Decide(int64_t nowNs, uint32_t nQueued, uint32_t size, const FlowKey *key, Rng &rng)
+    {
+      return Decide(nowNs, nQueued, size, key, key ? key->Hash() : 0, rng);
+    }
+
+    /**
+     * \brief Prefetch the RRED state of a flow ahead of Decide
+     * \param hash the flow hash
+     */
+    void PrefetchFlow(uint32_t hash) const
+    {
+      if (m_config.isRRED)
+      {
+        m_rredFlows.Prefetch(hash);
+      }
+    }
+
+    /**
+     * \brief Report that a packet RED asked to drop was dropped, not marked
+     * \param d the decision
+     * \param nowNs the time
+     */
+    void Dropped(const RedDecision &d, int64_t nowNs)
+    {
+      if (d.dropType == DTYPE_FORCED && m_config.isNs1Compat)
+      {
+        m_count = 0;
+        m_countBytes = 0;
+      }
+      if (!d.rredDrop)
+      {
+        m_t2Ns = nowNs;
+      }
+    }
+
+    /**
+     * \brief Decide and apply the decision, for callers that never mark
+     *
+     * \param nowNs arrival time
+     * \param nQueued current queue length, in packets or bytes
+     * \param size packet size in bytes
+     * \param key flow of the packet, or 0 to bypass the RRED filter
+     * \param hash key->Hash (), ignored without a key
+     * \param rng uniform [0, 1) generator, called as rng ()
+     * \returns true if the packet must be enqueued
+     */
+    template <typename Rng>
+    bool Admit(int64_t nowNs, uint32_t nQueued, uint32_t size, const FlowKey *key, uint32_t hash, Rng &rng)
+    {
+      RedDecision d = Decide(nowNs, nQueued, size, key, hash, rng);
+      if (d.dropType != DTYPE_NONE)
+      {
+        Dropped(d, nowNs);
+        return false;
+      }
+      return !d.rredDrop;
+    }
+
+    /**
+     * \brief Report that a dequeue found the queue empty
+     * \param nowNs the time
+     */
+    void SetIdle(int64_t nowNs)
+    {
+      m_idle = 1;
+      m_idleTimeNs = nowNs;
+    }
+
+    /**
+     * \brief Report that a packet was dequeued
+     */
+    void SetBusy(void)
+    {
+      m_idle = 0;
+    }
+
+    /**
+     * \returns true if max_p adapts (ARED or Feng's adaptive RED), and
+     * Adapt must then run every intervalNs
+     */
+    bool IsAdaptive(void) const
+    {
+      return m_config.isAdaptMaxP || m_config.isFengAdaptive;
+    }
+
+    /**
+     * \brief Adapt max_p to the average queue size, a periodic event
+     *
+     * The average is the one of the last arrival, aged over the idle
+     * period if the queue is idle.  ARED applies its AIMD rule (at most
+     * once per intervalNs), Feng's adaptive RED its MIMD rule, and the
+     * gentle coefficients follow the new max_p.
+     *
+     * \param nowNs the time
+     */
+    void Adapt(int64_t nowNs)
+    {
+      const RedConfig &c = m_config;
+      uint32_t m = m_idle == 1 ? IdleArrivals(nowNs) : 0;
+      if (c.isFixedPoint)
+      {
+        uint64_t avg = AgeFixed(m_avgFx, m);
+        if (c.isAdaptMaxP)
+        {
+          UpdateMaxPFixed(nowNs, avg);
+        }
+        else if (c.isFengAdaptive)
+        {
+          UpdateMaxPFengFixed(avg);
+        }
+        return;
+      }
+
+      double avg = m == 0 ? m_qAvg : m_qAvg * std::pow(m_oneMinusQW, m);
+      if (c.isAdaptMaxP)
+      {
+        UpdateMaxP(nowNs, avg);
+      }
+      else if (c.isFengAdaptive)
+      {
+        UpdateMaxPFeng(avg); // Update curMaxP in MIMD fashion.
+      }
+      m_vC = (1.0 - m_curMaxP) / c.maxTh;
+      m_vD = 2.0 * m_curMaxP - 1.0;
+    }
+
+    /**
+     * \brief Run the Adapt events due up to a time, for callers without
+     * a scheduler
+     *
+     * Events fall on multiples of intervalNs; call it before each
+     * arrival and before each SetIdle, with that time.
+     *
+     * \param nowNs the time
+     */
+    void AdaptUntil(int64_t nowNs)
+    {
+      if (!IsAdaptive() || m_config.intervalNs <= 0)
+      {
+        return;
+      }
+      while (m_nextAdaptNs <= nowNs)
+      {
+        Adapt(m_nextAdaptNs);
+        m_nextAdaptNs += m_config.intervalNs;
+      }
+    }
+
+    /**
+     * \returns the configuration, with the automatic settings applied
+     */
+    const RedConfig &GetConfig(void) const
+    {
+      return m_config;
+    }
+
+    /**
+     * \returns the average queue size, as updated by the last arrival
+     */
+    double GetQueueAverage(void) const
+    {
+      return m_config.isFixedPoint ? std::ldexp(static_cast<double>(m_avgFx), -static_cast<int>(m_wlog) - 16) : m_qAvg;
+    }
+
+    /**
+     * \brief The average queue size at a time
+     *
+     * Outside idle periods this is GetQueueAverage; during one, the
+     * average is aged over the packets that could have arrived since the
+     * queue emptied, as Adapt ages it.
+     *
+     * \param nowNs the time
+     * \returns the average queue size
+     */
+    double GetQueueAverageAt(int64_t nowNs) const
+    {
+      uint32_t m = m_idle == 1 ? IdleArrivals(nowNs) : 0;
+      if (m_config.isFixedPoint)
+      {
+        return std::ldexp(static_cast<double>(AgeFixed(m_avgFx, m)), -static_cast<int>(m_wlog) - 16);
+      }
+      return m == 0 ? m_qAvg : m_qAvg * std::pow(m_oneMinusQW, m);
+    }
+
+    /**
+     * \returns the current max_p
+     */
+    double GetCurMaxP(void) const
+    {
+      return m_config.isFixedPoint ? std::ldexp(static_cast<double>(m_curMaxPFx), -32) : m_curMaxP;
+    }
+
+    /**
+     * \returns the drop probability computed by the last early drop test
+     */
+    double GetVProb(void) const
+    {
+      if (m_config.isFixedPoint)
+      {
+        // kept as a fraction, the fixed-point test never divides
+        return m_vProbNumFx >= m_vProbDenFx ? 1.0
+                                            : static_cast<double>(m_vProbNumFx) / static_cast<double>(m_vProbDenFx);
+      }
+      return m_vProb;
+    }
+
+    /**
+     * \returns the shift W of the fixed-point queue weight 2^-W
+     */
+    uint32_t GetWeightShift(void) const
+    {
+      return m_wlog;
+    }
+
+    /**
+     * \returns the RRED flow table
+     */
+    const FlatFlowTable<RredFlow> &GetRredFlows(void) const
+    {
+      return m_rredFlows;
+    }
+
+  private:
+    /**
+     * \brief The RRED filter
+     *
+     * A packet arriving within T* after a drop of its flow (by the
+     * filter) or of any flow (by RED) is suspicious and decrements the
+     * flow indicator; any other packet increments it.  Packets of flows
+     * with a negative indicator are dropped.
+     *
+     * \param nowNs arrival time
+     * \param key the flow
+     * \param hash key.Hash ()
+     * \returns true if the packet passes the filter
+     */
+    bool RredPass(int64_t nowNs, const FlowKey &key, uint32_t hash)
+    {
+      RredFlow &flow = m_rredFlows.FindOrInsert(key, hash);
+      int64_t tMax = flow.t1Ns > m_t2Ns ? flow.t1Ns : m_t2Ns;
+
+      if (nowNs >= tMax && nowNs <= tMax + m_config.rredWindowNs)
+      {
+        flow.indicator--;
+      }
+      else
+      {
+        flow.indicator++;
+      }
+
+      if (flow.indicator >= 0)
+      {
+        return true;
+      }
+      flow.t1Ns = nowNs;
+      return false;
+    }
+
+    /**
+     * \param nowNs the time
+     * \returns the number of packets that could have arrived since the
+     * queue went idle
+     */
+    uint32_t IdleArrivals(int64_t nowNs) const
+    {
+      // an Adapt event replayed late may fall before the idle report
+      if (nowNs <= m_idleTimeNs)
+      {
+        return 0;
+      }
+      if (m_config.isFixedPoint)
+      {
+        return IdleArrivalsFixed(nowNs);
+      }
+      double ptc = m_ptc;
+      if (m_config.cautious == 3)
+      {
+        ptc = m_ptc * m_config.meanPktSize / m_config.idlePktSize;
+      }
+      return uint32_t(ptc * (nowNs - m_idleTimeNs) * 1e-9);
+    }
+
+    /**
+     * \brief Compute the average queue size
+     * \param nQueued number of queued packets
+     * \param m simulated number of packets arrival during idle period
+     * \param qAvg average queue size
+     * \returns new average queue size
+     */
+    double Estimator(uint32_t nQueued, uint32_t m, double qAvg) const
+    {
+      // m is 1 unless the queue was idle: skip pow on the common path
+      double newAve = qAvg * (m == 1 ? m_oneMinusQW : std::pow(m_oneMinusQW, m));
+      newAve += m_config.qW * nQueued;
+      return newAve;
+    }
+
+    /**
+     * \brief Update curMaxP to keep the average queue length within the target range
+     * \param nowNs the time
+     * \param newAve new average queue length
+     */
+    void UpdateMaxP(int64_t nowNs, double newAve)
+    {
+      const RedConfig &c = m_config;
+      if (nowNs < m_lastSetNs + c.intervalNs)
+      {
+        return;
+      }
+      double part = 0.4 * (c.maxTh - c.minTh);
+      // AIMD rule to keep target Q~1/2(minTh + maxTh)
+      if (newAve < c.minTh + part && m_curMaxP > c.bottom)
+      {
+        // we should increase the average queue size, so decrease curMaxP
+        m_curMaxP = m_curMaxP * c.beta;
+        m_lastSetNs = nowNs;
+      }
+      else if (newAve > c.maxTh - part && c.top > m_curMaxP)
+      {
+        // we should decrease the average queue size, so increase curMaxP
+        double alpha = c.alpha;
+        if (alpha > 0.25 * m_curMaxP)
+        {
+          alpha = 0.25 * m_curMaxP;
+        }
+        m_curMaxP = m_curMaxP + alpha;
+        m_lastSetNs = nowNs;
+      }
+    }
+
+    /**
+     * \brief Update curMaxP based on Feng's Adaptive RED
+     *
+     * Following the pseudocode from: A Self-Configuring RED Gateway,
+     * INFOCOMM '99.  They recommend fengA = 3, and fengB = 2.
+     *
+     * \param newAve new average queue length
+     */
+    void UpdateMaxPFeng(double newAve)
+    {
+      const RedConfig &c = m_config;
+      if (c.minTh < newAve && newAve < c.maxTh)
+      {
+        m_fengStatus = Between;
+      }
+      else if (newAve < c.minTh && m_fengStatus != Below)
+      {
+        m_fengStatus = Below;
+        m_curMaxP = m_curMaxP / c.fengA;
+      }
+      else if (newAve > c.maxTh && m_fengStatus != Above)
+      {
+        m_fengStatus = Above;
+        m_curMaxP = m_curMaxP * c.fengB;
+      }
+    }
+
+    /**
+     * \brief Check if a packet needs to be dropped due to probability mark
+     * \param size packet size
+     * \param qSize queue size
+     * \param rng uniform [0, 1) generator
+     * \returns 0 for no drop/mark, 1 for drop
+     */
+    template <typename Rng>
+    uint32_t DropEarly(uint32_t size, uint32_t qSize, Rng &rng)
+    {
+      double prob1 = CalculatePNew();
+      m_vProb = ModifyP(prob1, size);
+
+      // Drop probability is computed, pick random number and act
+      if (m_config.cautious == 1)
+      {
+        /*
+         * Don't drop/mark if the instantaneous queue is much below the average.
+         * For experimental purposes only.
+         * pkts: the number of packets arriving in 50 ms
+         */
+        double pkts = m_ptc * 0.05;
+        double fraction = std::pow((1 - m_config.qW), pkts);
+
+        if ((double)qSize < fraction * m_qAvg)
+        {
+          // Queue could have been empty for 0.05 seconds
+          return 0;
+        }
+      }
+
+      double u = rng();
+
+      if (m_config.cautious == 2)
+      {
+        /*
+         * Decrease the drop probability if the instantaneous
+         * queue is much below the average.
+         * For experimental purposes only.
+         * pkts: the number of packets arriving in 50 ms
+         */
+        double pkts = m_ptc * 0.05;
+        double fraction = std::pow((1 - m_config.qW), pkts);
+        double ratio = qSize / (fraction * m_qAvg);
+
+        if (ratio < 1.0)
+        {
+          u *= 1.0 / ratio;
+        }
+      }
+
+      if (u <= m_vProb)
+      {
+        // DROP or MARK
+        m_count = 0;
+        m_countBytes = 0;
+
+        return 1; // drop
+      }
+
+      return 0; // no drop/mark
+    }
+
+    /**
+     * \brief Returns a probability using these function parameters for the DropEarly function
+     * \returns Prob. of packet drop before "count"
+     */
+    double CalculatePNew(void) const
+    {
+      const RedConfig &c = m_config;
+      double p;
+
+      if (c.isGentle && m_qAvg >= c.maxTh)
+      {
+        // p ranges from curMaxP to 1 as the average queue
+        // size ranges from maxTh to twice maxTh
+        p = m_vC * m_qAvg + m_vD;
+      }
+      else if (!c.isGentle && m_qAvg >= c.maxTh)
+      {
+        /*
+         * OLD: p continues to range linearly above curMaxP as
+         * the average queue size ranges above maxTh.
+         * NEW: p is set to 1.0
+         */
+        p = 1.0;
+      }
+      else
+      {
+        /*
+         * p ranges from 0 to curMaxP as the average queue size ranges from
+         * minTh to maxTh
+         */
+        p = m_vA * m_qAvg + m_vB;
+
+        if (c.isNonlinear)
+        {
+          p *= p * 1.5;
+        }
+
+        p *= m_curMaxP;
+      }
+
+      if (p > 1.0)
+      {
+        p = 1.0;
+      }
+
+      return p;
+    }
+
+    /**
+     * \brief Returns a probability using these function parameters for the DropEarly function
+     * \param p Prob. of packet drop before "count"
+     * \param size packet size
+     * \returns Prob. of packet drop
+     */
+    double ModifyP(double p, uint32_t size) const
+    {
+      const RedConfig &c = m_config;
+      double count1 = (double)m_count;
+
+      if (c.isBytes)
+      {
+        count1 = (double)(m_countBytes / c.meanPktSize);
+      }
+
+      if (c.isWait)
+      {
+        if (count1 * p < 1.0)
+        {
+          p = 0.0;
+        }
+        else if (count1 * p < 2.0)
+        {
+          p /= (2.0 - count1 * p);
+        }
+        else
+        {
+          p = 1.0;
+        }
+      }
+      else
+      {
+        if (count1 * p < 1.0)
+        {
+          p /= (1.0 - count1 * p);
+        }
+        else
+        {
+          p = 1.0;
+        }
+      }
+
+      if (c.isBytes && (p < 1.0))
+      {
+        p = (p * size) / c.meanPktSize;
+      }
+
+      if (p > 1.0)
+      {
+        p = 1.0;
+      }
+
+      return p;
+    }
+
+    /**
+     * \brief floor (a * b / 2^32) without overflow
+     * \param a any value with (a >> 32) * b below 2^64
+     * \param b at most 2^32, e.g. a Q0.32 fraction
+     * \returns the product
+     */
+    static uint64_t MulQ32(uint64_t a, uint64_t b)
+    {
+      return (a >> 32) * b + (((a & 0xffffffffull) * b) >> 32);
+    }
+
+    /**
+     * \param v a non-negative value
+     * \param shift the number of fractional bits
+     * \returns v rounded to the fixed-point format
+     */
+    static uint64_t ToFixed(double v, int shift)
+    {
+      return v > 0 ? static_cast<uint64_t>(std::ldexp(v, shift) + 0.5) : 0;
+    }
+
+    /**
+     * \brief Derive the constants of the fixed-point control law
+     */
+    void InitializeFixed(void)
+    {
+      const RedConfig &c = m_config;
+      int wlog = c.qW > 0 ? static_cast<int>(std::floor(-std::log2(c.qW) + 0.5)) : 1;
+      m_wlog = wlog < 1 ? 1 : (wlog > 16 ? 16 : wlog);
+      int w = static_cast<int>(m_wlog);
+
+      m_avgFx = 0;
+      m_minThFx = ToFixed(c.minTh, w + 16);
+      m_maxThFx = ToFixed(c.maxTh, w + 16);
+      m_forcedThFx = c.isGentle ? 2 * m_maxThFx : m_maxThFx;
+      // minTh and maxTh in Q.16, as A >> W gives the average
+      uint64_t minTh16 = m_minThFx >> w;
+      uint64_t maxTh16 = m_maxThFx >> w;
+      // equal thresholds count as a difference of 1, as vA does
+      uint64_t diff16 = maxTh16 > minTh16 ? maxTh16 - minTh16 : 65536;
+      m_minTh16 = minTh16;
+      m_maxTh16 = maxTh16;
+      // 2^48 / x: a Q.16 value below x times it stays below 2^48
+      m_invDiffFx = (1ull << 48) / diff16;
+      m_invMaxThFx = maxTh16 ? (1ull << 48) / maxTh16 : 0;
+
+      m_curMaxPFx = ToFixed(m_curMaxP, 32);
+      if (m_curMaxPFx > FX_ONE)
+      {
+        m_curMaxPFx = FX_ONE;
+      }
+
+      double part = 0.4 * (c.maxTh - c.minTh);
+      m_aredLowFx = ToFixed(c.minTh + part, w + 16);
+      m_aredHighFx = ToFixed(c.maxTh - part, w + 16);
+      m_topFx = ToFixed(c.top, 32);
+      m_bottomFx = ToFixed(c.bottom, 32);
+      m_alphaFx = ToFixed(c.alpha, 32);
+      m_betaFx = ToFixed(c.beta, 32);
+      m_fengInvAFx = c.fengA > 0 ? ToFixed(1.0 / c.fengA, 32) : 0;
+      m_fengBFx = ToFixed(c.fengB, 32);
+
+      // packets per nanosecond, Q0.32
+      double ptc = m_ptc;
+      if (c.cautious == 3 && c.idlePktSize > 0)
+      {
+        ptc = m_ptc * c.meanPktSize / c.idlePktSize;
+      }
+      m_ptcFx = ToFixed(ptc * 1e-9, 32);
+      if (m_ptcFx > FX_ONE)
+      {
+        m_ptcFx = FX_ONE;
+      }
+      m_oneMinusQWFx = FX_ONE - (FX_ONE >> w);
+      m_vProbNumFx = 0;
+      m_vProbDenFx = FX_ONE;
+    }
+
+    /**
+     * \param nowNs the time
+     * \returns the number of packets that could have arrived since the
+     * queue went idle
+     */
+    uint32_t IdleArrivalsFixed(int64_t nowNs) const
+    {
+      uint64_t m = MulQ32(static_cast<uint64_t>(nowNs - m_idleTimeNs), m_ptcFx);
+      return m > 0xffffffffull ? 0xffffffffu : static_cast<uint32_t>(m);
+    }
+
+    /**
+     * \brief Age a fixed-point average over an idle period
+     * \param avg the average
+     * \param m simulated number of packets arrival during idle period
+     * \returns avg * (1 - 2^-W)^m
+     */
+    uint64_t AgeFixed(uint64_t avg, uint32_t m) const
+    {
+      if (m == 0)
+      {
+        return avg;
+      }
+      // (1 - 2^-W)^m is below 2^-46 past 2^(W + 5) packets
+      if (m >> (m_wlog + 5))
+      {
+        return 0;
+      }
+      uint64_t f = m_oneMinusQWFx;
+      uint64_t r = FX_ONE;
+      for (uint32_t k = m; k; k >>= 1)
+      {
+        if (k & 1)
+        {
+          r = (r * f) >> 32;
+        }
+        f = (f * f) >> 32;
+      }
+      return MulQ32(avg, r);
+    }
+
+    /**
+     * \brief Fixed-point Estimator: age the average over m idle packets,
+     * then add the current sample
+     * \param nQueued number of queued packets
+     * \param m simulated number of packets arrival during idle period
+     */
+    void EstimatorFixed(uint32_t nQueued, uint32_t m)
+    {
+      m_avgFx = AgeFixed(m_avgFx, m);
+      m_avgFx = m_avgFx - (m_avgFx >> m_wlog) + (static_cast<uint64_t>(nQueued) << 16);
+    }
+
+    /**
+     * \brief Fixed-point UpdateMaxP
+     * \param nowNs the time
+     * \param avg the average queue length
+     */
+    void UpdateMaxPFixed(int64_t nowNs, uint64_t avg)
+    {
+      if (nowNs < m_lastSetNs + m_config.intervalNs)
+      {
+        return;
+      }
+      if (avg < m_aredLowFx && m_curMaxPFx > m_bottomFx)
+      {
+        m_curMaxPFx = MulQ32(m_betaFx, m_curMaxPFx);
+        m_lastSetNs = nowNs;
+      }
+      else if (avg > m_aredHighFx && m_topFx > m_curMaxPFx)
+      {
+        uint64_t alpha = m_alphaFx;
+        if (alpha > (m_curMaxPFx >> 2))
+        {
+          alpha = m_curMaxPFx >> 2;
+        }
+        m_curMaxPFx += alpha;
+        if (m_curMaxPFx > FX_ONE)
+        {
+          m_curMaxPFx = FX_ONE;
+        }
+        m_lastSetNs = nowNs;
+      }
+    }
+
+    /**
+     * \brief Fixed-point UpdateMaxPFeng
+     * \param avg the average queue length
+     */
+    void UpdateMaxPFengFixed(uint64_t avg)
+    {
+      if (m_minThFx < avg && avg < m_maxThFx)
+      {
+        m_fengStatus = Between;
+      }
+      else if (avg < m_minThFx && m_fengStatus != Below)
+      {
+        m_fengStatus = Below;
+        m_curMaxPFx = MulQ32(m_fengInvAFx, m_curMaxPFx);
+      }
+      else if (avg > m_maxThFx && m_fengStatus != Above)
+      {
+        m_fengStatus = Above;
+        m_curMaxPFx = MulQ32(m_fengBFx, m_curMaxPFx);
+        if (m_curMaxPFx > FX_ONE)
+        {
+          m_curMaxPFx = FX_ONE;
+        }
+      }
+    }
+
+    /**
+     * \brief Fixed-point CalculatePNew
+     * \returns Prob. of packet drop before "count", Q0.32
+     */
+    uint64_t CalculatePNewFixed(void) const
+    {
+      const RedConfig &c = m_config;
+      uint64_t avg16 = m_avgFx >> m_wlog;
+      uint64_t p;
+
+      if (c.isGentle && m_avgFx >= m_maxThFx)
+      {
+        // curMaxP + (1 - curMaxP) (qAvg - maxTh) / maxTh, i.e. vC qAvg + vD
+        uint64_t x = avg16 > m_maxTh16 ? avg16 - m_maxTh16 : 0;
+        uint64_t frac = (x * m_invMaxThFx) >> 16;
+        p = m_curMaxPFx + (((FX_ONE - m_curMaxPFx) * frac) >> 32);
+      }
+      else if (!c.isGentle && m_avgFx >= m_maxThFx)
+      {
+        p = FX_ONE;
+      }
+      else
+      {
+        // (qAvg - minTh) / (maxTh - minTh), below 1 here
+        uint64_t x = avg16 > m_minTh16 ? avg16 - m_minTh16 : 0;
+        p = (x * m_invDiffFx) >> 16;
+
+        if (c.isNonlinear)
+        {
+          p = (((p * p) >> 32) * 3) >> 1;
+        }
+
+        p = ((p >> 1) * m_curMaxPFx) >> 31;
+      }
+
+      return p > FX_ONE ? FX_ONE : p;
+    }
+
+    /**
+     * \brief Fixed-point DropEarly: ModifyP and the random test, with the
+     * probability kept as the fraction num / den
+     * \param size packet size
+     * \param rng uniform [0, 1) generator
+     * \returns 0 for no drop/mark, 1 for drop
+     */
+    template <typename Rng>
+    uint32_t DropEarlyFixed(uint32_t size, Rng &rng)
+    {
+      const RedConfig &c = m_config;
+      uint64_t p = CalculatePNewFixed();
+      uint64_t count1 = c.isBytes ? m_countBytes / c.meanPktSize : m_count;
+      // count1 < 2^32 and p <= 2^32: no overflow
+      uint64_t cp = count1 * p;
+      uint64_t num = FX_ONE;
+      uint64_t den = FX_ONE;
+
+      if (c.isWait)
+      {
+        if (cp < FX_ONE)
+        {
+          num = 0;
+        }
+        else if (cp < 2 * FX_ONE)
+        {
+          num = p;
+          den = 2 * FX_ONE - cp;
+        }
+      }
+      else if (cp < FX_ONE)
+      {
+        num = p;
+        den = FX_ONE - cp;
+      }
+
+      if (c.isBytes && num < den)
+      {
+        num *= size;
+        den *= c.meanPktSize;
+      }
+      m_vProbNumFx = num;
+      m_vProbDenFx = den;
+
+      // on the device the generator yields the 32 bits directly
+      uint64_t u = static_cast<uint64_t>(std::ldexp(rng(), 32));
+      if (MulQ32(den, u) <= num)
+      {
+        // DROP or MARK
+        m_count = 0;
+        m_countBytes = 0;
+
+        return 1; // drop
+      }
+
+      return 0; // no drop/mark
+    }
+
+    RedConfig m_config; //!< Configuration, automatic settings applied
+
+    // ** Variables maintained by RED
+    double m_vA;             //!< 1.0 / (maxTh - minTh)
+    double m_vB;             //!< -minTh / (maxTh - minTh)
+    double m_vC;             //!< (1.0 - curMaxP) / maxTh - used in "gentle" mode
+    double m_vD;             //!< 2.0 * curMaxP - 1.0 - used in "gentle" mode
+    double m_curMaxP;        //!< Current max_p
+    int64_t m_lastSetNs;     //!< Last time curMaxP was updated
+    int64_t m_nextAdaptNs;   //!< Next Adapt event of AdaptUntil
+    double m_vProb;          //!< Prob. of packet drop
+    uint32_t m_countBytes;   //!< Number of bytes since last drop
+    uint32_t m_old;          //!< 0 when average queue first exceeds threshold
+    uint32_t m_idle;         //!< 0/1 idle status
+    double m_ptc;            //!< packet time constant in packets/second
+    double m_qAvg;           //!< Average queue length
+    double m_oneMinusQW;     //!< 1 - qW
+    uint32_t m_count;        //!< Number of packets since last random number generation
+    FengStatus m_fengStatus; //!< For use in Feng's Adaptive RED
+    int64_t m_idleTimeNs;    //!< Start of current idle period
+
+    // ** Fixed-point state: Q0.32 fractions, averages and thresholds * 2^(W + 16)
+    uint32_t m_wlog;          //!< W, the queue weight is 2^-W
+    uint64_t m_avgFx;         //!< Average queue length
+    uint64_t m_minThFx;       //!< minTh
+    uint64_t m_maxThFx;       //!< maxTh
+    uint64_t m_forcedThFx;    //!< Forced drop threshold
+    uint64_t m_minTh16;       //!< minTh in Q.16
+    uint64_t m_maxTh16;       //!< maxTh in Q.16
+    uint64_t m_invDiffFx;     //!< 2^48 / (maxTh - minTh in Q.16)
+    uint64_t m_invMaxThFx;    //!< 2^48 / (maxTh in Q.16)
+    uint64_t m_curMaxPFx;     //!< Current max_p
+    uint64_t m_aredLowFx;     //!< ARED lower target, minTh + part
+    uint64_t m_aredHighFx;    //!< ARED upper target, maxTh - part
+    uint64_t m_topFx;         //!< top
+    uint64_t m_bottomFx;      //!< bottom
+    uint64_t m_alphaFx;       //!< alpha
+    uint64_t m_betaFx;        //!< beta
+    uint64_t m_fengInvAFx;    //!< 1 / fengA
+    uint64_t m_fengBFx;       //!< fengB, Q32.32
+    uint64_t m_ptcFx;         //!< Packets per nanosecond
+    uint64_t m_oneMinusQWFx;  //!< 1 - 2^-W
+    uint64_t m_vProbNumFx;    //!< Prob. of packet drop, numerator
+    uint64_t m_vProbDenFx;    //!< Prob. of packet drop, denominator
+
+    // ** Variables maintained by RRED
+    int64_t m_t2Ns;                     //!< Arrival of the last packet dropped by RED
+    FlatFlowTable<RredFlow> m_rredFlows; //!< Per-flow indicators
+  };
+
+} // namespace ns3
+
+#endif // RED_ENGINE_H
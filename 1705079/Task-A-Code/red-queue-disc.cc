@@ -65,7 +65,7 @@
 #include "red-queue-disc.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/ipv4-queue-disc-item.h"
-#include "/home/shammo/L3T2/CSE322/NS3/ns-allinone-3.35/ns-3.35/src/internet/model/tcp-header.h"
+#include "ns3/ipv6-queue-disc-item.h"
 
 namespace ns3
 {
@@ -74,6 +74,20 @@ namespace ns3
 
   NS_OBJECT_ENSURE_REGISTERED(RedQueueDisc);
 
+  namespace
+  {
+    // Random numbers for the engine, from the queue disc stream
+    struct StreamRng
+    {
+      UniformRandomVariable *uv;
+
+      double operator()(void)
+      {
+        return uv->GetValue();
+      }
+    };
+  } // namespace
+
   TypeId RedQueueDisc::GetTypeId(void)
   {
     static TypeId tid = TypeId("ns3::RedQueueDisc")
@@ -120,6 +134,21 @@ namespace ns3
                                           BooleanValue(false),
                                           MakeBooleanAccessor(&RedQueueDisc::m_isNonlinear),
                                           MakeBooleanChecker())
+                            .AddAttribute("RRED",
+                                          "True to filter low-rate DoS flows with Robust RED before RED",
+                                          BooleanValue(true),
+                                          MakeBooleanAccessor(&RedQueueDisc::m_isRRED),
+                                          MakeBooleanChecker())
+                            .AddAttribute("RREDWindow",
+                                          "RRED T*: arrivals within this time after a drop are suspicious",
+                                          TimeValue(MilliSeconds(10)),
+                                          MakeTimeAccessor(&RedQueueDisc::m_rredWindow),
+                                          MakeTimeChecker())
+                            .AddAttribute("FixedPoint",
+                                          "True for the integer (fixed-point) RED control law of constrained routers",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&RedQueueDisc::m_isFixedPoint),
+                                          MakeBooleanChecker())
                             .AddAttribute("MinTh",
                                           "Minimum average length threshold in packets/bytes",
                                           DoubleValue(5),
@@ -152,7 +181,7 @@ namespace ns3
                                           MakeTimeAccessor(&RedQueueDisc::m_targetDelay),
                                           MakeTimeChecker())
                             .AddAttribute("Interval",
-                                          "Time interval to update m_curMaxP",
+                                          "Time interval to update m_curMaxP (ARED and Feng's adaptive RED)",
                                           TimeValue(Seconds(0.5)),
                                           MakeTimeAccessor(&RedQueueDisc::m_interval),
                                           MakeTimeChecker())
@@ -220,12 +249,22 @@ namespace ns3
                                           "True to always drop packets above max threshold",
                                           BooleanValue(true),
                                           MakeBooleanAccessor(&RedQueueDisc::m_useHardDrop),
+                                          MakeBooleanChecker())
+                            .AddAttribute("HeadDrop",
+                                          "True to drop the packet at the head of the queue instead of the arriving one",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&RedQueueDisc::m_isHeadDrop),
                                           MakeBooleanChecker());
 
     return tid;
   }
 
-  RedQueueDisc::RedQueueDisc() : QueueDisc(QueueDiscSizePolicy::SINGLE_INTERNAL_QUEUE)
+  RedQueueDisc::RedQueueDisc() : QueueDisc(QueueDiscSizePolicy::SINGLE_INTERNAL_QUEUE),
+                                 m_adaptPaused(false),
+                                 m_inBatch(false),
+                                 m_batchNow(0),
+                                 m_batchQueued(0),
+                                 m_batchNext(0)
   {
     NS_LOG_FUNCTION(this);
     m_uv = CreateObject<UniformRandomVariable>();
@@ -241,6 +280,7 @@ namespace ns3
   {
     NS_LOG_FUNCTION(this);
     m_uv = 0;
+    Simulator::Remove(m_adaptEvent);
     QueueDisc::DoDispose();
   }
 
@@ -329,6 +369,28 @@ namespace ns3
     m_maxTh = maxTh;
   }
 
+  double
+  RedQueueDisc::GetQueueAverage(void)
+  {
+    NS_LOG_FUNCTION(this);
+    if (m_adaptPaused)
+    {
+      CatchUpAdapt();
+    }
+    return m_engine.GetQueueAverageAt(Simulator::Now().GetNanoSeconds());
+  }
+
+  double
+  RedQueueDisc::GetCurMaxP(void)
+  {
+    NS_LOG_FUNCTION(this);
+    if (m_adaptPaused)
+    {
+      CatchUpAdapt();
+    }
+    return m_engine.GetCurMaxP();
+  }
+
   int64_t
   RedQueueDisc::AssignStreams(int64_t stream)
   {
@@ -337,159 +399,168 @@ namespace ns3
     return 1;
   }
 
-  bool RedQueueDisc::RREDCheck(Ptr<QueueDiscItem> item, Time &arrivalTime)
+  bool
+  RedQueueDisc::MakeFlowKey(Ptr<const QueueDiscItem> item, FlowKey &key)
   {
-    Ptr<Ipv4QueueDiscItem> ipItem = DynamicCast<Ipv4QueueDiscItem>(item);
-    Ipv4Header ipHeader = ipItem->GetHeader();
-    TcpHeader tcpHeader;
-    item->GetPacket()->PeekHeader(tcpHeader);
-
-    Flow flow;
-    flow.destAddress = ipHeader.GetDestination();
-    flow.destPort = tcpHeader.GetDestinationPort();
-    flow.srcAddress = ipHeader.GetSource();
-    flow.destPort = tcpHeader.GetSourcePort();
-    flow.protocol = ipHeader.GetProtocol();
-
-    int flowId = flowSimulator.getFlowId(flow);
-
-    if (flowId == -1)
-      flowSimulator.insertNewFlow(flow);
-
-    Tmax = std::max(flowSimulator.getT1(flowId), T2);
-    arrivalTime = Simulator::Now();
-
-    if (arrivalTime >= Tmax && arrivalTime <= (Tmax + Tstar))
-      flowSimulator.decrementIndicator(flowId);
-    else
-      flowSimulator.incrementIndicator(flowId);
-
-    if (flowSimulator.getIndicator(flowId) >= 0)
-      return true;
+    Ptr<const Ipv4QueueDiscItem> item4 = DynamicCast<const Ipv4QueueDiscItem>(item);
+    Ptr<const Ipv6QueueDiscItem> item6;
+    if (item4)
+    {
+      const Ipv4Header &header = item4->GetHeader();
+      key.family = 4;
+      key.protocol = header.GetProtocol();
+      header.GetSource().Serialize(key.srcAddress);
+      header.GetDestination().Serialize(key.dstAddress);
+    }
+    else if ((item6 = DynamicCast<const Ipv6QueueDiscItem>(item)))
+    {
+      const Ipv6Header &header = item6->GetHeader();
+      key.family = 6;
+      key.protocol = header.GetNextHeader();
+      header.GetSourceAddress().Serialize(key.srcAddress);
+      header.GetDestinationAddress().Serialize(key.dstAddress);
+    }
     else
     {
-      flowSimulator.setT1(flowId, arrivalTime);
       return false;
     }
 
-    // std::cout << "source port : " << srcPort << std::endl;
-    // std::cout << "destination port: " << destPort << std::endl;
+    // TCP and UDP both start with the source and destination ports
+    if (key.protocol == 6 || key.protocol == 17)
+    {
+      uint8_t ports[4];
+      if (item->GetPacket()->CopyData(ports, 4) == 4)
+      {
+        key.srcPort = static_cast<uint16_t>((ports[0] << 8) | ports[1]);
+        key.dstPort = static_cast<uint16_t>((ports[2] << 8) | ports[3]);
+      }
+    }
+    return true;
   }
 
-  bool RedQueueDisc::DoEnqueue(Ptr<QueueDiscItem> item)
+  uint32_t
+  RedQueueDisc::EnqueueBatch(const std::vector<Ptr<QueueDiscItem>> &items)
   {
-    NS_LOG_FUNCTION(this << item);
-    Time arrivalTime;
-    bool flag;
-     flag = RREDCheck(item, arrivalTime);
-    // for only RED 
-    //  flag = true;
-
-    // std ::string src = ipHeader.GetProtocol();
-    // std::cout << "source : " << ipHeader.GetSource() << std::endl;
-    // std::cout << "source port : " << srcPort << std::endl;
-    // std::cout << "destination : " << ipHeader.GetDestination() << std::endl;
-    // std::cout << "destination port: " << destPort << std::endl;
-    // std::cout << "protocol : " << ipHeader.GetProtocol() << std::endl;
-
-    uint32_t nQueued = GetInternalQueue(0)->GetCurrentSize().GetValue();
-
-    // simulate number of packets arrival during idle period
-    uint32_t m = 0;
-
-    if (m_idle == 1)
-    {
-      NS_LOG_DEBUG("RED Queue Disc is idle.");
-      Time now = Simulator::Now();
-
-      if (m_cautious == 3)
+    NS_LOG_FUNCTION(this << items.size());
+    std::size_t n = items.size();
+
+    // classify the whole batch before deciding on any item
+    m_batchKeys.resize(n);
+    m_batchHashes.resize(n);
+    m_batchHasKey.resize(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      m_batchKeys[i] = FlowKey();
+      m_batchHasKey[i] = m_isRRED && MakeFlowKey(items[i], m_batchKeys[i]);
+      if (m_batchHasKey[i])
       {
-        double ptc = m_ptc * m_meanPktSize / m_idlePktSize;
-        m = uint32_t(ptc * (now - m_idleTime).GetSeconds());
+        m_batchHashes[i] = m_batchKeys[i].Hash();
+        m_engine.PrefetchFlow(m_batchHashes[i]);
       }
-      else
+    }
+
+    m_inBatch = true;
+    m_batchNow = Simulator::Now().GetNanoSeconds();
+    m_batchQueued = GetInternalQueue(0)->GetCurrentSize().GetValue();
+    uint32_t nEnqueued = 0;
+    for (m_batchNext = 0; m_batchNext < n; ++m_batchNext)
+    {
+      // QueueDisc::Enqueue keeps the statistics and calls DoEnqueue
+      if (Enqueue(items[m_batchNext]))
       {
-        m = uint32_t(m_ptc * (now - m_idleTime).GetSeconds());
+        nEnqueued++;
       }
-
-      m_idle = 0;
     }
+    m_inBatch = false;
+    return nEnqueued;
+  }
 
-    m_qAvg = Estimator(nQueued, m + 1, m_qAvg, m_qW);
-
-    NS_LOG_DEBUG("\t bytesInQueue  " << GetInternalQueue(0)->GetNBytes() << "\tQavg " << m_qAvg);
-    NS_LOG_DEBUG("\t packetsInQueue  " << GetInternalQueue(0)->GetNPackets() << "\tQavg " << m_qAvg);
-
-    m_count++;
-    m_countBytes += item->GetSize();
+  bool
+  RedQueueDisc::DoEnqueue(Ptr<QueueDiscItem> item)
+  {
+    NS_LOG_FUNCTION(this << item);
 
-    uint32_t dropType = DTYPE_NONE;
-    if (m_qAvg >= m_minTh && nQueued > 1)
+    if (m_inBatch)
     {
-      if ((!m_isGentle && m_qAvg >= m_maxTh) ||
-          (m_isGentle && m_qAvg >= 2 * m_maxTh))
-      {
-        NS_LOG_DEBUG("adding DROP FORCED MARK");
-        dropType = DTYPE_FORCED;
-      }
-      else if (m_old == 0)
-      {
-        /*
-         * The average queue size has just crossed the
-         * threshold from below to above m_minTh, or
-         * from above m_minTh with an empty queue to
-         * above m_minTh with a nonempty queue.
-         */
-        m_count = 1;
-        m_countBytes = item->GetSize();
-        m_old = 1;
-      }
-      else if (DropEarly(item, nQueued))
+      std::size_t i = m_batchNext;
+      bool retval = EnqueueAt(item, m_batchNow, m_batchQueued, m_batchHasKey[i] ? &m_batchKeys[i] : 0,
+                              m_batchHashes[i]);
+      if (retval)
       {
-        NS_LOG_LOGIC("DropEarly returns 1");
-        dropType = DTYPE_UNFORCED;
+        m_batchQueued += GetMaxSize().GetUnit() == QueueSizeUnit::BYTES ? item->GetSize() : 1;
       }
+      return retval;
     }
-    else
+
+    // items that are neither IPv4 nor IPv6 bypass the RRED filter
+    FlowKey key;
+    bool hasKey = m_isRRED && MakeFlowKey(item, key);
+    return EnqueueAt(item, Simulator::Now().GetNanoSeconds(), GetInternalQueue(0)->GetCurrentSize().GetValue(),
+                     hasKey ? &key : 0, hasKey ? key.Hash() : 0);
+  }
+
+  bool
+  RedQueueDisc::EnqueueAt(Ptr<QueueDiscItem> item, int64_t now, uint32_t nQueued, const FlowKey *key, uint32_t hash)
+  {
+    if (m_adaptPaused)
     {
-      // No packets are being dropped
-      m_vProb = 0.0;
-      m_old = 0;
+      ResumeAdapt();
     }
+    StreamRng rng = {PeekPointer(m_uv)};
+    RedDecision d = m_engine.Decide(now, nQueued, item->GetSize(), key, hash, rng);
+
+    NS_LOG_DEBUG("\t bytesInQueue  " << GetInternalQueue(0)->GetNBytes() << "\tQavg " << m_engine.GetQueueAverage());
+    NS_LOG_DEBUG("\t packetsInQueue  " << GetInternalQueue(0)->GetNPackets() << "\tQavg " << m_engine.GetQueueAverage());
 
-    if (dropType == DTYPE_UNFORCED)
+    // a packet the RRED filter rejects is dropped at the tail anyway, so
+    // RED's drop falls on it rather than on a second packet
+    bool headDrop = m_isHeadDrop && !d.rredDrop;
+
+    if (d.dropType == DTYPE_UNFORCED)
     {
       if (!m_useEcn || !Mark(item, UNFORCED_MARK))
       {
-        NS_LOG_DEBUG("\t Dropping due to Prob Mark " << m_qAvg);
-        DropBeforeEnqueue(item, UNFORCED_DROP);
-        if (flag == true)
-          T2 = arrivalTime;
-        return false;
+        m_engine.Dropped(d, now);
+        if (!headDrop || !DropHead(UNFORCED_DROP))
+        {
+          NS_LOG_DEBUG("\t Dropping due to Prob Mark " << m_engine.GetQueueAverage());
+          DropBeforeEnqueue(item, UNFORCED_DROP);
+          return false;
+        }
+        NS_LOG_DEBUG("\t Dropping the head due to Prob Mark " << m_engine.GetQueueAverage());
+      }
+      else
+      {
+        NS_LOG_DEBUG("\t Marking due to Prob Mark " << m_engine.GetQueueAverage());
       }
-      NS_LOG_DEBUG("\t Marking due to Prob Mark " << m_qAvg);
     }
-    else if (dropType == DTYPE_FORCED)
+    else if (d.dropType == DTYPE_FORCED)
     {
       if (m_useHardDrop || !m_useEcn || !Mark(item, FORCED_MARK))
       {
-        NS_LOG_DEBUG("\t Dropping due to Hard Mark " << m_qAvg);
-        DropBeforeEnqueue(item, FORCED_DROP);
-        if (m_isNs1Compat)
+        m_engine.Dropped(d, now);
+        if (!headDrop || !DropHead(FORCED_DROP))
         {
-          m_count = 0;
-          m_countBytes = 0;
+          NS_LOG_DEBUG("\t Dropping due to Hard Mark " << m_engine.GetQueueAverage());
+          DropBeforeEnqueue(item, FORCED_DROP);
+          return false;
         }
-        if (flag == true)
-          T2 = arrivalTime;
-        return false;
+        NS_LOG_DEBUG("\t Dropping the head due to Hard Mark " << m_engine.GetQueueAverage());
+      }
+      else
+      {
+        NS_LOG_DEBUG("\t Marking due to Hard Mark " << m_engine.GetQueueAverage());
       }
-      NS_LOG_DEBUG("\t Marking due to Hard Mark " << m_qAvg);
     }
 
-    bool retval = false;
-    if (flag == true)
-      retval = GetInternalQueue(0)->Enqueue(item);
+    if (d.rredDrop)
+    {
+      NS_LOG_DEBUG("\t Dropping due to RRED detection");
+      DropBeforeEnqueue(item, RRED_DROP);
+      return false;
+    }
+
+    bool retval = GetInternalQueue(0)->Enqueue(item);
 
     // If Queue::Enqueue fails, QueueDisc::DropBeforeEnqueue is called by the
     // internal queue because QueueDisc::AddInternalQueue sets the trace callback
@@ -500,6 +571,24 @@ namespace ns3
     return retval;
   }
 
+  bool
+  RedQueueDisc::DropHead(const char *reason)
+  {
+    Ptr<QueueDiscItem> head = GetInternalQueue(0)->Dequeue();
+    if (!head)
+    {
+      return false;
+    }
+    // the signal reaches the flow this much earlier than a tail drop would
+    NS_LOG_LOGIC("Head dropped after " << (Simulator::Now() - head->GetTimeStamp()).GetSeconds() << "s in the queue");
+    if (m_inBatch)
+    {
+      m_batchQueued -= GetMaxSize().GetUnit() == QueueSizeUnit::BYTES ? head->GetSize() : 1;
+    }
+    DropAfterDequeue(head, reason);
+    return true;
+  }
+
   /*
    * Note: if the link bandwidth changes in the course of the
    * simulation, the bandwidth-dependent RED parameters do not change.
@@ -512,356 +601,103 @@ namespace ns3
     NS_LOG_FUNCTION(this);
     NS_LOG_INFO("Initializing RED params.");
 
-    m_cautious = 0;
-    m_ptc = m_linkBandwidth.GetBitRate() / (8.0 * m_meanPktSize);
-
-    if (m_isARED)
-    {
-      // Set m_minTh, m_maxTh and m_qW to zero for automatic setting
-      m_minTh = 0;
-      m_maxTh = 0;
-      m_qW = 0;
-
-      // Turn on m_isAdaptMaxP to adapt m_curMaxP
-      m_isAdaptMaxP = true;
-    }
-
-    if (m_isFengAdaptive)
-    {
-      // Initialize m_fengStatus
-      m_fengStatus = Above;
-    }
-
-    if (m_minTh == 0 && m_maxTh == 0)
-    {
-      m_minTh = 5.0;
-
-      // set m_minTh to max(m_minTh, targetqueue/2.0) [Ref: http://www.icir.org/floyd/papers/adaptiveRed.pdf]
-      double targetqueue = m_targetDelay.GetSeconds() * m_ptc;
-
-      if (m_minTh < targetqueue / 2.0)
-      {
-        m_minTh = targetqueue / 2.0;
-      }
-      if (GetMaxSize().GetUnit() == QueueSizeUnit::BYTES)
-      {
-        m_minTh = m_minTh * m_meanPktSize;
-      }
-
-      // set m_maxTh to three times m_minTh [Ref: http://www.icir.org/floyd/papers/adaptiveRed.pdf]
-      m_maxTh = 3 * m_minTh;
-    }
+    RedConfig config;
+    config.meanPktSize = m_meanPktSize;
+    config.idlePktSize = m_idlePktSize;
+    config.isWait = m_isWait;
+    config.isGentle = m_isGentle;
+    config.isARED = m_isARED;
+    config.isAdaptMaxP = m_isAdaptMaxP;
+    config.isFengAdaptive = m_isFengAdaptive;
+    config.isNonlinear = m_isNonlinear;
+    config.isRRED = m_isRRED;
+    config.isNs1Compat = m_isNs1Compat;
+    config.isBytes = GetMaxSize().GetUnit() == QueueSizeUnit::BYTES;
+    config.isFixedPoint = m_isFixedPoint;
+    config.minTh = m_minTh;
+    config.maxTh = m_maxTh;
+    config.qW = m_qW;
+    config.lInterm = m_lInterm;
+    config.top = m_top;
+    config.bottom = m_bottom;
+    config.alpha = m_alpha;
+    config.beta = m_beta;
+    config.fengA = m_a;
+    config.fengB = m_b;
+    config.linkBitRate = m_linkBandwidth.GetBitRate();
+    config.linkDelayNs = m_linkDelay.GetNanoSeconds();
+    config.targetDelayNs = m_targetDelay.GetNanoSeconds();
+    config.intervalNs = m_interval.GetNanoSeconds();
+    config.rttNs = m_rtt.GetNanoSeconds();
+    config.lastSetNs = m_lastSet.GetNanoSeconds();
+    config.rredWindowNs = m_rredWindow.GetNanoSeconds();
+    config.cautious = 0;
+    m_engine.Initialize(config);
+
+    // keep the attributes in line with the automatic settings
+    const RedConfig &c = m_engine.GetConfig();
+    m_isAdaptMaxP = c.isAdaptMaxP;
+    m_minTh = c.minTh;
+    m_maxTh = c.maxTh;
+    m_qW = c.qW;
+    m_bottom = c.bottom;
 
     NS_ASSERT(m_minTh <= m_maxTh);
-
-    m_qAvg = 0.0;
-    m_count = 0;
-    m_countBytes = 0;
-    m_old = 0;
-    m_idle = 1;
-
-    double th_diff = (m_maxTh - m_minTh);
-    if (th_diff == 0)
+    if (m_engine.IsAdaptive())
     {
-      th_diff = 1.0;
+      Simulator::Remove(m_adaptEvent);
+      m_adaptEvent = Simulator::Schedule(m_interval, &RedQueueDisc::Adapt, this);
+      m_nextAdapt = Simulator::Now() + m_interval;
+      m_adaptPaused = false;
     }
-    m_vA = 1.0 / th_diff;
-    m_curMaxP = 1.0 / m_lInterm;
-    m_vB = -m_minTh / th_diff;
-
-    if (m_isGentle)
+    if (m_isFixedPoint)
     {
-      m_vC = (1.0 - m_curMaxP) / m_maxTh;
-      m_vD = 2.0 * m_curMaxP - 1.0;
-    }
-    m_idleTime = NanoSeconds(0);
-
-    /*
-     * If m_qW=0, set it to a reasonable value of 1-exp(-1/C)
-     * This corresponds to choosing m_qW to be of that value for
-     * which the packet time constant -1/ln(1-m)qW) per default RTT
-     * of 100ms is an order of magnitude more than the link capacity, C.
-     *
-     * If m_qW=-1, then the queue weight is set to be a function of
-     * the bandwidth and the link propagation delay.  In particular,
-     * the default RTT is assumed to be three times the link delay and
-     * transmission delay, if this gives a default RTT greater than 100 ms.
-     *
-     * If m_qW=-2, set it to a reasonable value of 1-exp(-10/C).
-     */
-    if (m_qW == 0.0)
-    {
-      m_qW = 1.0 - std::exp(-1.0 / m_ptc);
-    }
-    else if (m_qW == -1.0)
-    {
-      double rtt = 3.0 * (m_linkDelay.GetSeconds() + 1.0 / m_ptc);
-
-      if (rtt < 0.1)
-      {
-        rtt = 0.1;
-      }
-      m_qW = 1.0 - std::exp(-1.0 / (10 * rtt * m_ptc));
-    }
-    else if (m_qW == -2.0)
-    {
-      m_qW = 1.0 - std::exp(-10.0 / m_ptc);
-    }
-
-    if (m_bottom == 0)
-    {
-      m_bottom = 0.01;
-      // Set bottom to at most 1/W, where W is the delay-bandwidth
-      // product in packets for a connection.
-      // So W = m_linkBandwidth.GetBitRate () / (8.0 * m_meanPktSize * m_rtt.GetSeconds())
-      double bottom1 = (8.0 * m_meanPktSize * m_rtt.GetSeconds()) / m_linkBandwidth.GetBitRate();
-      if (bottom1 < m_bottom)
-      {
-        m_bottom = bottom1;
-      }
+      NS_LOG_INFO("Fixed-point RED: queue weight rounded to 2^-" << m_engine.GetWeightShift());
     }
 
     NS_LOG_DEBUG("\tm_delay " << m_linkDelay.GetSeconds() << "; m_isWait "
-                              << m_isWait << "; m_qW " << m_qW << "; m_ptc " << m_ptc
+                              << m_isWait << "; m_qW " << m_qW
                               << "; m_minTh " << m_minTh << "; m_maxTh " << m_maxTh
-                              << "; m_isGentle " << m_isGentle << "; th_diff " << th_diff
-                              << "; lInterm " << m_lInterm << "; va " << m_vA << "; cur_max_p "
-                              << m_curMaxP << "; v_b " << m_vB << "; m_vC "
-                              << m_vC << "; m_vD " << m_vD);
+                              << "; m_isGentle " << m_isGentle
+                              << "; lInterm " << m_lInterm << "; cur_max_p "
+                              << m_engine.GetCurMaxP() << "; m_isFixedPoint " << m_isFixedPoint);
   }
 
-  // Updating m_curMaxP, following the pseudocode
-  // from: A Self-Configuring RED Gateway, INFOCOMM '99.
-  // They recommend m_a = 3, and m_b = 2.
   void
-  RedQueueDisc::UpdateMaxPFeng(double newAve)
+  RedQueueDisc::Adapt(void)
   {
-    NS_LOG_FUNCTION(this << newAve);
-
-    if (m_minTh < newAve && newAve < m_maxTh)
-    {
-      m_fengStatus = Between;
-    }
-    else if (newAve < m_minTh && m_fengStatus != Below)
-    {
-      m_fengStatus = Below;
-      m_curMaxP = m_curMaxP / m_a;
-    }
-    else if (newAve > m_maxTh && m_fengStatus != Above)
+    NS_LOG_FUNCTION(this);
+    m_engine.Adapt(Simulator::Now().GetNanoSeconds());
+    NS_LOG_DEBUG("\tQavg " << m_engine.GetQueueAverage() << "; cur_max_p " << m_engine.GetCurMaxP());
+    m_nextAdapt = Simulator::Now() + m_interval;
+    if (GetInternalQueue(0)->IsEmpty())
     {
-      m_fengStatus = Above;
-      m_curMaxP = m_curMaxP * m_b;
+      NS_LOG_LOGIC("Queue empty, adaptation waits for an arrival");
+      m_adaptPaused = true;
+      return;
     }
+    m_adaptEvent = Simulator::Schedule(m_interval, &RedQueueDisc::Adapt, this);
   }
 
-  // Update m_curMaxP to keep the average queue length within the target range.
   void
-  RedQueueDisc::UpdateMaxP(double newAve)
+  RedQueueDisc::CatchUpAdapt(void)
   {
-    NS_LOG_FUNCTION(this << newAve);
-
-    Time now = Simulator::Now();
-    double m_part = 0.4 * (m_maxTh - m_minTh);
-    // AIMD rule to keep target Q~1/2(m_minTh + m_maxTh)
-    if (newAve < m_minTh + m_part && m_curMaxP > m_bottom)
-    {
-      // we should increase the average queue size, so decrease m_curMaxP
-      m_curMaxP = m_curMaxP * m_beta;
-      m_lastSet = now;
-    }
-    else if (newAve > m_maxTh - m_part && m_top > m_curMaxP)
-    {
-      // we should decrease the average queue size, so increase m_curMaxP
-      double alpha = m_alpha;
-      if (alpha > 0.25 * m_curMaxP)
-      {
-        alpha = 0.25 * m_curMaxP;
-      }
-      m_curMaxP = m_curMaxP + alpha;
-      m_lastSet = now;
-    }
-  }
-
-  // Compute the average queue size
-  double
-  RedQueueDisc::Estimator(uint32_t nQueued, uint32_t m, double qAvg, double qW)
-  {
-    NS_LOG_FUNCTION(this << nQueued << m << qAvg << qW);
-
-    double newAve = qAvg * std::pow(1.0 - qW, m);
-    newAve += qW * nQueued;
-
+    NS_LOG_FUNCTION(this);
     Time now = Simulator::Now();
-    if (m_isAdaptMaxP && now > m_lastSet + m_interval)
-    {
-      UpdateMaxP(newAve);
-    }
-    else if (m_isFengAdaptive)
+    while (m_nextAdapt <= now)
     {
-      UpdateMaxPFeng(newAve); // Update m_curMaxP in MIMD fashion.
+      m_engine.Adapt(m_nextAdapt.GetNanoSeconds());
+      m_nextAdapt += m_interval;
     }
-
-    return newAve;
   }
 
-  // Check if packet p needs to be dropped due to probability mark
-  uint32_t
-  RedQueueDisc::DropEarly(Ptr<QueueDiscItem> item, uint32_t qSize)
-  {
-    NS_LOG_FUNCTION(this << item << qSize);
-
-    double prob1 = CalculatePNew();
-    m_vProb = ModifyP(prob1, item->GetSize());
-
-    // Drop probability is computed, pick random number and act
-    if (m_cautious == 1)
-    {
-      /*
-       * Don't drop/mark if the instantaneous queue is much below the average.
-       * For experimental purposes only.
-       * pkts: the number of packets arriving in 50 ms
-       */
-      double pkts = m_ptc * 0.05;
-      double fraction = std::pow((1 - m_qW), pkts);
-
-      if ((double)qSize < fraction * m_qAvg)
-      {
-        // Queue could have been empty for 0.05 seconds
-        return 0;
-      }
-    }
-
-    double u = m_uv->GetValue();
-
-    if (m_cautious == 2)
-    {
-      /*
-       * Decrease the drop probability if the instantaneous
-       * queue is much below the average.
-       * For experimental purposes only.
-       * pkts: the number of packets arriving in 50 ms
-       */
-      double pkts = m_ptc * 0.05;
-      double fraction = std::pow((1 - m_qW), pkts);
-      double ratio = qSize / (fraction * m_qAvg);
-
-      if (ratio < 1.0)
-      {
-        u *= 1.0 / ratio;
-      }
-    }
-
-    if (u <= m_vProb)
-    {
-      NS_LOG_LOGIC("u <= m_vProb; u " << u << "; m_vProb " << m_vProb);
-
-      // DROP or MARK
-      m_count = 0;
-      m_countBytes = 0;
-      /// \todo Implement set bit to mark
-
-      return 1; // drop
-    }
-
-    return 0; // no drop/mark
-  }
-
-  // Returns a probability using these function parameters for the DropEarly function
-  double
-  RedQueueDisc::CalculatePNew(void)
+  void
+  RedQueueDisc::ResumeAdapt(void)
   {
     NS_LOG_FUNCTION(this);
-    double p;
-
-    if (m_isGentle && m_qAvg >= m_maxTh)
-    {
-      // p ranges from m_curMaxP to 1 as the average queue
-      // size ranges from m_maxTh to twice m_maxTh
-      p = m_vC * m_qAvg + m_vD;
-    }
-    else if (!m_isGentle && m_qAvg >= m_maxTh)
-    {
-      /*
-       * OLD: p continues to range linearly above m_curMaxP as
-       * the average queue size ranges above m_maxTh.
-       * NEW: p is set to 1.0
-       */
-      p = 1.0;
-    }
-    else
-    {
-      /*
-       * p ranges from 0 to m_curMaxP as the average queue size ranges from
-       * m_minTh to m_maxTh
-       */
-      p = m_vA * m_qAvg + m_vB;
-
-      if (m_isNonlinear)
-      {
-        p *= p * 1.5;
-      }
-
-      p *= m_curMaxP;
-    }
-
-    if (p > 1.0)
-    {
-      p = 1.0;
-    }
-
-    return p;
-  }
-
-  // Returns a probability using these function parameters for the DropEarly function
-  double
-  RedQueueDisc::ModifyP(double p, uint32_t size)
-  {
-    NS_LOG_FUNCTION(this << p << size);
-    double count1 = (double)m_count;
-
-    if (GetMaxSize().GetUnit() == QueueSizeUnit::BYTES)
-    {
-      count1 = (double)(m_countBytes / m_meanPktSize);
-    }
-
-    if (m_isWait)
-    {
-      if (count1 * p < 1.0)
-      {
-        p = 0.0;
-      }
-      else if (count1 * p < 2.0)
-      {
-        p /= (2.0 - count1 * p);
-      }
-      else
-      {
-        p = 1.0;
-      }
-    }
-    else
-    {
-      if (count1 * p < 1.0)
-      {
-        p /= (1.0 - count1 * p);
-      }
-      else
-      {
-        p = 1.0;
-      }
-    }
-
-    if ((GetMaxSize().GetUnit() == QueueSizeUnit::BYTES) && (p < 1.0))
-    {
-      p = (p * size) / m_meanPktSize;
-    }
-
-    if (p > 1.0)
-    {
-      p = 1.0;
-    }
-
-    return p;
+    CatchUpAdapt();
+    m_adaptPaused = false;
+    m_adaptEvent = Simulator::Schedule(m_nextAdapt - Simulator::Now(), &RedQueueDisc::Adapt, this);
   }
 
   Ptr<QueueDiscItem>
@@ -872,14 +708,13 @@ namespace ns3
     if (GetInternalQueue(0)->IsEmpty())
     {
       NS_LOG_LOGIC("Queue empty");
-      m_idle = 1;
-      m_idleTime = Simulator::Now();
+      m_engine.SetIdle(Simulator::Now().GetNanoSeconds());
 
       return 0;
     }
     else
     {
-      m_idle = 0;
+      m_engine.SetBusy();
       Ptr<QueueDiscItem> item = GetInternalQueue(0)->Dequeue();
 
       NS_LOG_LOGIC("Popped " << item);
@@ -942,6 +777,12 @@ namespace ns3
       NS_LOG_ERROR("m_isAdaptMaxP and m_isFengAdaptive cannot be simultaneously true");
     }
 
+    if ((m_isARED || m_isAdaptMaxP || m_isFengAdaptive) && !m_interval.IsStrictlyPositive())
+    {
+      NS_LOG_ERROR("Adapting m_curMaxP needs a positive Interval");
+      return false;
+    }
+
     return true;
   }
 
@@ -66,7 +66,10 @@
 #include "ns3/boolean.h"
 #include "ns3/data-rate.h"
 #include "ns3/random-variable-stream.h"
-#include "/home/shammo/L3T2/CSE322/NS3/ns-allinone-3.35/ns-3.35/src/traffic-control/model/flow-simulator.cc"
+#include "ns3/event-id.h"
+#include "red-engine.h"
+
+#include <vector>
 
 namespace ns3
 {
@@ -77,6 +80,25 @@ namespace ns3
    * \ingroup traffic-control
    *
    * \brief A RED packet queue disc
+   *
+   * The drop decisions are made by a RedEngine; this class maps the
+   * attributes to a RedConfig, builds the RRED flow key of each item and
+   * turns the engine decisions into drops and marks.
+   *
+   * With HeadDrop, a drop decided on an arrival removes the oldest
+   * packet instead (DropAfterDequeue) and the arrival is enqueued, so the
+   * flow that loses a packet learns it a queue delay earlier.  The
+   * decision itself, RRED's last drop time T2 (the arrival that
+   * triggered the drop) and marking are unchanged; an arrival the RRED
+   * filter rejects takes RED's drop itself.
+   *
+   * With ARED or Feng's adaptive RED, max_p is adapted by an event every
+   * Interval, whether packets arrive or not; enqueues only read it.  The
+   * event is not rescheduled once it finds the queue empty, so that the
+   * simulator can run out of events; the next arrival, and
+   * GetQueueAverage and GetCurMaxP, first run the adaptations missed
+   * meanwhile, each at its own time.  The results are those of an event
+   * that kept running through the idle period.
    */
   class RedQueueDisc : public QueueDisc
   {
@@ -100,24 +122,14 @@ namespace ns3
      */
     virtual ~RedQueueDisc();
 
-    /**
-     * \brief Used in Feng's Adaptive RED
-     */
-    enum FengStatus
-    {
-      Above,   //!< When m_qAvg > m_maxTh
-      Between, //!< When m_maxTh < m_qAvg < m_minTh
-      Below,   //!< When m_qAvg < m_minTh
-    };
-
     /**
      * \brief Drop types
      */
     enum
     {
-      DTYPE_NONE,     //!< Ok, no drop
-      DTYPE_FORCED,   //!< A "forced" drop
-      DTYPE_UNFORCED, //!< An "unforced" (random) drop
+      DTYPE_NONE = RedEngine::DTYPE_NONE,         //!< Ok, no drop
+      DTYPE_FORCED = RedEngine::DTYPE_FORCED,     //!< A "forced" drop
+      DTYPE_UNFORCED = RedEngine::DTYPE_UNFORCED, //!< An "unforced" (random) drop
     };
 
     /**
@@ -184,6 +196,24 @@ namespace ns3
      */
     void SetTh(double minTh, double maxTh);
 
+    /**
+     * \brief Get the average queue size.
+     *
+     * While the queue is idle the average is aged to the current time,
+     * as the next arrival will age it, and the adaptations of max_p due
+     * by now are run first.
+     *
+     * \returns The average queue size (m_qAvg) in bytes or packets
+     */
+    double GetQueueAverage(void);
+
+    /**
+     * \brief Get the current max_p, after the adaptations due by now
+     *
+     * \returns The current max_p
+     */
+    double GetCurMaxP(void);
+
     /**
      * Assign a fixed random variable stream number to the random variables
      * used by this model.  Return the number of streams (possibly zero) that
@@ -194,9 +224,29 @@ namespace ns3
      */
     int64_t AssignStreams(int64_t stream);
 
+    /**
+     * \brief Enqueue items that arrive at the same time
+     *
+     * The decisions, drops, marks, traces and statistics are those of
+     * calling Enqueue on each item in order.  Each decision still updates
+     * the average with the queue length the previous one left, so the RED
+     * arithmetic is not batched.  What is amortized is the classification:
+     * the flow keys and hashes of the whole batch are computed first and
+     * their RRED flow table slots prefetched, so that the cache misses of
+     * the lookups overlap; the clock and the internal queue length are
+     * read once per batch.  The gain is expected only with RRED and a flow
+     * table that does not fit in cache; compare
+     * 1705079_red_microbench --batch=N with --batch=1.
+     *
+     * \param items the items, in arrival order
+     * \returns the number of items enqueued
+     */
+    uint32_t EnqueueBatch(const std::vector<Ptr<QueueDiscItem>> &items);
+
     // Reasons for dropping packets
     static constexpr const char *UNFORCED_DROP = "Unforced drop"; //!< Early probability drops
     static constexpr const char *FORCED_DROP = "Forced drop";     //!< Forced drops, m_qAvg > m_maxTh
+    static constexpr const char *RRED_DROP = "RRED drop";         //!< Packets of flows flagged by RRED
     // Reasons for marking packets
     static constexpr const char *UNFORCED_MARK = "Unforced mark"; //!< Early probability marks
     static constexpr const char *FORCED_MARK = "Forced mark";     //!< Forced marks, m_qAvg > m_maxTh
@@ -223,43 +273,46 @@ namespace ns3
      */
     virtual void InitializeParams(void);
     /**
-     * \brief Compute the average queue size
-     * \param nQueued number of queued packets
-     * \param m simulated number of packets arrival during idle period
-     * \param qAvg average queue size
-     * \param qW queue weight given to cur q size sample
-     * \returns new average queue size
+     * \brief Build the RRED flow key of an item
+     * \param item queue item
+     * \param key the key
+     * \returns false if the item is neither IPv4 nor IPv6
      */
-    double Estimator(uint32_t nQueued, uint32_t m, double qAvg, double qW);
+    static bool MakeFlowKey(Ptr<const QueueDiscItem> item, FlowKey &key);
     /**
-     * \brief Update m_curMaxP
-     * \param newAve new average queue length
+     * \brief Decide on an item and enqueue it or drop it
+     * \param item queue item
+     * \param now arrival time in nanoseconds
+     * \param nQueued current queue length, in packets or bytes
+     * \param key flow of the item, or 0 to bypass the RRED filter
+     * \param hash key->Hash (), ignored without a key
+     * \returns true if the item was enqueued
      */
-    void UpdateMaxP(double newAve);
+    bool EnqueueAt(Ptr<QueueDiscItem> item, int64_t now, uint32_t nQueued, const FlowKey *key, uint32_t hash);
     /**
-     * \brief Update m_curMaxP based on Feng's Adaptive RED
-     * \param newAve new average queue length
+     * \brief Drop the packet at the head of the internal queue, in
+     * HeadDrop mode
+     *
+     * The packet goes out through DropAfterDequeue, so the Drop trace and
+     * the statistics (by reason) name the flow that loses it.
+     *
+     * \param reason the drop reason
+     * \returns false if the queue is empty
      */
-    void UpdateMaxPFeng(double newAve);
+    bool DropHead(const char *reason);
     /**
-     * \brief Check if a packet needs to be dropped due to probability mark
-     * \param item queue item
-     * \param qSize queue size
-     * \returns 0 for no drop/mark, 1 for drop
+     * \brief Periodic adaptation of max_p, see RedEngine::Adapt
      */
-    uint32_t DropEarly(Ptr<QueueDiscItem> item, uint32_t qSize);
+    void Adapt(void);
     /**
-     * \brief Returns a probability using these function parameters for the DropEarly function
-     * \returns Prob. of packet drop before "count"
+     * \brief Run the adaptations missed while the event was paused, up to now
      */
-    double CalculatePNew(void);
+    void CatchUpAdapt(void);
     /**
-     * \brief Returns a probability using these function parameters for the DropEarly function
-     * \param p Prob. of packet drop before "count"
-     * \param size packet size
-     * \returns Prob. of packet drop
+     * \brief Run the adaptations missed while the queue was empty and
+     * restart the periodic event
      */
-    double ModifyP(double p, uint32_t size);
+    void ResumeAdapt(void);
 
     // ** Variables supplied by user
     uint32_t m_meanPktSize;   //!< Avg pkt size
@@ -281,6 +334,7 @@ namespace ns3
     Time m_rtt;               //!< Rtt to be considered while automatically setting m_bottom in ARED
     bool m_isFengAdaptive;    //!< True to enable Feng's Adaptive RED
     bool m_isNonlinear;       //!< True to enable Nonlinear RED
+    bool m_isRRED;            //!< True to enable the RRED filter
     double m_b;               //!< Increment parameter for m_curMaxP in Feng's Adaptive RED
     double m_a;               //!< Decrement parameter for m_curMaxP in Feng's Adaptive RED
     bool m_isNs1Compat;       //!< Ns-1 compatibility
@@ -288,42 +342,25 @@ namespace ns3
     Time m_linkDelay;         //!< Link delay
     bool m_useEcn;            //!< True if ECN is used (packets are marked instead of being dropped)
     bool m_useHardDrop;       //!< True if packets are always dropped above max threshold
+    Time m_lastSet;           //!< Initial time of the last m_curMaxP update
+    Time m_rredWindow;        //!< RRED T*, window after a drop in which arrivals are suspicious
+    bool m_isFixedPoint;      //!< True for the integer control law of RedEngine
+    bool m_isHeadDrop;        //!< True to drop at the head of the queue instead of the tail
 
-    // ** Variables maintained by RED
-    double m_vA;             //!< 1.0 / (m_maxTh - m_minTh)
-    double m_vB;             //!< -m_minTh / (m_maxTh - m_minTh)
-    double m_vC;             //!< (1.0 - m_curMaxP) / m_maxTh - used in "gentle" mode
-    double m_vD;             //!< 2.0 * m_curMaxP - 1.0 - used in "gentle" mode
-    double m_curMaxP;        //!< Current max_p
-    Time m_lastSet;          //!< Last time m_curMaxP was updated
-    double m_vProb;          //!< Prob. of packet drop
-    uint32_t m_countBytes;   //!< Number of bytes since last drop
-    uint32_t m_old;          //!< 0 when average queue first exceeds threshold
-    uint32_t m_idle;         //!< 0/1 idle status
-    double m_ptc;            //!< packet time constant in packets/second
-    double m_qAvg;           //!< Average queue length
-    uint32_t m_count;        //!< Number of packets since last random number generation
-    FengStatus m_fengStatus; //!< For use in Feng's Adaptive RED
-
-    /**
-     * 0 for default RED
-     * 1 experimental (see red-queue-disc.cc)
-     * 2 experimental (see red-queue-disc.cc)
-     * 3 use Idle packet size in the ptc
-     */
-    uint32_t m_cautious;
-    Time m_idleTime; //!< Start of current idle period
-
+    RedEngine m_engine;              //!< Decisions and RED state
     Ptr<UniformRandomVariable> m_uv; //!< rng stream
+    EventId m_adaptEvent;            //!< Next adaptation of max_p
+    Time m_nextAdapt;                //!< Time of the next adaptation
+    bool m_adaptPaused;              //!< True while the event waits for an arrival
 
-    // new variables added by Shammo
-    FlowSimulator flowSimulator;
-    Time T2;
-    Time Tmax;
-    Time Tstar = Time("10ms");
-
-    // function
-    bool RREDCheck(Ptr<QueueDiscItem>, Time &);
+    // ** Batch in progress, see EnqueueBatch
+    bool m_inBatch;                      //!< True while EnqueueBatch runs
+    int64_t m_batchNow;                  //!< Arrival time of the batch
+    uint32_t m_batchQueued;              //!< Queue length, packets or bytes
+    std::size_t m_batchNext;             //!< Index of the next item
+    std::vector<FlowKey> m_batchKeys;    //!< Flow keys of the batch
+    std::vector<uint32_t> m_batchHashes; //!< Their hashes
+    std::vector<uint8_t> m_batchHasKey;  //!< False for items that bypass RRED
   };
 
 }; // namespace ns3
@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RED_VARIANT_H
+#define RED_VARIANT_H
+
+#include "ns3/abort.h"
+#include "ns3/boolean.h"
+#include "ns3/object-factory.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+  /**
+   * \ingroup traffic-control
+   *
+   * \brief A named RedQueueDisc configuration: red, ared, feng, nlred or
+   * rred
+   *
+   * Only the mode attributes are set; thresholds and link parameters are
+   * left to the defaults, so that every variant of a benchmark sees the
+   * same configuration otherwise.
+   */
+  struct RedVariant
+  {
+    std::string name; //!< Variant name
+    bool ared;        //!< ARED attribute
+    bool feng;        //!< FengAdaptive attribute
+    bool nlred;       //!< NLRED attribute
+    bool rred;        //!< RRED attribute
+
+    /**
+     * \param name red, ared, feng, nlred or rred
+     * \returns the variant
+     */
+    static RedVariant Parse(const std::string &name)
+    {
+      RedVariant v = {name, false, false, false, false};
+      if (name == "ared")
+      {
+        v.ared = true;
+      }
+      else if (name == "feng")
+      {
+        v.feng = true;
+      }
+      else if (name == "nlred")
+      {
+        v.nlred = true;
+      }
+      else if (name == "rred")
+      {
+        v.rred = true;
+      }
+      else if (name != "red")
+      {
+        NS_FATAL_ERROR("Unknown RED variant " << name << " (use red, ared, feng, nlred or rred)");
+      }
+      return v;
+    }
+
+    /**
+     * \param list comma separated variant names
+     * \returns the variants
+     */
+    static std::vector<RedVariant> ParseList(const std::string &list)
+    {
+      std::vector<RedVariant> variants;
+      std::istringstream is(list);
+      std::string name;
+      while (std::getline(is, name, ','))
+      {
+        if (!name.empty())
+        {
+          variants.push_back(Parse(name));
+        }
+      }
+      return variants;
+    }
+
+    /**
+     * \brief Set the mode attributes on a RedQueueDisc factory
+     * \param factory the factory
+     */
+    void Apply(ObjectFactory &factory) const
+    {
+      factory.Set("ARED", BooleanValue(ared));
+      factory.Set("FengAdaptive", BooleanValue(feng));
+      factory.Set("NLRED", BooleanValue(nlred));
+      factory.Set("RRED", BooleanValue(rred));
+    }
+  };
+
+} // namespace ns3
+
+#endif // RED_VARIANT_H
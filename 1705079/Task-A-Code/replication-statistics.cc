@@ -0,0 +1,220 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "replication-statistics.h"
+
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+
+namespace ns3
+{
+
+  namespace
+  {
+    /**
+     * Continued fraction of the regularized incomplete beta function
+     * (modified Lentz), valid for x < (a + 1) / (a + b + 2)
+     */
+    double
+    BetaContinuedFraction(double a, double b, double x)
+    {
+      const double tiny = 1e-300;
+      double c = 1;
+      double d = 1 - (a + b) * x / (a + 1);
+      d = 1 / (std::fabs(d) < tiny ? tiny : d);
+      double h = d;
+      for (int m = 1; m <= 300; ++m)
+      {
+        double aa = m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m));
+        d = 1 + aa * d;
+        d = 1 / (std::fabs(d) < tiny ? tiny : d);
+        c = 1 + aa / c;
+        c = std::fabs(c) < tiny ? tiny : c;
+        h *= d * c;
+        aa = -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1));
+        d = 1 + aa * d;
+        d = 1 / (std::fabs(d) < tiny ? tiny : d);
+        c = 1 + aa / c;
+        c = std::fabs(c) < tiny ? tiny : c;
+        double delta = d * c;
+        h *= delta;
+        if (std::fabs(delta - 1) < 1e-14)
+        {
+          break;
+        }
+      }
+      return h;
+    }
+
+    /**
+     * Regularized incomplete beta function I_x (a, b)
+     */
+    double
+    IncompleteBeta(double a, double b, double x)
+    {
+      if (x <= 0)
+      {
+        return 0;
+      }
+      if (x >= 1)
+      {
+        return 1;
+      }
+      double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) +
+                              b * std::log(1 - x));
+      if (x < (a + 1) / (a + b + 2))
+      {
+        return front * BetaContinuedFraction(a, b, x) / a;
+      }
+      return 1 - front * BetaContinuedFraction(b, a, 1 - x) / b;
+    }
+
+    /**
+     * Student t cumulative distribution function
+     */
+    double
+    StudentCdf(double t, double df)
+    {
+      double tail = 0.5 * IncompleteBeta(df / 2, 0.5, df / (df + t * t));
+      return t >= 0 ? 1 - tail : tail;
+    }
+  } // namespace
+
+  RunningStatistic::RunningStatistic()
+      : m_n(0),
+        m_mean(0),
+        m_m2(0)
+  {
+  }
+
+  void
+  RunningStatistic::Add(double x)
+  {
+    ++m_n;
+    double delta = x - m_mean;
+    m_mean += delta / m_n;
+    m_m2 += delta * (x - m_mean);
+  }
+
+  uint32_t
+  RunningStatistic::GetCount(void) const
+  {
+    return m_n;
+  }
+
+  double
+  RunningStatistic::GetMean(void) const
+  {
+    return m_mean;
+  }
+
+  double
+  RunningStatistic::GetVariance(void) const
+  {
+    return m_n > 1 ? m_m2 / (m_n - 1) : 0;
+  }
+
+  double
+  RunningStatistic::GetHalfWidth(double level) const
+  {
+    if (m_n < 2)
+    {
+      return std::numeric_limits<double>::infinity();
+    }
+    double t = ReplicationStatistics::StudentQuantile(0.5 + level / 2, m_n - 1);
+    return t * std::sqrt(GetVariance() / m_n);
+  }
+
+  ReplicationStatistics::ReplicationStatistics(double level, double relativePrecision, uint32_t minReplications)
+      : m_level(level),
+        m_relativePrecision(relativePrecision),
+        m_minReplications(minReplications < 2 ? 2 : minReplications)
+  {
+  }
+
+  void
+  ReplicationStatistics::Add(const std::string &name, double x)
+  {
+    for (std::size_t i = 0; i < m_names.size(); ++i)
+    {
+      if (m_names[i] == name)
+      {
+        m_statistics[i].Add(x);
+        return;
+      }
+    }
+    m_names.push_back(name);
+    m_statistics.push_back(RunningStatistic());
+    m_statistics.back().Add(x);
+  }
+
+  bool
+  ReplicationStatistics::IsPreciseEnough(void) const
+  {
+    if (m_statistics.empty())
+    {
+      return false;
+    }
+    for (const RunningStatistic &s : m_statistics)
+    {
+      if (s.GetCount() < m_minReplications ||
+          s.GetHalfWidth(m_level) > m_relativePrecision * std::fabs(s.GetMean()))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void
+  ReplicationStatistics::Print(std::ostream &os) const
+  {
+    os << std::left << std::setw(24) << "metric" << std::right << std::setw(6) << "n" << std::setw(16)
+       << "mean" << std::setw(16) << "+/-" << std::setw(12) << "relative" << std::endl;
+    for (std::size_t i = 0; i < m_names.size(); ++i)
+    {
+      const RunningStatistic &s = m_statistics[i];
+      double hw = s.GetHalfWidth(m_level);
+      os << std::left << std::setw(24) << m_names[i] << std::right << std::setw(6) << s.GetCount()
+         << std::setw(16) << s.GetMean() << std::setw(16) << hw << std::setw(12)
+         << (s.GetMean() != 0 ? hw / std::fabs(s.GetMean()) : 0) << std::endl;
+    }
+  }
+
+  double
+  ReplicationStatistics::StudentQuantile(double p, double df)
+  {
+    // bisection on the cdf; the quantile of interest is far below 1e6
+    double lo = -1e6;
+    double hi = 1e6;
+    for (int i = 0; i < 200 && hi - lo > 1e-12 * (1 + std::fabs(lo)); ++i)
+    {
+      double mid = 0.5 * (lo + hi);
+      if (StudentCdf(mid, df) < p)
+      {
+        lo = mid;
+      }
+      else
+      {
+        hi = mid;
+      }
+    }
+    return 0.5 * (lo + hi);
+  }
+
+} // namespace ns3
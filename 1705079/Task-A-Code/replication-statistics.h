@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef REPLICATION_STATISTICS_H
+#define REPLICATION_STATISTICS_H
+
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+  /**
+   * \ingroup core
+   *
+   * \brief Running mean and variance of one metric across replications,
+   * with a Student t confidence interval
+   *
+   * Uses Welford's update, so samples are not stored.
+   */
+  class RunningStatistic
+  {
+  public:
+    RunningStatistic();
+
+    /**
+     * \brief Add a sample
+     * \param x the sample
+     */
+    void Add(double x);
+
+    /**
+     * \returns the number of samples
+     */
+    uint32_t GetCount(void) const;
+    /**
+     * \returns the sample mean
+     */
+    double GetMean(void) const;
+    /**
+     * \returns the unbiased sample variance (0 with fewer than 2 samples)
+     */
+    double GetVariance(void) const;
+
+    /**
+     * \brief Half-width of the confidence interval of the mean
+     * \param level confidence level, e.g. 0.95
+     * \returns the half-width, infinite with fewer than 2 samples
+     */
+    double GetHalfWidth(double level) const;
+
+  private:
+    uint32_t m_n;  //!< Samples
+    double m_mean; //!< Mean
+    double m_m2;   //!< Sum of squared deviations from the mean
+  };
+
+  /**
+   * \ingroup core
+   *
+   * \brief Named metrics of a replicated experiment and the stopping rule
+   *
+   * The experiment may stop once every metric has at least the minimum
+   * number of samples and a confidence interval whose half-width is at
+   * most the target precision times the absolute mean.
+   */
+  class ReplicationStatistics
+  {
+  public:
+    /**
+     * \brief Constructor
+     * \param level confidence level, e.g. 0.95
+     * \param relativePrecision target half-width relative to the mean
+     * \param minReplications replications before the rule is checked
+     */
+    ReplicationStatistics(double level = 0.95, double relativePrecision = 0.05, uint32_t minReplications = 5);
+
+    /**
+     * \brief Add a sample of a metric, creating the metric if needed
+     * \param name the metric name
+     * \param x the sample
+     */
+    void Add(const std::string &name, double x);
+
+    /**
+     * \returns true if every metric satisfies the stopping rule
+     */
+    bool IsPreciseEnough(void) const;
+
+    /**
+     * \brief Print one line per metric: name, n, mean, half-width,
+     * relative half-width
+     * \param os the output stream
+     */
+    void Print(std::ostream &os) const;
+
+    /**
+     * \brief Student t quantile
+     * \param p the probability, in (0, 1)
+     * \param df degrees of freedom
+     * \returns t such that P(T <= t) = p
+     */
+    static double StudentQuantile(double p, double df);
+
+  private:
+    double m_level;                               //!< Confidence level
+    double m_relativePrecision;                   //!< Target relative half-width
+    uint32_t m_minReplications;                   //!< Minimum samples per metric
+    std::vector<std::string> m_names;             //!< Metric names, in order of first sample
+    std::vector<RunningStatistic> m_statistics;   //!< Metric statistics
+  };
+
+} // namespace ns3
+
+#endif // REPLICATION_STATISTICS_H
@@ -0,0 +1,385 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/node.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/output-stream-wrapper.h"
+#include "scalable-dumbbell-helper.h"
+
+namespace ns3
+{
+
+  NS_LOG_COMPONENT_DEFINE("ScalableDumbbellHelper");
+
+  NS_OBJECT_ENSURE_REGISTERED(DumbbellRouting);
+
+  TypeId
+  DumbbellRouting::GetTypeId(void)
+  {
+    static TypeId tid = TypeId("ns3::DumbbellRouting")
+                            .SetParent<Ipv4RoutingProtocol>()
+                            .SetGroupName("Internet")
+                            .AddConstructor<DumbbellRouting>();
+    return tid;
+  }
+
+  DumbbellRouting::DumbbellRouting()
+      : m_leafBlock(0),
+        m_nLeaves(0),
+        m_firstLeafInterface(0),
+        m_bottleneckInterface(0)
+  {
+    NS_LOG_FUNCTION(this);
+  }
+
+  void
+  DumbbellRouting::SetTopology(Ipv4Address leafBlock, uint32_t nLeaves, uint32_t firstLeafInterface,
+                               uint32_t bottleneckInterface, Ipv4Address peer)
+  {
+    NS_LOG_FUNCTION(this << leafBlock << nLeaves << firstLeafInterface << bottleneckInterface << peer);
+    m_leafBlock = leafBlock.Get();
+    m_nLeaves = nLeaves;
+    m_firstLeafInterface = firstLeafInterface;
+    m_bottleneckInterface = bottleneckInterface;
+    m_peer = peer;
+  }
+
+  Ptr<Ipv4Route>
+  DumbbellRouting::Lookup(Ipv4Address destination, bool &local) const
+  {
+    local = false;
+    uint32_t offset = destination.Get() - m_leafBlock;
+    uint32_t interface;
+    Ipv4Address gateway;
+    if (offset < 4 * m_nLeaves)
+    {
+      // .0 and .3 of a leaf network are its network and broadcast
+      // addresses, .2 is the router itself
+      uint32_t host = offset & 3;
+      if (host == 2)
+      {
+        local = true;
+        return 0;
+      }
+      if (host != 1)
+      {
+        return 0;
+      }
+      interface = m_firstLeafInterface + (offset >> 2);
+      gateway = Ipv4Address::GetZero();
+    }
+    else if (destination == m_ipv4->GetAddress(m_bottleneckInterface, 0).GetLocal() ||
+             destination.IsLocalhost())
+    {
+      local = true;
+      return 0;
+    }
+    else if (destination.IsMulticast() || destination.IsBroadcast())
+    {
+      return 0;
+    }
+    else
+    {
+      interface = m_bottleneckInterface;
+      gateway = m_peer;
+    }
+
+    Ptr<Ipv4Route> route = Create<Ipv4Route>();
+    route->SetDestination(destination);
+    route->SetGateway(gateway);
+    route->SetSource(m_ipv4->GetAddress(interface, 0).GetLocal());
+    route->SetOutputDevice(m_ipv4->GetNetDevice(interface));
+    return route;
+  }
+
+  Ptr<Ipv4Route>
+  DumbbellRouting::RouteOutput(Ptr<Packet> p, const Ipv4Header &header, Ptr<NetDevice> oif,
+                               Socket::SocketErrno &sockerr)
+  {
+    NS_LOG_FUNCTION(this << p << header << oif);
+    bool local;
+    Ptr<Ipv4Route> route = Lookup(header.GetDestination(), local);
+    if (route == 0 || (oif != 0 && route->GetOutputDevice() != oif))
+    {
+      sockerr = Socket::ERROR_NOROUTETOHOST;
+      return 0;
+    }
+    sockerr = Socket::ERROR_NOTERROR;
+    return route;
+  }
+
+  bool
+  DumbbellRouting::RouteInput(Ptr<const Packet> p, const Ipv4Header &header, Ptr<const NetDevice> idev,
+                              UnicastForwardCallback ucb, MulticastForwardCallback mcb,
+                              LocalDeliverCallback lcb, ErrorCallback ecb)
+  {
+    NS_LOG_FUNCTION(this << p << header << idev);
+    // the router's own addresses are recognized from the address plan:
+    // Ipv4::IsDestinationAddress would scan every interface
+    bool local;
+    Ptr<Ipv4Route> route = Lookup(header.GetDestination(), local);
+    if (local)
+    {
+      if (lcb.IsNull())
+      {
+        return false;
+      }
+      lcb(p, header, m_ipv4->GetInterfaceForDevice(idev));
+      return true;
+    }
+    if (route == 0)
+    {
+      NS_LOG_LOGIC("No route to " << header.GetDestination());
+      return false;
+    }
+    ucb(route, p, header);
+    return true;
+  }
+
+  void
+  DumbbellRouting::NotifyInterfaceUp(uint32_t interface)
+  {
+  }
+
+  void
+  DumbbellRouting::NotifyInterfaceDown(uint32_t interface)
+  {
+  }
+
+  void
+  DumbbellRouting::NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address)
+  {
+  }
+
+  void
+  DumbbellRouting::NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address)
+  {
+  }
+
+  void
+  DumbbellRouting::SetIpv4(Ptr<Ipv4> ipv4)
+  {
+    NS_LOG_FUNCTION(this << ipv4);
+    m_ipv4 = ipv4;
+  }
+
+  void
+  DumbbellRouting::PrintRoutingTable(Ptr<OutputStreamWrapper> stream, Time::Unit unit) const
+  {
+    std::ostream *os = stream->GetStream();
+    *os << "Node: " << m_ipv4->GetObject<Node>()->GetId() << ", DumbbellRouting: leaves "
+        << Ipv4Address(m_leafBlock) << "/30 x " << m_nLeaves << " on interfaces "
+        << m_firstLeafInterface << ".." << m_firstLeafInterface + m_nLeaves - 1
+        << ", default " << m_peer << " on interface " << m_bottleneckInterface << std::endl;
+  }
+
+  void
+  DumbbellRouting::DoDispose(void)
+  {
+    m_ipv4 = 0;
+    Ipv4RoutingProtocol::DoDispose();
+  }
+
+  DumbbellRoutingHelper *
+  DumbbellRoutingHelper::Copy(void) const
+  {
+    return new DumbbellRoutingHelper(*this);
+  }
+
+  Ptr<Ipv4RoutingProtocol>
+  DumbbellRoutingHelper::Create(Ptr<Node> node) const
+  {
+    return CreateObject<DumbbellRouting>();
+  }
+
+  ScalableDumbbellHelper::ScalableDumbbellHelper()
+      : m_nLeft(0),
+        m_nRight(0),
+        m_leftBlock("10.64.0.0"),
+        m_rightBlock("10.128.0.0"),
+        m_bottleneckBlock("10.0.0.0")
+  {
+  }
+
+  ScalableDumbbellHelper &
+  ScalableDumbbellHelper::SetLeaves(uint32_t nLeft, uint32_t nRight)
+  {
+    m_nLeft = nLeft;
+    m_nRight = nRight;
+    return *this;
+  }
+
+  ScalableDumbbellHelper &
+  ScalableDumbbellHelper::SetLeafLink(PointToPointHelper helper)
+  {
+    m_leafLink = helper;
+    return *this;
+  }
+
+  ScalableDumbbellHelper &
+  ScalableDumbbellHelper::SetBottleneckLink(PointToPointHelper helper)
+  {
+    m_bottleneck = helper;
+    return *this;
+  }
+
+  ScalableDumbbellHelper &
+  ScalableDumbbellHelper::SetAddressBlocks(Ipv4Address left, Ipv4Address right, Ipv4Address bottleneck)
+  {
+    m_leftBlock = left;
+    m_rightBlock = right;
+    m_bottleneckBlock = bottleneck;
+    return *this;
+  }
+
+  uint32_t
+  ScalableDumbbellHelper::AddInterface(Ptr<NetDevice> device, Ipv4Address address, Ipv4Mask mask)
+  {
+    Ptr<Ipv4> ipv4 = device->GetNode()->GetObject<Ipv4>();
+    uint32_t interface = ipv4->AddInterface(device);
+    ipv4->AddAddress(interface, Ipv4InterfaceAddress(address, mask));
+    ipv4->SetMetric(interface, 1);
+    ipv4->SetUp(interface);
+    return interface;
+  }
+
+  void
+  ScalableDumbbellHelper::Build(void)
+  {
+    NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_IF(m_nLeft == 0 || m_nRight == 0, "ScalableDumbbellHelper: both sides need leaves");
+    NS_ABORT_MSG_IF(m_routers.GetN() != 0, "ScalableDumbbellHelper: already built");
+
+    m_routers.Create(2);
+    m_leftLeaves.Create(m_nLeft);
+    m_rightLeaves.Create(m_nRight);
+
+    // devices before stacks, so that the device indices match
+    // PointToPointDumbbellHelper and the loopback comes last
+    NetDeviceContainer bottleneck = m_bottleneck.Install(m_routers);
+    NetDeviceContainer left;
+    for (uint32_t i = 0; i < m_nLeft; ++i)
+    {
+      left.Add(m_leafLink.Install(m_routers.Get(0), m_leftLeaves.Get(i)));
+    }
+    NetDeviceContainer right;
+    for (uint32_t i = 0; i < m_nRight; ++i)
+    {
+      right.Add(m_leafLink.Install(m_routers.Get(1), m_rightLeaves.Get(i)));
+    }
+
+    InternetStackHelper routerStack;
+    routerStack.SetIpv6StackInstall(false);
+    routerStack.SetRoutingHelper(DumbbellRoutingHelper());
+    routerStack.Install(m_routers);
+    InternetStackHelper leafStack;
+    leafStack.SetIpv6StackInstall(false);
+    leafStack.SetRoutingHelper(Ipv4StaticRoutingHelper());
+    leafStack.Install(m_leftLeaves);
+    leafStack.Install(m_rightLeaves);
+
+    Ipv4Mask mask("255.255.255.252");
+    uint32_t base = m_bottleneckBlock.Get();
+    uint32_t bottleneckInterface = AddInterface(bottleneck.Get(0), Ipv4Address(base + 1), mask);
+    AddInterface(bottleneck.Get(1), Ipv4Address(base + 2), mask);
+
+    BuildSide(left, m_leftBlock);
+    BuildSide(right, m_rightBlock);
+
+    for (uint32_t r = 0; r < 2; ++r)
+    {
+      Ptr<Ipv4> ipv4 = m_routers.Get(r)->GetObject<Ipv4>();
+      Ptr<DumbbellRouting> routing = DynamicCast<DumbbellRouting>(ipv4->GetRoutingProtocol());
+      routing->SetTopology(r == 0 ? m_leftBlock : m_rightBlock, r == 0 ? m_nLeft : m_nRight,
+                           bottleneckInterface + 1, bottleneckInterface, Ipv4Address(base + 2 - r));
+    }
+  }
+
+  void
+  ScalableDumbbellHelper::BuildSide(NetDeviceContainer devices, Ipv4Address block)
+  {
+    // devices alternate router, leaf; leaf i is .1 and the router .2 of
+    // the i-th /30, router interfaces follow the bottleneck in leaf order
+    Ipv4Mask mask("255.255.255.252");
+    Ipv4StaticRoutingHelper staticRouting;
+    for (uint32_t i = 0; i < devices.GetN() / 2; ++i)
+    {
+      uint32_t network = block.Get() + 4 * i;
+      AddInterface(devices.Get(2 * i), Ipv4Address(network + 2), mask);
+      Ptr<NetDevice> leaf = devices.Get(2 * i + 1);
+      uint32_t interface = AddInterface(leaf, Ipv4Address(network + 1), mask);
+      Ptr<Ipv4> ipv4 = leaf->GetNode()->GetObject<Ipv4>();
+      staticRouting.GetStaticRouting(ipv4)->SetDefaultRoute(Ipv4Address(network + 2), interface);
+    }
+  }
+
+  Ptr<Node>
+  ScalableDumbbellHelper::GetLeft(void) const
+  {
+    return m_routers.Get(0);
+  }
+
+  Ptr<Node>
+  ScalableDumbbellHelper::GetLeft(uint32_t i) const
+  {
+    return m_leftLeaves.Get(i);
+  }
+
+  Ptr<Node>
+  ScalableDumbbellHelper::GetRight(void) const
+  {
+    return m_routers.Get(1);
+  }
+
+  Ptr<Node>
+  ScalableDumbbellHelper::GetRight(uint32_t i) const
+  {
+    return m_rightLeaves.Get(i);
+  }
+
+  uint32_t
+  ScalableDumbbellHelper::LeftCount(void) const
+  {
+    return m_nLeft;
+  }
+
+  uint32_t
+  ScalableDumbbellHelper::RightCount(void) const
+  {
+    return m_nRight;
+  }
+
+  Ipv4Address
+  ScalableDumbbellHelper::GetLeftIpv4Address(uint32_t i) const
+  {
+    NS_ABORT_MSG_UNLESS(i < m_nLeft, "ScalableDumbbellHelper: no left leaf " << i);
+    return Ipv4Address(m_leftBlock.Get() + 4 * i + 1);
+  }
+
+  Ipv4Address
+  ScalableDumbbellHelper::GetRightIpv4Address(uint32_t i) const
+  {
+    NS_ABORT_MSG_UNLESS(i < m_nRight, "ScalableDumbbellHelper: no right leaf " << i);
+    return Ipv4Address(m_rightBlock.Get() + 4 * i + 1);
+  }
+
+} // namespace ns3
@@ -0,0 +1,210 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SCALABLE_DUMBBELL_HELPER_H
+#define SCALABLE_DUMBBELL_HELPER_H
+
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-routing-helper.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/net-device-container.h"
+#include "ns3/node-container.h"
+#include "ns3/point-to-point-helper.h"
+
+namespace ns3
+{
+
+  class Ipv4;
+
+  /**
+   * \ingroup internet
+   *
+   * \brief Routing of a dumbbell router, computed from the address plan
+   *
+   * Leaf links of one side are consecutive /30 networks of a block, and
+   * leaf i is on interface firstLeafInterface + i, so the output interface
+   * of a destination is found with one subtraction and one shift instead
+   * of a scan of one route per leaf.  Everything else goes to the peer
+   * router over the bottleneck.
+   */
+  class DumbbellRouting : public Ipv4RoutingProtocol
+  {
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId(void);
+
+    DumbbellRouting();
+
+    /**
+     * \brief Set the address plan of the router
+     * \param leafBlock first address of the /30 leaf networks
+     * \param nLeaves number of leaves
+     * \param firstLeafInterface interface of leaf 0
+     * \param bottleneckInterface interface of the bottleneck link
+     * \param peer address of the other router on the bottleneck
+     */
+    void SetTopology(Ipv4Address leafBlock, uint32_t nLeaves, uint32_t firstLeafInterface,
+                     uint32_t bottleneckInterface, Ipv4Address peer);
+
+    // Inherited
+    virtual Ptr<Ipv4Route> RouteOutput(Ptr<Packet> p, const Ipv4Header &header, Ptr<NetDevice> oif,
+                                       Socket::SocketErrno &sockerr);
+    virtual bool RouteInput(Ptr<const Packet> p, const Ipv4Header &header, Ptr<const NetDevice> idev,
+                            UnicastForwardCallback ucb, MulticastForwardCallback mcb,
+                            LocalDeliverCallback lcb, ErrorCallback ecb);
+    virtual void NotifyInterfaceUp(uint32_t interface);
+    virtual void NotifyInterfaceDown(uint32_t interface);
+    virtual void NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address);
+    virtual void NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address);
+    virtual void SetIpv4(Ptr<Ipv4> ipv4);
+    virtual void PrintRoutingTable(Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const;
+
+  protected:
+    virtual void DoDispose(void);
+
+  private:
+    /**
+     * \brief Compute the route to a destination
+     * \param destination the destination
+     * \param local set if the destination is an address of the router
+     * \returns the route, or 0 for local and unroutable destinations
+     */
+    Ptr<Ipv4Route> Lookup(Ipv4Address destination, bool &local) const;
+
+    Ptr<Ipv4> m_ipv4;               //!< Ipv4 of the router
+    uint32_t m_leafBlock;           //!< First address of the leaf networks
+    uint32_t m_nLeaves;             //!< Number of leaves
+    uint32_t m_firstLeafInterface;  //!< Interface of leaf 0
+    uint32_t m_bottleneckInterface; //!< Interface of the bottleneck
+    Ipv4Address m_peer;             //!< Peer router
+  };
+
+  /**
+   * \ingroup internet
+   *
+   * \brief Installs DumbbellRouting with InternetStackHelper
+   */
+  class DumbbellRoutingHelper : public Ipv4RoutingHelper
+  {
+  public:
+    virtual DumbbellRoutingHelper *Copy(void) const;
+    virtual Ptr<Ipv4RoutingProtocol> Create(Ptr<Node> node) const;
+  };
+
+  /**
+   * \ingroup point-to-point-layout
+   *
+   * \brief Dumbbell builder for very large leaf counts
+   *
+   * Builds the same topology as PointToPointDumbbellHelper (router device
+   * 0 is the bottleneck, router device i + 1 connects leaf i) but avoids
+   * the parts that grow faster than the node count:
+   *
+   * - addresses are computed, not allocated: leaf link i of a side is the
+   *   /30 network block + 4 i, the leaf is .1 and the router .2;
+   * - the routers use DumbbellRouting and the leaves a single static
+   *   default route, so Ipv4GlobalRoutingHelper is not needed;
+   * - the IPv6 stack is not installed;
+   * - leaf links get no queue disc, packets go straight to the device
+   *   queue (the bottleneck queue disc is installed by the caller).
+   *
+   * Each router keeps one interface per leaf, and ns-3 demultiplexes
+   * received packets by scanning the node's protocol handlers, so the
+   * per-packet cost still grows with the number of leaves; many flows
+   * should share leaves (see the flowsPerLeaf option of 1705079_base).
+   *
+   * Options are set with chained setters before Build ().
+   */
+  class ScalableDumbbellHelper
+  {
+  public:
+    ScalableDumbbellHelper();
+
+    /**
+     * \param nLeft number of left leaves
+     * \param nRight number of right leaves
+     * \returns this helper
+     */
+    ScalableDumbbellHelper &SetLeaves(uint32_t nLeft, uint32_t nRight);
+    /**
+     * \param helper helper of the leaf links
+     * \returns this helper
+     */
+    ScalableDumbbellHelper &SetLeafLink(PointToPointHelper helper);
+    /**
+     * \param helper helper of the bottleneck link
+     * \returns this helper
+     */
+    ScalableDumbbellHelper &SetBottleneckLink(PointToPointHelper helper);
+    /**
+     * \brief Set the address blocks; each side block must hold 4 addresses
+     * per leaf
+     * \param left left leaf block
+     * \param right right leaf block
+     * \param bottleneck bottleneck /30
+     * \returns this helper
+     */
+    ScalableDumbbellHelper &SetAddressBlocks(Ipv4Address left, Ipv4Address right, Ipv4Address bottleneck);
+
+    /**
+     * \brief Create nodes, devices, stacks, addresses and routes
+     */
+    void Build(void);
+
+    Ptr<Node> GetLeft(void) const;           //!< \returns the left router
+    Ptr<Node> GetLeft(uint32_t i) const;     //!< \param i leaf index \returns left leaf i
+    Ptr<Node> GetRight(void) const;          //!< \returns the right router
+    Ptr<Node> GetRight(uint32_t i) const;    //!< \param i leaf index \returns right leaf i
+    uint32_t LeftCount(void) const;          //!< \returns the number of left leaves
+    uint32_t RightCount(void) const;         //!< \returns the number of right leaves
+    Ipv4Address GetLeftIpv4Address(uint32_t i) const;  //!< \param i leaf index \returns its address
+    Ipv4Address GetRightIpv4Address(uint32_t i) const; //!< \param i leaf index \returns its address
+
+  private:
+    /**
+     * \brief Address one side and set the leaves' default routes
+     * \param devices the leaf links, router device first
+     * \param block the leaf block
+     */
+    void BuildSide(NetDeviceContainer devices, Ipv4Address block);
+
+    /**
+     * \brief Add an interface with an address and bring it up
+     * \param device the device
+     * \param address the address
+     * \param mask the mask
+     * \returns the interface index
+     */
+    static uint32_t AddInterface(Ptr<NetDevice> device, Ipv4Address address, Ipv4Mask mask);
+
+    uint32_t m_nLeft;                 //!< Left leaves
+    uint32_t m_nRight;                //!< Right leaves
+    PointToPointHelper m_leafLink;    //!< Leaf links
+    PointToPointHelper m_bottleneck;  //!< Bottleneck link
+    Ipv4Address m_leftBlock;          //!< Left leaf block
+    Ipv4Address m_rightBlock;         //!< Right leaf block
+    Ipv4Address m_bottleneckBlock;    //!< Bottleneck /30
+    NodeContainer m_routers;          //!< Left and right routers
+    NodeContainer m_leftLeaves;       //!< Left leaves
+    NodeContainer m_rightLeaves;      //!< Right leaves
+  };
+
+} // namespace ns3
+
+#endif // SCALABLE_DUMBBELL_HELPER_H
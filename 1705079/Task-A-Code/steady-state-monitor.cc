@@ -0,0 +1,269 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/packet-sink.h"
+#include "steady-state-monitor.h"
+#include "replication-statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ns3
+{
+
+  NS_LOG_COMPONENT_DEFINE("SteadyStateMonitor");
+
+  namespace
+  {
+    const char *const SERIES_NAMES[] = {"queue_avg", "drop_rate", "goodput_bps"};
+    const std::size_t N_SERIES = 3;
+    const uint32_t MSER_BATCH = 5;
+  } // namespace
+
+  SteadyStateMonitor::SteadyStateMonitor()
+      : m_relativePrecision(0.05),
+        m_level(0.95),
+        m_batches(20),
+        m_checkEvery(50),
+        m_mode(STOP),
+        m_steady(false),
+        m_lastReceived(0),
+        m_lastDropped(0),
+        m_lastRx(0),
+        m_series(N_SERIES)
+  {
+  }
+
+  void
+  SteadyStateMonitor::SetQueueDisc(Ptr<RedQueueDisc> queueDisc)
+  {
+    NS_LOG_FUNCTION(this << queueDisc);
+    m_queueDisc = queueDisc;
+  }
+
+  void
+  SteadyStateMonitor::SetSinks(ApplicationContainer sinks)
+  {
+    NS_LOG_FUNCTION(this);
+    m_sinks = sinks;
+  }
+
+  void
+  SteadyStateMonitor::SetPrecision(double relativePrecision, double level, uint32_t batches)
+  {
+    NS_LOG_FUNCTION(this << relativePrecision << level << batches);
+    NS_ABORT_MSG_UNLESS(batches >= 2, "SteadyStateMonitor: at least 2 batches are needed");
+    m_relativePrecision = relativePrecision;
+    m_level = level;
+    m_batches = batches;
+  }
+
+  void
+  SteadyStateMonitor::Start(Time start, Time interval, uint32_t checkEvery, Mode mode)
+  {
+    NS_LOG_FUNCTION(this << start << interval << checkEvery << mode);
+    NS_ABORT_MSG_UNLESS(m_queueDisc, "SteadyStateMonitor: no queue disc");
+    NS_ABORT_MSG_UNLESS(interval.IsStrictlyPositive(), "SteadyStateMonitor: interval must be positive");
+    m_start = start;
+    m_interval = interval;
+    m_checkEvery = std::max(checkEvery, 1u);
+    m_mode = mode;
+    m_event.Cancel();
+    // the first event only sets the counters: the first sample covers a
+    // whole interval
+    m_event = Simulator::Schedule(start - Simulator::Now(), &SteadyStateMonitor::Sample, this);
+  }
+
+  void
+  SteadyStateMonitor::Sample(void)
+  {
+    const QueueDisc::Stats &st = m_queueDisc->GetStats();
+    uint64_t rx = 0;
+    for (ApplicationContainer::Iterator i = m_sinks.Begin(); i != m_sinks.End(); ++i)
+    {
+      rx += DynamicCast<PacketSink>(*i)->GetTotalRx();
+    }
+
+    if (Simulator::Now() > m_start)
+    {
+      uint64_t received = st.nTotalReceivedPackets - m_lastReceived;
+      uint64_t dropped = st.nTotalDroppedPackets - m_lastDropped;
+      m_series[0].push_back(m_queueDisc->GetQueueAverage());
+      m_series[1].push_back(received > 0 ? static_cast<double>(dropped) / received : 0);
+      m_series[2].push_back((rx - m_lastRx) * 8.0 / m_interval.GetSeconds());
+    }
+    m_lastReceived = st.nTotalReceivedPackets;
+    m_lastDropped = st.nTotalDroppedPackets;
+    m_lastRx = rx;
+
+    if (!m_steady && !m_series[0].empty() && m_series[0].size() % m_checkEvery == 0 && Check())
+    {
+      m_steady = true;
+      m_steadyTime = Simulator::Now();
+      NS_LOG_INFO("Steady state at " << m_steadyTime << ", warm-up ended at " << GetWarmupEnd());
+      if (m_mode == STOP)
+      {
+        Simulator::Stop();
+        return;
+      }
+    }
+    m_event = Simulator::Schedule(m_interval, &SteadyStateMonitor::Sample, this);
+  }
+
+  uint32_t
+  SteadyStateMonitor::Mser5(const std::vector<double> &x)
+  {
+    std::size_t nb = x.size() / MSER_BATCH;
+    if (nb < 4)
+    {
+      return static_cast<uint32_t>(x.size());
+    }
+    std::vector<double> b(nb);
+    for (std::size_t j = 0; j < nb; ++j)
+    {
+      double s = 0;
+      for (uint32_t k = 0; k < MSER_BATCH; ++k)
+      {
+        s += x[j * MSER_BATCH + k];
+      }
+      b[j] = s / MSER_BATCH;
+    }
+
+    // suffix sums, so that every truncation point costs O(1)
+    double s1 = 0;
+    double s2 = 0;
+    std::vector<double> mser(nb);
+    for (std::size_t d = nb; d-- > 0;)
+    {
+      s1 += b[d];
+      s2 += b[d] * b[d];
+      double n = static_cast<double>(nb - d);
+      mser[d] = std::max(0.0, s2 - s1 * s1 / n) / (n * n);
+    }
+    // the last batches are too few for a meaningful statistic
+    std::size_t best = 0;
+    for (std::size_t d = 1; d + 2 < nb; ++d)
+    {
+      if (mser[d] < mser[best])
+      {
+        best = d;
+      }
+    }
+    if (best > nb / 2)
+    {
+      return static_cast<uint32_t>(x.size());
+    }
+    return static_cast<uint32_t>(best * MSER_BATCH);
+  }
+
+  double
+  SteadyStateMonitor::BatchMeans(const std::vector<double> &x, uint32_t batches, double level, double &mean)
+  {
+    std::size_t size = x.size() / batches;
+    mean = 0;
+    if (size == 0)
+    {
+      return std::numeric_limits<double>::infinity();
+    }
+    // drop the oldest samples that do not fill a batch
+    std::size_t first = x.size() - size * batches;
+    RunningStatistic stat;
+    for (uint32_t j = 0; j < batches; ++j)
+    {
+      double s = 0;
+      for (std::size_t k = 0; k < size; ++k)
+      {
+        s += x[first + j * size + k];
+      }
+      stat.Add(s / size);
+    }
+    mean = stat.GetMean();
+    return stat.GetHalfWidth(level);
+  }
+
+  uint32_t
+  SteadyStateMonitor::Warmup(void) const
+  {
+    uint32_t warmup = 0;
+    for (const std::vector<double> &x : m_series)
+    {
+      warmup = std::max(warmup, Mser5(x));
+    }
+    return warmup;
+  }
+
+  bool
+  SteadyStateMonitor::Check(void)
+  {
+    uint32_t warmup = Warmup();
+    if (warmup >= m_series[0].size())
+    {
+      return false;
+    }
+    for (const std::vector<double> &x : m_series)
+    {
+      std::vector<double> tail(x.begin() + warmup, x.end());
+      double mean;
+      double hw = BatchMeans(tail, m_batches, m_level, mean);
+      if (hw > m_relativePrecision * std::fabs(mean))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool
+  SteadyStateMonitor::IsSteady(void) const
+  {
+    return m_steady;
+  }
+
+  Time
+  SteadyStateMonitor::GetSteadyTime(void) const
+  {
+    return m_steadyTime;
+  }
+
+  Time
+  SteadyStateMonitor::GetWarmupEnd(void) const
+  {
+    uint32_t warmup = std::min<uint32_t>(Warmup(), m_series[0].size());
+    return m_start + m_interval * static_cast<int64_t>(warmup);
+  }
+
+  std::vector<SteadyStateMonitor::Estimate>
+  SteadyStateMonitor::GetEstimates(void) const
+  {
+    uint32_t warmup = std::min<uint32_t>(Warmup(), m_series[0].size());
+    std::vector<Estimate> estimates;
+    for (std::size_t i = 0; i < N_SERIES; ++i)
+    {
+      Estimate e;
+      e.name = SERIES_NAMES[i];
+      e.warmup = warmup;
+      std::vector<double> tail(m_series[i].begin() + warmup, m_series[i].end());
+      e.halfWidth = BatchMeans(tail, m_batches, m_level, e.mean);
+      estimates.push_back(e);
+    }
+    return estimates;
+  }
+
+} // namespace ns3
@@ -0,0 +1,189 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef STEADY_STATE_MONITOR_H
+#define STEADY_STATE_MONITOR_H
+
+#include "ns3/application-container.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "red-queue-disc.h"
+
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+  /**
+   * \ingroup traffic-control
+   *
+   * \brief Online warm-up and steady-state detection on a RED bottleneck
+   *
+   * Every sample interval the monitor records three series: the RED
+   * average queue size, the drop rate of the queue disc over the interval
+   * and the total goodput of a set of PacketSink applications.
+   *
+   * At each check the end of the warm-up is estimated per series with
+   * MSER-5 (the truncation point minimizing the marginal standard error
+   * of the batch means of 5 samples); the warm-up ends at the latest of
+   * them.  It is only accepted when it falls in the first half of the
+   * data.  The samples after the warm-up are then split into a fixed
+   * number of batches, and the batch means give a Student t confidence
+   * interval for each series.  Steady state is declared when every
+   * interval's half-width is below the target fraction of its mean.
+   *
+   * In STOP mode the simulator is stopped at that point; in TRIM mode the
+   * run continues.  The truncation only applies to the three series of
+   * the monitor, as returned by GetEstimates (); statistics collected
+   * elsewhere over the whole run (flow monitor, queue disc) still include
+   * the warm-up.
+   *
+   * Events are bound to a raw pointer, so the monitor must outlive
+   * Simulator::Run ().
+   */
+  class SteadyStateMonitor
+  {
+  public:
+    /**
+     * \brief What to do once steady state is reached
+     */
+    enum Mode
+    {
+      STOP, //!< Stop the simulator
+      TRIM, //!< Keep running, the estimates exclude the warm-up
+    };
+
+    /**
+     * \brief Steady-state estimate of one series
+     */
+    struct Estimate
+    {
+      std::string name; //!< Series name
+      double mean;      //!< Mean after the warm-up
+      double halfWidth; //!< Confidence interval half-width (batch means)
+      uint32_t warmup;  //!< Samples removed by MSER-5
+    };
+
+    SteadyStateMonitor();
+
+    /**
+     * \brief Set the monitored queue disc
+     * \param queueDisc the bottleneck queue disc
+     */
+    void SetQueueDisc(Ptr<RedQueueDisc> queueDisc);
+
+    /**
+     * \brief Set the applications whose goodput is monitored
+     * \param sinks PacketSink applications
+     */
+    void SetSinks(ApplicationContainer sinks);
+
+    /**
+     * \brief Set the steady-state criterion
+     * \param relativePrecision target half-width relative to the mean
+     * \param level confidence level
+     * \param batches number of batches of the batch means method
+     */
+    void SetPrecision(double relativePrecision, double level, uint32_t batches);
+
+    /**
+     * \brief Start sampling
+     * \param start first sample time
+     * \param interval sample interval
+     * \param checkEvery samples between two steady-state checks
+     * \param mode what to do once steady state is reached
+     */
+    void Start(Time start, Time interval, uint32_t checkEvery, Mode mode);
+
+    /**
+     * \returns true once steady state was reached
+     */
+    bool IsSteady(void) const;
+
+    /**
+     * \returns the time steady state was reached
+     */
+    Time GetSteadyTime(void) const;
+
+    /**
+     * \returns the estimated end of the warm-up
+     */
+    Time GetWarmupEnd(void) const;
+
+    /**
+     * \brief Estimate the steady state from the samples collected so far
+     * \returns one estimate per series
+     */
+    std::vector<Estimate> GetEstimates(void) const;
+
+    /**
+     * \brief MSER-5 truncation point
+     * \param x the series
+     * \returns the number of leading samples to discard, or x.size () if
+     * the warm-up is not over
+     */
+    static uint32_t Mser5(const std::vector<double> &x);
+
+    /**
+     * \brief Batch means confidence interval
+     * \param x the series, warm-up removed
+     * \param batches number of batches
+     * \param level confidence level
+     * \param mean the mean
+     * \returns the half-width, infinite if there are not enough samples
+     */
+    static double BatchMeans(const std::vector<double> &x, uint32_t batches, double level, double &mean);
+
+  private:
+    /**
+     * \brief Sample event
+     */
+    void Sample(void);
+
+    /**
+     * \brief Steady-state test
+     * \returns true if every series is in steady state
+     */
+    bool Check(void);
+
+    /**
+     * \returns the warm-up length in samples, over all series
+     */
+    uint32_t Warmup(void) const;
+
+    Ptr<RedQueueDisc> m_queueDisc;        //!< Bottleneck
+    ApplicationContainer m_sinks;         //!< Goodput sources
+    double m_relativePrecision;           //!< Target relative half-width
+    double m_level;                       //!< Confidence level
+    uint32_t m_batches;                   //!< Batches of the batch means method
+    Time m_start;                         //!< First sample time
+    Time m_interval;                      //!< Sample interval
+    uint32_t m_checkEvery;                //!< Samples between checks
+    Mode m_mode;                          //!< Action at steady state
+    EventId m_event;                      //!< Next sample
+    bool m_steady;                        //!< Steady state reached
+    Time m_steadyTime;                    //!< When it was reached
+    uint64_t m_lastReceived;              //!< Queue disc arrivals at the last sample
+    uint64_t m_lastDropped;               //!< Queue disc drops at the last sample
+    uint64_t m_lastRx;                    //!< Sink bytes at the last sample
+    std::vector<std::vector<double>> m_series; //!< Samples: queue average, drop rate, goodput
+  };
+
+} // namespace ns3
+
+#endif // STEADY_STATE_MONITOR_H
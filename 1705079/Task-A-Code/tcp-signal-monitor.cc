@@ -0,0 +1,180 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/callback.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv6-l3-protocol.h"
+#include "ns3/onoff-application.h"
+#include "ns3/bulk-send-application.h"
+#include "tcp-signal-monitor.h"
+
+namespace ns3
+{
+
+  NS_LOG_COMPONENT_DEFINE("TcpSignalMonitor");
+
+  TcpSignalMonitor::TcpSignalMonitor()
+      : m_nDataSegments(0),
+        m_nRetransmissions(0),
+        m_nEceAcks(0),
+        m_nEctDelivered(0),
+        m_nCeDelivered(0)
+  {
+    NS_LOG_FUNCTION(this);
+  }
+
+  void
+  TcpSignalMonitor::InstallSources(ApplicationContainer sources, Time start)
+  {
+    NS_LOG_FUNCTION(this << start);
+    // scheduled after the applications' own start events, so at the
+    // same time their sockets already exist
+    Simulator::Schedule(start, &TcpSignalMonitor::ConnectSources, this, sources);
+  }
+
+  void
+  TcpSignalMonitor::ConnectSources(ApplicationContainer sources)
+  {
+    NS_LOG_FUNCTION(this);
+    for (ApplicationContainer::Iterator i = sources.Begin(); i != sources.End(); ++i)
+    {
+      Ptr<Socket> socket;
+      Ptr<OnOffApplication> onOff = DynamicCast<OnOffApplication>(*i);
+      Ptr<BulkSendApplication> bulkSend = DynamicCast<BulkSendApplication>(*i);
+      if (onOff)
+      {
+        socket = onOff->GetSocket();
+      }
+      else if (bulkSend)
+      {
+        socket = bulkSend->GetSocket();
+      }
+      Ptr<TcpSocketBase> tcp = DynamicCast<TcpSocketBase>(socket);
+      if (!tcp)
+      {
+        NS_LOG_WARN("Application " << *i << " has no TCP socket yet");
+        continue;
+      }
+      tcp->TraceConnectWithoutContext("Tx", MakeCallback(&TcpSignalMonitor::Tx, this));
+      tcp->TraceConnectWithoutContext("Rx", MakeCallback(&TcpSignalMonitor::Rx, this));
+    }
+  }
+
+  void
+  TcpSignalMonitor::InstallSinks(NodeContainer nodes)
+  {
+    NS_LOG_FUNCTION(this);
+    for (NodeContainer::Iterator i = nodes.Begin(); i != nodes.End(); ++i)
+    {
+      Ptr<Ipv4L3Protocol> ipv4 = (*i)->GetObject<Ipv4L3Protocol>();
+      if (ipv4)
+      {
+        ipv4->TraceConnectWithoutContext("LocalDeliver", MakeCallback(&TcpSignalMonitor::LocalDeliver4, this));
+      }
+      Ptr<Ipv6L3Protocol> ipv6 = (*i)->GetObject<Ipv6L3Protocol>();
+      if (ipv6)
+      {
+        ipv6->TraceConnectWithoutContext("LocalDeliver", MakeCallback(&TcpSignalMonitor::LocalDeliver6, this));
+      }
+    }
+  }
+
+  void
+  TcpSignalMonitor::Tx(Ptr<const Packet> packet, const TcpHeader &header, Ptr<const TcpSocketBase> socket)
+  {
+    if (packet->GetSize() == 0)
+    {
+      return;
+    }
+    ++m_nDataSegments;
+    SequenceNumber32 end = header.GetSequenceNumber() + packet->GetSize();
+    std::map<const TcpSocketBase *, SequenceNumber32>::iterator it = m_highTx.find(PeekPointer(socket));
+    if (it == m_highTx.end())
+    {
+      m_highTx[PeekPointer(socket)] = end;
+    }
+    else if (end <= it->second)
+    {
+      ++m_nRetransmissions;
+    }
+    else
+    {
+      it->second = end;
+    }
+  }
+
+  void
+  TcpSignalMonitor::Rx(Ptr<const Packet> packet, const TcpHeader &header, Ptr<const TcpSocketBase> socket)
+  {
+    if (header.GetFlags() & TcpHeader::ECE)
+    {
+      ++m_nEceAcks;
+    }
+  }
+
+  void
+  TcpSignalMonitor::LocalDeliver4(const Ipv4Header &header, Ptr<const Packet> packet, uint32_t interface)
+  {
+    if (header.GetEcn() != Ipv4Header::ECN_NotECT)
+    {
+      ++m_nEctDelivered;
+      m_nCeDelivered += header.GetEcn() == Ipv4Header::ECN_CE;
+    }
+  }
+
+  void
+  TcpSignalMonitor::LocalDeliver6(const Ipv6Header &header, Ptr<const Packet> packet, uint32_t interface)
+  {
+    if (header.GetEcn() != Ipv6Header::ECN_NotECT)
+    {
+      ++m_nEctDelivered;
+      m_nCeDelivered += header.GetEcn() == Ipv6Header::ECN_CE;
+    }
+  }
+
+  uint64_t
+  TcpSignalMonitor::GetNDataSegments(void) const
+  {
+    return m_nDataSegments;
+  }
+
+  uint64_t
+  TcpSignalMonitor::GetNRetransmissions(void) const
+  {
+    return m_nRetransmissions;
+  }
+
+  uint64_t
+  TcpSignalMonitor::GetNEceAcks(void) const
+  {
+    return m_nEceAcks;
+  }
+
+  uint64_t
+  TcpSignalMonitor::GetNEctDelivered(void) const
+  {
+    return m_nEctDelivered;
+  }
+
+  uint64_t
+  TcpSignalMonitor::GetNCeDelivered(void) const
+  {
+    return m_nCeDelivered;
+  }
+
+} // namespace ns3
@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TCP_SIGNAL_MONITOR_H
+#define TCP_SIGNAL_MONITOR_H
+
+#include "ns3/application-container.h"
+#include "ns3/node-container.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv6-header.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-socket-base.h"
+
+#include <map>
+
+namespace ns3
+{
+
+  /**
+   * \ingroup tcp
+   *
+   * \brief Congestion signals seen by TCP flows: retransmissions, and
+   * ECN marks from the queue to the sink and back to the source
+   *
+   * On the sources, the Tx trace of each TCP socket counts data segments
+   * and retransmissions (segments that end at or below the highest
+   * sequence already sent, so fast retransmits and timeouts alike), and
+   * the Rx trace counts the acknowledgements carrying ECE.  On the sinks,
+   * the IPv4 / IPv6 LocalDeliver trace counts the packets that arrive
+   * ECN-capable and those that arrive with CE, which shows whether a
+   * mark survives the path (6LoWPAN header compression included).
+   *
+   * Source sockets only exist once the applications start, so they are
+   * connected at a given time; OnOffApplication and BulkSendApplication
+   * are supported.
+   *
+   * Trace sinks are bound to a raw pointer, so the monitor must outlive
+   * Simulator::Run ().
+   */
+  class TcpSignalMonitor
+  {
+  public:
+    TcpSignalMonitor();
+
+    /**
+     * \brief Watch the sockets of some source applications
+     * \param sources the applications
+     * \param start a time at or after their start, when the sockets exist
+     */
+    void InstallSources(ApplicationContainer sources, Time start);
+
+    /**
+     * \brief Count the ECN codepoints of the packets delivered to some nodes
+     * \param nodes the sink nodes
+     */
+    void InstallSinks(NodeContainer nodes);
+
+    /**
+     * \returns the data segments sent, retransmissions included
+     */
+    uint64_t GetNDataSegments(void) const;
+
+    /**
+     * \returns the retransmitted data segments
+     */
+    uint64_t GetNRetransmissions(void) const;
+
+    /**
+     * \returns the acknowledgements with ECE received by the sources
+     */
+    uint64_t GetNEceAcks(void) const;
+
+    /**
+     * \returns the ECN-capable packets delivered to the sinks, CE included
+     */
+    uint64_t GetNEctDelivered(void) const;
+
+    /**
+     * \returns the packets delivered to the sinks with CE
+     */
+    uint64_t GetNCeDelivered(void) const;
+
+  private:
+    /**
+     * \brief Connect the sockets of the source applications
+     * \param sources the applications
+     */
+    void ConnectSources(ApplicationContainer sources);
+
+    /**
+     * \brief Tx trace of a source socket
+     * \param packet the payload
+     * \param header the TCP header
+     * \param socket the socket
+     */
+    void Tx(Ptr<const Packet> packet, const TcpHeader &header, Ptr<const TcpSocketBase> socket);
+
+    /**
+     * \brief Rx trace of a source socket
+     * \param packet the payload
+     * \param header the TCP header
+     * \param socket the socket
+     */
+    void Rx(Ptr<const Packet> packet, const TcpHeader &header, Ptr<const TcpSocketBase> socket);
+
+    void LocalDeliver4(const Ipv4Header &header, Ptr<const Packet> packet, uint32_t interface); //!< Ipv4 sink trace
+    void LocalDeliver6(const Ipv6Header &header, Ptr<const Packet> packet, uint32_t interface); //!< Ipv6 sink trace
+
+    std::map<const TcpSocketBase *, SequenceNumber32> m_highTx; //!< End of the highest segment sent, per socket
+    uint64_t m_nDataSegments;  //!< Data segments sent
+    uint64_t m_nRetransmissions; //!< Retransmitted data segments
+    uint64_t m_nEceAcks;       //!< Acknowledgements with ECE
+    uint64_t m_nEctDelivered;  //!< ECN-capable packets delivered
+    uint64_t m_nCeDelivered;   //!< Packets delivered with CE
+  };
+
+} // namespace ns3
+
+#endif // TCP_SIGNAL_MONITOR_H
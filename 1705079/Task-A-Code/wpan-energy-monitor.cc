@@ -0,0 +1,188 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/callback.h"
+#include "ns3/ipv6-l3-protocol.h"
+#include "ns3/lr-wpan-mac-header.h"
+#include "ns3/lr-wpan-net-device.h"
+#include "wpan-energy-monitor.h"
+
+#include <limits>
+#include <sstream>
+
+namespace ns3
+{
+
+  NS_LOG_COMPONENT_DEFINE("WpanEnergyMonitor");
+
+  WpanEnergyMonitor::WpanEnergyMonitor()
+      : m_forwardedUid(std::numeric_limits<uint64_t>::max()),
+        m_forwardedEnergy(0),
+        m_upwardEnergy(0),
+        m_droppedEnergy(0),
+        m_nDropped(0),
+        m_nChargedDrops(0),
+        m_nForwardedSeen(0)
+  {
+    NS_LOG_FUNCTION(this);
+  }
+
+  void
+  WpanEnergyMonitor::Install(const WpanSide &side, const DeviceEnergyModelContainer &models)
+  {
+    NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_UNLESS(models.GetN() == side.nodes.GetN(), "One radio energy model per node is needed");
+    for (uint32_t i = 0; i < side.nodes.GetN(); ++i)
+    {
+      Ptr<DeviceEnergyModel> model = models.Get(i);
+      m_models.Add(model);
+      if (side.parent[i] < 0)
+      {
+        // the router only sends down the tree or out of the network
+        m_routerModels.Add(model);
+        m_parents.push_back(Mac16Address());
+        Ptr<Ipv6L3Protocol> ipv6 = side.nodes.Get(i)->GetObject<Ipv6L3Protocol>();
+        ipv6->TraceConnectWithoutContext("UnicastForward", MakeCallback(&WpanEnergyMonitor::Forward, this));
+        continue;
+      }
+      Ptr<LrWpanNetDevice> parent = DynamicCast<LrWpanNetDevice>(side.lrwpanDevices.Get(side.parent[i]));
+      std::ostringstream context;
+      context << m_parents.size();
+      m_parents.push_back(parent->GetMac()->GetShortAddress());
+      model->TraceConnect("TxEnergy", context.str(), MakeCallback(&WpanEnergyMonitor::TxEnergy, this));
+    }
+  }
+
+  void
+  WpanEnergyMonitor::InstallQueueDiscs(QueueDiscContainer queueDiscs)
+  {
+    NS_LOG_FUNCTION(this);
+    for (QueueDiscContainer::ConstIterator i = queueDiscs.Begin(); i != queueDiscs.End(); ++i)
+    {
+      (*i)->TraceConnectWithoutContext("Enqueue", MakeCallback(&WpanEnergyMonitor::Enqueue, this));
+      (*i)->TraceConnectWithoutContext("Drop", MakeCallback(&WpanEnergyMonitor::Drop, this));
+    }
+  }
+
+  void
+  WpanEnergyMonitor::TxEnergy(std::string context, Ptr<const Packet> frame, double energyJ)
+  {
+    LrWpanMacHeader header;
+    frame->PeekHeader(header);
+    if (!header.IsData() || header.GetDstAddrMode() != LrWpanMacHeader::SHORTADDR ||
+        header.GetShortDstAddr() != m_parents[std::stoul(context)])
+    {
+      return;
+    }
+    m_pending[frame->GetUid()] += energyJ;
+    m_upwardEnergy += energyJ;
+  }
+
+  void
+  WpanEnergyMonitor::Forward(const Ipv6Header &header, Ptr<const Packet> packet, uint32_t interface)
+  {
+    m_forwardedUid = packet->GetUid();
+    m_forwardedEnergy = 0;
+    std::unordered_map<uint64_t, double>::iterator it = m_pending.find(m_forwardedUid);
+    if (it != m_pending.end())
+    {
+      m_forwardedEnergy = it->second;
+      m_pending.erase(it);
+    }
+  }
+
+  void
+  WpanEnergyMonitor::Enqueue(Ptr<const QueueDiscItem> item)
+  {
+    if (item->GetPacket()->GetUid() == m_forwardedUid)
+    {
+      ++m_nForwardedSeen;
+    }
+  }
+
+  void
+  WpanEnergyMonitor::Drop(Ptr<const QueueDiscItem> item)
+  {
+    ++m_nDropped;
+    if (item->GetPacket()->GetUid() != m_forwardedUid)
+    {
+      return;
+    }
+    ++m_nForwardedSeen;
+    if (m_forwardedEnergy > 0)
+    {
+      NS_LOG_LOGIC("Dropped packet " << m_forwardedUid << " cost " << m_forwardedEnergy << " J");
+      m_droppedEnergy += m_forwardedEnergy;
+      ++m_nChargedDrops;
+      m_forwardedEnergy = 0;
+    }
+  }
+
+  double
+  WpanEnergyMonitor::Sum(const DeviceEnergyModelContainer &models)
+  {
+    double energy = 0;
+    for (DeviceEnergyModelContainer::Iterator i = models.Begin(); i != models.End(); ++i)
+    {
+      energy += (*i)->GetTotalEnergyConsumption();
+    }
+    return energy;
+  }
+
+  double
+  WpanEnergyMonitor::GetTotalEnergy(void) const
+  {
+    return Sum(m_models);
+  }
+
+  double
+  WpanEnergyMonitor::GetNodeEnergy(void) const
+  {
+    return Sum(m_models) - Sum(m_routerModels);
+  }
+
+  double
+  WpanEnergyMonitor::GetUpwardEnergy(void) const
+  {
+    return m_upwardEnergy;
+  }
+
+  double
+  WpanEnergyMonitor::GetDroppedEnergy(void) const
+  {
+    return m_droppedEnergy;
+  }
+
+  uint64_t
+  WpanEnergyMonitor::GetNDropped(void) const
+  {
+    return m_nDropped;
+  }
+
+  uint64_t
+  WpanEnergyMonitor::GetNChargedDrops(void) const
+  {
+    return m_nChargedDrops;
+  }
+
+  uint64_t
+  WpanEnergyMonitor::GetNForwardedSeen(void) const
+  {
+    return m_nForwardedSeen;
+  }
+
+} // namespace ns3
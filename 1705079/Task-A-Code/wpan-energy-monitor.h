@@ -0,0 +1,176 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef WPAN_ENERGY_MONITOR_H
+#define WPAN_ENERGY_MONITOR_H
+
+#include "ns3/device-energy-model-container.h"
+#include "ns3/ipv6-header.h"
+#include "ns3/mac16-address.h"
+#include "ns3/packet.h"
+#include "ns3/queue-disc-container.h"
+#include "ns3/queue-item.h"
+#include "wpan-scenario-builder.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+  /**
+   * \ingroup energy
+   *
+   * \brief Radio energy of WPAN networks, and the part of it wasted on
+   * packets that a queue disc drops
+   *
+   * The monitor sums the LrWpanRadioEnergyModels of the networks it
+   * watches.  It also charges the transmissions of every packet on its way
+   * up to the border router to that packet: each model's TxEnergy trace
+   * reports a frame, and a data frame sent to the sender's parent (see
+   * WpanSide::parent) adds its energy, retries included, to the entry of
+   * the packet's uid.  Acknowledgements and frames going down the tree
+   * are not charged.
+   *
+   * When a router forwards a packet out of the network, its entry is
+   * taken off the table and kept as the last forwarded packet.  Queue
+   * discs drop at enqueue, in the same call chain as the forwarding, so
+   * a drop of that packet by a watched queue disc adds its energy to the
+   * dropped energy.  A head drop (RedQueueDisc::HeadDrop) removes an
+   * older packet, which is counted in GetNDropped but not charged.
+   * Packets that never leave the network (lost in the WPAN, or for the
+   * router itself) stay in the table.
+   *
+   * Packets are matched by uid, which 6LoWPAN and IPv6 forwarding keep;
+   * 6LoWPAN reassembly does not, so fragmented packets are not charged.
+   *
+   * The queue discs must be on a device the routers forward through with
+   * IPv6, e.g. their point-to-point link.  A disc on a router's LR-WPAN
+   * device never sees a packet (6LoWPAN sends to the device directly), and
+   * the dropped energy would always be 0; GetNForwardedSeen tells the two
+   * cases apart.
+   *
+   * Trace sinks are bound to a raw pointer, so the monitor must outlive
+   * Simulator::Run ().
+   */
+  class WpanEnergyMonitor
+  {
+  public:
+    WpanEnergyMonitor();
+
+    /**
+     * \brief Watch a network
+     * \param side the network
+     * \param models the radio energy models of its nodes, in the order of
+     * side.nodes (router first)
+     */
+    void Install(const WpanSide &side, const DeviceEnergyModelContainer &models);
+
+    /**
+     * \brief Charge the drops of some queue discs
+     * \param queueDiscs queue discs on the egress of the routers
+     */
+    void InstallQueueDiscs(QueueDiscContainer queueDiscs);
+
+    /**
+     * \returns the energy of all watched radios so far, J
+     */
+    double GetTotalEnergy(void) const;
+
+    /**
+     * \returns the energy of the watched radios other than the routers, J
+     */
+    double GetNodeEnergy(void) const;
+
+    /**
+     * \returns the energy charged to packets on their way up, J
+     */
+    double GetUpwardEnergy(void) const;
+
+    /**
+     * \returns the energy charged to packets the queue discs dropped, J
+     */
+    double GetDroppedEnergy(void) const;
+
+    /**
+     * \returns the packets dropped by the watched queue discs
+     */
+    uint64_t GetNDropped(void) const;
+
+    /**
+     * \returns the dropped packets that had energy charged
+     */
+    uint64_t GetNChargedDrops(void) const;
+
+    /**
+     * \returns the packets forwarded by a router that then reached a
+     * watched queue disc; 0 means the discs are not on the forwarding path
+     * and GetDroppedEnergy says nothing
+     */
+    uint64_t GetNForwardedSeen(void) const;
+
+  private:
+    /**
+     * \brief TxEnergy trace sink
+     * \param context index of the sender in m_parents
+     * \param frame the frame
+     * \param energyJ energy of its transmission
+     */
+    void TxEnergy(std::string context, Ptr<const Packet> frame, double energyJ);
+
+    /**
+     * \brief UnicastForward trace sink of the routers
+     * \param header the IPv6 header
+     * \param packet the packet
+     * \param interface the incoming interface
+     */
+    void Forward(const Ipv6Header &header, Ptr<const Packet> packet, uint32_t interface);
+
+    /**
+     * \brief Queue disc enqueue trace sink
+     * \param item the enqueued item
+     */
+    void Enqueue(Ptr<const QueueDiscItem> item);
+
+    /**
+     * \brief Queue disc drop trace sink
+     * \param item the dropped item
+     */
+    void Drop(Ptr<const QueueDiscItem> item);
+
+    /**
+     * \param models some energy models
+     * \returns their energy so far, J
+     */
+    static double Sum(const DeviceEnergyModelContainer &models);
+
+    std::vector<Mac16Address> m_parents;       //!< Short address of each sender's parent
+    DeviceEnergyModelContainer m_models;       //!< All watched models
+    DeviceEnergyModelContainer m_routerModels; //!< Models of the routers
+    std::unordered_map<uint64_t, double> m_pending; //!< Energy of packets not forwarded yet, by uid
+    uint64_t m_forwardedUid;                   //!< Uid of the last packet a router forwarded
+    double m_forwardedEnergy;                  //!< Its energy
+    double m_upwardEnergy;                     //!< Energy charged to packets
+    double m_droppedEnergy;                    //!< Energy of the dropped packets
+    uint64_t m_nDropped;                       //!< Packets dropped
+    uint64_t m_nChargedDrops;                  //!< Dropped packets with energy charged
+    uint64_t m_nForwardedSeen;                 //!< Forwarded packets that reached a watched disc
+  };
+
+} // namespace ns3
+
+#endif // WPAN_ENERGY_MONITOR_H
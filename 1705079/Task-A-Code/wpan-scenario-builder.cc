@@ -0,0 +1,454 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/object-factory.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/position-allocator.h"
+#include "ns3/sixlowpan-helper.h"
+#include "ns3/ipv6-address-helper.h"
+#include "ns3/ipv6-static-routing-helper.h"
+#include "ns3/ipv6-static-routing.h"
+#include "ns3/ipv6.h"
+#include "wpan-scenario-builder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <unordered_map>
+
+namespace ns3
+{
+
+  NS_LOG_COMPONENT_DEFINE("WpanScenarioBuilder");
+
+  namespace
+  {
+    // Nodes by square cell of the link range: the neighbours of a node
+    // are in the 3 x 3 cells around it
+    class CellIndex
+    {
+    public:
+      CellIndex(const std::vector<Vector> &positions, double size)
+          : m_positions(positions),
+            m_size(size)
+      {
+        for (uint32_t i = 0; i < positions.size(); ++i)
+        {
+          m_cells[Key(Cell(positions[i].x), Cell(positions[i].y))].push_back(i);
+        }
+      }
+
+      // Indexes of the nodes within range of node i, in cell order
+      void Neighbours(uint32_t i, std::vector<uint32_t> &out) const
+      {
+        out.clear();
+        const Vector &p = m_positions[i];
+        int64_t cx = Cell(p.x);
+        int64_t cy = Cell(p.y);
+        for (int64_t dx = -1; dx <= 1; ++dx)
+        {
+          for (int64_t dy = -1; dy <= 1; ++dy)
+          {
+            std::unordered_map<uint64_t, std::vector<uint32_t>>::const_iterator cell =
+                m_cells.find(Key(cx + dx, cy + dy));
+            if (cell == m_cells.end())
+            {
+              continue;
+            }
+            for (uint32_t j : cell->second)
+            {
+              if (j != i && CalculateDistance(p, m_positions[j]) <= m_size)
+              {
+                out.push_back(j);
+              }
+            }
+          }
+        }
+      }
+
+    private:
+      int64_t Cell(double x) const
+      {
+        return static_cast<int64_t>(std::floor(x / m_size));
+      }
+
+      static uint64_t Key(int64_t cx, int64_t cy)
+      {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+      }
+
+      const std::vector<Vector> &m_positions;
+      double m_size;
+      std::unordered_map<uint64_t, std::vector<uint32_t>> m_cells;
+    };
+  } // namespace
+
+  uint32_t
+  WpanSide::GetMaxHops(void) const
+  {
+    return hops.empty() ? 0 : *std::max_element(hops.begin(), hops.end());
+  }
+
+  double
+  WpanSide::GetMeanHops(void) const
+  {
+    if (hops.size() < 2)
+    {
+      return 0;
+    }
+    double sum = 0;
+    for (std::size_t i = 1; i < hops.size(); ++i)
+    {
+      sum += hops[i];
+    }
+    return sum / (hops.size() - 1);
+  }
+
+  WpanScenarioBuilder::WpanScenarioBuilder()
+      : m_layout(GRID),
+        m_spacing(20),
+        m_clusterSize(20),
+        m_clusterRadius(40),
+        m_channelType("ns3::SingleModelSpectrumChannel"),
+        m_range(150)
+  {
+    NS_LOG_FUNCTION(this);
+    m_uv = CreateObject<UniformRandomVariable>();
+  }
+
+  WpanScenarioBuilder::Layout
+  WpanScenarioBuilder::ParseLayout(const std::string &name)
+  {
+    if (name == "grid")
+    {
+      return GRID;
+    }
+    if (name == "uniform")
+    {
+      return UNIFORM;
+    }
+    NS_ABORT_MSG_UNLESS(name == "clustered", "Unknown layout " << name << " (use grid, uniform or clustered)");
+    return CLUSTERED;
+  }
+
+  void
+  WpanScenarioBuilder::SetLayout(Layout layout, double spacing)
+  {
+    NS_LOG_FUNCTION(this << layout << spacing);
+    NS_ABORT_MSG_UNLESS(spacing > 0, "The layout spacing must be positive");
+    m_layout = layout;
+    m_spacing = spacing;
+  }
+
+  void
+  WpanScenarioBuilder::SetClusters(uint32_t clusterSize, double clusterRadius)
+  {
+    NS_LOG_FUNCTION(this << clusterSize << clusterRadius);
+    NS_ABORT_MSG_UNLESS(clusterSize > 0, "Clusters must have nodes");
+    m_clusterSize = clusterSize;
+    m_clusterRadius = clusterRadius;
+  }
+
+  void
+  WpanScenarioBuilder::SetChannel(const std::string &typeId, Ptr<PropagationLossModel> loss,
+                                  Ptr<PropagationDelayModel> delay, double range)
+  {
+    NS_LOG_FUNCTION(this << typeId << loss << delay << range);
+    NS_ABORT_MSG_UNLESS(range > 0, "The link range must be positive");
+    m_channelType = typeId;
+    m_loss = loss;
+    m_delay = delay;
+    m_range = range;
+  }
+
+  void
+  WpanScenarioBuilder::SetStream(int64_t stream)
+  {
+    NS_LOG_FUNCTION(this << stream);
+    m_uv->SetStream(stream);
+  }
+
+  std::vector<Vector>
+  WpanScenarioBuilder::Place(uint32_t n)
+  {
+    NS_LOG_FUNCTION(this << n);
+    std::vector<Vector> positions;
+    positions.reserve(n);
+    double side = m_spacing * std::sqrt(static_cast<double>(n));
+
+    if (m_layout == GRID)
+    {
+      // odd width, so that the router sits on the centre cell
+      int64_t w = static_cast<int64_t>(std::ceil(std::sqrt(static_cast<double>(n))));
+      w += 1 - w % 2;
+      int64_t c = w / 2;
+      std::vector<std::pair<int64_t, int64_t>> cells;
+      cells.reserve(w * w);
+      for (int64_t j = 0; j < w; ++j)
+      {
+        for (int64_t i = 0; i < w; ++i)
+        {
+          cells.push_back(std::make_pair(i - c, j - c));
+        }
+      }
+      // nearest cells first; ties keep row order
+      std::stable_sort(cells.begin(), cells.end(),
+                       [](const std::pair<int64_t, int64_t> &a, const std::pair<int64_t, int64_t> &b) {
+                         return a.first * a.first + a.second * a.second < b.first * b.first + b.second * b.second;
+                       });
+      for (uint32_t k = 0; k < n; ++k)
+      {
+        positions.push_back(Vector(cells[k].first * m_spacing, cells[k].second * m_spacing, 0));
+      }
+    }
+    else if (m_layout == UNIFORM)
+    {
+      positions.push_back(Vector(0, 0, 0));
+      for (uint32_t k = 1; k < n; ++k)
+      {
+        double x = (m_uv->GetValue() - 0.5) * side;
+        double y = (m_uv->GetValue() - 0.5) * side;
+        positions.push_back(Vector(x, y, 0));
+      }
+    }
+    else
+    {
+      uint32_t nClusters = (n + m_clusterSize - 1) / m_clusterSize;
+      std::vector<Vector> centres(1, Vector(0, 0, 0));
+      for (uint32_t k = 1; k < nClusters; ++k)
+      {
+        double x = (m_uv->GetValue() - 0.5) * side;
+        double y = (m_uv->GetValue() - 0.5) * side;
+        centres.push_back(Vector(x, y, 0));
+      }
+      positions.push_back(Vector(0, 0, 0));
+      for (uint32_t k = 1; k < n; ++k)
+      {
+        const Vector &centre = centres[k % nClusters];
+        double r = m_clusterRadius * std::sqrt(m_uv->GetValue());
+        double a = 2 * M_PI * m_uv->GetValue();
+        positions.push_back(Vector(centre.x + r * std::cos(a), centre.y + r * std::sin(a), 0));
+      }
+    }
+    return positions;
+  }
+
+  uint32_t
+  WpanScenarioBuilder::Connect(std::vector<Vector> &positions, double range)
+  {
+    uint32_t n = positions.size();
+    if (n == 0)
+    {
+      return 0;
+    }
+
+    // label the connected parts of the layout as it was drawn
+    std::vector<int32_t> part(n, -1);
+    std::vector<std::vector<uint32_t>> parts;
+    {
+      CellIndex index(positions, range);
+      std::vector<uint32_t> neighbours;
+      for (uint32_t s = 0; s < n; ++s)
+      {
+        if (part[s] >= 0)
+        {
+          continue;
+        }
+        int32_t id = parts.size();
+        parts.push_back(std::vector<uint32_t>(1, s));
+        part[s] = id;
+        for (std::size_t q = 0; q < parts[id].size(); ++q)
+        {
+          index.Neighbours(parts[id][q], neighbours);
+          for (uint32_t j : neighbours)
+          {
+            if (part[j] < 0)
+            {
+              part[j] = id;
+              parts[id].push_back(j);
+            }
+          }
+        }
+      }
+    }
+
+    // join the other parts, in order, to the part of node 0: a part moves
+    // whole, so its own links stay
+    std::vector<uint32_t> connected = parts[0];
+    for (std::size_t k = 1; k < parts.size(); ++k)
+    {
+      double best = std::numeric_limits<double>::max();
+      uint32_t from = 0;
+      uint32_t to = 0;
+      for (uint32_t v : parts[k])
+      {
+        for (uint32_t c : connected)
+        {
+          double d = CalculateDistance(positions[v], positions[c]);
+          if (d < best)
+          {
+            best = d;
+            from = v;
+            to = c;
+          }
+        }
+      }
+      // move along the line from the part to its nearest connected node
+      double f = 1.0 - 0.9 * range / best;
+      Vector shift((positions[to].x - positions[from].x) * f, (positions[to].y - positions[from].y) * f,
+                   (positions[to].z - positions[from].z) * f);
+      for (uint32_t v : parts[k])
+      {
+        positions[v] = Vector(positions[v].x + shift.x, positions[v].y + shift.y, positions[v].z + shift.z);
+      }
+      connected.insert(connected.end(), parts[k].begin(), parts[k].end());
+    }
+    NS_LOG_INFO("Joined " << parts.size() - 1 << " parts of the layout");
+    return parts.size() - 1;
+  }
+
+  std::vector<int32_t>
+  WpanScenarioBuilder::HopTree(const std::vector<Vector> &positions, double range, std::vector<uint32_t> &hops)
+  {
+    uint32_t n = positions.size();
+    std::vector<int32_t> parent(n, -1);
+    hops.assign(n, std::numeric_limits<uint32_t>::max());
+    if (n == 0)
+    {
+      return parent;
+    }
+
+    CellIndex index(positions, range);
+    std::vector<uint32_t> neighbours;
+    std::deque<uint32_t> queue(1, 0);
+    hops[0] = 0;
+    while (!queue.empty())
+    {
+      uint32_t u = queue.front();
+      queue.pop_front();
+      index.Neighbours(u, neighbours);
+      for (uint32_t v : neighbours)
+      {
+        if (hops[v] == std::numeric_limits<uint32_t>::max())
+        {
+          hops[v] = hops[u] + 1;
+          parent[v] = u;
+          queue.push_back(v);
+        }
+      }
+    }
+    return parent;
+  }
+
+  WpanSide
+  WpanScenarioBuilder::Build(Ptr<Node> router, uint32_t nNodes, InternetStackHelper &stack, Ipv6Address network,
+                             Ipv6Prefix prefix, uint16_t panId)
+  {
+    NS_LOG_FUNCTION(this << router << nNodes << network << panId);
+    WpanSide side;
+    side.nodes.Add(router);
+    NodeContainer others;
+    others.Create(nNodes);
+    side.nodes.Add(others);
+
+    side.positions = Place(side.nodes.GetN());
+    Connect(side.positions, m_range);
+    side.parent = HopTree(side.positions, m_range, side.hops);
+
+    Ptr<ListPositionAllocator> allocator = CreateObject<ListPositionAllocator>();
+    for (const Vector &p : side.positions)
+    {
+      allocator->Add(p);
+    }
+    MobilityHelper mobility;
+    mobility.SetPositionAllocator(allocator);
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    mobility.Install(side.nodes);
+
+    ObjectFactory channelFactory(m_channelType);
+    side.channel = channelFactory.Create<SpectrumChannel>();
+    if (m_loss)
+    {
+      side.channel->AddPropagationLossModel(m_loss);
+    }
+    if (m_delay)
+    {
+      side.channel->SetPropagationDelayModel(m_delay);
+    }
+    m_lrWpanHelper.SetChannel(side.channel);
+    side.lrwpanDevices = m_lrWpanHelper.Install(side.nodes);
+    // Fake PAN association and short address assignment.
+    // This is needed because the lr-wpan module does not provide (yet)
+    // a full PAN association procedure.
+    m_lrWpanHelper.AssociateToPan(side.lrwpanDevices, panId);
+
+    stack.Install(side.nodes);
+    SixLowPanHelper sixLowPanHelper;
+    side.sixLowPanDevices = sixLowPanHelper.Install(side.lrwpanDevices);
+
+    Ipv6AddressHelper ipv6;
+    ipv6.SetBase(network, prefix);
+    side.interfaces = ipv6.Assign(side.sixLowPanDevices);
+    for (uint32_t i = 0; i < side.interfaces.GetN(); ++i)
+    {
+      side.interfaces.SetForwarding(i, true);
+    }
+    InstallRoutes(side);
+
+    NS_LOG_INFO(network << ": " << side.nodes.GetN() << " nodes, " << side.GetMaxHops() << " hops at most, "
+                        << side.GetMeanHops() << " on average");
+    return side;
+  }
+
+  void
+  WpanScenarioBuilder::InstallRoutes(const WpanSide &side) const
+  {
+    NS_LOG_FUNCTION(this);
+    Ipv6StaticRoutingHelper routingHelper;
+    std::vector<Ptr<Ipv6StaticRouting>> routing(side.nodes.GetN());
+    for (uint32_t i = 0; i < side.nodes.GetN(); ++i)
+    {
+      routing[i] = routingHelper.GetStaticRouting(side.nodes.Get(i)->GetObject<Ipv6>());
+    }
+
+    for (uint32_t v = 1; v < side.nodes.GetN(); ++v)
+    {
+      int32_t p = side.parent[v];
+      NS_ASSERT_MSG(p >= 0, "Node " << v << " cannot reach the router");
+      routing[v]->SetDefaultRoute(side.interfaces.GetAddress(p, 1), side.interfaces.GetInterfaceIndex(v));
+
+      // the parent reaches v on link; the nodes above it need a host route
+      Ipv6Address destination = side.interfaces.GetAddress(v, 1);
+      uint32_t child = p;
+      for (int32_t a = side.parent[p]; a >= 0; child = a, a = side.parent[a])
+      {
+        routing[a]->AddHostRouteTo(destination, side.interfaces.GetAddress(child, 1),
+                                   side.interfaces.GetInterfaceIndex(a));
+      }
+    }
+  }
+
+  int64_t
+  WpanScenarioBuilder::AssignStreams(const WpanSide &side, int64_t stream)
+  {
+    NS_LOG_FUNCTION(this << stream);
+    return m_lrWpanHelper.AssignStreams(side.lrwpanDevices, stream);
+  }
+
+} // namespace ns3
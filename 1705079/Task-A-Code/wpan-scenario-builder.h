@@ -0,0 +1,213 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef WPAN_SCENARIO_BUILDER_H
+#define WPAN_SCENARIO_BUILDER_H
+
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/ipv6-address.h"
+#include "ns3/ipv6-interface-container.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/lr-wpan-helper.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/spectrum-channel.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/vector.h"
+
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+  /**
+   * \brief One 6LoWPAN network built by WpanScenarioBuilder
+   *
+   * Index 0 of every container is the border router.
+   */
+  struct WpanSide
+  {
+    NodeContainer nodes;                //!< Router first
+    NetDeviceContainer lrwpanDevices;   //!< LrWpanNetDevices
+    NetDeviceContainer sixLowPanDevices; //!< SixLowPanNetDevices over them
+    Ipv6InterfaceContainer interfaces;  //!< 6LoWPAN interfaces; address 1 is the global one
+    Ptr<SpectrumChannel> channel;       //!< The channel of the network
+    std::vector<Vector> positions;      //!< Node positions
+    std::vector<int32_t> parent;        //!< Next hop towards the router, -1 for the router
+    std::vector<uint32_t> hops;         //!< Hops to the router
+
+    /**
+     * \returns the largest hop count
+     */
+    uint32_t GetMaxHops(void) const;
+
+    /**
+     * \returns the mean hop count of the nodes other than the router
+     */
+    double GetMeanHops(void) const;
+  };
+
+  /**
+   * \brief Builds route-over 6LoWPAN networks of any size around a
+   * border router
+   *
+   * Nodes are placed on a 2-D layout drawn from one ns-3 random stream,
+   * so that a layout only depends on the stream, --RngSeed and --RngRun:
+   *
+   *  - grid: a square grid centred on the router, step `spacing`, filled
+   *    from the centre outwards;
+   *  - uniform: uniform in a square of side spacing * sqrt (n) centred on
+   *    the router;
+   *  - clustered: clusters of `clusterSize` nodes, uniform in discs of
+   *    radius `clusterRadius` around centres that are uniform in the same
+   *    square; the first centre is the router.
+   *
+   * Two nodes are linked when they are within `range` (the MaxRange of
+   * the RangePropagationLossModel).  Parts of the layout that cannot
+   * reach the router are moved, whole, towards the nearest connected
+   * node until they are within 0.9 range of it, so every node reaches
+   * the router in one or more hops.  A breadth-first search from the
+   * router then gives every node a parent: nodes get a default route to
+   * their parent, and every node on the way up gets a host route to each
+   * node below it.  Neighbours are found through a grid of cells of the
+   * range's size, so building scales with the number of links, not with
+   * the square of the number of nodes.
+   *
+   * Devices, the IPv6 stack, 6LoWPAN and addresses are installed on each
+   * network with one call per helper.
+   */
+  class WpanScenarioBuilder
+  {
+  public:
+    /**
+     * \brief Node placement
+     */
+    enum Layout
+    {
+      GRID,      //!< Square grid
+      UNIFORM,   //!< Uniform in a square
+      CLUSTERED, //!< Clusters around uniform centres
+    };
+
+    WpanScenarioBuilder();
+
+    /**
+     * \param name grid, uniform or clustered
+     * \returns the layout; aborts on an unknown name
+     */
+    static Layout ParseLayout(const std::string &name);
+
+    /**
+     * \brief Set the placement
+     * \param layout the layout
+     * \param spacing grid step, or mean distance between nodes, in m
+     */
+    void SetLayout(Layout layout, double spacing);
+
+    /**
+     * \brief Set the clusters of the clustered layout
+     * \param clusterSize nodes per cluster
+     * \param clusterRadius radius of a cluster, in m
+     */
+    void SetClusters(uint32_t clusterSize, double clusterRadius);
+
+    /**
+     * \brief Set the radio channel of the networks
+     * \param typeId TypeId name of the SpectrumChannel
+     * \param loss the propagation loss model
+     * \param delay the propagation delay model
+     * \param range distance up to which two nodes hear each other, in m
+     */
+    void SetChannel(const std::string &typeId, Ptr<PropagationLossModel> loss, Ptr<PropagationDelayModel> delay,
+                    double range);
+
+    /**
+     * \brief Set the random stream of the layouts
+     * \param stream the stream
+     */
+    void SetStream(int64_t stream);
+
+    /**
+     * \brief Build a network
+     *
+     * \param router the border router, already created
+     * \param nNodes nodes besides the router
+     * \param stack the IPv6 stack helper
+     * \param network the network of the 6LoWPAN addresses
+     * \param prefix its prefix
+     * \param panId the PAN id
+     * \returns the network
+     */
+    WpanSide Build(Ptr<Node> router, uint32_t nNodes, InternetStackHelper &stack, Ipv6Address network,
+                   Ipv6Prefix prefix, uint16_t panId);
+
+    /**
+     * \brief Assign random streams to the LR-WPAN devices of a network
+     * \param side the network
+     * \param stream the first stream
+     * \returns the number of streams used
+     */
+    int64_t AssignStreams(const WpanSide &side, int64_t stream);
+
+    /**
+     * \brief Draw the positions of a layout, router first at the origin
+     * \param n number of nodes, router included
+     * \returns the positions
+     */
+    std::vector<Vector> Place(uint32_t n);
+
+    /**
+     * \brief Move the parts that cannot reach node 0 towards it
+     * \param positions the positions, modified in place
+     * \param range the link range
+     * \returns the number of parts moved
+     */
+    static uint32_t Connect(std::vector<Vector> &positions, double range);
+
+    /**
+     * \brief Breadth-first tree from node 0
+     * \param positions the positions
+     * \param range the link range
+     * \param hops set to the hop count of every node
+     * \returns the parent of every node, -1 for node 0 and unreachable nodes
+     */
+    static std::vector<int32_t> HopTree(const std::vector<Vector> &positions, double range,
+                                        std::vector<uint32_t> &hops);
+
+  private:
+    /**
+     * \brief Install the routes of a network
+     * \param side the network
+     */
+    void InstallRoutes(const WpanSide &side) const;
+
+    Layout m_layout;                        //!< Placement
+    double m_spacing;                       //!< Grid step or mean distance, m
+    uint32_t m_clusterSize;                 //!< Nodes per cluster
+    double m_clusterRadius;                 //!< Cluster radius, m
+    std::string m_channelType;              //!< SpectrumChannel TypeId name
+    Ptr<PropagationLossModel> m_loss;       //!< Propagation loss model
+    Ptr<PropagationDelayModel> m_delay;     //!< Propagation delay model
+    double m_range;                         //!< Link range, m
+    Ptr<UniformRandomVariable> m_uv;        //!< Layout stream
+    LrWpanHelper m_lrWpanHelper;            //!< Device helper
+  };
+
+} // namespace ns3
+
+#endif // WPAN_SCENARIO_BUILDER_H
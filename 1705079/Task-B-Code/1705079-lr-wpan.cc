@@ -12,18 +12,35 @@
 #include "ns3/wifi-module.h"
 #include "ns3/flow-monitor-module.h"
 #include "ns3/traffic-control-module.h"
+#include "ns3/energy-module.h"
+
+#include "../Task-A-Code/async-trace-stream.h"
+#include "../Task-A-Code/filtered-trace-helper.h"
+#include "../Task-A-Code/flow-stats-exporter.h"
+#include "../Task-A-Code/endpoint-flow-monitor.h"
+#include "../Task-A-Code/ensemble-runner.h"
+#include "../Task-A-Code/steady-state-monitor.h"
+#include "../Task-A-Code/range-culled-spectrum-channel.h"
+#include "../Task-A-Code/wpan-scenario-builder.h"
+#include "../Task-A-Code/lr-wpan-radio-energy-model.h"
+#include "../Task-A-Code/wpan-energy-monitor.h"
+#include "../Task-A-Code/tcp-signal-monitor.h"
 
 // Default Network Topology
 //
-//  lrwpan 2001:a::
-//                 RO
-//  *    *    *    *
-//  |    |    |    |    2001:b::
-//  n7   n6   n5  n4 --------------  n0  n1   n2   n3
-//                   point-to-point  |    |    |    |
-//                                   *    *    *    *
+//     LRWPAN 2001:b::                          LRWPAN 2001:c::
 //
-//                                   LRWPAN 2001:c::
+//    *   *   *                                  *   *   *
+//      \ | /          point-to-point              \ | /
+//    * -- R0 -------------------------------------- R1 -- *
+//      / | \            2001:a::                  / | \
+//    *   *   *                                  *   *   *
+//
+// Each side has totalNode / 2 nodes, border router included, placed
+// around the router (grid, uniform or clustered layout) and reaching it
+// over one or more 6LoWPAN hops with static routes, see
+// WpanScenarioBuilder.  Flows go from a left node to a right node; the
+// RED queue discs sit on the point-to-point router link.
 
 using namespace std;
 using namespace ns3;
@@ -33,124 +50,168 @@ int main(int argc, char **argv)
 
     double minTh = 20;
     double maxTh = 35;
-    uint32_t pktSize = 256;
+    uint32_t queueDiscLimitPackets = 100;
     std::string appDataRate = "5Mbps";
     std::string queueDiscType = "RED";
     uint16_t port = 5001;
-    std::string bottleNeckLinkBw = "2Mbps";
+    // well below what the WPAN delivers to its router, so that the queue
+    // builds on the router link and not inside the WPAN
+    std::string bottleNeckLinkBw = "20kbps";
     std::string bottleNeckLinkDelay = "50ms";
     uint32_t totalNode = 100;
-    uint32_t wpanCount = totalNode / 2 - 1;
     uint32_t totalFlow = 20;
     int packetsPerSecond = 300;
     int multiplier = 1;
 
     uint32_t packetSize = 50;
-    std::string p2pDataRate("2Mbps");
     std::string p2pDelay("30ms");
     uint32_t duration = 50;
-    double maxRange = 150 * multiplier;
+    std::string layout = "grid";
+    double spacing = 40;
+    uint32_t clusterSize = 20;
+    double clusterRadius = 40;
+    std::string traceMode = "none";
+    std::string traceNodes = "routers";
+    std::string traceEvents = "all";
+    uint32_t traceSample = 1;
+    bool traceFlowSample = false;
+    std::string flowExport = "csv";
+    double flowExportInterval = 0;
+    std::string flowMonitorMode = "full";
+    uint32_t ensemble = 0;
+    uint32_t ensembleJobs = 0;
+    double ciPrecision = 0;
+    double ciLevel = 0.95;
+    uint32_t minReplications = 5;
+    std::string steadyState = "none";
+    double steadyInterval = 0.1;
+    double steadyPrecision = 0.05;
+    bool fixedPoint = false;
+    std::string channelType = "culled";
+    bool energy = true;
+    double batteryEnergy = 20000;
+    double supplyVoltage = 3.0;
+    bool ecn = false;
+    bool rred = true;
+    bool headDrop = false;
 
     Packet::EnablePrinting();
     CommandLine cmd(__FILE__);
 
-    srand(time(0));
     cmd.AddValue("totalNode", "vary total nodes", totalNode);
     cmd.AddValue("totalFlow", "vary total flows", totalFlow);
     cmd.AddValue("packetsPerSecond", "vary packets per second", packetsPerSecond);
     cmd.AddValue("multiplier", "vary coverage area", multiplier);
+    cmd.AddValue("layout", "WPAN node placement: grid, uniform or clustered", layout);
+    cmd.AddValue("spacing", "WPAN grid step or mean distance between nodes, in m", spacing);
+    cmd.AddValue("clusterSize", "Nodes per cluster of the clustered layout", clusterSize);
+    cmd.AddValue("clusterRadius", "Cluster radius of the clustered layout, in m", clusterRadius);
+    cmd.AddValue("traceMode", "Ascii tracing: filtered or none", traceMode);
+    cmd.AddValue("traceNodes", "Filtered tracing device set: routers or all", traceNodes);
+    cmd.AddValue("traceEvents", "Filtered tracing events: comma list of enqueue, dequeue, drop, rx, all", traceEvents);
+    cmd.AddValue("traceSample", "Filtered tracing keeps one event in N", traceSample);
+    cmd.AddValue("traceFlowSample", "Filtered tracing samples whole flows by five-tuple hash", traceFlowSample);
+    cmd.AddValue("flowExport", "Flow statistics output: csv, bin or xml", flowExport);
+    cmd.AddValue("flowExportInterval", "Seconds between periodic flow statistics dumps (0 for the final one only)",
+                 flowExportInterval);
+    cmd.AddValue("flowMonitor", "Flow monitoring: full (every node) or endpoint (sources, sinks, bottleneck)",
+                 flowMonitorMode);
+    cmd.AddValue("ensemble", "Replications forked after the topology is built, from run RngRun (0 for a single run)",
+                 ensemble);
+    cmd.AddValue("ensembleJobs", "Concurrent ensemble workers (0 for the number of cores)", ensembleJobs);
+    cmd.AddValue("ciPrecision", "Stop the ensemble once every confidence interval half-width is below this "
+                                "fraction of its mean (0 to run all replications)",
+                 ciPrecision);
+    cmd.AddValue("ciLevel", "Confidence level of the ensemble statistics", ciLevel);
+    cmd.AddValue("minReplications", "Replications before the ciPrecision rule is checked", minReplications);
+    cmd.AddValue("steadyState", "Steady-state detection on the bottleneck: none, stop (end the run) or trim "
+                                "(keep running, also report the monitored series without warm-up)",
+                 steadyState);
+    cmd.AddValue("steadyInterval", "Steady-state sample interval in seconds", steadyInterval);
+    cmd.AddValue("steadyPrecision", "Steady-state target confidence interval half-width, relative to the mean",
+                 steadyPrecision);
+    cmd.AddValue("fixedPoint", "Integer RED control law of the FPU-less border routers", fixedPoint);
+    cmd.AddValue("channel", "WPAN spectrum channel: culled (receivers within MaxRange only) or single", channelType);
+    cmd.AddValue("energy", "Radio energy accounting of the WPAN nodes", energy);
+    cmd.AddValue("batteryEnergy", "Initial energy of each WPAN node, in J", batteryEnergy);
+    cmd.AddValue("supplyVoltage", "Supply voltage of the WPAN radios, in V", supplyVoltage);
+    cmd.AddValue("ecn", "RED marks ECN-capable packets instead of dropping them, and TCP negotiates ECN", ecn);
+    cmd.AddValue("rred", "Robust RED filter in front of RED", rred);
+    cmd.AddValue("headDrop", "RED drops the packet at the head of the queue instead of the arriving one", headDrop);
+    cmd.AddValue("bottleneckBw", "Rate of the router link, where the RED queue discs sit", bottleNeckLinkBw);
+    cmd.AddValue("queueDiscLimitPackets", "Max Packets allowed in the queue disc", queueDiscLimitPackets);
 
     cmd.Parse(argc, argv);
 
+    NS_ABORT_MSG_UNLESS(channelType == "culled" || channelType == "single",
+                        "Unknown channel " << channelType << " (use culled or single)");
+    std::string channelTypeId =
+        channelType == "culled" ? "ns3::RangeCulledSpectrumChannel" : "ns3::SingleModelSpectrumChannel";
+    NS_ABORT_MSG_IF(totalNode < 4, "totalNode must leave at least one node besides the router on each side");
+
+    // nodes of each side besides its border router
+    uint32_t wpanCount = totalNode / 2 - 1;
+    double maxRange = 150 * multiplier;
+
     Config::SetDefault("ns3::TcpSocket::SegmentSize", UintegerValue(packetSize));
     Config::SetDefault("ns3::RangePropagationLossModel::MaxRange", DoubleValue(maxRange));
     Ptr<RangePropagationLossModel> propModel = CreateObject<RangePropagationLossModel>();
     Ptr<ConstantSpeedPropagationDelayModel> delayModel = CreateObject<ConstantSpeedPropagationDelayModel>();
 
-    // default queue configuration
+    // default queue configuration; the limit stays above MaxTh, so that
+    // RED rather than a full queue decides
+    NS_ABORT_MSG_IF(queueDiscLimitPackets <= maxTh, "queueDiscLimitPackets must be above the RED MaxTh");
+    Config::SetDefault("ns3::RedQueueDisc::MaxSize",
+                       QueueSizeValue(QueueSize(QueueSizeUnit::PACKETS, queueDiscLimitPackets)));
     Config::SetDefault("ns3::RedQueueDisc::MinTh", DoubleValue(minTh));
     Config::SetDefault("ns3::RedQueueDisc::MaxTh", DoubleValue(maxTh));
     Config::SetDefault("ns3::RedQueueDisc::LinkBandwidth", StringValue(bottleNeckLinkBw));
     Config::SetDefault("ns3::RedQueueDisc::LinkDelay", StringValue(bottleNeckLinkDelay));
-    Config::SetDefault("ns3::RedQueueDisc::MeanPktSize", UintegerValue(pktSize));
+    // segments cross the router link uncompressed: IPv6 and TCP headers
+    Config::SetDefault("ns3::RedQueueDisc::MeanPktSize", UintegerValue(packetSize + 60));
+    Config::SetDefault("ns3::RedQueueDisc::FixedPoint", BooleanValue(fixedPoint));
+    Config::SetDefault("ns3::RedQueueDisc::RRED", BooleanValue(rred));
+    Config::SetDefault("ns3::RedQueueDisc::HeadDrop", BooleanValue(headDrop));
+    Config::SetDefault("ns3::RedQueueDisc::UseEcn", BooleanValue(ecn));
+    // both ends negotiate ECN, so the sources react to marks
+    Config::SetDefault("ns3::TcpSocketBase::UseEcn", StringValue(ecn ? "On" : "Off"));
 
     // p2p nodes creation
     NodeContainer p2pNodes;
     p2pNodes.Create(2);
 
     PointToPointHelper p2pHelper;
-    p2pHelper.SetDeviceAttribute("DataRate", StringValue(p2pDataRate));
+    p2pHelper.SetDeviceAttribute("DataRate", StringValue(bottleNeckLinkBw));
     p2pHelper.SetChannelAttribute("Delay", StringValue(p2pDelay));
 
     NetDeviceContainer p2pDevices;
     p2pDevices = p2pHelper.Install(p2pNodes);
     InternetStackHelper internetv6;
 
-    // lrwpan left side
-    NodeContainer wpanNodesLeft;
-    wpanNodesLeft.Add(p2pNodes.Get(0));
-    wpanNodesLeft.Create(wpanCount);
-
-    // lrwpan left side
-    NodeContainer wpanNodesRight;
-    wpanNodesRight.Add(p2pNodes.Get(1));
-    wpanNodesRight.Create(wpanCount);
-
-    MobilityHelper mobilityLeft;
-    mobilityLeft.SetPositionAllocator("ns3::GridPositionAllocator",
-                                      "MinX", DoubleValue(10.0),
-                                      "MinY", DoubleValue(10.0),
-                                      "DeltaX", DoubleValue(20.0),
-                                      "DeltaY", DoubleValue(20.0),
-                                      "GridWidth", UintegerValue(1),
-                                      "LayoutType", StringValue("RowFirst"));
-    mobilityLeft.SetMobilityModel("ns3::ConstantPositionMobilityModel");
-    mobilityLeft.Install(wpanNodesLeft);
-
-    // left lrwpan helper setup
-    LrWpanHelper lrWpanHelperLeft;
-    Ptr<SingleModelSpectrumChannel> channelLeft = CreateObject<SingleModelSpectrumChannel>();
-    channelLeft->AddPropagationLossModel(propModel);
-    channelLeft->SetPropagationDelayModel(delayModel);
-    lrWpanHelperLeft.SetChannel(channelLeft);
-    // Add and install the LrWpanNetDevice for each node
-    NetDeviceContainer lrwpanDevicesLeft = lrWpanHelperLeft.Install(wpanNodesLeft);
-
-    // Fake PAN association and short address assignment.
-    // This is needed because the lr-wpan module does not provide (yet)
-    // a full PAN association procedure.
-    lrWpanHelperLeft.AssociateToPan(lrwpanDevicesLeft, 0);
-    internetv6.Install(wpanNodesLeft);
-
-    // six low pan
-    SixLowPanHelper sixLowPanHelperLeft;
-    NetDeviceContainer sixLowPanDevicesLeft = sixLowPanHelperLeft.Install(lrwpanDevicesLeft);
-
-    MobilityHelper mobilityright;
-    mobilityright.SetPositionAllocator("ns3::GridPositionAllocator",
-                                       "MinX", DoubleValue(20.0),
-                                       "MinY", DoubleValue(20.0),
-                                       "DeltaX", DoubleValue(30.0),
-                                       "DeltaY", DoubleValue(50.0),
-                                       "GridWidth", UintegerValue(300),
-                                       "LayoutType", StringValue("RowFirst"));
-    mobilityright.SetMobilityModel("ns3::ConstantPositionMobilityModel");
-    mobilityright.Install(wpanNodesRight);
-
-    // right lrwpan helper setup
-    LrWpanHelper lrWpanHelperRight;
-    Ptr<SingleModelSpectrumChannel> channelRight = CreateObject<SingleModelSpectrumChannel>();
-    channelRight->AddPropagationLossModel(propModel);
-    channelRight->SetPropagationDelayModel(delayModel);
-    lrWpanHelperRight.SetChannel(channelRight);
-    // Add and install the LrWpanNetDevice for each node
-    NetDeviceContainer lrwpanDevicesRight = lrWpanHelperRight.Install(wpanNodesRight);
-
-    lrWpanHelperRight.AssociateToPan(lrwpanDevicesRight, 0);
-    internetv6.Install(wpanNodesRight);
-    // six low pan
-    SixLowPanHelper sixLowPanHelperRight;
-    NetDeviceContainer sixLowPanDevicesRight = sixLowPanHelperRight.Install(lrwpanDevicesRight);
+    // addresses are unique by construction: skip duplicate address
+    // detection, which floods large WPANs at start-up
+    Config::SetDefault("ns3::Icmpv6L4Protocol::DAD", BooleanValue(false));
+
+    // both WPANs around their border router
+    WpanScenarioBuilder wpanBuilder;
+    wpanBuilder.SetLayout(WpanScenarioBuilder::ParseLayout(layout), spacing);
+    wpanBuilder.SetClusters(clusterSize, clusterRadius);
+    wpanBuilder.SetChannel(channelTypeId, propModel, delayModel, maxRange);
+    // like the flow pairs, the layouts come from a reserved stream
+    wpanBuilder.SetStream(1);
+    WpanSide wpanLeft = wpanBuilder.Build(p2pNodes.Get(0), wpanCount, internetv6, Ipv6Address("2001:b::"),
+                                          Ipv6Prefix(64), 0);
+    WpanSide wpanRight = wpanBuilder.Build(p2pNodes.Get(1), wpanCount, internetv6, Ipv6Address("2001:c::"),
+                                           Ipv6Prefix(64), 0);
+    std::cout << "WPAN sides of " << wpanLeft.nodes.GetN() << " nodes; hops to the router: left "
+              << wpanLeft.GetMeanHops() << " mean, " << wpanLeft.GetMaxHops() << " max; right "
+              << wpanRight.GetMeanHops() << " mean, " << wpanRight.GetMaxHops() << " max" << std::endl;
+
+    NodeContainer wpanNodesLeft = wpanLeft.nodes;
+    NodeContainer wpanNodesRight = wpanRight.nodes;
+    NetDeviceContainer lrwpanDevicesLeft = wpanLeft.lrwpanDevices;
+    NetDeviceContainer lrwpanDevicesRight = wpanRight.lrwpanDevices;
+    Ipv6InterfaceContainer wpanInterfacesRight = wpanRight.interfaces;
 
     // NS_LOG_INFO("Configure Addresses");
     Ipv6AddressHelper ipv6;
@@ -162,32 +223,32 @@ int main(int argc, char **argv)
     routerInterfaces.SetDefaultRouteInAllNodes(0);
     routerInterfaces.SetForwarding(1, true);
     routerInterfaces.SetDefaultRouteInAllNodes(1);
-    // address for wpan left nodes
-    ipv6.SetBase(Ipv6Address("2001:b::"), Ipv6Prefix(64));
-    Ipv6InterfaceContainer wpanInterfacesLeft;
-    wpanInterfacesLeft = ipv6.Assign(sixLowPanDevicesLeft);
-    wpanInterfacesLeft.SetForwarding(0, true);
-    wpanInterfacesLeft.SetDefaultRouteInAllNodes(0);
-    // address for wpan right nodes
-    ipv6.SetBase(Ipv6Address("2001:c::"), Ipv6Prefix(64));
-    Ipv6InterfaceContainer wpanInterfacesRight;
-    wpanInterfacesRight = ipv6.Assign(sixLowPanDevicesRight);
-    wpanInterfacesRight.SetForwarding(0, true);
-    wpanInterfacesRight.SetDefaultRouteInAllNodes(0);
 
     TrafficControlHelper tchBottleneck;
     QueueDiscContainer queueDiscs;
     tchBottleneck.SetRootQueueDisc("ns3::RedQueueDisc");
-    tchBottleneck.Install(lrwpanDevicesLeft.Get(0));
-    queueDiscs = tchBottleneck.Install(lrwpanDevicesRight.Get(0));
+    // RED sits on the router link: IPv6 queues there as Ipv6QueueDiscItems,
+    // while 6LoWPAN hands packets to the LR-WPAN devices directly.  Address
+    // assignment installed the default queue disc first
+    tchBottleneck.Uninstall(p2pDevices);
+    QueueDiscContainer redQueueDiscs = tchBottleneck.Install(p2pDevices);
+    // the data flows left to right
+    queueDiscs.Add(redQueueDiscs.Get(0));
+    // flow pairs come from the ns-3 RNG on a reserved stream, so that they
+    // only depend on --RngSeed / --RngRun; ensemble workers share the pairs
+    // drawn before the fork
+    Ptr<UniformRandomVariable> pairChooser = CreateObject<UniformRandomVariable>();
+    pairChooser->SetStream(0);
+    ApplicationContainer sourceApps;
+    ApplicationContainer sinks;
     for (uint32_t i = 0; i < totalFlow; i++)
     {
-        // choose pair
-        int idx = rand() % wpanCount;
+        // choose pair, routers excluded
+        uint32_t idx = pairChooser->GetInteger(1, wpanCount);
         // create sink
         PacketSinkHelper sink("ns3::TcpSocketFactory", Inet6SocketAddress(Ipv6Address::GetAny(), port));
         // create source
-        OnOffHelper source("ns3::TcpSocketFactory", Inet6SocketAddress(wpanInterfacesLeft.GetAddress(idx, 1), port));
+        OnOffHelper source("ns3::TcpSocketFactory", Inet6SocketAddress(wpanInterfacesRight.GetAddress(idx, 1), port));
         source.SetAttribute("PacketSize", UintegerValue(packetSize));
         source.SetAttribute("MaxBytes", UintegerValue(0));
         source.SetConstantRate(DataRate(packetsPerSecond * packetSize * 8));
@@ -195,6 +256,7 @@ int main(int argc, char **argv)
         // install sink in right station's ith node
         ApplicationContainer sinkApps = sink.Install(wpanNodesRight.Get(idx));
         Ptr<PacketSink> temp = StaticCast<PacketSink>(sinkApps.Get(0));
+        sinks.Add(sinkApps);
         sinkApps.Start(Seconds(1.0));
         sinkApps.Stop(Seconds(duration - 1));
         port++;
@@ -203,6 +265,7 @@ int main(int argc, char **argv)
         ApplicationContainer sourceApp = source.Install(wpanNodesLeft.Get(idx));
         sourceApp.Start(Seconds(2.0));
         sourceApp.Stop(Seconds(duration - 1));
+        sourceApps.Add(sourceApp);
     }
 
     // Address sinkLocalAddress(Inet6SocketAddress(Ipv6Address::GetAny(), port));
@@ -229,66 +292,289 @@ int main(int argc, char **argv)
     // clientApps.Start(Seconds(2.0)); // Start 2 second after sink
     // clientApps.Stop(Seconds(10.0)); // Stop before the sink
 
+    // everything above is shared by the ensemble workers; output files are
+    // only opened below, with a per-worker name
+    EnsembleRunner runner;
+    if (ciPrecision > 0)
+    {
+        runner.SetStopRule(ciLevel, ciPrecision, minReplications);
+    }
+    if (!runner.Fork(ensemble, ensembleJobs, "1705079-wpan"))
+    {
+        return runner.GetNFailed() == 0 ? 0 : 1;
+    }
+
+    // random variables created so far drew their run number before the
+    // fork, so assign every stream again
+    int64_t stream = 2;
+    stream += internetv6.AssignStreams(NodeContainer::GetGlobal(), stream);
+    stream += wpanBuilder.AssignStreams(wpanLeft, stream);
+    stream += wpanBuilder.AssignStreams(wpanRight, stream);
+    for (uint32_t i = 0; i < redQueueDiscs.GetN(); ++i)
+    {
+        stream += DynamicCast<RedQueueDisc>(redQueueDiscs.Get(i))->AssignStreams(stream);
+    }
+    for (uint32_t i = 0; i < sourceApps.GetN(); ++i)
+    {
+        stream += DynamicCast<OnOffApplication>(sourceApps.Get(i))->AssignStreams(stream);
+    }
+
+    AsyncTraceHelper asyncHelper;
+    if (traceMode == "filtered")
+    {
+        FilteredTraceHelper filteredHelper;
+        filteredHelper.SetEventMask(FilteredTraceHelper::ParseEventMask(traceEvents));
+        filteredHelper.SetSampling(traceSample, traceFlowSample);
+
+        Ptr<OutputStreamWrapper> routerStream = asyncHelper.CreateFileStream(runner.GetFileName("1705079-wpan-routers.tr"));
+        filteredHelper.Enable(routerStream, p2pDevices);
+        filteredHelper.Enable(routerStream, lrwpanDevicesLeft.Get(0));
+        filteredHelper.Enable(routerStream, lrwpanDevicesRight.Get(0));
+        if (traceNodes == "all")
+        {
+            Ptr<OutputStreamWrapper> wpanStream = asyncHelper.CreateFileStream(runner.GetFileName("1705079-wpan-leaves.tr"));
+            for (uint32_t i = 1; i < lrwpanDevicesLeft.GetN(); ++i)
+            {
+                filteredHelper.Enable(wpanStream, lrwpanDevicesLeft.Get(i));
+            }
+            for (uint32_t i = 1; i < lrwpanDevicesRight.GetN(); ++i)
+            {
+                filteredHelper.Enable(wpanStream, lrwpanDevicesRight.Get(i));
+            }
+        }
+        else if (traceNodes != "routers")
+        {
+            NS_FATAL_ERROR("Unknown traceNodes " << traceNodes << " (use routers or all)");
+        }
+    }
+    else if (traceMode != "none")
+    {
+        NS_FATAL_ERROR("Unknown traceMode " << traceMode << " (use filtered or none)");
+    }
+
     Ptr<FlowMonitor> flow_monitor;
     FlowMonitorHelper flow_helper;
-    flow_monitor = flow_helper.InstallAll();
+    EndpointFlowMonitor endpointMonitor;
+    if (flowMonitorMode == "full")
+    {
+        flow_monitor = flow_helper.InstallAll();
+    }
+    else if (flowMonitorMode == "endpoint")
+    {
+        NS_ABORT_MSG_IF(flowExport == "xml", "The endpoint flow monitor cannot be serialized to xml");
+        // sources live on the left side, sinks on the right side
+        endpointMonitor.InstallSources(wpanNodesLeft);
+        endpointMonitor.InstallSinks(wpanNodesRight);
+        endpointMonitor.InstallQueueDiscs(queueDiscs);
+    }
+    else
+    {
+        NS_FATAL_ERROR("Unknown flowMonitor " << flowMonitorMode << " (use full or endpoint)");
+    }
+
+    FlowStatsExporter flowExporter(flow_monitor, flow_helper.GetClassifier6());
+    if (flowMonitorMode == "endpoint")
+    {
+        flowExporter.SetEndpointFlowMonitor(&endpointMonitor);
+    }
+    if (flowExport != "xml")
+    {
+        FlowStatsExporter::Format format = FlowStatsExporter::ParseFormat(flowExport);
+        flowExporter.Open(runner.GetFileName(format == FlowStatsExporter::CSV ? "1705079-wpan-flowmon1.csv" : "1705079-wpan-flowmon1.fsx"), format);
+        if (flowExportInterval > 0)
+        {
+            flowExporter.SchedulePeriodic(Seconds(flowExportInterval));
+        }
+    }
+
+    SteadyStateMonitor steadyMonitor;
+    if (steadyState != "none")
+    {
+        NS_ABORT_MSG_UNLESS(steadyState == "stop" || steadyState == "trim",
+                            "Unknown steadyState " << steadyState << " (use none, stop or trim)");
+        steadyMonitor.SetQueueDisc(DynamicCast<RedQueueDisc>(queueDiscs.Get(0)));
+        steadyMonitor.SetSinks(sinks);
+        steadyMonitor.SetPrecision(steadyPrecision, 0.95, 20);
+        steadyMonitor.Start(Seconds(2.0), Seconds(steadyInterval), 50,
+                            steadyState == "stop" ? SteadyStateMonitor::STOP : SteadyStateMonitor::TRIM);
+    }
+
+    // retransmissions at the sources; marks that reach the sinks through
+    // the right WPAN and come back as ECE
+    TcpSignalMonitor signalMonitor;
+    signalMonitor.InstallSources(sourceApps, Seconds(2.0));
+    signalMonitor.InstallSinks(wpanNodesRight);
+
+    // radio energy of both WPANs; the transmissions of packets on their
+    // way to the routers are charged to the packets the queue discs drop
+    WpanEnergyMonitor energyMonitor;
+    if (energy)
+    {
+        BasicEnergySourceHelper sourceHelper;
+        sourceHelper.Set("BasicEnergySourceInitialEnergyJ", DoubleValue(batteryEnergy));
+        sourceHelper.Set("BasicEnergySupplyVoltageV", DoubleValue(supplyVoltage));
+        LrWpanRadioEnergyModelHelper radioHelper;
+        EnergySourceContainer sourcesLeft = sourceHelper.Install(wpanLeft.nodes);
+        energyMonitor.Install(wpanLeft, radioHelper.Install(wpanLeft.lrwpanDevices, sourcesLeft));
+        EnergySourceContainer sourcesRight = sourceHelper.Install(wpanRight.nodes);
+        energyMonitor.Install(wpanRight, radioHelper.Install(wpanRight.lrwpanDevices, sourcesRight));
+        energyMonitor.InstallQueueDiscs(redQueueDiscs);
+    }
 
     std::cout << "Running the simulation" << std::endl;
     Simulator::Stop(Seconds(25.0));
     Simulator::Run();
+    asyncHelper.Close();
+
+    uint32_t sentPackets = 0;
+    uint32_t receivedPackets = 0;
+    uint32_t lostPackets = 0;
+    uint64_t receivedBytes = 0;
+    uint32_t flow_count = 0;
+    float avgThroughput = 0.0;
+    Time delay;
+
+    // both monitors are read through the same flow table
+    FlowStatsTable flows;
+    flowExporter.Snapshot(flows);
+    for (std::size_t i = 0; i < flows.GetNRows(); ++i)
+    {
+        if (flows.txPackets[i] == 0 || flows.lastRxNs[i] <= flows.firstTxNs[i])
+        {
+            // only seen at the bottleneck, or never delivered
+            continue;
+        }
+        Ipv6Address sourceAddress = Ipv6Address::Deserialize(flows.srcAddress[i].data());
+        Ipv6Address destinationAddress = Ipv6Address::Deserialize(flows.dstAddress[i].data());
+        double flowDuration = (flows.lastRxNs[i] - flows.firstTxNs[i]) / 1e9;
+        NS_LOG_UNCOND("\t\tFlow ID = " << flows.flowId[i]);
+        NS_LOG_UNCOND("sorce address = " << sourceAddress << " destination address = " << destinationAddress);
+        NS_LOG_UNCOND("sent packects = " << flows.txPackets[i]);
+        NS_LOG_UNCOND("received packets = " << flows.rxPackets[i]);
+        NS_LOG_UNCOND("lost packets = " << flows.txPackets[i] - flows.rxPackets[i]);
+        NS_LOG_UNCOND("packet delivery ratio = " << flows.rxPackets[i] * 100 / flows.txPackets[i] << "%");
+        NS_LOG_UNCOND("packet loss ratio = " << (flows.txPackets[i] - flows.rxPackets[i]) * 100 / flows.txPackets[i] << "%");
+        NS_LOG_UNCOND("delay = " << NanoSeconds(flows.delaySumNs[i]));
+        NS_LOG_UNCOND("throughput = " << flows.rxBytes[i] * 8.0 / flowDuration / 1024 << "Kbps");
+
+        sentPackets = sentPackets + (flows.txPackets[i]);
+        receivedPackets = receivedPackets + (flows.rxPackets[i]);
+        lostPackets = lostPackets + (flows.txPackets[i] - flows.rxPackets[i]);
+        receivedBytes = receivedBytes + flows.rxBytes[i];
+        avgThroughput = avgThroughput + (flows.rxBytes[i] * 8.0 / flowDuration / 1024);
+        delay = delay + NanoSeconds(flows.delaySumNs[i]);
+
+        flow_count++;
+    }
 
-    // uint32_t sentPackets = 0;
-    // uint32_t receivedPackets = 0;
-    // uint32_t lostPackets = 0;
-    // uint32_t flow_count = 0;
-    // float avgThroughput = 0.0;
-    // Time delay;
-
-    // flow_monitor->CheckForLostPackets();
-    // Ptr<Ipv6FlowClassifier> classifier = DynamicCast<Ipv6FlowClassifier>(flow_helper.GetClassifier());
-    // std::map<FlowId, FlowMonitor::FlowStats> stats = flow_monitor->GetFlowStats();
-    // for (std::map<FlowId, FlowMonitor::FlowStats>::const_iterator i = stats.begin(); i != stats.end(); ++i)
-    // {
-    //     Ipv6FlowClassifier::FiveTuple t = classifier->FindFlow(i->first);
-    //     // std::cout << "id : " << i->first << " src : " << t.sourceAddress << " des : " << t.destinationAddress << " ";
-    //     // std::cout << "data : " << (i->second.rxBytes) * 8.0 / 1024 / 1024 << "Mbps" << std::endl;
-    //     NS_LOG_UNCOND("\t\tFlow ID = " << i->first);
-    //     NS_LOG_UNCOND("sorce address = " << t.sourceAddress << " destination address = " << t.destinationAddress);
-    //     NS_LOG_UNCOND("sent packects = " << i->second.txPackets);
-    //     NS_LOG_UNCOND("received packets = " << i->second.rxPackets);
-    //     NS_LOG_UNCOND("lost packets = " << i->second.txPackets - i->second.rxPackets);
-    //     NS_LOG_UNCOND("packet delivery ratio = " << i->second.rxPackets * 100 / i->second.txPackets << "%");
-    //     NS_LOG_UNCOND("packet loss ratio = " << (i->second.txPackets - i->second.rxPackets) * 100 / i->second.txPackets << "%");
-    //     NS_LOG_UNCOND("delay = " << i->second.delaySum);
-    //     NS_LOG_UNCOND("throughput = " << i->second.rxBytes * 8.0 / (i->second.timeLastRxPacket.GetSeconds() - i->second.timeFirstTxPacket.GetSeconds()) / 1024 << "Kbps");
-
-    //     sentPackets = sentPackets + (i->second.txPackets);
-    //     receivedPackets = receivedPackets + (i->second.rxPackets);
-    //     lostPackets = lostPackets + (i->second.txPackets - i->second.rxPackets);
-    //     avgThroughput = avgThroughput + (i->second.rxBytes * 8.0 / (i->second.timeLastRxPacket.GetSeconds() - i->second.timeFirstTxPacket.GetSeconds()) / 1024);
-    //     delay = delay + (i->second.delaySum);
-
-    //     flow_count++;
-    // }
+    if (flow_count > 0)
+    {
+        avgThroughput = avgThroughput / flow_count;
+        // flow monitor totals are cumulative, so only the steady-state
+        // series below have the warm-up removed
+        NS_LOG_UNCOND("\t ****Total Results of the simulation****"
+                      << (steadyState == "trim" ? " (whole run, warm-up included)" : "") << std::endl);
+        NS_LOG_UNCOND("Total sent packets  =" << sentPackets);
+        NS_LOG_UNCOND("Total Received Packets =" << receivedPackets);
+        NS_LOG_UNCOND("Total Lost Packets =" << lostPackets);
+        NS_LOG_UNCOND("Packet Loss ratio =" << ((lostPackets * 100) / sentPackets) << "%");
+        NS_LOG_UNCOND("Packet delivery ratio =" << ((receivedPackets * 100) / sentPackets) << "%");
+        NS_LOG_UNCOND("Average Throughput =" << avgThroughput << "Kbps");
+        NS_LOG_UNCOND("Average End to End Delay =" << delay / flow_count);
+        NS_LOG_UNCOND("Total flow count " << flow_count);
+    }
 
-    // avgThroughput = avgThroughput / flow_count;
-    // NS_LOG_UNCOND("\t ****Total Results of the simulation****" << std::endl);
-    // NS_LOG_UNCOND("Total sent packets  =" << sentPackets);
-    // NS_LOG_UNCOND("Total Received Packets =" << receivedPackets);
-    // NS_LOG_UNCOND("Total Lost Packets =" << lostPackets);
-    // NS_LOG_UNCOND("Packet Loss ratio =" << ((lostPackets * 100) / sentPackets) << "%");
-    // NS_LOG_UNCOND("Packet delivery ratio =" << ((receivedPackets * 100) / sentPackets) << "%");
-    // NS_LOG_UNCOND("Average Throughput =" << avgThroughput << "Kbps");
-    // NS_LOG_UNCOND("Average End to End Delay =" << delay / flow_count);
-    // NS_LOG_UNCOND("Total flow count " << flow_count);
+    QueueDisc::Stats st = queueDiscs.Get(0)->GetStats();
+    uint64_t marks = st.GetNMarkedPackets(RedQueueDisc::UNFORCED_MARK) + st.GetNMarkedPackets(RedQueueDisc::FORCED_MARK);
+    NS_LOG_UNCOND("Data segments =" << signalMonitor.GetNDataSegments()
+                                    << ", retransmitted =" << signalMonitor.GetNRetransmissions());
+    NS_LOG_UNCOND("Bottleneck drops =" << st.GetNDroppedPackets(RedQueueDisc::UNFORCED_DROP) +
+                                              st.GetNDroppedPackets(RedQueueDisc::FORCED_DROP)
+                                       << ", marks =" << marks << ", RRED drops ="
+                                       << st.GetNDroppedPackets(RedQueueDisc::RRED_DROP));
+    if (ecn)
+    {
+        NS_LOG_UNCOND("CE delivered to the sinks =" << signalMonitor.GetNCeDelivered() << " of "
+                                                    << signalMonitor.GetNEctDelivered()
+                                                    << " ECN-capable packets, ECE acks at the sources ="
+                                                    << signalMonitor.GetNEceAcks());
+    }
+
+    double energyPerBit = 0;
+    if (energy)
+    {
+        double totalEnergy = energyMonitor.GetTotalEnergy();
+        double droppedEnergy = energyMonitor.GetDroppedEnergy();
+        double upwardEnergy = energyMonitor.GetUpwardEnergy();
+        energyPerBit = receivedBytes > 0 ? totalEnergy / (receivedBytes * 8.0) : 0;
+        NS_LOG_UNCOND("WPAN radio energy =" << totalEnergy << "J (" << energyMonitor.GetNodeEnergy()
+                                            << "J without the routers)");
+        NS_LOG_UNCOND("Energy per delivered bit =" << energyPerBit * 1e6 << "uJ");
+        if (energyMonitor.GetNForwardedSeen() == 0)
+        {
+            // the discs are not where the routers forward to, nothing can be charged
+            NS_LOG_UNCOND("Energy of packets dropped at the queue discs = n/a, no forwarded packet reached them");
+        }
+        else
+        {
+            NS_LOG_UNCOND("Energy of packets dropped at the queue discs =" << droppedEnergy * 1e3 << "mJ, "
+                                                                           << energyMonitor.GetNChargedDrops() << " of "
+                                                                           << energyMonitor.GetNDropped() << " drops");
+            NS_LOG_UNCOND("Share of the upward transmit energy dropped ="
+                          << (upwardEnergy > 0 ? droppedEnergy * 100 / upwardEnergy : 0) << "%");
+        }
+    }
 
-    flow_monitor->SerializeToXmlFile("1705079-wpan-flowmon1.xml", true, true);
+    if (steadyState != "none")
+    {
+        if (steadyMonitor.IsSteady())
+        {
+            NS_LOG_UNCOND("Steady state reached at " << steadyMonitor.GetSteadyTime().GetSeconds()
+                                                     << "s, warm-up ended at " << steadyMonitor.GetWarmupEnd().GetSeconds() << "s");
+        }
+        else
+        {
+            NS_LOG_UNCOND("Steady state not reached");
+        }
+        for (const SteadyStateMonitor::Estimate &e : steadyMonitor.GetEstimates())
+        {
+            NS_LOG_UNCOND("Steady-state " << e.name << " =" << e.mean << " +/- " << e.halfWidth << " (first "
+                                          << e.warmup << " samples trimmed)");
+        }
+    }
 
-    QueueDisc::Stats st = queueDiscs.Get(0)->GetStats();
+    if (flowExport == "xml")
+    {
+        flow_monitor->SerializeToXmlFile(runner.GetFileName("1705079-wpan-flowmon1.xml"), true, true);
+    }
+    else
+    {
+        flowExporter.Dump();
+        flowExporter.Close();
+    }
+
+    // per-replication samples for the ensemble confidence intervals
+    runner.Report("throughput_kbps", avgThroughput);
+    runner.Report("loss_pct", sentPackets > 0 ? lostPackets * 100.0 / sentPackets : 0);
+    runner.Report("delay_ms", flow_count > 0 ? (delay / flow_count).GetSeconds() * 1e3 : 0);
+    runner.Report("unforced_drops", st.GetNDroppedPackets(RedQueueDisc::UNFORCED_DROP));
+    runner.Report("forced_drops", st.GetNDroppedPackets(RedQueueDisc::FORCED_DROP));
+    // head drops leave after dequeue
+    runner.Report("head_drops", st.nTotalDroppedPacketsAfterDequeue);
+    runner.Report("marks", marks);
+    runner.Report("retransmissions", signalMonitor.GetNRetransmissions());
+    if (energy)
+    {
+        runner.Report("uj_per_bit", energyPerBit * 1e6);
+        if (energyMonitor.GetNForwardedSeen() > 0)
+        {
+            runner.Report("dropped_energy_mj", energyMonitor.GetDroppedEnergy() * 1e3);
+        }
+    }
 
-    if (st.GetNDroppedPackets(RedQueueDisc::UNFORCED_DROP) == 0)
+    if (st.GetNDroppedPackets(RedQueueDisc::UNFORCED_DROP) == 0 && st.GetNMarkedPackets(RedQueueDisc::UNFORCED_MARK) == 0)
     {
-        std::cout << "There should be some unforced drops" << std::endl;
+        std::cout << "There should be some unforced drops or marks" << std::endl;
         exit(1);
     }
 